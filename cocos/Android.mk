@@ -9,8 +9,10 @@ LOCAL_ARM_MODE := arm
 
 ifeq ($(TARGET_ARCH_ABI),armeabi-v7a)
 MATHNEONFILE := math/MathUtil.cpp.neon
+PIXELTRANSFORMFILE := base/CCPixelTransform.cpp.neon
 else
 MATHNEONFILE := math/MathUtil.cpp
+PIXELTRANSFORMFILE := base/CCPixelTransform.cpp
 endif
 
 LOCAL_SRC_FILES := \
@@ -46,6 +48,7 @@ base/CCLog.cpp \
 base/CCScheduler.cpp \
 base/csscolorparser.cpp \
 base/CCGLUtils.cpp \
+$(PIXELTRANSFORMFILE) \
 base/CCRenderTexture.cpp \
 renderer/Types.cpp \
 renderer/gfx/DeviceGraphics.cpp \
@@ -61,6 +64,7 @@ renderer/gfx/State.cpp \
 renderer/gfx/Texture.cpp \
 renderer/gfx/Texture2D.cpp \
 renderer/gfx/VertexBuffer.cpp \
+renderer/gfx/TransientGeometry.cpp \
 renderer/gfx/VertexFormat.cpp \
 renderer/renderer/BaseRenderer.cpp \
 renderer/renderer/Camera.cpp \
@@ -7,6 +7,12 @@ LOCAL_MODULE := audioengine_static
 
 LOCAL_MODULE_FILENAME := libaudioengine
 
+ifeq ($(TARGET_ARCH_ABI),armeabi-v7a)
+MIXERKERNELSFILE := AudioMixerKernels.cpp.neon
+else
+MIXERKERNELSFILE := AudioMixerKernels.cpp
+endif
+
 LOCAL_SRC_FILES := AudioEngine-inl.cpp \
                    ../AudioEngine.cpp \
                    AssetFd.cpp \
@@ -20,11 +26,14 @@ LOCAL_SRC_FILES := AudioEngine-inl.cpp \
                    AudioResampler.cpp \
                    AudioResamplerCubic.cpp \
                    PcmBufferProvider.cpp \
+                   PcmCache.cpp \
+                   PcmStream.cpp \
                    PcmAudioPlayer.cpp \
                    UrlAudioPlayer.cpp \
                    PcmData.cpp \
                    AudioMixerController.cpp \
                    AudioMixer.cpp \
+                   $(MIXERKERNELSFILE) \
                    PcmAudioService.cpp \
                    Track.cpp \
                    audio_utils/format.c \
@@ -45,8 +54,9 @@ LOCAL_C_INCLUDES := $(LOCAL_PATH)/../include \
                     $(LOCAL_PATH)/../../../external \
                     $(LOCAL_PATH)/../../../external/sources
 
-LOCAL_STATIC_LIBRARIES += libvorbisidec libpvmp3dec
+LOCAL_STATIC_LIBRARIES += libvorbisidec libpvmp3dec cpufeatures
 include $(BUILD_STATIC_LIBRARY)
 
 $(call import-module,sources/tremolo)
 $(call import-module,sources/pvmp3dec)
+$(call import-module,android/cpufeatures)
@@ -136,6 +136,25 @@ bool AudioDecoder::start()
     return ret;
 }
 
+bool AudioDecoder::openStream()
+{
+    return false;
+}
+
+int AudioDecoder::readStream(int16_t* buffer, int frames)
+{
+    return -1;
+}
+
+bool AudioDecoder::seekStream(int frame)
+{
+    return false;
+}
+
+void AudioDecoder::closeStream()
+{
+}
+
 bool AudioDecoder::resample()
 {
     if (_result.sampleRate == _sampleRate)
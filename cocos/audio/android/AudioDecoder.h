@@ -44,6 +44,16 @@ public:
     inline PcmData getResult()
     { return _result; };
 
+    // Streaming mode decodes the file piece by piece instead of all at once. It's only supported
+    // by decoders which know the total frame count from the file header. After openStream()
+    // succeeds, getResult() describes the format of the stream, but holds no pcm data.
+    // Frames are read in the original sample rate and channel count of the file.
+    virtual bool openStream();
+    // Returns the number of frames read, 0 at the end of the stream or -1 on error.
+    virtual int readStream(int16_t* buffer, int frames);
+    virtual bool seekStream(int frame);
+    virtual void closeStream();
+
 protected:
     virtual bool decodeToPcm() = 0;
     bool resample();
@@ -31,13 +31,14 @@ THE SOFTWARE.
 namespace cocos2d { namespace experimental {
 
 AudioDecoderOgg::AudioDecoderOgg()
+        : _isStreamOpened(false)
 {
     ALOGV("Create AudioDecoderOgg");
 }
 
 AudioDecoderOgg::~AudioDecoderOgg()
 {
-
+    closeStream();
 }
 
 int AudioDecoderOgg::fseek64Wrap(void* datasource, ogg_int64_t off, int whence)
@@ -45,12 +46,15 @@ int AudioDecoderOgg::fseek64Wrap(void* datasource, ogg_int64_t off, int whence)
     return AudioDecoder::fileSeek(datasource, (long)off, whence);
 }
 
-bool AudioDecoderOgg::decodeToPcm()
+bool AudioDecoderOgg::openVorbisFile(OggVorbis_File* vf)
 {
-    _fileData = FileUtils::getInstance()->getDataFromFile(_url);
     if (_fileData.isNull())
     {
-        return false;
+        _fileData = FileUtils::getInstance()->getDataFromFile(_url);
+        if (_fileData.isNull())
+        {
+            return false;
+        }
     }
 
     ov_callbacks callbacks;
@@ -61,13 +65,22 @@ bool AudioDecoderOgg::decodeToPcm()
 
     _fileCurrPos = 0;
 
-    OggVorbis_File vf;
-    int ret = ov_open_callbacks(this, &vf, NULL, 0, callbacks);
+    int ret = ov_open_callbacks(this, vf, NULL, 0, callbacks);
     if (ret != 0)
     {
         ALOGE("Open file error, file: %s, ov_open_callbacks return %d", _url.c_str(), ret);
         return false;
     }
+    return true;
+}
+
+bool AudioDecoderOgg::decodeToPcm()
+{
+    OggVorbis_File vf;
+    if (!openVorbisFile(&vf))
+    {
+        return false;
+    }
     // header
     auto vi = ov_info(&vf, -1);
 
@@ -110,4 +123,84 @@ bool AudioDecoderOgg::decodeToPcm()
     return (curPos > 0);
 }
 
+bool AudioDecoderOgg::openStream()
+{
+    closeStream();
+
+    if (!openVorbisFile(&_streamFile))
+    {
+        return false;
+    }
+    _isStreamOpened = true;
+
+    auto vi = ov_info(&_streamFile, -1);
+    ogg_int64_t pcmSamples = ov_pcm_total(&_streamFile, -1);
+    if (vi == nullptr || pcmSamples <= 0)
+    {
+        ALOGE("Couldn't get the length of (%s), streaming isn't supported!", _url.c_str());
+        closeStream();
+        return false;
+    }
+
+    _result.numChannels = vi->channels;
+    _result.sampleRate = vi->rate;
+    _result.bitsPerSample = SL_PCMSAMPLEFORMAT_FIXED_16;
+    _result.containerSize = SL_PCMSAMPLEFORMAT_FIXED_16;
+    _result.channelMask = vi->channels == 1 ? SL_SPEAKER_FRONT_CENTER : (SL_SPEAKER_FRONT_LEFT | SL_SPEAKER_FRONT_RIGHT);
+    _result.endianness = SL_BYTEORDER_LITTLEENDIAN;
+    _result.numFrames = (int) pcmSamples;
+    _result.duration = 1.0f * pcmSamples / vi->rate;
+    return true;
+}
+
+int AudioDecoderOgg::readStream(int16_t* buffer, int frames)
+{
+    if (!_isStreamOpened)
+    {
+        return -1;
+    }
+
+    const long frameSize = _result.numChannels * sizeof(int16_t);
+    const long totalBytes = frames * frameSize;
+    char* out = (char*) buffer;
+    long curPos = 0;
+    int currentSection = 0;
+
+    while (curPos < totalBytes)
+    {
+        long readBytes = ov_read(&_streamFile, out + curPos, (int) (totalBytes - curPos), &currentSection);
+        if (readBytes == OV_HOLE)
+        {
+            // Interruption in the data, just carry on with the next packet
+            continue;
+        }
+        if (readBytes < 0)
+        {
+            ALOGE("ov_read (%s) returns %ld!", _url.c_str(), readBytes);
+            return curPos > 0 ? (int) (curPos / frameSize) : -1;
+        }
+        if (readBytes == 0)
+        {
+            break;
+        }
+        curPos += readBytes;
+    }
+
+    return (int) (curPos / frameSize);
+}
+
+bool AudioDecoderOgg::seekStream(int frame)
+{
+    return _isStreamOpened && ov_pcm_seek(&_streamFile, frame) == 0;
+}
+
+void AudioDecoderOgg::closeStream()
+{
+    if (_isStreamOpened)
+    {
+        ov_clear(&_streamFile);
+        _isStreamOpened = false;
+    }
+}
+
 }} // namespace cocos2d { namespace experimental {
\ No newline at end of file
@@ -40,6 +40,16 @@ protected:
     static int fseek64Wrap(void* datasource, ogg_int64_t off, int whence);
     virtual bool decodeToPcm() override;
 
+    virtual bool openStream() override;
+    virtual int readStream(int16_t* buffer, int frames) override;
+    virtual bool seekStream(int frame) override;
+    virtual void closeStream() override;
+
+    bool openVorbisFile(OggVorbis_File* vf);
+
+    OggVorbis_File _streamFile;
+    bool _isStreamOpened;
+
     friend class AudioDecoderProvider;
 };
 
@@ -26,21 +26,22 @@ THE SOFTWARE.
 #define LOG_TAG "AudioDecoderWav"
 
 #include "audio/android/AudioDecoderWav.h"
-#include "audio/android/tinysndfile.h"
 #include "platform/CCFileUtils.h"
 
 #include <assert.h>
+#include <algorithm>
 
 namespace cocos2d { namespace experimental {
 
 AudioDecoderWav::AudioDecoderWav()
+        : _streamHandle(nullptr)
 {
     ALOGV("Create AudioDecoderWav");
 }
 
 AudioDecoderWav::~AudioDecoderWav()
 {
-
+    closeStream();
 }
 
 void* AudioDecoderWav::onWavOpen(const char* path, void* user)
@@ -58,16 +59,17 @@ int AudioDecoderWav::onWavClose(void* datasource)
     return 0;
 }
 
-bool AudioDecoderWav::decodeToPcm()
+SNDFILE* AudioDecoderWav::openSndFile(SF_INFO* info)
 {
-    _fileData = FileUtils::getInstance()->getDataFromFile(_url);
     if (_fileData.isNull())
     {
-        return false;
+        _fileData = FileUtils::getInstance()->getDataFromFile(_url);
+        if (_fileData.isNull())
+        {
+            return nullptr;
+        }
     }
 
-    SF_INFO info;
-
     snd_callbacks cb;
     cb.open = onWavOpen;
     cb.read = AudioDecoder::fileRead;
@@ -75,11 +77,18 @@ bool AudioDecoderWav::decodeToPcm()
     cb.close = onWavClose;
     cb.tell = AudioDecoder::fileTell;
 
+    _fileCurrPos = 0;
+    return sf_open_read(_url.c_str(), info, &cb, this);
+}
+
+bool AudioDecoderWav::decodeToPcm()
+{
+    SF_INFO info;
     SNDFILE* handle = NULL;
     bool ret = false;
     do
     {
-        handle = sf_open_read(_url.c_str(), &info, &cb, this);
+        handle = openSndFile(&info);
         if (handle == nullptr)
             break;
 
@@ -112,4 +121,80 @@ bool AudioDecoderWav::decodeToPcm()
     return ret;
 }
 
+bool AudioDecoderWav::openStream()
+{
+    closeStream();
+
+    SF_INFO info;
+    _streamHandle = openSndFile(&info);
+    if (_streamHandle == nullptr)
+    {
+        return false;
+    }
+
+    if (info.frames == 0)
+    {
+        closeStream();
+        return false;
+    }
+
+    _result.numChannels = info.channels;
+    _result.sampleRate = info.samplerate;
+    _result.bitsPerSample = SL_PCMSAMPLEFORMAT_FIXED_16;
+    _result.containerSize = SL_PCMSAMPLEFORMAT_FIXED_16;
+    _result.channelMask = _result.numChannels == 1 ? SL_SPEAKER_FRONT_CENTER : (SL_SPEAKER_FRONT_LEFT | SL_SPEAKER_FRONT_RIGHT);
+    _result.endianness = SL_BYTEORDER_LITTLEENDIAN;
+    _result.numFrames = info.frames;
+    _result.duration = 1.0f * info.frames / _result.sampleRate;
+    return true;
+}
+
+int AudioDecoderWav::readStream(int16_t* buffer, int frames)
+{
+    if (_streamHandle == nullptr)
+    {
+        return -1;
+    }
+    return (int) sf_readf_short(_streamHandle, buffer, frames);
+}
+
+bool AudioDecoderWav::seekStream(int frame)
+{
+    if (_streamHandle == nullptr)
+    {
+        return false;
+    }
+
+    // tinysndfile couldn't seek, reopen the file and skip the frames before the new position.
+    sf_close(_streamHandle);
+    SF_INFO info;
+    _streamHandle = openSndFile(&info);
+    if (_streamHandle == nullptr)
+    {
+        return false;
+    }
+
+    int16_t skipBuffer[1024];
+    const int skipFrames = (int) (sizeof(skipBuffer) / sizeof(skipBuffer[0])) / _result.numChannels;
+    while (frame > 0)
+    {
+        int readFrames = (int) sf_readf_short(_streamHandle, skipBuffer, std::min(frame, skipFrames));
+        if (readFrames <= 0)
+        {
+            return false;
+        }
+        frame -= readFrames;
+    }
+    return true;
+}
+
+void AudioDecoderWav::closeStream()
+{
+    if (_streamHandle != nullptr)
+    {
+        sf_close(_streamHandle);
+        _streamHandle = nullptr;
+    }
+}
+
 }} // namespace cocos2d { namespace experimental {
\ No newline at end of file
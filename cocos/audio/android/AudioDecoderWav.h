@@ -26,6 +26,7 @@ THE SOFTWARE.
 #pragma once
 
 #include "audio/android/AudioDecoder.h"
+#include "audio/android/tinysndfile.h"
 
 namespace cocos2d { namespace experimental {
 
@@ -37,10 +38,19 @@ protected:
 
     virtual bool decodeToPcm() override;
 
+    virtual bool openStream() override;
+    virtual int readStream(int16_t* buffer, int frames) override;
+    virtual bool seekStream(int frame) override;
+    virtual void closeStream() override;
+
+    SNDFILE* openSndFile(SF_INFO* info);
+
     static void* onWavOpen(const char* path, void* user);
     static int onWavSeek(void* datasource, long offset, int whence);
     static int onWavClose(void* datasource);
 
+    SNDFILE* _streamHandle;
+
     friend class AudioDecoderProvider;
 };
 
@@ -36,7 +36,9 @@
 #include "base/CCRef.h"
 #include "base/ccUtils.h"
 
-#define MAX_AUDIOINSTANCES 24
+// Sounds beyond the voices of AudioMixer are virtualized, this only bounds the bookkeeping.
+// UrlAudioPlayers have their own lower limit, see UrlAudioPlayer::MAX_INSTANCES.
+#define MAX_AUDIOINSTANCES 256
 
 #define ERRORLOG(msg) log("fun:%s,line:%d,msg:%s",__func__,__LINE__,#msg)
 
@@ -58,7 +60,7 @@ public:
     ~AudioEngineImpl();
 
     bool init();
-    int play2d(const std::string &fileFullPath ,bool loop ,float volume);
+    int play2d(const std::string &fileFullPath ,bool loop ,float volume, int priority = 0);
     void setVolume(int audioID,float volume);
     void setLoop(int audioID, bool loop);
     void pause(int audioID);
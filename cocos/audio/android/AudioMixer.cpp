@@ -29,6 +29,7 @@
 
 #include "audio/android/AudioMixerOps.h"
 #include "audio/android/AudioMixer.h"
+#include "audio/android/AudioMixerKernels.h"
 
 // The FCC_2 macro refers to the Fixed Channel Count of 2 for the legacy integer mixer.
 #ifndef FCC_2
@@ -1139,12 +1140,7 @@ void AudioMixer::volumeRampStereo(track_t* t, int32_t* out, size_t frameCount, i
         } while (--frameCount);
         t->prevAuxLevel = va;
     } else {
-        do {
-            *out++ += (vl >> 16) * (*temp++ >> 12);
-            *out++ += (vr >> 16) * (*temp++ >> 12);
-            vl += vlInc;
-            vr += vrInc;
-        } while (--frameCount);
+        AudioMixerKernels::mixStereo32Ramp(out, temp, frameCount, &vl, &vr, vlInc, vrInc);
     }
     t->prevVolume[0] = vl;
     t->prevVolume[1] = vr;
@@ -1170,13 +1166,7 @@ void AudioMixer::volumeStereo(track_t* t, int32_t* out, size_t frameCount, int32
             aux++;
         } while (--frameCount);
     } else {
-        do {
-            int16_t l = (int16_t)(*temp++ >> 12);
-            int16_t r = (int16_t)(*temp++ >> 12);
-            out[0] = mulAdd(l, vl, out[0]);
-            out[1] = mulAdd(r, vr, out[1]);
-            out += 2;
-        } while (--frameCount);
+        AudioMixerKernels::mixStereo32(out, temp, frameCount, vl, vr);
     }
 }
 
@@ -1245,12 +1235,8 @@ void AudioMixer::track__16BitsStereo(track_t* t, int32_t* out, size_t frameCount
             //        t, vlInc/65536.0f, vl/65536.0f, t->volume[0],
             //        (vl + vlInc*frameCount)/65536.0f, frameCount);
 
-            do {
-                *out++ += (vl >> 16) * (int32_t) *in++;
-                *out++ += (vr >> 16) * (int32_t) *in++;
-                vl += vlInc;
-                vr += vrInc;
-            } while (--frameCount);
+            AudioMixerKernels::mixStereo16Ramp(out, in, frameCount, &vl, &vr, vlInc, vrInc);
+            in += frameCount * 2;
 
             t->prevVolume[0] = vl;
             t->prevVolume[1] = vr;
@@ -1259,14 +1245,8 @@ void AudioMixer::track__16BitsStereo(track_t* t, int32_t* out, size_t frameCount
 
         // constant gain
         else {
-            const uint32_t vrl = t->volumeRL;
-            do {
-                uint32_t rl = *reinterpret_cast<const uint32_t *>(in);
-                in += 2;
-                out[0] = mulAddRL(1, rl, vrl, out[0]);
-                out[1] = mulAddRL(0, rl, vrl, out[1]);
-                out += 2;
-            } while (--frameCount);
+            AudioMixerKernels::mixStereo16(out, in, frameCount, t->volume[0], t->volume[1]);
+            in += frameCount * 2;
         }
     }
     t->in = in;
@@ -1640,28 +1620,10 @@ void AudioMixer::process__OneTrack16BitsStereoNoResampling(state_t* state,
             } while (--outFrames);
             break;
         case AUDIO_FORMAT_PCM_16_BIT:
-            if (CC_UNLIKELY(uint32_t(vl) > UNITY_GAIN_INT || uint32_t(vr) > UNITY_GAIN_INT)) {
-                // volume is boosted, so we might need to clamp even though
-                // we process only one track.
-                do {
-                    uint32_t rl = *reinterpret_cast<const uint32_t *>(in);
-                    in += 2;
-                    int32_t l = mulRL(1, rl, vrl) >> 12;
-                    int32_t r = mulRL(0, rl, vrl) >> 12;
-                    // clamping...
-                    l = clamp16(l);
-                    r = clamp16(r);
-                    *out++ = (r<<16) | (l & 0xFFFF);
-                } while (--outFrames);
-            } else {
-                do {
-                    uint32_t rl = *reinterpret_cast<const uint32_t *>(in);
-                    in += 2;
-                    int32_t l = mulRL(1, rl, vrl) >> 12;
-                    int32_t r = mulRL(0, rl, vrl) >> 12;
-                    *out++ = (r<<16) | (l & 0xFFFF);
-                } while (--outFrames);
-            }
+            // Clamping is only needed if the volume is boosted, but it doesn't change
+            // the result otherwise and the kernel gets it for free.
+            AudioMixerKernels::scaleStereo16(out, in, outFrames, vl, vr);
+            out += outFrames;
             break;
         default:
             LOG_ALWAYS_FATAL("bad mixer format: %d", t.mMixerFormat);
@@ -1962,7 +1924,7 @@ void AudioMixer::convertMixerFormat(void *out, audio_format_t mixerOutFormat,
             break;
         case AUDIO_FORMAT_PCM_16_BIT:
             // two int16_t are produced per iteration
-            ditherAndClamp((int32_t*)out, (int32_t*)in, sampleCount >> 1);
+            AudioMixerKernels::clampStereo16((int32_t*)out, (int32_t*)in, sampleCount >> 1);
             break;
         default:
             LOG_ALWAYS_FATAL("bad mixerOutFormat: %#x", mixerOutFormat);
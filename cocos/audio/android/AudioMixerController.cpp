@@ -34,11 +34,15 @@ THE SOFTWARE.
 
 namespace cocos2d { namespace experimental {
 
+// Ranking bonus of tracks which are mixed already, about 2 dB
+static const float __voiceHysteresis = 1.25f;
+
 AudioMixerController::AudioMixerController(int bufferSizeInFrames, int sampleRate, int channelCount)
         : _bufferSizeInFrames(bufferSizeInFrames)
         , _sampleRate(sampleRate)
         , _channelCount(channelCount)
         , _mixer(nullptr)
+        , _pendingTracks(nullptr)
         , _isPaused(false)
         , _isMixingFrame(false)
 {
@@ -73,18 +77,46 @@ bool AudioMixerController::init()
 bool AudioMixerController::addTrack(Track* track)
 {
     ALOG_ASSERT(track != nullptr, "Shouldn't pass nullptr to addTrack");
-    bool ret = false;
 
-    std::lock_guard<std::mutex> lk(_activeTracksMutex);
+    if (track->_isPending.exchange(true))
+        return false;
+
+    Track* head = _pendingTracks.load(std::memory_order_relaxed);
+    do
+    {
+        track->_nextPendingTrack = head;
+    } while (!_pendingTracks.compare_exchange_weak(head, track, std::memory_order_release, std::memory_order_relaxed));
+
+    return true;
+}
+
+void AudioMixerController::takePendingTracks()
+{
+    Track* track = _pendingTracks.exchange(nullptr, std::memory_order_acquire);
 
-    auto iter = std::find(_activeTracks.begin(), _activeTracks.end(), track);
-    if (iter == _activeTracks.end())
+    // The list is in reverse order of addTrack calls
+    Track* first = nullptr;
+    while (track != nullptr)
     {
-        _activeTracks.push_back(track);
-        ret = true;
+        Track* next = track->_nextPendingTrack;
+        track->_nextPendingTrack = first;
+        first = track;
+        track = next;
     }
 
-    return ret;
+    while (first != nullptr)
+    {
+        Track* next = first->_nextPendingTrack;
+        first->_nextPendingTrack = nullptr;
+        // The track may be added again once the flag is cleared, its link mustn't be used after that.
+        first->_isPending = false;
+
+        if (std::find(_activeTracks.begin(), _activeTracks.end(), first) == _activeTracks.end())
+        {
+            _activeTracks.push_back(first);
+        }
+        first = next;
+    }
 }
 
 template <typename T>
@@ -97,10 +129,10 @@ static void removeItemFromVector(std::vector<T>& v, T item)
     }
 }
 
-void AudioMixerController::initTrack(Track* track, std::vector<Track*>& tracksToRemove)
+bool AudioMixerController::initTrack(Track* track, bool isFadeIn)
 {
     if (track->isInitialized())
-        return;
+        return true;
 
     uint32_t channelMask = audio_channel_out_mask_from_count(2);
     int32_t name = _mixer->getTrackName(channelMask, AUDIO_FORMAT_PCM_16_BIT,
@@ -108,8 +140,8 @@ void AudioMixerController::initTrack(Track* track, std::vector<Track*>& tracksTo
     if (name < 0)
     {
         // If we could not get the track name, it means that there're MAX_NUM_TRACKS tracks
-        // So ignore the new track.
-        tracksToRemove.push_back(track);
+        // The track stays virtual until a voice is available.
+        return false;
     }
     else
     {
@@ -137,6 +169,17 @@ void AudioMixerController::initTrack(Track* track, std::vector<Track*>& tracksTo
                 AudioMixer::CHANNEL_MASK,
                 (void *) (uintptr_t) channelMask);
 
+        // Decoded pcm data was resampled to the device sample rate already,
+        // but streaming tracks provide frames in the sample rate of the file.
+        if (track->getSampleRate() != _sampleRate)
+        {
+            _mixer->setParameter(
+                    name,
+                    AudioMixer::RESAMPLE,
+                    AudioMixer::SAMPLE_RATE,
+                    (void *) (uintptr_t) track->getSampleRate());
+        }
+
         track->setName(name);
         _mixer->enable(name);
 
@@ -145,23 +188,124 @@ void AudioMixerController::initTrack(Track* track, std::vector<Track*>& tracksTo
         float lVolume = float_from_gain(gain_minifloat_unpack_left(volume));
         float rVolume = float_from_gain(gain_minifloat_unpack_right(volume));
 
-        _mixer->setParameter(name, AudioMixer::VOLUME, AudioMixer::VOLUME0, &lVolume);
-        _mixer->setParameter(name, AudioMixer::VOLUME, AudioMixer::VOLUME1, &rVolume);
+        if (isFadeIn)
+        {
+            // The track was playing virtually, ramp up from silence instead of starting in the middle of a wave
+            float zero = 0.0f;
+            _mixer->setParameter(name, AudioMixer::VOLUME, AudioMixer::VOLUME0, &zero);
+            _mixer->setParameter(name, AudioMixer::VOLUME, AudioMixer::VOLUME1, &zero);
+            _mixer->setParameter(name, AudioMixer::RAMP_VOLUME, AudioMixer::VOLUME0, &lVolume);
+            _mixer->setParameter(name, AudioMixer::RAMP_VOLUME, AudioMixer::VOLUME1, &rVolume);
+        }
+        else
+        {
+            _mixer->setParameter(name, AudioMixer::VOLUME, AudioMixer::VOLUME0, &lVolume);
+            _mixer->setParameter(name, AudioMixer::VOLUME, AudioMixer::VOLUME1, &rVolume);
+        }
 
         track->setVolumeDirty(false);
         track->setInitialized(true);
     }
+    return true;
+}
+
+void AudioMixerController::releaseTrack(Track* track)
+{
+    if (track->isInitialized())
+    {
+        _mixer->deleteTrackName(track->getName());
+        track->setName(-1);
+        track->setInitialized(false);
+    }
+    track->_isReleasing = false;
+}
+
+void AudioMixerController::rampDownTrack(Track* track)
+{
+    // Cutting a voice off in the middle of a wave clicks, fade it out during the next buffer
+    int name = track->getName();
+    float zero = 0.0f;
+    _mixer->setParameter(name, AudioMixer::RAMP_VOLUME, AudioMixer::VOLUME0, &zero);
+    _mixer->setParameter(name, AudioMixer::RAMP_VOLUME, AudioMixer::VOLUME1, &zero);
+    track->_isReleasing = true;
+}
+
+void AudioMixerController::assignVoices()
+{
+    // Voices faded out in the previous frame are silent now
+    for (auto&& track : _activeTracks)
+    {
+        if (track->_isReleasing)
+        {
+            releaseTrack(track);
+        }
+    }
+
+    _playingTracks.clear();
+    for (auto&& track : _activeTracks)
+    {
+        if (track->getState() != Track::State::PLAYING)
+            continue;
+
+        // Audibility is the volume, the engine has no 3D sounds so distance attenuation is part of it already.
+        // Tracks having a voice win ties against virtual ones, so equal sounds don't keep swapping voices.
+        track->_audibility = track->getVolume();
+        if (track->isInitialized())
+        {
+            track->_audibility *= __voiceHysteresis;
+        }
+        _playingTracks.push_back(track);
+    }
+
+    size_t voiceCount = std::min(_playingTracks.size(), (size_t) AudioMixer::MAX_NUM_TRACKS);
+    if (voiceCount < _playingTracks.size())
+    {
+        std::nth_element(_playingTracks.begin(), _playingTracks.begin() + voiceCount, _playingTracks.end(),
+                         [](const Track* a, const Track* b) {
+                             int priorityA = a->getPriority();
+                             int priorityB = b->getPriority();
+                             if (priorityA != priorityB)
+                                 return priorityA > priorityB;
+                             return a->_audibility > b->_audibility;
+                         });
+
+        // Outranked tracks fade out during this frame and release their voices in the next one,
+        // promoted tracks which don't find a free voice meanwhile stay virtual for one more frame.
+        for (size_t i = voiceCount; i < _playingTracks.size(); ++i)
+        {
+            Track* track = _playingTracks[i];
+            if (track->isInitialized())
+            {
+                rampDownTrack(track);
+            }
+            track->_isVirtual = true;
+        }
+    }
+
+    for (size_t i = 0; i < voiceCount; ++i)
+    {
+        Track* track = _playingTracks[i];
+        if (initTrack(track, track->_isVirtual))
+        {
+            track->_isVirtual = false;
+        }
+        else
+        {
+            track->_isVirtual = true;
+        }
+    }
 }
 
 void AudioMixerController::mixOneFrame()
 {
     _isMixingFrame = true;
-    _activeTracksMutex.lock();
 
     auto mixStart = clockNow();
 
-    std::vector<Track*> tracksToRemove;
-    tracksToRemove.reserve(_activeTracks.size());
+    takePendingTracks();
+
+    std::vector<Track*>& tracksToRemove = _tracksToRemove;
+    tracksToRemove.clear();
 
     // FOR TESTING BEGIN
 //        Track* track = _activeTracks[0];
@@ -186,26 +330,54 @@ void AudioMixerController::mixOneFrame()
 //        }
 //
 //        _mixing->state = BufferState::FULL;
-//        _activeTracksMutex.unlock();
     // FOR TESTING END
 
     Track::State state;
-    // set up the tracks.
+    // update the states of the tracks.
     for (auto&& track : _activeTracks)
     {
         state = track->getState();
 
-        if (state == Track::State::PLAYING)
+        if (state == Track::State::RESUMED)
+        {
+            if (track->getPrevState() == Track::State::PAUSED)
+            {
+                track->setState(Track::State::PLAYING);
+            }
+            else
+            {
+                ALOGW("Previous state (%d) isn't PAUSED, couldn't resume!", static_cast<int>(track->getPrevState()));
+            }
+        }
+        else if (state == Track::State::PAUSED)
         {
-            initTrack(track, tracksToRemove);
+            // A paused track doesn't need a voice, it competes for one again once it's resumed.
+            releaseTrack(track);
+        }
+        else if (state == Track::State::STOPPED)
+        {
+            releaseTrack(track);
+            tracksToRemove.push_back(track);
+        }
+    }
+
+    // Only the most important playing tracks are mixed, the others are virtual.
+    assignVoices();
 
-            int name = track->getName();
-            ALOG_ASSERT(name >= 0);
+    for (auto&& track : _playingTracks)
+    {
+        // Tracks fading out are mixed as they are, a volume change would stop the ramp.
+        if (track->_isReleasing)
+            continue;
 
-            std::lock_guard<std::mutex> lk(track->_volumeDirtyMutex);
+        if (track->isInitialized())
+        {
+            // If the game thread is setting the volume right now, pick it up in the next frame.
+            std::unique_lock<std::mutex> lk(track->_volumeDirtyMutex, std::try_to_lock);
 
-            if (track->isVolumeDirty())
+            if (lk.owns_lock() && track->isVolumeDirty())
             {
+                int name = track->getName();
                 gain_minifloat_packed_t volume = track->getVolumeLR();
                 float lVolume = float_from_gain(gain_minifloat_unpack_left(volume));
                 float rVolume = float_from_gain(gain_minifloat_unpack_right(volume));
@@ -218,46 +390,15 @@ void AudioMixerController::mixOneFrame()
                 track->setVolumeDirty(false);
             }
         }
-        else if (state == Track::State::RESUMED)
-        {
-            initTrack(track, tracksToRemove);
-
-            if (track->getPrevState() == Track::State::PAUSED)
-            {
-                _mixer->enable(track->getName());
-                track->setState(Track::State::PLAYING);
-            }
-            else
-            {
-                ALOGW("Previous state (%d) isn't PAUSED, couldn't resume!", static_cast<int>(track->getPrevState()));
-            }
-        }
-        else if (state == Track::State::PAUSED)
-        {
-            initTrack(track, tracksToRemove);
-
-            if (track->getPrevState() == Track::State::PLAYING || track->getPrevState() == Track::State::RESUMED)
-            {
-                _mixer->disable(track->getName());
-            }
-            else
-            {
-                ALOGW("Previous state (%d) isn't PLAYING, couldn't pause!", static_cast<int>(track->getPrevState()));
-            }
-        }
-        else if (state == Track::State::STOPPED)
+        else
         {
-            if (track->isInitialized())
-            {
-                _mixer->deleteTrackName(track->getName());
-            }
-            else
-            {
-                ALOGV("Track (%p) hasn't been initialized yet!", track);
-            }
-            tracksToRemove.push_back(track);
+            // Virtual tracks move on as if they were mixed, in their own sample rate.
+            track->skipFrames((size_t) ((int64_t) _bufferSizeInFrames * track->getSampleRate() / _sampleRate));
         }
+    }
 
+    for (auto&& track : _activeTracks)
+    {
         if (track->isPlayOver())
         {
             if (track->isLoop())
@@ -267,7 +408,7 @@ void AudioMixerController::mixOneFrame()
             else
             {
                 ALOGV("Play over ...");
-                _mixer->deleteTrackName(track->getName());
+                releaseTrack(track);
                 tracksToRemove.push_back(track);
                 track->setState(Track::State::OVER);
             }
@@ -278,7 +419,8 @@ void AudioMixerController::mixOneFrame()
 
     if (hasAvailableTracks)
     {
-        ALOGV_IF(_activeTracks.size() > 8,  "More than 8 active tracks: %d", (int) _activeTracks.size());
+        ALOGV_IF(_activeTracks.size() > 8,  "More than 8 active tracks: %d, virtual: %d", (int) _activeTracks.size(),
+                 (int) (_playingTracks.size() - std::min(_playingTracks.size(), (size_t) AudioMixer::MAX_NUM_TRACKS)));
         _mixer->process(AudioBufferProvider::kInvalidPTS);
     }
     else
@@ -301,8 +443,6 @@ void AudioMixerController::mixOneFrame()
         }
     }
 
-    _activeTracksMutex.unlock();
-
     auto mixEnd = clockNow();
     float mixInterval = intervalInMS(mixStart, mixEnd);
     ALOGV_IF(mixInterval > 1.0f, "Mix a frame waste: %fms", mixInterval);
@@ -331,7 +471,8 @@ void AudioMixerController::resume()
 
 bool AudioMixerController::hasPlayingTacks()
 {
-    std::lock_guard<std::mutex> lk (_activeTracksMutex);
+    takePendingTracks();
+
     if (_activeTracks.empty())
         return false;
 
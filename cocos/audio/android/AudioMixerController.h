@@ -54,7 +54,10 @@ public:
 
     bool init();
 
+    // Thread safe and lock free, the track is mixed from the next frame on.
+    // Returns false if the track is already waiting to be mixed.
     bool addTrack(Track* track);
+    // Has to be invoked in the thread which mixes frames.
     bool hasPlayingTacks();
 
     void pause();
@@ -67,7 +70,11 @@ public:
 
 private:
     void destroy();
-    void initTrack(Track* track, std::vector<Track*>& tracksToRemove);
+    bool initTrack(Track* track, bool isFadeIn);
+    void releaseTrack(Track* track);
+    void rampDownTrack(Track* track);
+    void assignVoices();
+    void takePendingTracks();
 
 private:
     int _bufferSizeInFrames;
@@ -76,8 +83,15 @@ private:
 
     AudioMixer* _mixer;
 
-    std::mutex _activeTracksMutex;
+    // Tracks added by other threads are pushed to this lock free list, the mixing thread moves
+    // them to _activeTracks which is only touched by that thread. So play and stop never block
+    // the mixer and the mixer never blocks them.
+    std::atomic<Track*> _pendingTracks;
     std::vector<Track*> _activeTracks;
+    std::vector<Track*> _tracksToRemove;
+    // Playing tracks of the current frame, the first AudioMixer::MAX_NUM_TRACKS ones are mixed,
+    // the others are virtual: they keep their play position without being mixed.
+    std::vector<Track*> _playingTracks;
 
     OutputBuffer _mixingBuffer;
 
@@ -0,0 +1,620 @@
+/****************************************************************************
+Copyright (c) 2018 Xiamen Yaji Software Co., Ltd.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#define LOG_TAG "AudioMixerKernels"
+
+#include "audio/android/AudioMixerKernels.h"
+#include "audio/android/audio_utils/include/audio_utils/primitives.h"
+
+//#define USE_NEON          : neon code is always used
+//#define INCLUDE_NEON      : neon code included, used if the cpu supports it
+//#define USE_SSE           : SSE2 code used
+
+#if defined (__arm64__) || defined (__aarch64__)
+#define USE_NEON
+#define INCLUDE_NEON
+#elif defined (__ARM_NEON__)
+#define INCLUDE_NEON
+#include <cpu-features.h>
+#endif
+
+// Application.mk undefines __SSE__ for simulators without SSE, so SSE2 is only used if both are defined.
+#if defined (__SSE__) && defined (__SSE2__)
+#define USE_SSE
+#endif
+
+#ifdef INCLUDE_NEON
+#include <arm_neon.h>
+#endif
+
+#ifdef USE_SSE
+#include <emmintrin.h>
+#endif
+
+namespace cocos2d { namespace experimental {
+
+// Same fixed point layout as AudioResampler and AudioResamplerOrder1
+static const int __linearPhaseBits = 30;
+static const uint32_t __linearPhaseMask = (1LU << __linearPhaseBits) - 1;
+static const int __linearInterpBits = 15;
+static const int __linearPreInterpShift = __linearPhaseBits - __linearInterpBits;
+
+static inline int32_t interpLinear(int32_t x0, int32_t x1, uint32_t f)
+{
+    return x0 + (((x1 - x0) * (int32_t)(f >> __linearPreInterpShift)) >> __linearInterpBits);
+}
+
+// Computes the input frames and phases of the next 4 output frames of the linear resampler.
+// Returns false without advancing if any of them would read beyond inFrameCount.
+static inline bool prepareLinearStereo16(const int16_t* in, size_t* inputIndex, size_t inFrameCount,
+                                         uint32_t* phaseFraction, uint32_t phaseIncrement,
+                                         int32_t* x0, int32_t* x1, int32_t* f)
+{
+    size_t index = *inputIndex;
+    uint32_t frac = *phaseFraction;
+    for (int i = 0; i < 4; ++i)
+    {
+        if (index >= inFrameCount)
+            return false;
+
+        x0[i * 2] = in[index * 2 - 2];
+        x0[i * 2 + 1] = in[index * 2 - 1];
+        x1[i * 2] = in[index * 2];
+        x1[i * 2 + 1] = in[index * 2 + 1];
+        f[i * 2] = f[i * 2 + 1] = (int32_t) (frac >> __linearPreInterpShift);
+
+        frac += phaseIncrement;
+        index += (size_t) (frac >> __linearPhaseBits);
+        frac &= __linearPhaseMask;
+    }
+    *inputIndex = index;
+    *phaseFraction = frac;
+    return true;
+}
+
+// C
+
+static void mixStereo16C(int32_t* out, const int16_t* in, size_t frameCount, int16_t vl, int16_t vr)
+{
+    while (frameCount--)
+    {
+        out[0] = mulAdd(in[0], vl, out[0]);
+        out[1] = mulAdd(in[1], vr, out[1]);
+        in += 2;
+        out += 2;
+    }
+}
+
+static void mixStereo16RampC(int32_t* out, const int16_t* in, size_t frameCount,
+                             int32_t* vl, int32_t* vr, int32_t vlInc, int32_t vrInc)
+{
+    int32_t l = *vl;
+    int32_t r = *vr;
+    while (frameCount--)
+    {
+        *out++ += (l >> 16) * (int32_t) *in++;
+        *out++ += (r >> 16) * (int32_t) *in++;
+        l += vlInc;
+        r += vrInc;
+    }
+    *vl = l;
+    *vr = r;
+}
+
+static void mixStereo32C(int32_t* out, const int32_t* in, size_t frameCount, int16_t vl, int16_t vr)
+{
+    while (frameCount--)
+    {
+        out[0] = mulAdd((int16_t) (in[0] >> 12), vl, out[0]);
+        out[1] = mulAdd((int16_t) (in[1] >> 12), vr, out[1]);
+        in += 2;
+        out += 2;
+    }
+}
+
+static void mixStereo32RampC(int32_t* out, const int32_t* in, size_t frameCount,
+                             int32_t* vl, int32_t* vr, int32_t vlInc, int32_t vrInc)
+{
+    int32_t l = *vl;
+    int32_t r = *vr;
+    while (frameCount--)
+    {
+        *out++ += (l >> 16) * (*in++ >> 12);
+        *out++ += (r >> 16) * (*in++ >> 12);
+        l += vlInc;
+        r += vrInc;
+    }
+    *vl = l;
+    *vr = r;
+}
+
+static void scaleStereo16C(int32_t* out, const int16_t* in, size_t frameCount, int16_t vl, int16_t vr)
+{
+    while (frameCount--)
+    {
+        int32_t l = clamp16(mul(in[0], vl) >> 12);
+        int32_t r = clamp16(mul(in[1], vr) >> 12);
+        in += 2;
+        *out++ = (r << 16) | (l & 0xFFFF);
+    }
+}
+
+static void resampleLinearStereo16C(int32_t* out, size_t* outputIndex, size_t outputSampleCount,
+                                    const int16_t* in, size_t* inputIndex, size_t inFrameCount,
+                                    uint32_t* phaseFraction, uint32_t phaseIncrement,
+                                    int16_t vl, int16_t vr)
+{
+    size_t outIndex = *outputIndex;
+    size_t index = *inputIndex;
+    uint32_t frac = *phaseFraction;
+    while (outIndex < outputSampleCount && index < inFrameCount)
+    {
+        out[outIndex++] += vl * interpLinear(in[index * 2 - 2], in[index * 2], frac);
+        out[outIndex++] += vr * interpLinear(in[index * 2 - 1], in[index * 2 + 1], frac);
+        frac += phaseIncrement;
+        index += (size_t) (frac >> __linearPhaseBits);
+        frac &= __linearPhaseMask;
+    }
+    *outputIndex = outIndex;
+    *inputIndex = index;
+    *phaseFraction = frac;
+}
+
+// NEON, 4 frames per iteration
+
+#ifdef INCLUDE_NEON
+
+static void mixStereo16Neon(int32_t* out, const int16_t* in, size_t frameCount, int16_t vl, int16_t vr)
+{
+    const int16_t volumes[4] = { vl, vr, vl, vr };
+    const int16x4_t volume = vld1_s16(volumes);
+    for (; frameCount >= 4; frameCount -= 4)
+    {
+        int16x8_t samples = vld1q_s16(in);
+        vst1q_s32(out, vmlal_s16(vld1q_s32(out), vget_low_s16(samples), volume));
+        vst1q_s32(out + 4, vmlal_s16(vld1q_s32(out + 4), vget_high_s16(samples), volume));
+        in += 8;
+        out += 8;
+    }
+    mixStereo16C(out, in, frameCount, vl, vr);
+}
+
+static void mixStereo16RampNeon(int32_t* out, const int16_t* in, size_t frameCount,
+                                int32_t* vl, int32_t* vr, int32_t vlInc, int32_t vrInc)
+{
+    if (frameCount >= 4)
+    {
+        const int32_t volumes[4] = { *vl, *vr, *vl + vlInc, *vr + vrInc };
+        const int32_t increments[4] = { vlInc * 2, vrInc * 2, vlInc * 2, vrInc * 2 };
+        int32x4_t volume = vld1q_s32(volumes);
+        const int32x4_t increment = vld1q_s32(increments);
+        for (; frameCount >= 4; frameCount -= 4)
+        {
+            int16x8_t samples = vld1q_s16(in);
+            int32x4_t nextVolume = vaddq_s32(volume, increment);
+            vst1q_s32(out, vmlaq_s32(vld1q_s32(out), vmovl_s16(vget_low_s16(samples)),
+                                     vshrq_n_s32(volume, 16)));
+            vst1q_s32(out + 4, vmlaq_s32(vld1q_s32(out + 4), vmovl_s16(vget_high_s16(samples)),
+                                         vshrq_n_s32(nextVolume, 16)));
+            volume = vaddq_s32(nextVolume, increment);
+            in += 8;
+            out += 8;
+        }
+        *vl = vgetq_lane_s32(volume, 0);
+        *vr = vgetq_lane_s32(volume, 1);
+    }
+    mixStereo16RampC(out, in, frameCount, vl, vr, vlInc, vrInc);
+}
+
+static void mixStereo32Neon(int32_t* out, const int32_t* in, size_t frameCount, int16_t vl, int16_t vr)
+{
+    const int16_t volumes[4] = { vl, vr, vl, vr };
+    const int16x4_t volume = vld1_s16(volumes);
+    for (; frameCount >= 4; frameCount -= 4)
+    {
+        int16x4_t low = vmovn_s32(vshrq_n_s32(vld1q_s32(in), 12));
+        int16x4_t high = vmovn_s32(vshrq_n_s32(vld1q_s32(in + 4), 12));
+        vst1q_s32(out, vmlal_s16(vld1q_s32(out), low, volume));
+        vst1q_s32(out + 4, vmlal_s16(vld1q_s32(out + 4), high, volume));
+        in += 8;
+        out += 8;
+    }
+    mixStereo32C(out, in, frameCount, vl, vr);
+}
+
+static void mixStereo32RampNeon(int32_t* out, const int32_t* in, size_t frameCount,
+                                int32_t* vl, int32_t* vr, int32_t vlInc, int32_t vrInc)
+{
+    if (frameCount >= 4)
+    {
+        const int32_t volumes[4] = { *vl, *vr, *vl + vlInc, *vr + vrInc };
+        const int32_t increments[4] = { vlInc * 2, vrInc * 2, vlInc * 2, vrInc * 2 };
+        int32x4_t volume = vld1q_s32(volumes);
+        const int32x4_t increment = vld1q_s32(increments);
+        for (; frameCount >= 4; frameCount -= 4)
+        {
+            int32x4_t nextVolume = vaddq_s32(volume, increment);
+            vst1q_s32(out, vmlaq_s32(vld1q_s32(out), vshrq_n_s32(vld1q_s32(in), 12),
+                                     vshrq_n_s32(volume, 16)));
+            vst1q_s32(out + 4, vmlaq_s32(vld1q_s32(out + 4), vshrq_n_s32(vld1q_s32(in + 4), 12),
+                                         vshrq_n_s32(nextVolume, 16)));
+            volume = vaddq_s32(nextVolume, increment);
+            in += 8;
+            out += 8;
+        }
+        *vl = vgetq_lane_s32(volume, 0);
+        *vr = vgetq_lane_s32(volume, 1);
+    }
+    mixStereo32RampC(out, in, frameCount, vl, vr, vlInc, vrInc);
+}
+
+static void scaleStereo16Neon(int32_t* out, const int16_t* in, size_t frameCount, int16_t vl, int16_t vr)
+{
+    const int16_t volumes[4] = { vl, vr, vl, vr };
+    const int16x4_t volume = vld1_s16(volumes);
+    for (; frameCount >= 4; frameCount -= 4)
+    {
+        int16x8_t samples = vld1q_s16(in);
+        int16x4_t low = vqshrn_n_s32(vmull_s16(vget_low_s16(samples), volume), 12);
+        int16x4_t high = vqshrn_n_s32(vmull_s16(vget_high_s16(samples), volume), 12);
+        vst1q_s16(reinterpret_cast<int16_t*>(out), vcombine_s16(low, high));
+        in += 8;
+        out += 4;
+    }
+    scaleStereo16C(out, in, frameCount, vl, vr);
+}
+
+static void clampStereo16Neon(int32_t* out, const int32_t* sums, size_t frameCount)
+{
+    for (; frameCount >= 4; frameCount -= 4)
+    {
+        int16x4_t low = vqshrn_n_s32(vld1q_s32(sums), 12);
+        int16x4_t high = vqshrn_n_s32(vld1q_s32(sums + 4), 12);
+        vst1q_s16(reinterpret_cast<int16_t*>(out), vcombine_s16(low, high));
+        sums += 8;
+        out += 4;
+    }
+    ditherAndClamp(out, sums, frameCount);
+}
+
+static void resampleLinearStereo16Neon(int32_t* out, size_t* outputIndex, size_t outputSampleCount,
+                                       const int16_t* in, size_t* inputIndex, size_t inFrameCount,
+                                       uint32_t* phaseFraction, uint32_t phaseIncrement,
+                                       int16_t vl, int16_t vr)
+{
+    const int32_t volumes[4] = { vl, vr, vl, vr };
+    const int32x4_t volume = vld1q_s32(volumes);
+    int32_t x0[8], x1[8], f[8];
+    size_t outIndex = *outputIndex;
+    while (outIndex + 8 <= outputSampleCount
+           && prepareLinearStereo16(in, inputIndex, inFrameCount, phaseFraction, phaseIncrement, x0, x1, f))
+    {
+        for (int i = 0; i < 8; i += 4)
+        {
+            int32x4_t first = vld1q_s32(x0 + i);
+            int32x4_t delta = vmulq_s32(vsubq_s32(vld1q_s32(x1 + i), first), vld1q_s32(f + i));
+            int32x4_t sample = vaddq_s32(first, vshrq_n_s32(delta, __linearInterpBits));
+            vst1q_s32(out + outIndex + i, vmlaq_s32(vld1q_s32(out + outIndex + i), sample, volume));
+        }
+        outIndex += 8;
+    }
+    *outputIndex = outIndex;
+    resampleLinearStereo16C(out, outputIndex, outputSampleCount, in, inputIndex, inFrameCount,
+                            phaseFraction, phaseIncrement, vl, vr);
+}
+
+#endif // INCLUDE_NEON
+
+// SSE2, 4 frames per iteration.
+// Products of two 16-bit values use _mm_madd_epi16 with a zero upper half in one of the operands,
+// SSE2 doesn't have a 32-bit multiply returning the low half.
+
+#ifdef USE_SSE
+
+static inline __m128i mulLow32SSE(__m128i a, __m128i b)
+{
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+static inline __m128i loadSSE(const void* p)
+{
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+static inline void storeSSE(void* p, __m128i v)
+{
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v);
+}
+
+static void mixStereo16SSE(int32_t* out, const int16_t* in, size_t frameCount, int16_t vl, int16_t vr)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i volume = _mm_set_epi16(0, vr, 0, vl, 0, vr, 0, vl);
+    for (; frameCount >= 4; frameCount -= 4)
+    {
+        __m128i samples = loadSSE(in);
+        storeSSE(out, _mm_add_epi32(loadSSE(out), _mm_madd_epi16(_mm_unpacklo_epi16(samples, zero), volume)));
+        storeSSE(out + 4, _mm_add_epi32(loadSSE(out + 4), _mm_madd_epi16(_mm_unpackhi_epi16(samples, zero), volume)));
+        in += 8;
+        out += 8;
+    }
+    mixStereo16C(out, in, frameCount, vl, vr);
+}
+
+static void mixStereo16RampSSE(int32_t* out, const int16_t* in, size_t frameCount,
+                               int32_t* vl, int32_t* vr, int32_t vlInc, int32_t vrInc)
+{
+    if (frameCount >= 4)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i increment = _mm_set_epi32(vrInc * 2, vlInc * 2, vrInc * 2, vlInc * 2);
+        __m128i volume = _mm_set_epi32(*vr + vrInc, *vl + vlInc, *vr, *vl);
+        for (; frameCount >= 4; frameCount -= 4)
+        {
+            __m128i samples = loadSSE(in);
+            __m128i nextVolume = _mm_add_epi32(volume, increment);
+            // The volumes are sign extended from 16 bits, the samples have a zero upper half.
+            storeSSE(out, _mm_add_epi32(loadSSE(out), _mm_madd_epi16(_mm_unpacklo_epi16(samples, zero),
+                                                                      _mm_srai_epi32(volume, 16))));
+            storeSSE(out + 4, _mm_add_epi32(loadSSE(out + 4), _mm_madd_epi16(_mm_unpackhi_epi16(samples, zero),
+                                                                              _mm_srai_epi32(nextVolume, 16))));
+            volume = _mm_add_epi32(nextVolume, increment);
+            in += 8;
+            out += 8;
+        }
+        *vl = _mm_cvtsi128_si32(volume);
+        *vr = _mm_cvtsi128_si32(_mm_srli_si128(volume, 4));
+    }
+    mixStereo16RampC(out, in, frameCount, vl, vr, vlInc, vrInc);
+}
+
+static void mixStereo32SSE(int32_t* out, const int32_t* in, size_t frameCount, int16_t vl, int16_t vr)
+{
+    const __m128i volume = _mm_set_epi16(0, vr, 0, vl, 0, vr, 0, vl);
+    for (; frameCount >= 4; frameCount -= 4)
+    {
+        // (int16_t) (x >> 12), sign extended to 32 bits
+        __m128i low = _mm_srai_epi32(_mm_slli_epi32(loadSSE(in), 4), 16);
+        __m128i high = _mm_srai_epi32(_mm_slli_epi32(loadSSE(in + 4), 4), 16);
+        storeSSE(out, _mm_add_epi32(loadSSE(out), _mm_madd_epi16(low, volume)));
+        storeSSE(out + 4, _mm_add_epi32(loadSSE(out + 4), _mm_madd_epi16(high, volume)));
+        in += 8;
+        out += 8;
+    }
+    mixStereo32C(out, in, frameCount, vl, vr);
+}
+
+static void mixStereo32RampSSE(int32_t* out, const int32_t* in, size_t frameCount,
+                               int32_t* vl, int32_t* vr, int32_t vlInc, int32_t vrInc)
+{
+    if (frameCount >= 4)
+    {
+        const __m128i increment = _mm_set_epi32(vrInc * 2, vlInc * 2, vrInc * 2, vlInc * 2);
+        __m128i volume = _mm_set_epi32(*vr + vrInc, *vl + vlInc, *vr, *vl);
+        for (; frameCount >= 4; frameCount -= 4)
+        {
+            __m128i nextVolume = _mm_add_epi32(volume, increment);
+            __m128i low = mulLow32SSE(_mm_srai_epi32(loadSSE(in), 12), _mm_srai_epi32(volume, 16));
+            __m128i high = mulLow32SSE(_mm_srai_epi32(loadSSE(in + 4), 12), _mm_srai_epi32(nextVolume, 16));
+            storeSSE(out, _mm_add_epi32(loadSSE(out), low));
+            storeSSE(out + 4, _mm_add_epi32(loadSSE(out + 4), high));
+            volume = _mm_add_epi32(nextVolume, increment);
+            in += 8;
+            out += 8;
+        }
+        *vl = _mm_cvtsi128_si32(volume);
+        *vr = _mm_cvtsi128_si32(_mm_srli_si128(volume, 4));
+    }
+    mixStereo32RampC(out, in, frameCount, vl, vr, vlInc, vrInc);
+}
+
+static void scaleStereo16SSE(int32_t* out, const int16_t* in, size_t frameCount, int16_t vl, int16_t vr)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i volume = _mm_set_epi16(0, vr, 0, vl, 0, vr, 0, vl);
+    for (; frameCount >= 4; frameCount -= 4)
+    {
+        __m128i samples = loadSSE(in);
+        __m128i low = _mm_srai_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(samples, zero), volume), 12);
+        __m128i high = _mm_srai_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(samples, zero), volume), 12);
+        storeSSE(out, _mm_packs_epi32(low, high));
+        in += 8;
+        out += 4;
+    }
+    scaleStereo16C(out, in, frameCount, vl, vr);
+}
+
+static void clampStereo16SSE(int32_t* out, const int32_t* sums, size_t frameCount)
+{
+    for (; frameCount >= 4; frameCount -= 4)
+    {
+        __m128i low = _mm_srai_epi32(loadSSE(sums), 12);
+        __m128i high = _mm_srai_epi32(loadSSE(sums + 4), 12);
+        storeSSE(out, _mm_packs_epi32(low, high));
+        sums += 8;
+        out += 4;
+    }
+    ditherAndClamp(out, sums, frameCount);
+}
+
+static void resampleLinearStereo16SSE(int32_t* out, size_t* outputIndex, size_t outputSampleCount,
+                                      const int16_t* in, size_t* inputIndex, size_t inFrameCount,
+                                      uint32_t* phaseFraction, uint32_t phaseIncrement,
+                                      int16_t vl, int16_t vr)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i lowMask = _mm_set1_epi32(0xFFFF);
+    const __m128i volume = _mm_set_epi16(0, vr, 0, vl, 0, vr, 0, vl);
+    int32_t x0[8], x1[8], f[8];
+    size_t outIndex = *outputIndex;
+    while (outIndex + 8 <= outputSampleCount
+           && prepareLinearStereo16(in, inputIndex, inFrameCount, phaseFraction, phaseIncrement, x0, x1, f))
+    {
+        for (int i = 0; i < 8; i += 4)
+        {
+            // (x1 - x0) * f == x1 * f + x0 * -f, with both pairs packed into 16-bit halves
+            __m128i first = loadSSE(x0 + i);
+            __m128i fraction = loadSSE(f + i);
+            __m128i pairs = _mm_or_si128(_mm_and_si128(loadSSE(x1 + i), lowMask), _mm_slli_epi32(first, 16));
+            __m128i weights = _mm_or_si128(fraction, _mm_slli_epi32(_mm_sub_epi32(zero, fraction), 16));
+            __m128i delta = _mm_srai_epi32(_mm_madd_epi16(pairs, weights), __linearInterpBits);
+            __m128i sample = _mm_add_epi32(first, delta);
+            storeSSE(out + outIndex + i, _mm_add_epi32(loadSSE(out + outIndex + i), _mm_madd_epi16(sample, volume)));
+        }
+        outIndex += 8;
+    }
+    *outputIndex = outIndex;
+    resampleLinearStereo16C(out, outputIndex, outputSampleCount, in, inputIndex, inFrameCount,
+                            phaseFraction, phaseIncrement, vl, vr);
+}
+
+#endif // USE_SSE
+
+bool AudioMixerKernels::isNeonEnabled()
+{
+#ifdef USE_NEON
+    return true;
+#elif defined (INCLUDE_NEON)
+    class AndroidNeonChecker
+    {
+    public:
+        AndroidNeonChecker()
+        {
+            if (android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM && (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0)
+                _isNeonEnabled = true;
+            else
+                _isNeonEnabled = false;
+        }
+        bool isNeonEnabled() const { return _isNeonEnabled; }
+    private:
+        bool _isNeonEnabled;
+    };
+    static AndroidNeonChecker checker;
+    return checker.isNeonEnabled();
+#else
+    return false;
+#endif
+}
+
+bool AudioMixerKernels::isSSEEnabled()
+{
+#ifdef USE_SSE
+    return true;
+#else
+    return false;
+#endif
+}
+
+void AudioMixerKernels::mixStereo16(int32_t* out, const int16_t* in, size_t frameCount,
+                                    int16_t vl, int16_t vr)
+{
+#ifdef INCLUDE_NEON
+    if (isNeonEnabled())
+        return mixStereo16Neon(out, in, frameCount, vl, vr);
+#elif defined (USE_SSE)
+    return mixStereo16SSE(out, in, frameCount, vl, vr);
+#endif
+    mixStereo16C(out, in, frameCount, vl, vr);
+}
+
+void AudioMixerKernels::mixStereo16Ramp(int32_t* out, const int16_t* in, size_t frameCount,
+                                        int32_t* vl, int32_t* vr, int32_t vlInc, int32_t vrInc)
+{
+#ifdef INCLUDE_NEON
+    if (isNeonEnabled())
+        return mixStereo16RampNeon(out, in, frameCount, vl, vr, vlInc, vrInc);
+#elif defined (USE_SSE)
+    return mixStereo16RampSSE(out, in, frameCount, vl, vr, vlInc, vrInc);
+#endif
+    mixStereo16RampC(out, in, frameCount, vl, vr, vlInc, vrInc);
+}
+
+void AudioMixerKernels::mixStereo32(int32_t* out, const int32_t* in, size_t frameCount,
+                                    int16_t vl, int16_t vr)
+{
+#ifdef INCLUDE_NEON
+    if (isNeonEnabled())
+        return mixStereo32Neon(out, in, frameCount, vl, vr);
+#elif defined (USE_SSE)
+    return mixStereo32SSE(out, in, frameCount, vl, vr);
+#endif
+    mixStereo32C(out, in, frameCount, vl, vr);
+}
+
+void AudioMixerKernels::mixStereo32Ramp(int32_t* out, const int32_t* in, size_t frameCount,
+                                        int32_t* vl, int32_t* vr, int32_t vlInc, int32_t vrInc)
+{
+#ifdef INCLUDE_NEON
+    if (isNeonEnabled())
+        return mixStereo32RampNeon(out, in, frameCount, vl, vr, vlInc, vrInc);
+#elif defined (USE_SSE)
+    return mixStereo32RampSSE(out, in, frameCount, vl, vr, vlInc, vrInc);
+#endif
+    mixStereo32RampC(out, in, frameCount, vl, vr, vlInc, vrInc);
+}
+
+void AudioMixerKernels::scaleStereo16(int32_t* out, const int16_t* in, size_t frameCount,
+                                      int16_t vl, int16_t vr)
+{
+#ifdef INCLUDE_NEON
+    if (isNeonEnabled())
+        return scaleStereo16Neon(out, in, frameCount, vl, vr);
+#elif defined (USE_SSE)
+    return scaleStereo16SSE(out, in, frameCount, vl, vr);
+#endif
+    scaleStereo16C(out, in, frameCount, vl, vr);
+}
+
+void AudioMixerKernels::clampStereo16(int32_t* out, const int32_t* sums, size_t frameCount)
+{
+#ifdef INCLUDE_NEON
+    if (isNeonEnabled())
+        return clampStereo16Neon(out, sums, frameCount);
+#elif defined (USE_SSE)
+    return clampStereo16SSE(out, sums, frameCount);
+#endif
+    ditherAndClamp(out, sums, frameCount);
+}
+
+void AudioMixerKernels::resampleLinearStereo16(int32_t* out, size_t* outputIndex, size_t outputSampleCount,
+                                               const int16_t* in, size_t* inputIndex, size_t inFrameCount,
+                                               uint32_t* phaseFraction, uint32_t phaseIncrement,
+                                               int16_t vl, int16_t vr)
+{
+#ifdef INCLUDE_NEON
+    if (isNeonEnabled())
+        return resampleLinearStereo16Neon(out, outputIndex, outputSampleCount, in, inputIndex, inFrameCount,
+                                          phaseFraction, phaseIncrement, vl, vr);
+#elif defined (USE_SSE)
+    return resampleLinearStereo16SSE(out, outputIndex, outputSampleCount, in, inputIndex, inFrameCount,
+                                     phaseFraction, phaseIncrement, vl, vr);
+#endif
+    resampleLinearStereo16C(out, outputIndex, outputSampleCount, in, inputIndex, inFrameCount,
+                            phaseFraction, phaseIncrement, vl, vr);
+}
+
+}} // namespace cocos2d { namespace experimental {
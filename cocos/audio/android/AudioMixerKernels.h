@@ -0,0 +1,76 @@
+/****************************************************************************
+Copyright (c) 2018 Xiamen Yaji Software Co., Ltd.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace cocos2d { namespace experimental {
+
+// Inner loops of the 16-bit stereo mixer, with NEON and SSE2 versions.
+// The implementation is chosen at runtime: NEON on arm64, NEON on armv7 if the cpu supports it,
+// SSE2 on x86 unless SSE was disabled for the build. Every version gives the same output as the
+// plain C loops they replace, bit for bit.
+// Volumes are U4.12 fixed point, ramped volumes are U4.28 and only their upper 16 bits are used.
+class AudioMixerKernels
+{
+public:
+    // out[i] += in[i] * volume
+    static void mixStereo16(int32_t* out, const int16_t* in, size_t frameCount,
+                            int16_t vl, int16_t vr);
+
+    // out[i] += (volume >> 16) * in[i], volumes are advanced by their increments after each frame
+    // and the final volumes are stored back to vl and vr.
+    static void mixStereo16Ramp(int32_t* out, const int16_t* in, size_t frameCount,
+                                int32_t* vl, int32_t* vr, int32_t vlInc, int32_t vrInc);
+
+    // Mixes resampled Q4.27 samples: out[i] += (int16_t) (in[i] >> 12) * volume
+    static void mixStereo32(int32_t* out, const int32_t* in, size_t frameCount,
+                            int16_t vl, int16_t vr);
+
+    // out[i] += (volume >> 16) * (in[i] >> 12), volumes are ramped like mixStereo16Ramp.
+    static void mixStereo32Ramp(int32_t* out, const int32_t* in, size_t frameCount,
+                                int32_t* vl, int32_t* vr, int32_t vlInc, int32_t vrInc);
+
+    // Writes clamp16(in[i] * volume >> 12) as packed 16-bit stereo frames.
+    static void scaleStereo16(int32_t* out, const int16_t* in, size_t frameCount,
+                              int16_t vl, int16_t vr);
+
+    // Converts Q4.27 sums to packed 16-bit stereo frames with clamping, same as ditherAndClamp.
+    static void clampStereo16(int32_t* out, const int32_t* sums, size_t frameCount);
+
+    // General case of the linear stereo resampler: interpolates between in[inputIndex - 1] and
+    // in[inputIndex] and mixes the result into out until either outputSampleCount samples were
+    // written or inputIndex reaches inFrameCount. inputIndex has to be at least 1.
+    static void resampleLinearStereo16(int32_t* out, size_t* outputIndex, size_t outputSampleCount,
+                                       const int16_t* in, size_t* inputIndex, size_t inFrameCount,
+                                       uint32_t* phaseFraction, uint32_t phaseIncrement,
+                                       int16_t vl, int16_t vr);
+
+    static bool isNeonEnabled();
+    static bool isSSEEnabled();
+};
+
+}} // namespace cocos2d { namespace experimental {
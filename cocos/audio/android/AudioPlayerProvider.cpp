@@ -33,6 +33,7 @@ THE SOFTWARE.
 #include "audio/android/AudioDecoderProvider.h"
 #include "audio/android/AudioMixerController.h"
 #include "audio/android/PcmAudioService.h"
+#include "audio/android/PcmStream.h"
 #include "audio/android/ICallerThreadUtils.h"
 #include "audio/android/utils/Utils.h"
 
@@ -76,6 +77,12 @@ static AudioFileIndicator __audioFileIndicator[] = {
         {".mp3",    160000}
 };
 
+// Decoded pcm data of preloaded effects is limited by this budget.
+static const size_t __pcmCacheDefaultBudget = 32 * 1024 * 1024;
+// Effects whose decoded pcm data is larger than this are streamed instead of decoded at once,
+// it's about 6 seconds of 44.1kHz stereo audio.
+static const size_t __pcmStreamThreshold = 1024 * 1024;
+
 AudioPlayerProvider::AudioPlayerProvider(SLEngineItf engineItf, SLObjectItf outputMixObject,
                                          int deviceSampleRate, int bufferSizeInFrames,
                                          const FdGetterCallback &fdGetterCallback,
@@ -83,8 +90,10 @@ AudioPlayerProvider::AudioPlayerProvider(SLEngineItf engineItf, SLObjectItf outp
         : _engineItf(engineItf), _outputMixObject(outputMixObject),
           _deviceSampleRate(deviceSampleRate), _bufferSizeInFrames(bufferSizeInFrames),
           _fdGetterCallback(fdGetterCallback), _callerThreadUtils(callerThreadUtils),
+          _pcmCache(__pcmCacheDefaultBudget),
           _pcmAudioService(nullptr), _mixController(nullptr),
-          _threadPool(ThreadPool::newCachedThreadPool(1, 8, 5, 2, 2))
+          _threadPool(ThreadPool::newCachedThreadPool(1, 8, 5, 2, 2)),
+          _streamScheduler(new (std::nothrow) PcmStreamScheduler(_threadPool))
 {
     ALOGI("deviceSampleRate: %d, bufferSizeInFrames: %d", _deviceSampleRate, _bufferSizeInFrames);
     if (getSystemAPILevel() >= 17)
@@ -105,6 +114,7 @@ AudioPlayerProvider::~AudioPlayerProvider()
 
     SL_SAFE_DELETE(_pcmAudioService);
     SL_SAFE_DELETE(_mixController);
+    SL_SAFE_DELETE(_streamScheduler);
     SL_SAFE_DELETE(_threadPool);
 }
 
@@ -124,18 +134,21 @@ IAudioPlayer *AudioPlayerProvider::getAudioPlayer(const std::string &audioFilePa
 
     IAudioPlayer *player = nullptr;
 
-    _pcmCacheMutex.lock();
-    auto iter = _pcmCache.find(audioFilePath);
-    if (iter != _pcmCache.end())
+    PcmData cachedPcmData;
+    if (findPreloadedEffect(audioFilePath, &cachedPcmData))
     {// Found pcm cache means it was used to be a PcmAudioService
-        PcmData pcmData = iter->second;
-        _pcmCacheMutex.unlock();
-        player = obtainPcmAudioPlayer(audioFilePath, pcmData);
+        if (cachedPcmData.isValid())
+        {
+            player = obtainPcmAudioPlayer(audioFilePath, cachedPcmData);
+        }
+        else
+        {
+            player = createStreamingPcmAudioPlayer(audioFilePath);
+        }
         ALOGV_IF(player == nullptr, "%s, %d: player is nullptr, path: %s", __FUNCTION__, __LINE__, audioFilePath.c_str());
     }
     else
     {
-        _pcmCacheMutex.unlock();
         // Check audio file size to determine to use a PcmAudioService or UrlAudioPlayer,
         // generally PcmAudioService is used for playing short audio like game effects while
         // playing background music uses UrlAudioPlayer
@@ -182,7 +195,9 @@ IAudioPlayer *AudioPlayerProvider::getAudioPlayer(const std::string &audioFilePa
                     }
                     else
                     {
-                        ALOGE("pcm data is invalid, path: %s", audioFilePath.c_str());
+                        // Succeed without pcm data means the clip is too long to be decoded at once
+                        player = createStreamingPcmAudioPlayer(info.url);
+                        ALOGE_IF(player == nullptr, "Couldn't stream audio, path: %s", audioFilePath.c_str());
                     }
                 }
                 else
@@ -216,16 +231,13 @@ void AudioPlayerProvider::preloadEffect(const std::string &audioFilePath, const
         return;
     }
 
-    _pcmCacheMutex.lock();
-    auto&& iter = _pcmCache.find(audioFilePath);
-    if (iter != _pcmCache.end())
+    PcmData cachedPcmData;
+    if (findPreloadedEffect(audioFilePath, &cachedPcmData))
     {
         ALOGV("preload return from cache: (%s)", audioFilePath.c_str());
-        _pcmCacheMutex.unlock();
-        cb(true, iter->second);
+        cb(true, cachedPcmData);
         return;
     }
-    _pcmCacheMutex.unlock();
 
     auto info = getFileInfo(audioFilePath);
     preloadEffect(info, [this, cb, audioFilePath](bool succeed, PcmData data){
@@ -253,16 +265,13 @@ void AudioPlayerProvider::preloadEffect(const AudioFileInfo &info, const Preload
         std::string audioFilePath = info.url;
 
         // 1. First time check, if it wasn't in the cache, goto 2 step
-        _pcmCacheMutex.lock();
-        auto&& iter = _pcmCache.find(audioFilePath);
-        if (iter != _pcmCache.end())
+        PcmData cachedPcmData;
+        if (findPreloadedEffect(audioFilePath, &cachedPcmData))
         {
             ALOGV("1. Return pcm data from cache, url: %s", info.url.c_str());
-            _pcmCacheMutex.unlock();
-            cb(true, iter->second);
+            cb(true, cachedPcmData);
             return;
         }
-        _pcmCacheMutex.unlock();
 
         {
             // 2. Check whether the audio file is being preloaded, if it has been removed from map just now,
@@ -282,16 +291,12 @@ void AudioPlayerProvider::preloadEffect(const AudioFileInfo &info, const Preload
 
             // 3. Check it in cache again. If it has been removed from map just now, the file is in
             // the cache absolutely.
-            _pcmCacheMutex.lock();
-            auto&& iter = _pcmCache.find(audioFilePath);
-            if (iter != _pcmCache.end())
+            if (findPreloadedEffect(audioFilePath, &cachedPcmData))
             {
                 ALOGV("2. Return pcm data from cache, url: %s", info.url.c_str());
-                _pcmCacheMutex.unlock();
-                cb(true, iter->second);
+                cb(true, cachedPcmData);
                 return;
             }
-            _pcmCacheMutex.unlock();
 
             PreloadCallbackParam param;
             param.callback = cb;
@@ -305,14 +310,28 @@ void AudioPlayerProvider::preloadEffect(const AudioFileInfo &info, const Preload
             ALOGV("AudioPlayerProvider::preloadEffect: (%s)", audioFilePath.c_str());
             PcmData d;
             AudioDecoder* decoder = AudioDecoderProvider::createAudioDecoder(_engineItf, audioFilePath, _bufferSizeInFrames, _deviceSampleRate, _fdGetterCallback);
-            bool ret = decoder != nullptr && decoder->start();
-            if (ret)
+            bool ret = decoder != nullptr;
+            if (ret && decoder->openStream() && isLongClip(decoder->getResult()))
             {
-                d = decoder->getResult();
+                // Don't decode the whole clip, it will be decoded piece by piece while playing
+                ALOGV("(%s) is too long, stream it instead of decoding at once", audioFilePath.c_str());
+                decoder->closeStream();
                 std::lock_guard<std::mutex> lk(_pcmCacheMutex);
-                _pcmCache.insert(std::make_pair(audioFilePath, d));
+                _streamingUrls.insert(audioFilePath);
             }
-            else
+            else if (ret)
+            {
+                decoder->closeStream();
+                ret = decoder->start();
+                if (ret)
+                {
+                    d = decoder->getResult();
+                    std::lock_guard<std::mutex> lk(_pcmCacheMutex);
+                    _pcmCache.put(audioFilePath, d);
+                }
+            }
+
+            if (!ret)
             {
                 ALOGE("decode (%s) failed!", audioFilePath.c_str());
             }
@@ -325,10 +344,9 @@ void AudioPlayerProvider::preloadEffect(const AudioFileInfo &info, const Preload
             {
                 auto&& params = preloadIter->second;
                 ALOGV("preload (%s) callback count: %d", audioFilePath.c_str(), (int)params.size());
-                PcmData result = decoder->getResult();
                 for (auto&& param : params)
                 {
-                    param.callback(ret, result);
+                    param.callback(ret, d);
                     if (param.isPreloadInPlay2d)
                     {
                         _preloadWaitCond.notify_one();
@@ -431,14 +449,42 @@ bool AudioPlayerProvider::isSmallFile(const AudioFileInfo &info)
     return info.length < __audioFileIndicator[0].smallSizeIndicator;
 }
 
+bool AudioPlayerProvider::isLongClip(const PcmData &pcmData)
+{
+    if (pcmData.sampleRate <= 0 || pcmData.numFrames <= 0)
+        return false;
+
+    // Decoded pcm data is resampled to the device sample rate and converted to 16 bits stereo
+    int64_t outputFrames = (int64_t) pcmData.numFrames * _deviceSampleRate / pcmData.sampleRate;
+    return outputFrames * 2 * sizeof(int16_t) > __pcmStreamThreshold;
+}
+
+bool AudioPlayerProvider::findPreloadedEffect(const std::string &audioFilePath, PcmData *outData)
+{
+    std::lock_guard<std::mutex> lk(_pcmCacheMutex);
+    if (_pcmCache.get(audioFilePath, outData))
+    {
+        return true;
+    }
+
+    if (_streamingUrls.find(audioFilePath) != _streamingUrls.end())
+    {
+        // Streamed clips are preloaded without pcm data
+        outData->reset();
+        return true;
+    }
+
+    return false;
+}
+
 void AudioPlayerProvider::clearPcmCache(const std::string &audioFilePath)
 {
     std::lock_guard<std::mutex> lk(_pcmCacheMutex);
-    auto iter = _pcmCache.find(audioFilePath);
-    if (iter != _pcmCache.end())
+    bool isRemoved = _pcmCache.remove(audioFilePath);
+    isRemoved = _streamingUrls.erase(audioFilePath) > 0 || isRemoved;
+    if (isRemoved)
     {
         ALOGV("clear pcm cache: (%s)", audioFilePath.c_str());
-        _pcmCache.erase(iter);
     }
     else
     {
@@ -450,6 +496,13 @@ void AudioPlayerProvider::clearAllPcmCaches()
 {
     std::lock_guard<std::mutex> lk(_pcmCacheMutex);
     _pcmCache.clear();
+    _streamingUrls.clear();
+}
+
+void AudioPlayerProvider::setPcmCacheBudget(size_t budgetInBytes)
+{
+    std::lock_guard<std::mutex> lk(_pcmCacheMutex);
+    _pcmCache.setBudget(budgetInBytes);
 }
 
 PcmAudioPlayer *AudioPlayerProvider::obtainPcmAudioPlayer(const std::string &url,
@@ -471,6 +524,30 @@ PcmAudioPlayer *AudioPlayerProvider::obtainPcmAudioPlayer(const std::string &url
     return pcmPlayer;
 }
 
+PcmAudioPlayer *AudioPlayerProvider::createStreamingPcmAudioPlayer(const std::string &url)
+{
+    AudioDecoder* decoder = AudioDecoderProvider::createAudioDecoder(_engineItf, url, _bufferSizeInFrames, _deviceSampleRate, _fdGetterCallback);
+    if (decoder == nullptr || !decoder->openStream())
+    {
+        ALOGE("createStreamingPcmAudioPlayer failed, couldn't open stream: %s", url.c_str());
+        AudioDecoderProvider::destroyAudioDecoder(&decoder);
+        return nullptr;
+    }
+
+    auto stream = PcmStream::create(decoder, _streamScheduler);
+    if (stream == nullptr)
+    {
+        return nullptr;
+    }
+
+    PcmAudioPlayer *pcmPlayer = new(std::nothrow) PcmAudioPlayer(_mixController, _callerThreadUtils);
+    if (pcmPlayer != nullptr)
+    {
+        pcmPlayer->prepare(url, stream);
+    }
+    return pcmPlayer;
+}
+
 UrlAudioPlayer *AudioPlayerProvider::createUrlAudioPlayer(
         const AudioPlayerProvider::AudioFileInfo &info)
 {
@@ -480,6 +557,12 @@ UrlAudioPlayer *AudioPlayerProvider::createUrlAudioPlayer(
         return nullptr;
     }
 
+    if (UrlAudioPlayer::getInstanceCount() >= UrlAudioPlayer::MAX_INSTANCES)
+    {
+        ALOGE("createUrlAudioPlayer failed, there're already %d UrlAudioPlayers!", UrlAudioPlayer::MAX_INSTANCES);
+        return nullptr;
+    }
+
     SLuint32 locatorType = info.assetFd->getFd() > 0 ? SL_DATALOCATOR_ANDROIDFD : SL_DATALOCATOR_URI;
     auto urlPlayer = new (std::nothrow) UrlAudioPlayer(_engineItf, _outputMixObject, _callerThreadUtils);
     bool ret = urlPlayer->prepare(info.url, locatorType, info.assetFd, info.start, info.length);
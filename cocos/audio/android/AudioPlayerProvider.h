@@ -28,8 +28,10 @@ THE SOFTWARE.
 #include "audio/android/IAudioPlayer.h"
 #include "audio/android/OpenSLHelper.h"
 #include "audio/android/PcmData.h"
+#include "audio/android/PcmCache.h"
 
 #include <unordered_map>
+#include <unordered_set>
 #include <memory>
 #include <condition_variable>
 
@@ -43,6 +45,7 @@ class AudioMixerController;
 class ICallerThreadUtils;
 class AssetFd;
 class ThreadPool;
+class PcmStreamScheduler;
 
 class AudioPlayerProvider
 {
@@ -62,6 +65,9 @@ public:
 
     void clearAllPcmCaches();
 
+    // Limits the memory used by decoded pcm data of preloaded effects
+    void setPcmCacheBudget(size_t budgetInBytes);
+
     void pause();
 
     void resume();
@@ -87,6 +93,8 @@ private:
 
     PcmAudioPlayer *obtainPcmAudioPlayer(const std::string &url, const PcmData &pcmData);
 
+    PcmAudioPlayer *createStreamingPcmAudioPlayer(const std::string &url);
+
     UrlAudioPlayer *createUrlAudioPlayer(const AudioFileInfo &info);
 
     void preloadEffect(const AudioFileInfo &info, const PreloadCallback& cb, bool isPreloadInPlay2d);
@@ -95,6 +103,10 @@ private:
 
     bool isSmallFile(const AudioFileInfo &info);
 
+    bool isLongClip(const PcmData &pcmData);
+
+    bool findPreloadedEffect(const std::string &audioFilePath, PcmData *outData);
+
 private:
     SLEngineItf _engineItf;
     SLObjectItf _outputMixObject;
@@ -103,7 +115,9 @@ private:
     FdGetterCallback _fdGetterCallback;
     ICallerThreadUtils* _callerThreadUtils;
 
-    std::unordered_map<std::string, PcmData> _pcmCache;
+    PcmCache _pcmCache;
+    // Long clips which are streamed instead of cached
+    std::unordered_set<std::string> _streamingUrls;
     std::mutex _pcmCacheMutex;
 
     struct PreloadCallbackParam
@@ -122,6 +136,7 @@ private:
     AudioMixerController *_mixController;
 
     ThreadPool* _threadPool;
+    PcmStreamScheduler* _streamScheduler;
 };
 
 }} // namespace cocos2d { namespace experimental {
@@ -27,6 +27,7 @@
 //#include <cutils/properties.h>
 #include "audio/android/audio_utils/include/audio_utils/primitives.h"
 #include "audio/android/AudioResampler.h"
+#include "audio/android/AudioMixerKernels.h"
 //#include "audio/android/AudioResamplerSinc.h"
 #include "audio/android/AudioResamplerCubic.h"
 
@@ -398,13 +399,9 @@ size_t AudioResamplerOrder1::resampleStereo16(int32_t* out, size_t outFrameCount
         }
 #endif  // ASM_ARM_RESAMP1
 
-        while (outputIndex < outputSampleCount && inputIndex < mBuffer.frameCount) {
-            out[outputIndex++] += vl * Interp(in[inputIndex*2-2],
-                    in[inputIndex*2], phaseFraction);
-            out[outputIndex++] += vr * Interp(in[inputIndex*2-1],
-                    in[inputIndex*2+1], phaseFraction);
-            Advance(&inputIndex, &phaseFraction, phaseIncrement);
-        }
+        AudioMixerKernels::resampleLinearStereo16(out, &outputIndex, outputSampleCount,
+                in, &inputIndex, mBuffer.frameCount, &phaseFraction, phaseIncrement,
+                mVolume[0], mVolume[1]);
 
         // ALOGE("loop done - outputIndex=%d, inputIndex=%d", outputIndex, inputIndex);
 
@@ -75,6 +75,9 @@ public:
 
     virtual bool isLoop() const = 0;
 
+    // Players with a higher priority keep a mixer voice when there're more sounds than voices
+    virtual void setPriority(int priority) = 0;
+
     virtual float getDuration() const = 0;
 
     virtual float getPosition() const = 0;
@@ -27,6 +27,7 @@ THE SOFTWARE.
 
 #include "audio/android/cutils/log.h"
 #include "audio/android/PcmAudioPlayer.h"
+#include "audio/android/PcmStream.h"
 #include "audio/android/AudioMixerController.h"
 #include "audio/android/ICallerThreadUtils.h"
 
@@ -54,7 +55,22 @@ bool PcmAudioPlayer::prepare(const std::string &url, const PcmData &decResult)
     _decResult = decResult;
 
     _track = new (std::nothrow) Track(_decResult);
+    setupTrack();
+    return true;
+}
+
+bool PcmAudioPlayer::prepare(const std::string &url, const std::shared_ptr<PcmStream> &stream)
+{
+    _url = url;
+    _decResult = stream->getPcmData();
+
+    _track = new (std::nothrow) Track(stream);
+    setupTrack();
+    return true;
+}
 
+void PcmAudioPlayer::setupTrack()
+{
     std::thread::id callerThreadId = _callerThreadUtils->getCallerThreadId();
 
     // @note The logic may cause this issue https://github.com/cocos2d/cocos2d-x/issues/17707
@@ -103,8 +119,6 @@ bool PcmAudioPlayer::prepare(const std::string &url, const PcmData &decResult)
     };
 
     setVolume(1.0f);
-
-    return true;
 }
 
 void PcmAudioPlayer::rewind()
@@ -137,6 +151,11 @@ bool PcmAudioPlayer::isLoop() const
     return _track->isLoop();
 }
 
+void PcmAudioPlayer::setPriority(int priority)
+{
+    _track->setPriority(priority);
+}
+
 float PcmAudioPlayer::getDuration() const
 {
     return _decResult.duration;
@@ -33,6 +33,7 @@ namespace cocos2d { namespace experimental {
 
 class ICallerThreadUtils;
 class AudioMixerController;
+class PcmStream;
 
 class PcmAudioPlayer : public IAudioPlayer
 {
@@ -40,6 +41,8 @@ public:
 
     bool prepare(const std::string &url, const PcmData &decResult);
 
+    bool prepare(const std::string &url, const std::shared_ptr<PcmStream> &stream);
+
     // Override Functions Begin
     virtual int getId() const override { return _id; };
 
@@ -69,6 +72,8 @@ public:
 
     virtual bool isLoop() const override;
 
+    virtual void setPriority(int priority) override;
+
     virtual float getDuration() const override;
 
     virtual float getPosition() const override;
@@ -83,6 +88,8 @@ private:
     PcmAudioPlayer(AudioMixerController * controller, ICallerThreadUtils* callerThreadUtils);
     virtual ~PcmAudioPlayer();
 
+    void setupTrack();
+
 private:
     int _id;
     std::string _url;
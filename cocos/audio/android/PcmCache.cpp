@@ -0,0 +1,116 @@
+/****************************************************************************
+Copyright (c) 2018 Xiamen Yaji Software Co., Ltd.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#define LOG_TAG "PcmCache"
+
+#include "audio/android/cutils/log.h"
+#include "audio/android/PcmCache.h"
+
+namespace cocos2d { namespace experimental {
+
+PcmCache::PcmCache(size_t budgetInBytes)
+        : _budget(budgetInBytes)
+        , _size(0)
+{
+}
+
+bool PcmCache::get(const std::string &url, PcmData *outData)
+{
+    auto iter = _index.find(url);
+    if (iter == _index.end())
+    {
+        return false;
+    }
+
+    _entries.splice(_entries.begin(), _entries, iter->second);
+    *outData = iter->second->data;
+    return true;
+}
+
+void PcmCache::put(const std::string &url, const PcmData &data)
+{
+    remove(url);
+
+    Entry entry;
+    entry.url = url;
+    entry.data = data;
+    entry.bytes = data.pcmBuffer != nullptr ? data.pcmBuffer->size() : 0;
+
+    _size += entry.bytes;
+    _entries.push_front(std::move(entry));
+    _index[url] = _entries.begin();
+
+    evict();
+}
+
+bool PcmCache::remove(const std::string &url)
+{
+    auto iter = _index.find(url);
+    if (iter == _index.end())
+    {
+        return false;
+    }
+
+    _size -= iter->second->bytes;
+    _entries.erase(iter->second);
+    _index.erase(iter);
+    return true;
+}
+
+void PcmCache::clear()
+{
+    _entries.clear();
+    _index.clear();
+    _size = 0;
+}
+
+void PcmCache::setBudget(size_t budgetInBytes)
+{
+    _budget = budgetInBytes;
+    evict();
+}
+
+void PcmCache::evict()
+{
+    // Skip the most recently used entry, it's the one which was just put or fetched.
+    auto iter = _entries.end();
+    while (_size > _budget && iter != _entries.begin() && std::prev(iter) != _entries.begin())
+    {
+        --iter;
+        if (iter->data.pcmBuffer.use_count() > 1)
+        {
+            continue;
+        }
+
+        ALOGV("Evict pcm cache: (%s), %d bytes", iter->url.c_str(), (int) iter->bytes);
+        _size -= iter->bytes;
+        _index.erase(iter->url);
+        iter = _entries.erase(iter);
+    }
+
+    ALOGV_IF(_size > _budget, "Pcm cache (%d bytes) is over budget (%d bytes), the rest entries are in use",
+             (int) _size, (int) _budget);
+}
+
+}} // namespace cocos2d { namespace experimental {
@@ -0,0 +1,75 @@
+/****************************************************************************
+Copyright (c) 2018 Xiamen Yaji Software Co., Ltd.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#pragma once
+
+#include "audio/android/PcmData.h"
+
+#include <list>
+#include <string>
+#include <unordered_map>
+
+namespace cocos2d { namespace experimental {
+
+// Decoded pcm data of preloaded effects, limited by a memory budget.
+// When the budget is exceeded, the least recently used entries are evicted first.
+// Entries whose pcm buffer is still shared with a track are pinned: evicting them
+// wouldn't release any memory, and the next play would decode the file again.
+// PcmCache isn't thread safe, AudioPlayerProvider guards it with its own mutex.
+class PcmCache
+{
+public:
+    explicit PcmCache(size_t budgetInBytes);
+
+    bool get(const std::string &url, PcmData *outData);
+
+    void put(const std::string &url, const PcmData &data);
+
+    bool remove(const std::string &url);
+
+    void clear();
+
+    void setBudget(size_t budgetInBytes);
+    inline size_t getBudget() const { return _budget; };
+
+    inline size_t getSize() const { return _size; };
+
+private:
+    struct Entry
+    {
+        std::string url;
+        PcmData data;
+        size_t bytes;
+    };
+
+    void evict();
+
+    // The most recently used entry is at the front
+    std::list<Entry> _entries;
+    std::unordered_map<std::string, std::list<Entry>::iterator> _index;
+    size_t _budget;
+    size_t _size;
+};
+
+}} // namespace cocos2d { namespace experimental {
@@ -0,0 +1,340 @@
+/****************************************************************************
+Copyright (c) 2018 Xiamen Yaji Software Co., Ltd.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#define LOG_TAG "PcmStream"
+
+#include "base/CCThreadPool.h"
+#include "audio/android/PcmStream.h"
+#include "audio/android/AudioDecoder.h"
+#include "audio/android/AudioDecoderProvider.h"
+
+#include <algorithm>
+#include <errno.h>
+
+namespace cocos2d { namespace experimental {
+
+// Duration of the ring buffer, decoding is scheduled when less than half of it is buffered.
+static const float __streamBufferDuration = 1.0f;
+// Frames decoded each time before they are published to the mixing thread.
+static const size_t __decodeChunkFrames = 1024;
+
+PcmStreamScheduler::PcmStreamScheduler(ThreadPool* threadPool)
+        : _threadPool(threadPool)
+        , _isQuit(false)
+{
+    sem_init(&_semaphore, 0, 0);
+    _thread = std::thread(&PcmStreamScheduler::run, this);
+}
+
+PcmStreamScheduler::~PcmStreamScheduler()
+{
+    _isQuit = true;
+    sem_post(&_semaphore);
+    if (_thread.joinable())
+    {
+        _thread.join();
+    }
+    sem_destroy(&_semaphore);
+}
+
+void PcmStreamScheduler::addStream(const std::shared_ptr<PcmStream>& stream)
+{
+    std::lock_guard<std::mutex> lk(_streamsMutex);
+    _streams.push_back(stream);
+}
+
+void PcmStreamScheduler::wakeUp()
+{
+    // sem_post doesn't allocate or block, unlike pushing a task
+    sem_post(&_semaphore);
+}
+
+void PcmStreamScheduler::run()
+{
+    std::vector<std::shared_ptr<PcmStream>> streams;
+    while (true)
+    {
+        while (sem_wait(&_semaphore) != 0 && errno == EINTR)
+        {
+        }
+
+        if (_isQuit)
+            break;
+
+        {
+            std::lock_guard<std::mutex> lk(_streamsMutex);
+            auto iter = _streams.begin();
+            while (iter != _streams.end())
+            {
+                auto stream = iter->lock();
+                if (stream == nullptr)
+                {
+                    iter = _streams.erase(iter);
+                    continue;
+                }
+
+                if (stream->_isDecodingRequested.exchange(false))
+                {
+                    streams.push_back(stream);
+                }
+                ++iter;
+            }
+        }
+
+        // Scheduled out of the lock, the last reference of a stream may be released here
+        for (auto& stream : streams)
+        {
+            stream->scheduleDecoding();
+        }
+        streams.clear();
+    }
+}
+
+std::shared_ptr<PcmStream> PcmStream::create(AudioDecoder* decoder, PcmStreamScheduler* scheduler)
+{
+    PcmData pcmData = decoder->getResult();
+    if (!(pcmData.numChannels == 1 || pcmData.numChannels == 2) || pcmData.sampleRate <= 0 || pcmData.numFrames <= 0)
+    {
+        ALOGE("Couldn't stream audio with %d channels, sample rate: %d, frames: %d",
+              pcmData.numChannels, pcmData.sampleRate, pcmData.numFrames);
+        AudioDecoderProvider::destroyAudioDecoder(&decoder);
+        return nullptr;
+    }
+
+    std::shared_ptr<PcmStream> stream(new (std::nothrow) PcmStream(decoder, scheduler));
+    if (stream == nullptr)
+    {
+        AudioDecoderProvider::destroyAudioDecoder(&decoder);
+        return nullptr;
+    }
+
+    scheduler->addStream(stream);
+
+    // Start decoding, so frames are ready before the track is played
+    stream->requestDecoding();
+    return stream;
+}
+
+PcmStream::PcmStream(AudioDecoder* decoder, PcmStreamScheduler* scheduler)
+        : _decoder(decoder)
+        , _scheduler(scheduler)
+        , _pcmData(decoder->getResult())
+        , _decoderChannels(_pcmData.numChannels)
+        , _capacity(0)
+        , _readIndex(0)
+        , _writeIndex(0)
+        , _seekRequest(-1)
+        , _flushIndex(-1)
+        , _seekBase(0)
+        , _position(0)
+        , _isLoop(false)
+        , _isEndOfStream(false)
+        , _isDecoding(false)
+        , _isDecodingRequested(false)
+{
+    _pcmData.numChannels = 2;
+    _pcmData.channelMask = SL_SPEAKER_FRONT_LEFT | SL_SPEAKER_FRONT_RIGHT;
+
+    _capacity = std::max((size_t) (_pcmData.sampleRate * __streamBufferDuration), __decodeChunkFrames * 2);
+    _buffer.resize(_capacity * 2);
+}
+
+PcmStream::~PcmStream()
+{
+    ALOGV("~PcmStream(): %p", this);
+    AudioDecoderProvider::destroyAudioDecoder(&_decoder);
+}
+
+void PcmStream::applyFlush()
+{
+    int64_t flushIndex = _flushIndex.exchange(-1, std::memory_order_acquire);
+    if (flushIndex < 0)
+        return;
+
+    uint64_t readIndex = _readIndex.load(std::memory_order_relaxed);
+    size_t seekBase = (size_t) _seekBase.load(std::memory_order_relaxed);
+    if ((uint64_t) flushIndex >= readIndex)
+    {
+        _readIndex.store((uint64_t) flushIndex, std::memory_order_release);
+        _position = seekBase;
+    }
+    else
+    {
+        // Frames after the seek were consumed together with the old ones already
+        _position = (seekBase + (size_t) (readIndex - flushIndex)) % _pcmData.numFrames;
+    }
+}
+
+size_t PcmStream::acquireFrames(void** data, size_t frames)
+{
+    applyFlush();
+
+    uint64_t readIndex = _readIndex.load(std::memory_order_relaxed);
+    uint64_t writeIndex = _writeIndex.load(std::memory_order_acquire);
+    size_t offset = (size_t) (readIndex % _capacity);
+    size_t available = std::min((size_t) (writeIndex - readIndex), _capacity - offset);
+
+    if (available == 0)
+    {
+        ALOGV_IF(!_isEndOfStream, "Stream (%p) underrun!", this);
+        if (needsDecoding())
+        {
+            requestDecoding();
+        }
+        *data = nullptr;
+        return 0;
+    }
+
+    *data = _buffer.data() + offset * 2;
+    return std::min(available, frames);
+}
+
+void PcmStream::releaseFrames(size_t frames)
+{
+    if (frames == 0)
+        return;
+
+    _readIndex.store(_readIndex.load(std::memory_order_relaxed) + frames, std::memory_order_release);
+    _position = (_position + frames) % _pcmData.numFrames;
+
+    if (needsDecoding())
+    {
+        requestDecoding();
+    }
+}
+
+bool PcmStream::isOver() const
+{
+    // The decoding task clears _isEndOfStream before taking a seek request, so check them in
+    // the reverse order.
+    return _seekRequest < 0 && _isEndOfStream && _flushIndex < 0
+           && _readIndex.load(std::memory_order_relaxed) == _writeIndex.load(std::memory_order_acquire);
+}
+
+void PcmStream::seek(size_t frame)
+{
+    _seekRequest = (int64_t) std::min(frame, (size_t) _pcmData.numFrames - 1);
+    // Seeking may happen in the mixing thread when a track is reset, leave pushing the task to the scheduler
+    requestDecoding();
+}
+
+bool PcmStream::needsDecoding() const
+{
+    if (_seekRequest >= 0)
+        return true;
+
+    if (_isEndOfStream)
+        return false;
+
+    uint64_t buffered = _writeIndex.load(std::memory_order_relaxed) - _readIndex.load(std::memory_order_relaxed);
+    return buffered < _capacity / 2;
+}
+
+void PcmStream::requestDecoding()
+{
+    if (_isDecodingRequested.exchange(true))
+        return;
+
+    _scheduler->wakeUp();
+}
+
+void PcmStream::scheduleDecoding()
+{
+    if (_isDecoding.exchange(true))
+        return;
+
+    auto thiz = shared_from_this();
+    _scheduler->getThreadPool()->pushTask([thiz](int tid){
+        thiz->decode();
+    }, ThreadPool::TaskType::AUDIO, ThreadPool::TaskPriority::HIGH);
+}
+
+void PcmStream::decode()
+{
+    uint64_t writeIndex = _writeIndex.load(std::memory_order_relaxed);
+
+    while (true)
+    {
+        if (_seekRequest >= 0)
+        {
+            _isEndOfStream = false;
+            int64_t frame = _seekRequest.exchange(-1);
+            if (!_decoder->seekStream((int) frame))
+            {
+                ALOGE("Seek stream (%p) to frame %d failed!", this, (int) frame);
+                _isEndOfStream = true;
+            }
+            _seekBase.store(frame, std::memory_order_relaxed);
+            _flushIndex.store((int64_t) writeIndex, std::memory_order_release);
+        }
+
+        if (_isEndOfStream)
+            break;
+
+        uint64_t readIndex = _readIndex.load(std::memory_order_acquire);
+        size_t freeFrames = _capacity - (size_t) (writeIndex - readIndex);
+        if (freeFrames < __decodeChunkFrames)
+            break;
+
+        size_t offset = (size_t) (writeIndex % _capacity);
+        size_t frames = std::min(std::min(freeFrames, _capacity - offset), __decodeChunkFrames);
+        int16_t* out = _buffer.data() + offset * 2;
+
+        int readFrames = _decoder->readStream(out, (int) frames);
+        if (readFrames > 0)
+        {
+            if (_decoderChannels == 1)
+            {
+                // Compose a stereo frame from each mono sample, backwards since it's in place
+                for (int i = readFrames - 1; i >= 0; --i)
+                {
+                    out[i * 2 + 1] = out[i];
+                    out[i * 2] = out[i];
+                }
+            }
+            writeIndex += readFrames;
+            _writeIndex.store(writeIndex, std::memory_order_release);
+        }
+        else if (readFrames == 0 && _isLoop && _decoder->seekStream(0))
+        {
+            // Loop without a gap, the position in the mixing thread wraps around by itself
+            continue;
+        }
+        else
+        {
+            ALOGE_IF(readFrames < 0, "Decode stream (%p) failed!", this);
+            _isEndOfStream = true;
+        }
+    }
+
+    _isDecoding = false;
+
+    // A seek or consumption may come between the last check and clearing the flag
+    if (needsDecoding())
+    {
+        requestDecoding();
+    }
+}
+
+}} // namespace cocos2d { namespace experimental {
@@ -0,0 +1,135 @@
+/****************************************************************************
+Copyright (c) 2018 Xiamen Yaji Software Co., Ltd.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#pragma once
+
+#include "audio/android/PcmData.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <semaphore.h>
+
+namespace cocos2d { namespace experimental {
+
+class AudioDecoder;
+class ThreadPool;
+class PcmStream;
+
+// Pushes the decoding tasks of streams to the thread pool from its own thread. Pushing a task
+// allocates and locks, and may resize the pool, so the audio mixing thread only flags the stream
+// and posts the semaphore of the scheduler instead.
+class PcmStreamScheduler
+{
+public:
+    PcmStreamScheduler(ThreadPool* threadPool);
+    ~PcmStreamScheduler();
+
+    inline ThreadPool* getThreadPool() const { return _threadPool; };
+
+private:
+    friend class PcmStream;
+
+    // Called by PcmStream::create().
+    void addStream(const std::shared_ptr<PcmStream>& stream);
+    // Could be called in any thread, the audio mixing thread included.
+    void wakeUp();
+    void run();
+
+    ThreadPool* _threadPool;
+    std::thread _thread;
+    sem_t _semaphore;
+    std::atomic_bool _isQuit;
+
+    std::mutex _streamsMutex;
+    std::vector<std::weak_ptr<PcmStream>> _streams;
+};
+
+// Provides the frames of a long audio file which is decoded piece by piece instead of all at once.
+// Decoded frames are kept in a ring buffer of about one second. Decoding tasks in the thread pool
+// produce them and the audio mixing thread consumes them, so neither side waits for the other.
+// Frames are always 16 bits stereo in the sample rate of the file, the mixer resamples them.
+class PcmStream : public std::enable_shared_from_this<PcmStream>
+{
+public:
+    // Takes the ownership of the decoder, whose stream should be opened already.
+    // Returns nullptr and destroys the decoder if the stream couldn't be played.
+    static std::shared_ptr<PcmStream> create(AudioDecoder* decoder, PcmStreamScheduler* scheduler);
+
+    ~PcmStream();
+
+    inline const PcmData& getPcmData() const { return _pcmData; };
+
+    // Called in the audio mixing thread only.
+    // Returns the number of contiguous frames available, which may be less than requested.
+    size_t acquireFrames(void** data, size_t frames);
+    void releaseFrames(size_t frames);
+    bool isOver() const;
+
+    // Could be called in any thread.
+    void seek(size_t frame);
+    inline size_t getPosition() const { return _position; };
+    inline void setLoop(bool isLoop) { _isLoop = isLoop; };
+
+private:
+    friend class PcmStreamScheduler;
+
+    PcmStream(AudioDecoder* decoder, PcmStreamScheduler* scheduler);
+
+    bool needsDecoding() const;
+    // Could be called in any thread, the scheduler pushes the decoding task later.
+    void requestDecoding();
+    // Called in the scheduler thread only, so the thread pool has a single producer.
+    void scheduleDecoding();
+    void decode();
+    void applyFlush();
+
+    AudioDecoder* _decoder;
+    PcmStreamScheduler* _scheduler;
+    PcmData _pcmData;
+    int _decoderChannels;
+
+    std::vector<int16_t> _buffer;
+    size_t _capacity; // in frames
+
+    // Frame counters which only grow, the ring buffer offset is the counter modulo _capacity.
+    std::atomic<uint64_t> _readIndex;
+    std::atomic<uint64_t> _writeIndex;
+
+    // A seek makes the decoding task publish the write index at the time of seeking, the frames
+    // before it are dropped by the mixing thread.
+    std::atomic<int64_t> _seekRequest;
+    std::atomic<int64_t> _flushIndex;
+    std::atomic<int64_t> _seekBase;
+
+    std::atomic<size_t> _position;
+    std::atomic_bool _isLoop;
+    std::atomic_bool _isEndOfStream;
+    std::atomic_bool _isDecoding;
+    std::atomic_bool _isDecodingRequested;
+};
+
+}} // namespace cocos2d { namespace experimental {
@@ -27,8 +27,10 @@ THE SOFTWARE.
 
 #include "audio/android/cutils/log.h"
 #include "audio/android/Track.h"
+#include "audio/android/PcmStream.h"
 
 #include <math.h>
+#include <algorithm>
 
 namespace cocos2d { namespace experimental {
 
@@ -43,10 +45,39 @@ Track::Track(const PcmData &pcmData)
         , _isLoop(false)
         , _isInitialized(false)
         , _isAudioFocus(true)
+        , _priority(0)
+        , _audibility(0.0f)
+        , _isVirtual(false)
+        , _isReleasing(false)
+        , _nextPendingTrack(nullptr)
+        , _isPending(false)
 {
     init(_pcmData.pcmBuffer->data(), _pcmData.numFrames, _pcmData.bitsPerSample / 8 * _pcmData.numChannels);
 }
 
+Track::Track(const std::shared_ptr<PcmStream> &stream)
+        : onStateChanged(nullptr)
+        , _pcmData(stream->getPcmData())
+        , _stream(stream)
+        , _prevState(State::IDLE)
+        , _state(State::IDLE)
+        , _name(-1)
+        , _volume(1.0f)
+        , _isVolumeDirty(true)
+        , _isLoop(false)
+        , _isInitialized(false)
+        , _isAudioFocus(true)
+        , _priority(0)
+        , _audibility(0.0f)
+        , _isVirtual(false)
+        , _isReleasing(false)
+        , _nextPendingTrack(nullptr)
+        , _isPending(false)
+{
+    _numFrames = _pcmData.numFrames;
+    _frameSize = _pcmData.bitsPerSample / 8 * _pcmData.numChannels;
+}
+
 Track::~Track()
 {
     ALOGV("~Track(): %p", this);
@@ -59,16 +90,99 @@ gain_minifloat_packed_t Track::getVolumeLR()
     return gain_minifloat_pack(v, v);
 }
 
+bool Track::isPlayOver() const
+{
+    if (_state != State::PLAYING)
+        return false;
+
+    if (_stream != nullptr)
+        return _stream->isOver();
+
+    return _nextFrame >= _numFrames;
+}
+
+status_t Track::getNextBuffer(Buffer *buffer, int64_t pts/* = kInvalidPTS*/)
+{
+    if (_stream == nullptr)
+        return PcmBufferProvider::getNextBuffer(buffer, pts);
+
+    buffer->frameCount = _stream->acquireFrames(&buffer->raw, buffer->frameCount);
+    _unrel = buffer->frameCount;
+    return buffer->frameCount > 0 ? NO_ERROR : NOT_ENOUGH_DATA;
+}
+
+void Track::releaseBuffer(Buffer *buffer)
+{
+    if (_stream == nullptr)
+    {
+        PcmBufferProvider::releaseBuffer(buffer);
+        return;
+    }
+
+    _stream->releaseFrames(std::min(buffer->frameCount, _unrel));
+    _unrel = 0;
+    buffer->frameCount = 0;
+    buffer->raw = nullptr;
+}
+
+void Track::skipFrames(size_t frames)
+{
+    if (_stream == nullptr)
+    {
+        _nextFrame = std::min(_nextFrame + frames, _numFrames);
+        return;
+    }
+
+    // Drop decoded frames, so the stream keeps its position and decoding pace
+    void* data = nullptr;
+    while (frames > 0)
+    {
+        size_t acquired = _stream->acquireFrames(&data, frames);
+        if (acquired == 0)
+            break;
+        _stream->releaseFrames(acquired);
+        frames -= acquired;
+    }
+}
+
+void Track::reset()
+{
+    if (_stream != nullptr)
+    {
+        _stream->seek(0);
+        return;
+    }
+
+    PcmBufferProvider::reset();
+}
+
+void Track::setLoop(bool isLoop)
+{
+    _isLoop = isLoop;
+    if (_stream != nullptr)
+    {
+        _stream->setLoop(isLoop);
+    }
+}
+
 bool Track::setPosition(float pos)
 {
-    _nextFrame = (size_t) (pos * _numFrames / _pcmData.duration);
+    size_t frame = (size_t) (pos * _numFrames / _pcmData.duration);
+    if (_stream != nullptr)
+    {
+        _stream->seek(frame);
+        return true;
+    }
+
+    _nextFrame = frame;
     _unrel = 0;
     return true;
 }
 
 float Track::getPosition() const
 {
-    return _nextFrame * _pcmData.duration / _numFrames;
+    size_t frame = _stream != nullptr ? _stream->getPosition() : _nextFrame;
+    return frame * _pcmData.duration / _numFrames;
 }
 
 void Track::setVolume(float volume)
@@ -29,11 +29,15 @@ THE SOFTWARE.
 #include "audio/android/IVolumeProvider.h"
 #include "audio/android/PcmBufferProvider.h"
 
+#include <atomic>
 #include <functional>
+#include <memory>
 #include <mutex>
 
 namespace cocos2d { namespace experimental {
 
+class PcmStream;
+
 class Track : public PcmBufferProvider, public IVolumeProvider
 {
 public:
@@ -49,6 +53,8 @@ public:
     };
 
     Track(const PcmData &pcmData);
+    // Plays a long audio file which is decoded piece by piece
+    Track(const std::shared_ptr<PcmStream> &stream);
     virtual ~Track();
 
     inline State getState() const { return _state; };
@@ -56,7 +62,7 @@ public:
 
     inline State getPrevState() const { return _prevState; };
 
-    inline bool isPlayOver() const { return _state == State::PLAYING && _nextFrame >= _numFrames;};
+    bool isPlayOver() const;
     inline void setName(int name) { _name = name; };
     inline int getName() const { return _name; };
 
@@ -70,9 +76,21 @@ public:
 
     virtual gain_minifloat_packed_t getVolumeLR() override ;
 
-    inline void setLoop(bool isLoop) { _isLoop = isLoop; };
+    virtual status_t getNextBuffer(Buffer *buffer, int64_t pts = kInvalidPTS) override ;
+    virtual void releaseBuffer(Buffer *buffer) override ;
+    virtual void reset() override ;
+
+    inline int getSampleRate() const { return _pcmData.sampleRate; };
+
+    void setLoop(bool isLoop);
     inline bool isLoop() const { return _isLoop; };
 
+    inline void setPriority(int priority) { _priority = priority; };
+    inline int getPriority() const { return _priority; };
+
+    // Advances the play position without mixing, used while the track has no mixer voice
+    void skipFrames(size_t frames);
+
     std::function<void(State)> onStateChanged;
 
 private:
@@ -90,6 +108,7 @@ private:
 
 private:
     PcmData _pcmData;
+    std::shared_ptr<PcmStream> _stream;
     State _prevState;
     State _state;
     std::mutex _stateMutex;
@@ -100,6 +119,17 @@ private:
     bool _isLoop;
     bool _isInitialized;
     bool _isAudioFocus;
+    std::atomic_int _priority;
+
+    // Only used by the mixing thread to rank tracks for voices
+    float _audibility;
+    bool _isVirtual;
+    // The track lost its voice and is ramping down to silence, the voice is released in the next frame
+    bool _isReleasing;
+
+    // Link in AudioMixerController's list of tracks waiting to be mixed
+    Track* _nextPendingTrack;
+    std::atomic_bool _isPending;
 
     friend class AudioMixerController;
 };
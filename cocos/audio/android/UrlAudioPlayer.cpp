@@ -397,6 +397,12 @@ bool UrlAudioPlayer::isLoop() const
     return _isLoop;
 }
 
+int UrlAudioPlayer::getInstanceCount()
+{
+    std::lock_guard<std::mutex> lk(__playerContainerMutex);
+    return (int)__playerContainer.size();
+}
+
 void UrlAudioPlayer::stopAll()
 {
     // To avoid break the for loop, we need to copy a new map
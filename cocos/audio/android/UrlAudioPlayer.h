@@ -75,6 +75,9 @@ public:
 
     virtual bool isLoop() const override;
 
+    // UrlAudioPlayer has its own OpenSL ES player, it never competes for a mixer voice
+    virtual void setPriority(int priority) override {};
+
     virtual float getDuration() const override;
 
     virtual float getPosition() const override;
@@ -93,6 +96,11 @@ private:
 
     static void stopAll();
 
+    // Each one holds an OpenSL ES player object and isn't virtualized like PCM tracks,
+    // so they keep a lower limit than MAX_AUDIOINSTANCES.
+    static const int MAX_INSTANCES = 24;
+    static int getInstanceCount();
+
     void destroy();
 
     inline void setState(State state)
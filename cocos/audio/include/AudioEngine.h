@@ -62,6 +62,11 @@ public:
     
     /* Minimum delay in between sounds */
     double minDelay;
+
+    /* Sounds with a higher priority keep playing audibly when there're more sounds than the
+     * platform can mix, among sounds of the same priority the louder ones win.
+     * Only used on Android for now. */
+    int priority;
     
     /**
      * Default constructor
@@ -71,6 +76,7 @@ public:
     AudioProfile()
     : maxInstances(0)
     , minDelay(0.0)
+    , priority(0)
     {
         
     }
@@ -49,7 +49,8 @@ public:
     ~AudioEngineImpl();
 
     bool init();
-    int play2d(const std::string &fileFullPath ,bool loop ,float volume);
+    // priority is only used on Android, where it decides which voices are demoted when there are too many
+    int play2d(const std::string &fileFullPath ,bool loop ,float volume, int priority = 0);
     void setVolume(int audioID,float volume);
     void setLoop(int audioID, bool loop);
     bool pause(int audioID);
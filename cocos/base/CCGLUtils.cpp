@@ -23,6 +23,7 @@
  ****************************************************************************/
 
 #include "CCGLUtils.h"
+#include "base/CCPixelTransform.h"
 #include <stdio.h>
 #include <cfloat>
 #include <cassert>
@@ -422,6 +423,22 @@ void ccFlipYOrPremultiptyAlphaIfNeeded(GLenum format, GLsizei width, GLsizei hei
 {
     if (pixels != nullptr)
     {
+        if (!__unpackFlipY && !__premultiplyAlpha)
+            return;
+
+        // Flip and premultiply 8 bits per channel pixels in one pass.
+        if ((format == GL_RGBA && pixelBytes == (uint32_t)(width * height * 4)) ||
+            (format == GL_RGB && pixelBytes == (uint32_t)(width * height * 3)))
+        {
+            PixelTransform transform;
+            transform.srcFormat = format == GL_RGBA ? PixelTransform::Format::RGBA8888 : PixelTransform::Format::RGB888;
+            transform.dstFormat = transform.srcFormat;
+            transform.flipY = __unpackFlipY;
+            transform.premultiplyAlpha = __premultiplyAlpha;
+            if (ccTransformPixels(transform, (const uint8_t*)pixels, (uint8_t*)pixels, width, height))
+                return;
+        }
+
         if (__unpackFlipY)
         {
             flipPixelsYByFormat((GLubyte*)pixels, format, width, height, pixelBytes);
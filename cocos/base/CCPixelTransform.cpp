@@ -0,0 +1,407 @@
+/****************************************************************************
+Copyright (c) 2018 Xiamen Yaji Software Co., Ltd.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "base/CCPixelTransform.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <utility>
+
+//#define USE_NEON          : neon code is always used
+//#define INCLUDE_NEON      : neon code included, used if the cpu supports it
+//#define USE_SSE           : SSE2 code used
+
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_IOS)
+    #if defined (__arm64__) || defined (__ARM_NEON__)
+    #define USE_NEON
+    #define INCLUDE_NEON
+    #endif
+#elif (CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID)
+    #if defined (__arm64__) || defined (__aarch64__)
+    #define USE_NEON
+    #define INCLUDE_NEON
+    #elif defined (__ARM_NEON__)
+    #define INCLUDE_NEON
+    #endif
+#endif
+
+// Application.mk undefines __SSE__ for simulators without SSE, so SSE2 is only used if both are defined.
+#if defined (__SSE__) && defined (__SSE2__)
+#define USE_SSE
+#endif
+
+#ifdef INCLUDE_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined (INCLUDE_NEON) && !defined (USE_NEON)
+#include "math/MathUtil.h"
+#endif
+
+#ifdef USE_SSE
+#include <emmintrin.h>
+#endif
+
+NS_CC_BEGIN
+
+namespace {
+
+    typedef PixelTransform::Format Format;
+
+    // Same rounding as the lookup table of premultiplyPixels in CCGLUtils: (c * a + 254) / 255,
+    // the division by 255 is exact for every c * a + 254 <= 65279.
+    inline uint32_t premultiply(uint32_t c, uint32_t a)
+    {
+        uint32_t t = c * a + 254;
+        return (t + 1 + (t >> 8)) >> 8;
+    }
+
+    void transformRowC(const PixelTransform& transform, const uint8_t* src, uint8_t* dst, uint32_t width)
+    {
+        bool hasAlpha = transform.srcFormat == Format::RGBA8888;
+        bool isPremultiply = transform.premultiplyAlpha && hasAlpha;
+        uint32_t srcBytesPerPixel = hasAlpha ? 4 : 3;
+        uint16_t* dst16 = (uint16_t*)dst;
+
+        for (uint32_t i = 0; i < width; ++i, src += srcBytesPerPixel)
+        {
+            uint32_t r = src[0];
+            uint32_t g = src[1];
+            uint32_t b = src[2];
+            uint32_t a = hasAlpha ? src[3] : 255;
+
+            if (transform.swapRB)
+                std::swap(r, b);
+
+            if (isPremultiply)
+            {
+                r = premultiply(r, a);
+                g = premultiply(g, a);
+                b = premultiply(b, a);
+            }
+
+            switch (transform.dstFormat)
+            {
+                case Format::RGBA8888:
+                    dst[i * 4] = r;
+                    dst[i * 4 + 1] = g;
+                    dst[i * 4 + 2] = b;
+                    dst[i * 4 + 3] = a;
+                    break;
+                case Format::RGB888:
+                    dst[i * 3] = r;
+                    dst[i * 3 + 1] = g;
+                    dst[i * 3 + 2] = b;
+                    break;
+                case Format::RGB565:
+                    dst16[i] = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+                    break;
+                case Format::RGBA4444:
+                    dst16[i] = ((r & 0xF0) << 8) | ((g & 0xF0) << 4) | (b & 0xF0) | (a >> 4);
+                    break;
+            }
+        }
+    }
+
+#ifdef INCLUDE_NEON
+    inline uint8x8_t premultiplyNeon(uint8x8_t c, uint8x8_t a)
+    {
+        uint16x8_t t = vmlal_u8(vdupq_n_u16(254), c, a);
+        uint16x8_t q = vsraq_n_u16(vaddq_u16(t, vdupq_n_u16(1)), t, 8);
+        return vshrn_n_u16(q, 8);
+    }
+
+    // Handles 8 pixels per iteration, returns the number of pixels done.
+    uint32_t transformRowNeon(const PixelTransform& transform, const uint8_t* src, uint8_t* dst, uint32_t width)
+    {
+        bool hasAlpha = transform.srcFormat == Format::RGBA8888;
+        bool isPremultiply = transform.premultiplyAlpha && hasAlpha;
+        uint32_t i = 0;
+
+        for (; i + 8 <= width; i += 8)
+        {
+            uint8x8_t r, g, b, a;
+            if (hasAlpha)
+            {
+                uint8x8x4_t v = vld4_u8(src + i * 4);
+                r = v.val[0];
+                g = v.val[1];
+                b = v.val[2];
+                a = v.val[3];
+            }
+            else
+            {
+                uint8x8x3_t v = vld3_u8(src + i * 3);
+                r = v.val[0];
+                g = v.val[1];
+                b = v.val[2];
+                a = vdup_n_u8(255);
+            }
+
+            if (transform.swapRB)
+                std::swap(r, b);
+
+            if (isPremultiply)
+            {
+                r = premultiplyNeon(r, a);
+                g = premultiplyNeon(g, a);
+                b = premultiplyNeon(b, a);
+            }
+
+            switch (transform.dstFormat)
+            {
+                case Format::RGBA8888:
+                {
+                    uint8x8x4_t v = {{ r, g, b, a }};
+                    vst4_u8(dst + i * 4, v);
+                    break;
+                }
+                case Format::RGB888:
+                {
+                    uint8x8x3_t v = {{ r, g, b }};
+                    vst3_u8(dst + i * 3, v);
+                    break;
+                }
+                case Format::RGB565:
+                {
+                    // Shift right and insert keeps the high bits of every channel.
+                    uint16x8_t v = vshll_n_u8(r, 8);
+                    v = vsriq_n_u16(v, vshll_n_u8(g, 8), 5);
+                    v = vsriq_n_u16(v, vshll_n_u8(b, 8), 11);
+                    vst1q_u16((uint16_t*)(dst + i * 2), v);
+                    break;
+                }
+                case Format::RGBA4444:
+                {
+                    uint16x8_t v = vshll_n_u8(r, 8);
+                    v = vsriq_n_u16(v, vshll_n_u8(g, 8), 4);
+                    v = vsriq_n_u16(v, vshll_n_u8(b, 8), 8);
+                    v = vsriq_n_u16(v, vshll_n_u8(a, 8), 12);
+                    vst1q_u16((uint16_t*)(dst + i * 2), v);
+                    break;
+                }
+            }
+        }
+        return i;
+    }
+#endif
+
+#ifdef USE_SSE
+    inline __m128i premultiplySSE(__m128i v, __m128i alphaMask)
+    {
+        __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+        __m128i t = _mm_add_epi16(_mm_mullo_epi16(v, a), _mm_set1_epi16(254));
+        __m128i q = _mm_add_epi16(_mm_add_epi16(t, _mm_set1_epi16(1)), _mm_srli_epi16(t, 8));
+        q = _mm_srli_epi16(q, 8);
+        return _mm_or_si128(_mm_and_si128(alphaMask, v), _mm_andnot_si128(alphaMask, q));
+    }
+
+    // Moves the low 16 bits of the 4 32-bit lanes into the low 64 bits.
+    inline __m128i packLow16SSE(__m128i v)
+    {
+        v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(3, 3, 2, 0));
+        v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(3, 3, 2, 0));
+        return _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 3, 2, 0));
+    }
+
+    // Handles 4 RGBA8888 pixels per iteration, returns the number of pixels done.
+    uint32_t transformRowSSE(const PixelTransform& transform, const uint8_t* src, uint8_t* dst, uint32_t width)
+    {
+        if (transform.srcFormat != Format::RGBA8888)
+            return 0;
+
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i alphaMask = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+        const __m128i byte0Mask = _mm_set1_epi32(0xFF);
+        const __m128i byte13Mask = _mm_set1_epi32(0xFF00FF00);
+        uint32_t i = 0;
+
+        for (; i + 4 <= width; i += 4)
+        {
+            __m128i p = _mm_loadu_si128((const __m128i*)(src + i * 4));
+
+            if (transform.swapRB)
+            {
+                p = _mm_or_si128(_mm_and_si128(p, byte13Mask),
+                                 _mm_or_si128(_mm_and_si128(_mm_srli_epi32(p, 16), byte0Mask),
+                                              _mm_slli_epi32(_mm_and_si128(p, byte0Mask), 16)));
+            }
+
+            if (transform.premultiplyAlpha)
+            {
+                __m128i lo = premultiplySSE(_mm_unpacklo_epi8(p, zero), alphaMask);
+                __m128i hi = premultiplySSE(_mm_unpackhi_epi8(p, zero), alphaMask);
+                p = _mm_packus_epi16(lo, hi);
+            }
+
+            switch (transform.dstFormat)
+            {
+                case Format::RGBA8888:
+                    _mm_storeu_si128((__m128i*)(dst + i * 4), p);
+                    break;
+                case Format::RGB565:
+                {
+                    __m128i v = _mm_slli_epi32(_mm_and_si128(p, _mm_set1_epi32(0xF8)), 8);
+                    v = _mm_or_si128(v, _mm_and_si128(_mm_srli_epi32(p, 5), _mm_set1_epi32(0x7E0)));
+                    v = _mm_or_si128(v, _mm_and_si128(_mm_srli_epi32(p, 19), _mm_set1_epi32(0x1F)));
+                    _mm_storel_epi64((__m128i*)(dst + i * 2), packLow16SSE(v));
+                    break;
+                }
+                case Format::RGBA4444:
+                {
+                    __m128i v = _mm_slli_epi32(_mm_and_si128(p, _mm_set1_epi32(0xF0)), 8);
+                    v = _mm_or_si128(v, _mm_and_si128(_mm_srli_epi32(p, 4), _mm_set1_epi32(0xF00)));
+                    v = _mm_or_si128(v, _mm_and_si128(_mm_srli_epi32(p, 16), _mm_set1_epi32(0xF0)));
+                    v = _mm_or_si128(v, _mm_srli_epi32(p, 28));
+                    _mm_storel_epi64((__m128i*)(dst + i * 2), packLow16SSE(v));
+                    break;
+                }
+                default:
+                    return i;
+            }
+        }
+        return i;
+    }
+#endif
+
+    bool isNeonEnabled()
+    {
+#if defined (USE_NEON)
+        return true;
+#elif defined (INCLUDE_NEON)
+        return MathUtil::isNeon32Enabled();
+#else
+        return false;
+#endif
+    }
+
+    void transformRow(const PixelTransform& transform, bool useNeon, const uint8_t* src, uint8_t* dst, uint32_t width)
+    {
+        uint32_t done = 0;
+#if defined (INCLUDE_NEON)
+        if (useNeon)
+            done = transformRowNeon(transform, src, dst, width);
+#elif defined (USE_SSE)
+        CC_UNUSED_PARAM(useNeon);
+        done = transformRowSSE(transform, src, dst, width);
+#else
+        CC_UNUSED_PARAM(useNeon);
+#endif
+
+        if (done < width)
+        {
+            transformRowC(transform,
+                          src + done * ccGetPixelTransformBytesPerPixel(transform.srcFormat),
+                          dst + done * ccGetPixelTransformBytesPerPixel(transform.dstFormat),
+                          width - done);
+        }
+    }
+}
+
+uint32_t ccGetPixelTransformBytesPerPixel(PixelTransform::Format format)
+{
+    switch (format)
+    {
+        case Format::RGBA8888:
+            return 4;
+        case Format::RGB888:
+            return 3;
+        default:
+            return 2;
+    }
+}
+
+bool ccTransformPixels(const PixelTransform& transform, const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height)
+{
+    if (src == nullptr || dst == nullptr)
+        return false;
+
+    if (transform.srcFormat != Format::RGB888 && transform.srcFormat != Format::RGBA8888)
+        return false;
+
+    if (transform.dstFormat == Format::RGB888 && transform.srcFormat != Format::RGB888)
+        return false;
+
+    uint32_t srcBytesPerRow = width * ccGetPixelTransformBytesPerPixel(transform.srcFormat);
+    uint32_t dstBytesPerRow = width * ccGetPixelTransformBytesPerPixel(transform.dstFormat);
+    bool isInPlace = src == dst;
+    if (isInPlace && srcBytesPerRow != dstBytesPerRow)
+        return false;
+
+    if (width == 0 || height == 0)
+        return true;
+
+    bool isRowCopy = transform.srcFormat == transform.dstFormat && !transform.swapRB
+                     && !(transform.premultiplyAlpha && transform.srcFormat == Format::RGBA8888);
+    if (isRowCopy && !transform.flipY)
+    {
+        if (!isInPlace)
+            memcpy(dst, src, (size_t)srcBytesPerRow * height);
+        return true;
+    }
+
+    bool useNeon = isNeonEnabled();
+    auto convertRow = [&](const uint8_t* srcRow, uint8_t* dstRow) {
+        if (isRowCopy)
+            memcpy(dstRow, srcRow, srcBytesPerRow);
+        else
+            transformRow(transform, useNeon, srcRow, dstRow, width);
+    };
+
+    if (!transform.flipY)
+    {
+        for (uint32_t y = 0; y < height; ++y)
+            convertRow(src + (size_t)y * srcBytesPerRow, dst + (size_t)y * dstBytesPerRow);
+    }
+    else if (!isInPlace)
+    {
+        for (uint32_t y = 0; y < height; ++y)
+            convertRow(src + (size_t)(height - 1 - y) * srcBytesPerRow, dst + (size_t)y * dstBytesPerRow);
+    }
+    else
+    {
+        // Converts the pairs of rows which swap their places through a temporary row.
+        uint8_t* tmpRow = (uint8_t*)malloc(dstBytesPerRow);
+        if (tmpRow == nullptr)
+            return false;
+
+        uint32_t top = 0;
+        uint32_t bottom = height - 1;
+        for (; top < bottom; ++top, --bottom)
+        {
+            convertRow(src + (size_t)top * srcBytesPerRow, tmpRow);
+            convertRow(src + (size_t)bottom * srcBytesPerRow, dst + (size_t)top * dstBytesPerRow);
+            memcpy(dst + (size_t)bottom * dstBytesPerRow, tmpRow, dstBytesPerRow);
+        }
+
+        if (top == bottom)
+            convertRow(src + (size_t)top * srcBytesPerRow, dst + (size_t)top * dstBytesPerRow);
+
+        free(tmpRow);
+    }
+
+    return true;
+}
+
+NS_CC_END
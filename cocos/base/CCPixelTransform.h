@@ -0,0 +1,67 @@
+/****************************************************************************
+Copyright (c) 2018 Xiamen Yaji Software Co., Ltd.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include "base/ccMacros.h"
+
+NS_CC_BEGIN
+
+/**
+ * Describes the conversions applied to 8 bits per channel pixels by ccTransformPixels, in one pass.
+ * The order is swizzle, premultiply then packing into the destination format.
+ */
+struct PixelTransform
+{
+    enum class Format : uint8_t
+    {
+        RGB888,
+        RGBA8888,
+        RGB565,
+        RGBA4444
+    };
+
+    // RGB888 or RGBA8888
+    Format srcFormat = Format::RGBA8888;
+    // Destination pixels are RGB888 only if the source pixels are too.
+    Format dstFormat = Format::RGBA8888;
+    // Reverses the order of the rows, like UNPACK_FLIP_Y_WEBGL.
+    bool flipY = false;
+    // Multiplies the color channels by alpha, like UNPACK_PREMULTIPLY_ALPHA_WEBGL.
+    bool premultiplyAlpha = false;
+    // Swaps the red and blue channels, BGRA8888 to RGBA8888 for example.
+    bool swapRB = false;
+};
+
+uint32_t ccGetPixelTransformBytesPerPixel(PixelTransform::Format format);
+
+/**
+ * Converts width * height tightly packed pixels from src into dst.
+ * dst may be src if both formats have the same size, rows are flipped in place then.
+ * Returns false if the formats aren't supported.
+ */
+bool ccTransformPixels(const PixelTransform& transform, const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height);
+
+NS_CC_END
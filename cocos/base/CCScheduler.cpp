@@ -27,8 +27,9 @@ THE SOFTWARE.
 ****************************************************************************/
 #include "base/CCScheduler.h"
 #include "base/ccMacros.h"
-#include "base/utlist.h"
-#include "base/ccCArray.h"
+
+#include <chrono>
+#include <climits>
 
 #define CC_REPEAT_FOREVER (UINT_MAX -1)
 
@@ -36,36 +37,14 @@ NS_CC_BEGIN
 
 // data structures
 
-// A list double-linked list used for "updates with priority"
-typedef struct _listEntry
-{
-    struct _listEntry   *prev, *next;
-    ccSchedulerFunc     callback;
-    void                *target;
-    int                 priority;
-    bool                paused;
-    bool                markedForDeletion; // selector will no longer be called and entry will be removed at end of the next tick
-} tListEntry;
-
-typedef struct _hashUpdateEntry
-{
-    tListEntry          **list;        // Which list does it belong to ?
-    tListEntry          *entry;        // entry in the list
-    void                *target;
-    ccSchedulerFunc     callback;
-    UT_hash_handle      hh;
-} tHashUpdateEntry;
-
-// Hash Element used for "selectors with interval"
+// Timers of one target
 typedef struct _hashSelectorEntry
 {
-    ccArray             *timers;
     void                *target;
-    int                 timerIndex;
-    Timer               *currentTimer;
-    bool                currentTimerSalvaged;
+    std::unordered_map<std::string, TimerTargetCallback*> timers;
+    std::unordered_map<uint32_t, TimerTargetCallback*> timersById;
+    double              pausedTime;
     bool                paused;
-    UT_hash_handle      hh;
 } tHashTimerEntry;
 
 // implementation Timer
@@ -141,6 +120,17 @@ void Timer::update(float dt)
     }
 }
 
+float Timer::getTimeToTrigger() const
+{
+    if (_elapsed == -1)
+    {
+        return 0.f;
+    }
+
+    float timeToTrigger = (_useDelay ? _delay : _interval) - _elapsed;
+    return (timeToTrigger > 0.f) ? timeToTrigger : 0.f;
+}
+
 // TimerTargetCallback
 
 TimerTargetCallback::TimerTargetCallback()
@@ -153,6 +143,18 @@ bool TimerTargetCallback::initWithCallback(Scheduler* scheduler, const ccSchedul
     _target = target;
     _callback = callback;
     _key = key;
+    _keyId = 0;
+    setupTimerWithInterval(seconds, repeat, delay);
+    return true;
+}
+
+bool TimerTargetCallback::initWithCallback(Scheduler* scheduler, const ccSchedulerFunc& callback, void *target, uint32_t keyId, float seconds, unsigned int repeat, float delay)
+{
+    _scheduler = scheduler;
+    _target = target;
+    _callback = callback;
+    _key.clear();
+    _keyId = keyId;
     setupTimerWithInterval(seconds, repeat, delay);
     return true;
 }
@@ -167,27 +169,157 @@ void TimerTargetCallback::trigger(float dt)
 
 void TimerTargetCallback::cancel()
 {
-    _scheduler->unschedule(_key, _target);
+    if (_keyId != 0)
+        _scheduler->unschedule(_keyId, _target);
+    else
+        _scheduler->unschedule(_key, _target);
 }
 
+struct Scheduler::PerformNode
+{
+    PerformNode()
+    : next(nullptr)
+    {}
+
+    std::atomic<PerformNode*> next;
+    std::function<void()> function;
+};
+
 // implementation of Scheduler
 
 Scheduler::Scheduler()
+: _functionsToPerformNum(0)
 {
-    // I don't expect to have more than 30 functions to all per frame
-    _functionsToPerform.reserve(30);
+    _performTail = new (std::nothrow) PerformNode();
+    _performHead = _performTail;
 }
 
 Scheduler::~Scheduler(void)
 {
     unscheduleAll();
+
+    // timers scheduled after the last update are still retained by the pending list
+    for (auto timer : _pendingTimers)
+        timer->release();
+    _pendingTimers.clear();
+
+    removeAllFunctionsToBePerformedInCocosThread();
+    delete _performTail;
 }
 
-void Scheduler::removeHashElement(_hashSelectorEntry *element)
+void Scheduler::pushTimer(Timer *timer)
 {
-    ccArrayFree(element->timers);
-    HASH_DEL(_hashForTimers, element);
-    free(element);
+    CCASSERT(timer->_heapIndex == -1, "timer is already in the heap!");
+    timer->_heapIndex = (int)_timerHeap.size();
+    _timerHeap.push_back(timer);
+    siftUpTimer(timer->_heapIndex);
+}
+
+void Scheduler::eraseTimer(Timer *timer)
+{
+    int index = timer->_heapIndex;
+    if (index < 0)
+    {
+        return;
+    }
+
+    Timer* last = _timerHeap.back();
+    _timerHeap.pop_back();
+    timer->_heapIndex = -1;
+
+    if (last != timer)
+    {
+        _timerHeap[index] = last;
+        last->_heapIndex = index;
+        siftUpTimer(index);
+        siftDownTimer(last->_heapIndex);
+    }
+}
+
+void Scheduler::siftUpTimer(int index)
+{
+    Timer* timer = _timerHeap[index];
+    while (index > 0)
+    {
+        int parent = (index - 1) / 2;
+        if (_timerHeap[parent]->_fireTime <= timer->_fireTime)
+        {
+            break;
+        }
+        _timerHeap[index] = _timerHeap[parent];
+        _timerHeap[index]->_heapIndex = index;
+        index = parent;
+    }
+    _timerHeap[index] = timer;
+    timer->_heapIndex = index;
+}
+
+void Scheduler::siftDownTimer(int index)
+{
+    int count = (int)_timerHeap.size();
+    Timer* timer = _timerHeap[index];
+    while (true)
+    {
+        int child = index * 2 + 1;
+        if (child >= count)
+        {
+            break;
+        }
+        if (child + 1 < count && _timerHeap[child + 1]->_fireTime < _timerHeap[child]->_fireTime)
+        {
+            ++child;
+        }
+        if (timer->_fireTime <= _timerHeap[child]->_fireTime)
+        {
+            break;
+        }
+        _timerHeap[index] = _timerHeap[child];
+        _timerHeap[index]->_heapIndex = index;
+        index = child;
+    }
+    _timerHeap[index] = timer;
+    timer->_heapIndex = index;
+}
+
+void Scheduler::removeTimer(TimerTargetCallback *timer)
+{
+    eraseTimer(timer);
+    timer->_entry = nullptr;
+    // Pending and due lists retain their timers, so this only drops the reference of the target.
+    timer->release();
+}
+
+void Scheduler::removeTimerTarget(tHashTimerEntry *element)
+{
+    for (auto& e : element->timers)
+    {
+        removeTimer(e.second);
+    }
+    for (auto& e : element->timersById)
+    {
+        removeTimer(e.second);
+    }
+
+    if (_currentTarget == element)
+    {
+        _currentTargetSalvaged = true;
+        _currentTarget = nullptr;
+    }
+
+    _timerTargets.erase(element->target);
+    delete element;
+}
+
+TimerTargetCallback* Scheduler::findTimer(tHashTimerEntry *element, const std::string& key, uint32_t keyId) const
+{
+    if (keyId != 0)
+    {
+        auto iter = element->timersById.find(keyId);
+        return iter != element->timersById.end() ? iter->second : nullptr;
+    }
+
+    auto iter = element->timers.find(key);
+    return iter != element->timers.end() ? iter->second : nullptr;
 }
 
 void Scheduler::schedule(const ccSchedulerFunc& callback, void *target, float interval, bool paused, const std::string& key)
@@ -197,51 +329,73 @@ void Scheduler::schedule(const ccSchedulerFunc& callback, void *target, float in
 
 void Scheduler::schedule(const ccSchedulerFunc& callback, void *target, float interval, unsigned int repeat, float delay, bool paused, const std::string& key)
 {
-    CCASSERT(target, "Argument target must be non-nullptr");
     CCASSERT(!key.empty(), "key should not be empty!");
+    scheduleTimer(callback, target, interval, repeat, delay, paused, key, 0);
+}
+
+void Scheduler::schedule(const ccSchedulerFunc& callback, void *target, float interval, unsigned int repeat, float delay, bool paused, uint32_t keyId)
+{
+    CCASSERT(keyId != 0, "keyId should not be 0!");
+    scheduleTimer(callback, target, interval, repeat, delay, paused, std::string(), keyId);
+}
+
+void Scheduler::scheduleTimer(const ccSchedulerFunc& callback, void *target, float interval, unsigned int repeat, float delay, bool paused, const std::string& key, uint32_t keyId)
+{
+    CCASSERT(target, "Argument target must be non-nullptr");
 
     tHashTimerEntry *element = nullptr;
-    HASH_FIND_PTR(_hashForTimers, &target, element);
+    auto iter = _timerTargets.find(target);
 
-    if (! element)
+    if (iter == _timerTargets.end())
     {
-        element = (tHashTimerEntry *)calloc(sizeof(*element), 1);
+        element = new (std::nothrow) tHashTimerEntry();
         element->target = target;
-
-        HASH_ADD_PTR(_hashForTimers, target, element);
+        element->pausedTime = _time;
 
         // Is this the 1st element ? Then set the pause level to all the selectors of this target
         element->paused = paused;
+
+        _timerTargets.emplace(target, element);
     }
     else
     {
+        element = iter->second;
         CCASSERT(element->paused == paused, "element's paused should be paused!");
-    }
 
-    if (element->timers == nullptr)
-    {
-        element->timers = ccArrayNew(10);
-    }
-    else
-    {
-        for (int i = 0; i < element->timers->num; ++i)
+        TimerTargetCallback *timer = findTimer(element, key, keyId);
+        if (timer)
         {
-            TimerTargetCallback *timer = dynamic_cast<TimerTargetCallback*>(element->timers->arr[i]);
-
-            if (timer && key == timer->getKey())
+            CCLOG("CCScheduler#scheduleSelector. Selector already scheduled. Updating interval from: %.4f to %.4f", timer->getInterval(), interval);
+            timer->setInterval(interval);
+            if (timer->_heapIndex >= 0)
             {
-                CCLOG("CCScheduler#scheduleSelector. Selector already scheduled. Updating interval from: %.4f to %.4f", timer->getInterval(), interval);
-                timer->setInterval(interval);
-                return;
+                eraseTimer(timer);
+                timer->_fireTime = timer->_lastUpdateTime + timer->getTimeToTrigger();
+                pushTimer(timer);
             }
+            return;
         }
-        ccArrayEnsureExtraCapacity(element->timers, 1);
     }
 
     TimerTargetCallback *timer = new (std::nothrow) TimerTargetCallback();
-    timer->initWithCallback(this, callback, target, key, interval, repeat, delay);
-    ccArrayAppendObject(element->timers, timer);
-    timer->release();
+    if (keyId != 0)
+    {
+        timer->initWithCallback(this, callback, target, keyId, interval, repeat, delay);
+        element->timersById.emplace(keyId, timer);
+    }
+    else
+    {
+        timer->initWithCallback(this, callback, target, key, interval, repeat, delay);
+        element->timers.emplace(key, timer);
+    }
+    timer->_entry = element;
+
+    if (!element->paused)
+    {
+        timer->retain();
+        timer->_pending = true;
+        _pendingTimers.push_back(timer);
+    }
 }
 
 void Scheduler::unschedule(const std::string &key, void *target)
@@ -252,96 +406,87 @@ void Scheduler::unschedule(const std::string &key, void *target)
         return;
     }
 
-    //CCASSERT(target);
-    //CCASSERT(selector);
-
-    tHashTimerEntry *element = nullptr;
-    HASH_FIND_PTR(_hashForTimers, &target, element);
+    unscheduleTimer(key, 0, target);
+}
 
-    if (element)
+void Scheduler::unschedule(uint32_t keyId, void *target)
+{
+    if (target == nullptr || keyId == 0)
     {
-        for (int i = 0; i < element->timers->num; ++i)
-        {
-            TimerTargetCallback *timer = dynamic_cast<TimerTargetCallback*>(element->timers->arr[i]);
-
-            if (timer && key == timer->getKey())
-            {
-                if (timer == element->currentTimer && (! element->currentTimerSalvaged))
-                {
-                    element->currentTimer->retain();
-                    element->currentTimerSalvaged = true;
-                }
-
-                ccArrayRemoveObjectAtIndex(element->timers, i, true);
-
-                // update timerIndex in case we are in tick:, looping over the actions
-                if (element->timerIndex >= i)
-                {
-                    element->timerIndex--;
-                }
-
-                if (element->timers->num == 0)
-                {
-                    if (_currentTarget == element)
-                    {
-                        _currentTargetSalvaged = true;
-                    }
-                    else
-                    {
-                        removeHashElement(element);
-                    }
-                }
-
-                return;
-            }
-        }
+        return;
     }
+
+    unscheduleTimer(std::string(), keyId, target);
 }
 
-bool Scheduler::isScheduled(const std::string& key, void *target)
+void Scheduler::unscheduleTimer(const std::string& key, uint32_t keyId, void *target)
 {
-    CCASSERT(!key.empty(), "Argument key must not be empty");
-    CCASSERT(target, "Argument target must be non-nullptr");
-
-    tHashTimerEntry *element = nullptr;
-    HASH_FIND_PTR(_hashForTimers, &target, element);
-
-    if (!element)
+    auto iter = _timerTargets.find(target);
+    if (iter == _timerTargets.end())
     {
-        return false;
+        return;
     }
 
-    if (element->timers == nullptr)
+    tHashTimerEntry *element = iter->second;
+    if (keyId != 0)
     {
-        return false;
+        auto timerIter = element->timersById.find(keyId);
+        if (timerIter == element->timersById.end())
+        {
+            return;
+        }
+        TimerTargetCallback* timer = timerIter->second;
+        element->timersById.erase(timerIter);
+        removeTimer(timer);
     }
     else
     {
-        for (int i = 0; i < element->timers->num; ++i)
+        auto timerIter = element->timers.find(key);
+        if (timerIter == element->timers.end())
         {
-            TimerTargetCallback *timer = dynamic_cast<TimerTargetCallback*>(element->timers->arr[i]);
-
-            if (timer && key == timer->getKey())
-            {
-                return true;
-            }
+            return;
         }
+        TimerTargetCallback* timer = timerIter->second;
+        element->timers.erase(timerIter);
+        removeTimer(timer);
+    }
+
+    if (element->timers.empty() && element->timersById.empty())
+    {
+        removeTimerTarget(element);
+    }
+}
+
+bool Scheduler::isScheduled(const std::string& key, void *target)
+{
+    CCASSERT(!key.empty(), "Argument key must not be empty");
+    return isTimerScheduled(key, 0, target);
+}
+
+bool Scheduler::isScheduled(uint32_t keyId, void *target)
+{
+    CCASSERT(keyId != 0, "Argument keyId must not be 0");
+    return isTimerScheduled(std::string(), keyId, target);
+}
+
+bool Scheduler::isTimerScheduled(const std::string& key, uint32_t keyId, void *target)
+{
+    CCASSERT(target, "Argument target must be non-nullptr");
 
+    auto iter = _timerTargets.find(target);
+    if (iter == _timerTargets.end())
+    {
         return false;
     }
 
-    return false;  // should never get here
+    return findTimer(iter->second, key, keyId) != nullptr;
 }
 
 void Scheduler::unscheduleAll()
 {
-    for (tHashTimerEntry *element = _hashForTimers, *nextElement = nullptr; element != nullptr;)
+    while (!_timerTargets.empty())
     {
-        // element may be removed in unscheduleAllSelectorsForTarget
-        nextElement = (tHashTimerEntry *)element->hh.next;
-        unscheduleAllForTarget(element->target);
-        
-        element = nextElement;
+        removeTimerTarget(_timerTargets.begin()->second);
     }
 }
 
@@ -354,53 +499,82 @@ void Scheduler::unscheduleAllForTarget(void *target)
     }
 
     // Custom Selectors
-    tHashTimerEntry *element = nullptr;
-    HASH_FIND_PTR(_hashForTimers, &target, element);
+    auto iter = _timerTargets.find(target);
+    if (iter != _timerTargets.end())
+    {
+        removeTimerTarget(iter->second);
+    }
+}
+
+void Scheduler::resumeTarget(void *target)
+{
+    CCASSERT(target != nullptr, "target can't be nullptr!");
 
-    if (element)
+    // custom selectors
+    auto iter = _timerTargets.find(target);
+    if (iter == _timerTargets.end() || !iter->second->paused)
     {
-        if (ccArrayContainsObject(element->timers, element->currentTimer)
-            && (! element->currentTimerSalvaged))
+        return;
+    }
+
+    tHashTimerEntry *element = iter->second;
+    element->paused = false;
+
+    // The time spent paused doesn't count for the timers.
+    double pausedDuration = _time - element->pausedTime;
+    auto resumeTimer = [this, pausedDuration](TimerTargetCallback* timer) {
+        if (timer->_pending || timer->_heapIndex >= 0)
         {
-            element->currentTimer->retain();
-            element->currentTimerSalvaged = true;
+            return;
         }
-        ccArrayRemoveAllObjects(element->timers);
 
-        if (_currentTarget == element)
+        if (timer->_elapsed == -1)
         {
-            _currentTargetSalvaged = true;
+            timer->retain();
+            timer->_pending = true;
+            _pendingTimers.push_back(timer);
         }
         else
         {
-            removeHashElement(element);
+            timer->_lastUpdateTime += pausedDuration;
+            timer->_fireTime = timer->_lastUpdateTime + timer->getTimeToTrigger();
+            pushTimer(timer);
         }
+    };
+
+    for (auto& e : element->timers)
+    {
+        resumeTimer(e.second);
+    }
+    for (auto& e : element->timersById)
+    {
+        resumeTimer(e.second);
     }
 }
 
-void Scheduler::resumeTarget(void *target)
+void Scheduler::pauseTarget(void *target)
 {
     CCASSERT(target != nullptr, "target can't be nullptr!");
 
     // custom selectors
-    tHashTimerEntry *element = nullptr;
-    HASH_FIND_PTR(_hashForTimers, &target, element);
-    if (element)
+    auto iter = _timerTargets.find(target);
+    if (iter == _timerTargets.end() || iter->second->paused)
     {
-        element->paused = false;
+        return;
     }
-}
 
-void Scheduler::pauseTarget(void *target)
-{
-    CCASSERT(target != nullptr, "target can't be nullptr!");
+    tHashTimerEntry *element = iter->second;
+    element->paused = true;
+    element->pausedTime = _time;
 
-    // custom selectors
-    tHashTimerEntry *element = nullptr;
-    HASH_FIND_PTR(_hashForTimers, &target, element);
-    if (element)
+    // Paused timers leave the heap, resumeTarget() puts them back.
+    for (auto& e : element->timers)
+    {
+        eraseTimer(e.second);
+    }
+    for (auto& e : element->timersById)
     {
-        element->paused = true;
+        eraseTimer(e.second);
     }
 }
 
@@ -409,11 +583,10 @@ bool Scheduler::isTargetPaused(void *target)
     CCASSERT( target != nullptr, "target must be non nil" );
 
     // Custom selectors
-    tHashTimerEntry *element = nullptr;
-    HASH_FIND_PTR(_hashForTimers, &target, element);
-    if( element )
+    auto iter = _timerTargets.find(target);
+    if (iter != _timerTargets.end())
     {
-        return element->paused;
+        return iter->second->paused;
     }
 
     return false;  // should never get here
@@ -424,11 +597,14 @@ std::set<void*> Scheduler::pauseAllTargets()
     std::set<void*> idsWithSelectors;
     
     // Custom Selectors
-    for(tHashTimerEntry *element = _hashForTimers; element != nullptr;
-        element = (tHashTimerEntry*)element->hh.next)
+    for (const auto& e : _timerTargets)
+    {
+        idsWithSelectors.insert(e.first);
+    }
+
+    for (const auto& target : idsWithSelectors)
     {
-        element->paused = true;
-        idsWithSelectors.insert(element->target);
+        pauseTarget(target);
     }
     
     return idsWithSelectors;
@@ -443,81 +619,152 @@ void Scheduler::resumeTargets(const std::set<void*>& targetsToResume)
 
 void Scheduler::performFunctionInCocosThread(const std::function<void ()> &function)
 {
-    _performMutex.lock();
-    _functionsToPerform.push_back(function);
-    _performMutex.unlock();
+    auto node = new (std::nothrow) PerformNode();
+    node->function = function;
+    pushFunctionToPerform(node);
+}
+
+void Scheduler::performFunctionInCocosThread(std::function<void ()> &&function)
+{
+    auto node = new (std::nothrow) PerformNode();
+    node->function = std::move(function);
+    pushFunctionToPerform(node);
 }
 
 void Scheduler::removeAllFunctionsToBePerformedInCocosThread()
 {
-    std::unique_lock<std::mutex> lock(_performMutex);
-    _functionsToPerform.clear();
+    std::function<void()> function;
+    while (popFunctionToPerform(function))
+        ;
+}
+
+void Scheduler::pushFunctionToPerform(PerformNode* node)
+{
+    ++_functionsToPerformNum;
+    PerformNode* prev = _performHead.exchange(node, std::memory_order_acq_rel);
+    // The node can't be popped until it's linked, the consumer stops at the gap and picks it up next frame.
+    prev->next.store(node, std::memory_order_release);
+}
+
+bool Scheduler::popFunctionToPerform(std::function<void()>& function)
+{
+    PerformNode* tail = _performTail;
+    PerformNode* next = tail->next.load(std::memory_order_acquire);
+    if (next == nullptr)
+        return false;
+
+    // next becomes the dummy node, the old one is freed
+    function = std::move(next->function);
+    next->function = nullptr;
+    _performTail = next;
+    delete tail;
+    --_functionsToPerformNum;
+    return true;
+}
+
+void Scheduler::performFunctions()
+{
+    _performedFunctionsNum = 0;
+    _performTime = 0.f;
+
+    // Only the functions queued before this point are called. Functions queued by them wait for the next frame,
+    // the same as when the whole queue was copied.
+    int num = _functionsToPerformNum;
+    if (num <= 0)
+        return;
+
+    auto start = std::chrono::steady_clock::now();
+    std::function<void()> function;
+    while (num-- > 0 && popFunctionToPerform(function))
+    {
+        function();
+        function = nullptr;
+        ++_performedFunctionsNum;
+
+        _performTime = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+        if (_performTimeBudget > 0 && _performTime >= _performTimeBudget)
+            break;
+    }
+}
+
+void Scheduler::startPendingTimers()
+{
+    // Starting a timer can't schedule new ones, but keep the list stable anyway.
+    std::vector<TimerTargetCallback*> timers;
+    timers.swap(_pendingTimers);
+
+    for (auto timer : timers)
+    {
+        timer->_pending = false;
+        // Timers of targets paused in the meantime are started when resumed.
+        if (timer->_entry && !timer->_entry->paused && timer->_heapIndex < 0)
+        {
+            // The first update only resets the elapsed time, the same as Timer::update() always did.
+            timer->update(0);
+            timer->_lastUpdateTime = _time;
+            timer->_fireTime = _time + timer->getTimeToTrigger();
+            pushTimer(timer);
+        }
+        timer->release();
+    }
 }
 
 // main loop
 void Scheduler::update(float dt)
 {
-    _updateHashLocked = true;
+    _time += dt;
 
-    // Iterate over all the custom selectors
-    for (tHashTimerEntry *elt = _hashForTimers; elt != nullptr; )
+    // Pop every timer that is due. Timers rescheduled below go back into the heap
+    // and wait for the next frame, even if they fire every frame.
+    _dueTimers.clear();
+    while (!_timerHeap.empty() && _timerHeap.front()->_fireTime <= _time)
     {
-        _currentTarget = elt;
-        _currentTargetSalvaged = false;
+        Timer* timer = _timerHeap.front();
+        eraseTimer(timer);
+        timer->retain();
+        _dueTimers.push_back(static_cast<TimerTargetCallback*>(timer));
+    }
 
-        if (! _currentTarget->paused)
-        {
-            // The 'timers' array may change while inside this loop
-            for (elt->timerIndex = 0; elt->timerIndex < elt->timers->num; ++(elt->timerIndex))
-            {
-                elt->currentTimer = (Timer*)(elt->timers->arr[elt->timerIndex]);
-                elt->currentTimerSalvaged = false;
+    // Callbacks may schedule timers and trigger nested updates, work on a copy.
+    std::vector<TimerTargetCallback*> dueTimers;
+    dueTimers.swap(_dueTimers);
 
-                elt->currentTimer->update(dt);
+    for (auto timer : dueTimers)
+    {
+        // The timer may have been unscheduled, paused, or resumed by an earlier callback.
+        if (timer->_entry && !timer->_entry->paused && timer->_heapIndex < 0)
+        {
+            _currentTarget = timer->_entry;
+            _currentTargetSalvaged = false;
 
-                if (elt->currentTimerSalvaged)
-                {
-                    // The currentTimer told the remove itself. To prevent the timer from
-                    // accidentally deallocating itself before finishing its step, we retained
-                    // it. Now that step is done, it's safe to release it.
-                    elt->currentTimer->release();
-                }
+            timer->update((float)(_time - timer->_lastUpdateTime));
+            timer->_lastUpdateTime = _time;
 
-                elt->currentTimer = nullptr;
+            if (timer->_entry && !timer->_entry->paused && timer->_heapIndex < 0)
+            {
+                timer->_fireTime = _time + timer->getTimeToTrigger();
+                pushTimer(timer);
             }
         }
+        timer->release();
+    }
 
-        // elt, at this moment, is still valid
-        // so it is safe to ask this here (issue #490)
-        elt = (tHashTimerEntry *)elt->hh.next;
+    _currentTarget = nullptr;
+    _currentTargetSalvaged = false;
 
-        // only delete currentTarget if no actions were scheduled during the cycle (issue #481)
-        if (_currentTargetSalvaged && _currentTarget->timers->num == 0)
-        {
-            removeHashElement(_currentTarget);
-        }
+    dueTimers.clear();
+    if (_dueTimers.empty())
+    {
+        // Keep the capacity for the next frame.
+        _dueTimers.swap(dueTimers);
     }
 
-    _updateHashLocked = false;
-    _currentTarget = nullptr;
+    startPendingTimers();
 
     //
     // Functions allocated from another thread
     //
-
-    // Testing size is faster than locking / unlocking.
-    // And almost never there will be functions scheduled to be called.
-    if( !_functionsToPerform.empty() ) {
-        _performMutex.lock();
-        // fixed #4123: Save the callback functions, they must be invoked after '_performMutex.unlock()', otherwise if new functions are added in callback, it will cause thread deadlock.
-        auto temp = _functionsToPerform;
-        _functionsToPerform.clear();
-        _performMutex.unlock();
-        for( const auto &function : temp ) {
-            function();
-        }
-
-    }
+    performFunctions();
 }
 
 NS_CC_END
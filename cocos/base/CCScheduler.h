@@ -27,13 +27,17 @@ THE SOFTWARE.
 ****************************************************************************/
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <functional>
 #include <mutex>
 #include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "base/CCRef.h"
 #include "base/CCVector.h"
-#include "base/uthash.h"
 
 NS_CC_BEGIN
 
@@ -59,11 +63,15 @@ public:
 
     /** triggers the timer */
     void update(float dt);
+
+    /** seconds until the next trigger, 0 if the timer is due or hasn't started yet */
+    float getTimeToTrigger() const;
     
 protected:
     Timer();
 
 protected:
+    friend class Scheduler;
 
     Scheduler* _scheduler = nullptr;
     float _elapsed = 0.f;
@@ -73,6 +81,13 @@ protected:
     unsigned int _repeat = 0; //0 = once, 1 is 2 x executed
     float _delay = 0.f;
     float _interval = 0.f;
+
+    // Bookkeeping of the scheduler, in scheduler time.
+    struct _hashSelectorEntry* _entry = nullptr; // nullptr once unscheduled
+    double _fireTime = 0.0;
+    double _lastUpdateTime = 0.0;
+    int _heapIndex = -1; // -1 if not in the scheduler's timer heap
+    bool _pending = false; // waiting for the scheduler to start it
 };
 
 class CC_DLL TimerTargetCallback final : public Timer
@@ -82,9 +97,13 @@ public:
 
     // Initializes a timer with a target, a lambda and an interval in seconds, repeat in number of times to repeat, delay in seconds.
     bool initWithCallback(Scheduler* scheduler, const ccSchedulerFunc& callback, void *target, const std::string& key, float seconds, unsigned int repeat, float delay);
+    // Same as above, but the timer is identified by a non-zero integer key instead of a string.
+    bool initWithCallback(Scheduler* scheduler, const ccSchedulerFunc& callback, void *target, uint32_t keyId, float seconds, unsigned int repeat, float delay);
 
     inline const ccSchedulerFunc& getCallback() const { return _callback; };
     inline const std::string& getKey() const { return _key; };
+    // 0 if the timer is identified by a string key.
+    inline uint32_t getKeyId() const { return _keyId; };
 
     virtual void trigger(float dt) override;
     virtual void cancel() override;
@@ -93,6 +112,7 @@ protected:
     void* _target = nullptr;
     ccSchedulerFunc _callback = nullptr;
     std::string _key;
+    uint32_t _keyId = 0;
 };
 
 /**
@@ -104,13 +124,14 @@ protected:
  * @{
  */
 
-struct _listEntry;
 struct _hashSelectorEntry;
-struct _hashUpdateEntry;
 
 /** @brief Scheduler is responsible for triggering the scheduled callbacks.
 You should not use system timer for your game logic. Instead, use this class.
 
+Timers are kept in a min-heap ordered by their next trigger time, so a frame only
+touches the timers that fire in it, no matter how many timers are scheduled.
+
 There are 2 different types of callbacks (selectors):
 
 - update selector: the 'update' selector will be called every frame. You can customize the priority.
@@ -176,6 +197,13 @@ public:
      */
     void schedule(const ccSchedulerFunc& callback, void *target, float interval, bool paused, const std::string& key);
 
+    /** Same as the string keyed version, but the callback is identified by an integer key.
+     Integer keys avoid building and comparing strings when a lot of callbacks are scheduled, e.g. from script bindings.
+     Integer keys and string keys never match each other.
+     @param keyId The key to identify the callback function, must not be 0.
+     */
+    void schedule(const ccSchedulerFunc& callback, void *target, float interval, unsigned int repeat, float delay, bool paused, uint32_t keyId);
+
     /////////////////////////////////////
 
     // unschedule
@@ -188,6 +216,12 @@ public:
      */
     void unschedule(const std::string& key, void *target);
 
+    /** Unschedules a callback scheduled with an integer key for a given target.
+     @param keyId The integer key of the callback.
+     @param target The target to be unscheduled.
+     */
+    void unschedule(uint32_t keyId, void *target);
+
     /** Unschedules all selectors for a given target.
      This also includes the "update" selector.
      @param target The target to be unscheduled.
@@ -222,6 +256,13 @@ public:
      */
     bool isScheduled(const std::string& key, void *target);
 
+    /** Checks whether a callback associated with the integer key 'keyId' and 'target' is scheduled.
+     @param keyId The integer key of the callback.
+     @param target The target of the callback.
+     @return True if the specified callback is invoked, false if not.
+     */
+    bool isScheduled(uint32_t keyId, void *target);
+
     /////////////////////////////////////
 
     /** Pauses the target.
@@ -270,40 +311,83 @@ public:
     void resumeTargets(const std::set<void*>& targetsToResume);
 
     /** Calls a function on the cocos2d thread. Useful when you need to call a cocos2d function from another thread.
-     This function is thread safe.
+     This function is thread safe and lock free.
+     Functions are called in the order they are queued. The functions queued before a frame are called in that frame
+     until the time budget is used up, the rest wait for the next frame.
      @param function The function to be run in cocos2d thread.
      @since v3.0
      @js NA
      */
     void performFunctionInCocosThread( const std::function<void()> &function);
+    void performFunctionInCocosThread(std::function<void()> &&function);
 
     /**
      * Remove all pending functions queued to be performed with Scheduler::performFunctionInCocosThread
      * Functions unscheduled in this manner will not be executed
-     * This function is thread safe
+     * This function has to be invoked in cocos thread
      * @since v3.14
      * @js NA
      */
     void removeAllFunctionsToBePerformedInCocosThread();
+
+    /** Sets the time in seconds the functions queued with performFunctionInCocosThread may take per frame.
+     At least one function is called per frame. 0 means no limit, the default is 5 ms.
+     @js NA
+     */
+    void setPerformTimeBudget(float seconds) { _performTimeBudget = seconds; }
+    float getPerformTimeBudget() const { return _performTimeBudget; }
+
+    /** Gets the number of functions waiting to be performed in cocos thread. This function is thread safe.
+     @js NA
+     */
+    int getFunctionsToPerformNum() const { return _functionsToPerformNum; }
+
+    /** Gets the number of functions performed in the last frame and the time in seconds they took.
+     @js NA
+     */
+    int getPerformedFunctionsNum() const { return _performedFunctionsNum; }
+    float getPerformTime() const { return _performTime; }
     
     bool isCurrentTargetSalvaged () const { return _currentTargetSalvaged; };
 
 private:
-    void removeHashElement(struct _hashSelectorEntry *element);
-    void removeUpdateFromHash(struct _listEntry *entry);
-
-    // update specific
+    void removeTimerTarget(struct _hashSelectorEntry *element);
+    void removeTimer(TimerTargetCallback *timer);
+    void scheduleTimer(const ccSchedulerFunc& callback, void *target, float interval, unsigned int repeat, float delay, bool paused, const std::string& key, uint32_t keyId);
+    void unscheduleTimer(const std::string& key, uint32_t keyId, void *target);
+    bool isTimerScheduled(const std::string& key, uint32_t keyId, void *target);
+    TimerTargetCallback* findTimer(struct _hashSelectorEntry *element, const std::string& key, uint32_t keyId) const;
+    void startPendingTimers();
+
+    struct PerformNode;
+    void pushFunctionToPerform(PerformNode* node);
+    bool popFunctionToPerform(std::function<void()>& function);
+    void performFunctions();
+
+    // min-heap of running timers, ordered by Timer::_fireTime
+    void pushTimer(Timer *timer);
+    void eraseTimer(Timer *timer);
+    void siftUpTimer(int index);
+    void siftDownTimer(int index);
 
     // Used for "selectors with interval"
-    struct _hashSelectorEntry *_hashForTimers = nullptr;
+    std::unordered_map<void*, struct _hashSelectorEntry*> _timerTargets;
+    std::vector<Timer*> _timerHeap;
+    // Timers scheduled since the last update, they start counting at the end of the next update.
+    std::vector<TimerTargetCallback*> _pendingTimers;
+    std::vector<TimerTargetCallback*> _dueTimers;
+    double _time = 0.0;
     struct _hashSelectorEntry *_currentTarget = nullptr;
     bool _currentTargetSalvaged = false;
-    // If true unschedule will not remove anything from a hash. Elements will only be marked for deletion.
-    bool _updateHashLocked = false;
 
-    // Used for "perform Function"
-    std::vector<std::function<void()>> _functionsToPerform;
-    std::mutex _performMutex;
+    // Used for "perform Function", an intrusive multi-producer single-consumer queue.
+    // Producers append at _performHead, the cocos thread pops after _performTail which is a dummy node.
+    std::atomic<PerformNode*> _performHead;
+    PerformNode* _performTail = nullptr;
+    std::atomic<int> _functionsToPerformNum;
+    float _performTimeBudget = 0.005f;
+    int _performedFunctionsNum = 0;
+    float _performTime = 0.f;
 };
 
 // end of base group
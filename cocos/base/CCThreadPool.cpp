@@ -26,7 +26,10 @@
  ****************************************************************************/
 
 #include "base/CCThreadPool.h"
+#include "base/CCScheduler.h"
+#include "platform/CCApplication.h"
 
+#include <algorithm>
 
 #ifdef __ANDROID__
 #include <android/log.h>
@@ -38,20 +41,130 @@
 
 namespace cocos2d { namespace experimental {
 
-#define DEFAULT_THREAD_POOL_MIN_NUM (4)
 #define DEFAULT_THREAD_POOL_MAX_NUM (20)
 
 #define DEFAULT_SHRINK_INTERVAL (5.0f)
 #define DEFAULT_SHRINK_STEP (2)
 #define DEFAULT_STRETCH_STEP (2)
 
+// Must be a power of two, tasks pushed to a full deque go to the shared queue instead
+#define LOCAL_QUEUE_CAPACITY (256)
+
 static ThreadPool *__defaultThreadPool = nullptr;
 
+// The pool and the thread slot of the current thread, they're only set in worker threads
+static thread_local ThreadPool *__currentThreadPool = nullptr;
+static thread_local int __currentThreadId = -1;
+
+/*
+ * Chase-Lev deque with a fixed capacity, the memory orders follow
+ * "Correct and Efficient Work-Stealing for Weak Memory Models" (Le et al., PPoPP 2013).
+ * Only the owner thread pushes and pops at the bottom, other threads steal from the top.
+ */
+class ThreadPool::WorkStealingQueue
+{
+public:
+    WorkStealingQueue()
+    : _top(0)
+    , _bottom(0)
+    {
+        for (auto& slot : _slots)
+            slot.store(nullptr, std::memory_order_relaxed);
+    }
+
+    // Returns false if the deque is full
+    bool push(Task* task)
+    {
+        int64_t b = _bottom.load(std::memory_order_relaxed);
+        int64_t t = _top.load(std::memory_order_acquire);
+        if (b - t >= LOCAL_QUEUE_CAPACITY)
+            return false;
+
+        _slots[b & (LOCAL_QUEUE_CAPACITY - 1)].store(task, std::memory_order_relaxed);
+        // publishes the task to thieves
+        _bottom.store(b + 1, std::memory_order_release);
+        return true;
+    }
+
+    Task* pop()
+    {
+        int64_t b = _bottom.load(std::memory_order_relaxed) - 1;
+        _bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = _top.load(std::memory_order_relaxed);
+
+        if (t > b)
+        {
+            // empty
+            _bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        Task* task = _slots[b & (LOCAL_QUEUE_CAPACITY - 1)].load(std::memory_order_relaxed);
+        if (t == b)
+        {
+            // the last task, thieves may be taking it too
+            if (!_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                task = nullptr;
+            _bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return task;
+    }
+
+    // Returns nullptr if the deque is empty or another thread took the task first
+    Task* steal()
+    {
+        int64_t t = _top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = _bottom.load(std::memory_order_acquire);
+        if (t >= b)
+            return nullptr;
+
+        Task* task = _slots[t & (LOCAL_QUEUE_CAPACITY - 1)].load(std::memory_order_relaxed);
+        if (!_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return nullptr;
+        return task;
+    }
+
+    int size() const
+    {
+        int64_t b = _bottom.load(std::memory_order_relaxed);
+        int64_t t = _top.load(std::memory_order_relaxed);
+        return b > t ? (int)(b - t) : 0;
+    }
+
+private:
+    std::atomic<int64_t> _top;
+    char _padding[64]; // keeps thieves and the owner off the same cache line
+    std::atomic<int64_t> _bottom;
+    std::atomic<Task*> _slots[LOCAL_QUEUE_CAPACITY];
+};
+
+class ThreadPool::TaskNode
+{
+public:
+    TaskNode()
+    : type(TaskType::DEFAULT)
+    , priority(TaskPriority::NORMAL)
+    , pendingNum(1)
+    , finished(false)
+    {}
+
+    std::function<void(int)> runnable;
+    std::function<void()> callbackInCocosThread;
+    TaskType type;
+    TaskPriority priority;
+    std::atomic<int> pendingNum; // unfinished dependencies, plus one while the task is being pushed
+    std::mutex mutex;
+    bool finished;
+    std::vector<TaskHandle> successors; // guarded by mutex
+};
+
 ThreadPool *ThreadPool::getDefaultThreadPool()
 {
     if (__defaultThreadPool == nullptr)
     {
-        __defaultThreadPool = newCachedThreadPool(DEFAULT_THREAD_POOL_MIN_NUM,
+        __defaultThreadPool = newCachedThreadPool(getDefaultThreadNum(),
                                                   DEFAULT_THREAD_POOL_MAX_NUM,
                                                   DEFAULT_SHRINK_INTERVAL, DEFAULT_SHRINK_STEP,
                                                   DEFAULT_STRETCH_STEP);
@@ -66,6 +179,13 @@ void ThreadPool::destroyDefaultThreadPool()
     __defaultThreadPool = nullptr;
 }
 
+int ThreadPool::getDefaultThreadNum()
+{
+    // hardware_concurrency() returns 0 if it isn't computable
+    int cores = (int)std::thread::hardware_concurrency();
+    return std::min(std::max(cores - 1, 2), 8);
+}
+
 ThreadPool *ThreadPool::newCachedThreadPool(int minThreadNum, int maxThreadNum, int shrinkInterval,
                                             int shrinkStep, int stretchStep)
 {
@@ -101,11 +221,14 @@ ThreadPool *ThreadPool::newSingleThreadPool()
 }
 
 ThreadPool::ThreadPool(int minNum, int maxNum)
-        : _isDone(false), _isStop(false), _idleThreadNum(0), _minThreadNum(minNum),
+        : _queuedTaskNum(0), _taskStamp(0), _stopAllStamp(0),
+          _isDone(false), _isStop(false), _idleThreadNum(0), _minThreadNum(minNum),
           _maxThreadNum(maxNum), _initedThreadNum(0), _shrinkInterval(DEFAULT_SHRINK_INTERVAL),
           _shrinkStep(DEFAULT_SHRINK_STEP), _stretchStep(DEFAULT_STRETCH_STEP),
           _isFixedSize(false)
 {
+    for (auto& slot : _stopTypeSlots)
+        slot = 0;
     init();
 }
 
@@ -118,8 +241,6 @@ ThreadPool::~ThreadPool()
 // number of idle threads
 int ThreadPool::getIdleThreadNum() const
 {
-    ThreadPool* thiz = const_cast<ThreadPool*>(this);
-    std::lock_guard<std::mutex> lk(thiz->_idleThreadNumMutex);
     return _idleThreadNum;
 }
 
@@ -133,6 +254,13 @@ void ThreadPool::init()
     _abortFlags.resize(_maxThreadNum);
     _idleFlags.resize(_maxThreadNum);
     _initedFlags.resize(_maxThreadNum);
+    _localQueues.resize(_maxThreadNum);
+
+    // threads steal from all the deques, so create them before starting any thread
+    for (int i = 0; i < _maxThreadNum; ++i)
+    {
+        _localQueues[i].reset(new (std::nothrow) WorkStealingQueue());
+    }
 
     for (int i = 0; i < _maxThreadNum; ++i)
     {
@@ -153,6 +281,12 @@ void ThreadPool::init()
 }
 
 bool ThreadPool::tryShrinkPool()
+{
+    std::lock_guard<std::mutex> lk(_resizeMutex);
+    return shrinkPool();
+}
+
+bool ThreadPool::shrinkPool()
 {
     LOGD("shrink pool, _idleThreadNum = %d \n", getIdleThreadNum());
 
@@ -247,15 +381,41 @@ void ThreadPool::stretchPool(int count)
 void ThreadPool::pushTask(const std::function<void(int)>& runnable,
                           TaskType type/* = DEFAULT*/)
 {
-    if (!_isFixedSize)
+    pushTask(runnable, type, TaskPriority::NORMAL);
+}
+
+void ThreadPool::pushTask(const std::function<void(int)>& runnable, TaskType type, TaskPriority priority)
+{
+    Task* task = new(std::nothrow) Task();
+    task->type = type;
+    task->priority = priority;
+    task->stamp = ++_taskStamp;
+    task->callback = runnable;
+
+    if (__currentThreadPool == this)
     {
-        _idleThreadNumMutex.lock();
+        // Pushed by a task of this pool, keep it close to the data the task produced
+        if (_localQueues[__currentThreadId]->push(task))
+        {
+            // Pairs with the increment of _idleThreadNum before a waiting thread checks the deques
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (_idleThreadNum > 0)
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _cv.notify_one();
+            }
+            return;
+        }
+    }
+    else if (!_isFixedSize)
+    {
+        // Only one producer resizes the pool at a time, the others just queue their tasks
+        std::unique_lock<std::mutex> lk(_resizeMutex, std::try_to_lock);
         int idleNum = _idleThreadNum;
-        _idleThreadNumMutex.unlock();
 
-        if (idleNum > _minThreadNum)
+        if (lk.owns_lock() && idleNum > _minThreadNum)
         {
-            if (_taskQueue.empty())
+            if (_queuedTaskNum == 0)
             {
                 struct timeval now;
                 gettimeofday(&now, nullptr);
@@ -264,25 +424,92 @@ void ThreadPool::pushTask(const std::function<void(int)>& runnable,
                                 (now.tv_usec - _lastShrinkTime.tv_usec) / 1000000.0f;
                 if (seconds > _shrinkInterval)
                 {
-                    tryShrinkPool();
+                    shrinkPool();
                     _lastShrinkTime = now;
                 }
             }
         }
-        else if (idleNum == 0)
+        else if (lk.owns_lock() && idleNum == 0)
         {
             stretchPool(_stretchStep);
         }
     }
 
-    auto callback = new(std::nothrow) std::function<void(int)>([runnable](int tid) {
-        runnable(tid);
-    });
+    enqueueTask(task, priority);
+}
+
+ThreadPool::TaskHandle ThreadPool::pushTask(const std::function<void(int)>& runnable, TaskType type,
+                                            TaskPriority priority, const std::vector<TaskHandle>& dependencies,
+                                            const std::function<void()>& callbackInCocosThread/* = nullptr*/)
+{
+    auto node = std::make_shared<TaskNode>();
+    node->runnable = runnable;
+    node->callbackInCocosThread = callbackInCocosThread;
+    node->type = type;
+    node->priority = priority;
+
+    for (const auto& dependency : dependencies)
+    {
+        if (dependency == nullptr)
+            continue;
+
+        std::lock_guard<std::mutex> lk(dependency->mutex);
+        if (!dependency->finished)
+        {
+            ++node->pendingNum;
+            dependency->successors.push_back(node);
+        }
+    }
+
+    // Drops the hold taken while pushing, the task runs now if nothing is pending
+    if (--node->pendingNum == 0)
+    {
+        scheduleTaskNode(node);
+    }
+    return node;
+}
+
+void ThreadPool::scheduleTaskNode(const TaskHandle& node)
+{
+    pushTask([this, node](int tid) {
+        runTaskNode(node, tid);
+    }, node->type, node->priority);
+}
+
+void ThreadPool::runTaskNode(const TaskHandle& node, int tid)
+{
+    node->runnable(tid);
+    node->runnable = nullptr; // release the captured objects as early as possible
+
+    if (node->callbackInCocosThread)
+    {
+        Application::getInstance()->getScheduler()->performFunctionInCocosThread(std::move(node->callbackInCocosThread));
+        node->callbackInCocosThread = nullptr;
+    }
+
+    std::vector<TaskHandle> successors;
+    {
+        std::lock_guard<std::mutex> lk(node->mutex);
+        node->finished = true;
+        successors.swap(node->successors);
+    }
+
+    for (const auto& successor : successors)
+    {
+        if (--successor->pendingNum == 0)
+        {
+            scheduleTaskNode(successor);
+        }
+    }
+}
 
-    Task task;
-    task.type = type;
-    task.callback = callback;
-    _taskQueue.push(std::move(task));
+void ThreadPool::enqueueTask(Task* task, TaskPriority priority)
+{
+    {
+        std::lock_guard<std::mutex> lk(_queueMutex);
+        _taskQueues[(int)priority].push_back(task);
+        ++_queuedTaskNum;
+    }
 
     {
         std::unique_lock<std::mutex> lock(_mutex);
@@ -290,39 +517,100 @@ void ThreadPool::pushTask(const std::function<void(int)>& runnable,
     }
 }
 
-void ThreadPool::stopAllTasks()
+ThreadPool::Task* ThreadPool::dequeueTask(int tid)
 {
-    Task task;
-    while (_taskQueue.pop(task))
+    // The newest task of its own deque is the most likely to be still in cache
+    Task* task = _localQueues[tid]->pop();
+    if (task != nullptr)
+        return task;
+
+    if (_queuedTaskNum > 0)
     {
-        delete task.callback; // empty the queue
+        std::lock_guard<std::mutex> lk(_queueMutex);
+        for (auto& queue : _taskQueues)
+        {
+            if (!queue.empty())
+            {
+                task = queue.front();
+                queue.pop_front();
+                --_queuedTaskNum;
+                return task;
+            }
+        }
     }
+
+    // Starts from the next slot so that thieves don't all hit the same deque
+    int n = (int)_localQueues.size();
+    for (int i = 1; i < n; ++i)
+    {
+        task = _localQueues[(tid + i) % n]->steal();
+        if (task != nullptr)
+            return task;
+    }
+    return nullptr;
 }
 
-void ThreadPool::stopTasksByType(TaskType type)
+bool ThreadPool::isTaskStopped(const Task* task)
 {
-    Task task;
+    if (task->stamp <= _stopAllStamp)
+        return true;
+
+    if (task->stamp > _stopTypeSlots[(unsigned)task->type % STOP_TYPE_SLOT_COUNT])
+        return false;
 
-    std::vector<Task> notStopTasks;
-    notStopTasks.reserve(_taskQueue.size());
+    // the type or another one sharing its slot was stopped after the task was pushed
+    std::lock_guard<std::mutex> lk(_queueMutex);
+    auto iter = _stopTypeStamps.find((int)task->type);
+    return iter != _stopTypeStamps.end() && task->stamp <= iter->second;
+}
 
-    while (_taskQueue.pop(task))
+void ThreadPool::runTask(Task* task, int tid)
+{
+    std::unique_ptr<Task> guard(task); // at return, delete the task even if an exception occurred
+    if (!isTaskStopped(task))
     {
-        if (task.type == type)
-        {// Delete the task from queue
-            delete task.callback;
-        }
-        else
-        {// If task type isn't match, push it into a vector, then insert to task queue again
-            notStopTasks.push_back(task);
+        task->callback(tid);
+    }
+}
+
+void ThreadPool::stopAllTasks()
+{
+    // Tasks in the deques of worker threads are dropped when they're popped
+    _stopAllStamp = _taskStamp.load();
+
+    std::lock_guard<std::mutex> lk(_queueMutex);
+    for (auto& queue : _taskQueues)
+    {
+        for (auto task : queue)
+        {
+            delete task; // empty the queue
         }
+        queue.clear();
     }
+    _queuedTaskNum = 0;
+}
 
-    if (!notStopTasks.empty())
+void ThreadPool::stopTasksByType(TaskType type)
+{
+    std::lock_guard<std::mutex> lk(_queueMutex);
+    uint64_t stamp = _taskStamp;
+    _stopTypeStamps[(int)type] = stamp;
+    _stopTypeSlots[(unsigned)type % STOP_TYPE_SLOT_COUNT] = stamp;
+
+    for (auto& queue : _taskQueues)
     {
-        for (const auto& t : notStopTasks)
+        for (auto iter = queue.begin(); iter != queue.end();)
         {
-            _taskQueue.push(t);
+            if ((*iter)->type == type)
+            {// Delete the task from queue
+                delete *iter;
+                iter = queue.erase(iter);
+                --_queuedTaskNum;
+            }
+            else
+            {
+                ++iter;
+            }
         }
     }
 }
@@ -346,7 +634,12 @@ void ThreadPool::joinThread(int tid)
 
 int ThreadPool::getTaskNum() const
 {
-    return (int) _taskQueue.size();
+    int num = _queuedTaskNum;
+    for (const auto& queue : _localQueues)
+    {
+        num += queue->size();
+    }
+    return num;
 }
 
 void ThreadPool::setFixedSize(bool isFixedSize)
@@ -392,6 +685,7 @@ void ThreadPool::stop()
     stopAllTasks();
     _threads.clear();
     _abortFlags.clear();
+    _localQueues.clear();
 }
 
 void ThreadPool::setThread(int tid)
@@ -399,39 +693,42 @@ void ThreadPool::setThread(int tid)
     std::shared_ptr<std::atomic<bool>> abort_ptr(
             _abortFlags[tid]); // a copy of the shared ptr to the flag
     auto f = [this, tid, abort_ptr/* a copy of the shared ptr to the abort */]() {
+        __currentThreadPool = this;
+        __currentThreadId = tid;
+
         std::atomic<bool>& abort = *abort_ptr;
-        Task task;
-        bool isPop = _taskQueue.pop(task);
+        Task* task = dequeueTask(tid);
         while (true)
         {
-            while (isPop)
-            {  // if there is anything in the queue
-                std::unique_ptr<std::function<void(int)>> func(
-                        task.callback); // at return, delete the function even if an exception occurred
-                (*task.callback)(tid);
+            while (task != nullptr)
+            {  // if there is anything to run
+                runTask(task, tid);
                 if (abort)
-                    return;  // the thread is wanted to stop, return even if the queue is not empty yet
+                {
+                    // the thread is wanted to stop, hand the tasks left in its deque over to the other threads
+                    while ((task = _localQueues[tid]->pop()) != nullptr)
+                    {
+                        enqueueTask(task, task->priority);
+                    }
+                    return;
+                }
                 else
-                    isPop = _taskQueue.pop(task);
+                    task = dequeueTask(tid);
             }
-            // the queue is empty here, wait for the next command
+            // nothing to run here, wait for the next command
             std::unique_lock<std::mutex> lock(_mutex);
-            _idleThreadNumMutex.lock();
             ++_idleThreadNum;
-            _idleThreadNumMutex.unlock();
 
             *_idleFlags[tid] = true;
-            _cv.wait(lock, [this, &task, &isPop, &abort]() {
-                isPop = _taskQueue.pop(task);
-                return isPop || _isDone || abort;
+            _cv.wait(lock, [this, tid, &task, &abort]() {
+                task = dequeueTask(tid);
+                return task != nullptr || _isDone || abort;
             });
             *_idleFlags[tid] = false;
-            _idleThreadNumMutex.lock();
             --_idleThreadNum;
-            _idleThreadNumMutex.unlock();
-            
-            if (!isPop)
-                return;  // if the queue is empty and isDone == true or *flag then return
+
+            if (task == nullptr)
+                return;  // if there is nothing to run and isDone == true or *flag then return
         }
     };
     _threads[tid].reset(
@@ -33,9 +33,10 @@
 #include <functional>
 #include <memory>
 #include <thread>
-#include <queue>
+#include <deque>
 #include <mutex>
 #include <condition_variable>
+#include <unordered_map>
 #include <vector>
 #include <atomic>
 
@@ -46,6 +47,12 @@ namespace cocos2d { namespace experimental {
  * @{
  */
 
+/*
+ * Every worker thread owns a lock-free deque. Tasks pushed by a worker go to its own deque and are
+ * popped in LIFO order, idle workers steal the oldest tasks from the deques of busy ones.
+ * Tasks pushed from other threads go to one queue per priority, workers always check the higher
+ * priority queues first.
+ */
 class CC_DLL ThreadPool
 {
 public:
@@ -59,6 +66,18 @@ public:
         USER = 1000
     };
 
+    enum class TaskPriority
+    {
+        HIGH = 0, // short tasks something is waiting for, e.g. image decoding
+        NORMAL,
+        LOW,      // background computing
+        COUNT
+    };
+
+    class TaskNode;
+    // A task which could be waited by other tasks, see pushTask with dependencies.
+    typedef std::shared_ptr<TaskNode> TaskHandle;
+
     /*
      * Gets the default thread pool which is a cached thread pool with default parameters.
      */
@@ -69,6 +88,12 @@ public:
      */
     static void destroyDefaultThreadPool();
 
+    /*
+     * Gets the suggested thread number for a pool which runs computing tasks.
+     * It's the number of cores minus one for the cocos thread, at least 2 and at most 8.
+     */
+    static int getDefaultThreadNum();
+
     /*
      * Creates a cached thread pool
      * @note The return value has to be delete while it doesn't needed
@@ -94,10 +119,25 @@ public:
     /* Pushs a task to thread pool
      *  @param runnable The callback of the task executed in sub thread
      *  @param type The task type, it's TASK_TYPE_DEFAULT if this argument isn't assigned
-     *  @note This function has to be invoked in cocos thread
+     *  @note This function has to be invoked in cocos thread or in a task of this pool.
+     *        Tasks pushed in a task are run by the same thread unless other threads steal them.
      */
     void pushTask(const std::function<void(int /*threadId*/)>& runnable, TaskType type = TaskType::DEFAULT);
 
+    // Pushs a task with the given priority, the other overload uses TaskPriority::NORMAL
+    void pushTask(const std::function<void(int /*threadId*/)>& runnable, TaskType type, TaskPriority priority);
+
+    /* Pushs a task which runs after all its dependencies finished
+     *  @param dependencies Handles returned by previous calls, finished or null handles are ignored
+     *  @param callbackInCocosThread Invoked in cocos thread after the task finished, it could be nullptr.
+     *         The tasks depending on this task don't wait for the callback.
+     *  @return The handle of the task, it could be used as a dependency of other tasks
+     *  @note If a task is stopped before running, the tasks depending on it are never run.
+     */
+    TaskHandle pushTask(const std::function<void(int /*threadId*/)>& runnable, TaskType type, TaskPriority priority,
+                        const std::vector<TaskHandle>& dependencies,
+                        const std::function<void()>& callbackInCocosThread = nullptr);
+
     // Stops all tasks, it will remove all tasks in queue
     void stopAllTasks();
 
@@ -139,6 +179,16 @@ private:
 
     ThreadPool& operator=(ThreadPool&&);
 
+    struct Task
+    {
+        TaskType type;
+        TaskPriority priority;
+        uint64_t stamp;
+        std::function<void(int)> callback;
+    };
+
+    class WorkStealingQueue;
+
     void init();
 
     void stop();
@@ -155,68 +205,50 @@ private:
 
     void setStretchStep(int step);
 
+    // Resize the threads of a cached pool, _resizeMutex has to be locked
+    bool shrinkPool();
+
     void stretchPool(int count);
 
+    void enqueueTask(Task* task, TaskPriority priority);
+
+    Task* dequeueTask(int tid);
+
+    void runTask(Task* task, int tid);
+
+    bool isTaskStopped(const Task* task);
+
+    void scheduleTaskNode(const TaskHandle& node);
+
+    void runTaskNode(const TaskHandle& node, int tid);
+
     std::vector<std::unique_ptr<std::thread>> _threads;
     std::vector<std::shared_ptr<std::atomic<bool>>> _abortFlags;
     std::vector<std::shared_ptr<std::atomic<bool>>> _idleFlags;
     std::vector<std::shared_ptr<std::atomic<bool>>> _initedFlags;
 
-    template<typename T>
-    class ThreadSafeQueue
-    {
-    public:
-        bool push(T const& value)
-        {
-            std::unique_lock<std::mutex> lock(this->mutex);
-            this->q.push(value);
-            return true;
-        }
-
-        // deletes the retrieved element, do not use for non integral types
-        bool pop(T& v)
-        {
-            std::unique_lock<std::mutex> lock(this->mutex);
-            if (this->q.empty())
-                return false;
-            v = this->q.front();
-            this->q.pop();
-            return true;
-        }
-
-        bool empty() const
-        {
-            auto thiz = const_cast<ThreadSafeQueue*>(this);
-            std::unique_lock<std::mutex> lock(thiz->mutex);
-            return this->q.empty();
-        }
-
-        size_t size() const
-        {
-            auto thiz = const_cast<ThreadSafeQueue*>(this);
-            std::unique_lock<std::mutex> lock(thiz->mutex);
-            return this->q.size();
-        }
-
-    private:
-        std::queue<T> q;
-        std::mutex mutex;
-    };
+    // One deque per thread slot, they live as long as the pool so thieves never see a dangling deque
+    std::vector<std::unique_ptr<WorkStealingQueue>> _localQueues;
 
-    struct Task
-    {
-        TaskType type;
-        std::function<void(int)> *callback;
-    };
+    // Tasks pushed from outside the pool, guarded by _queueMutex
+    std::deque<Task*> _taskQueues[(int)TaskPriority::COUNT];
+    std::atomic<int> _queuedTaskNum;
+    std::mutex _queueMutex;
+
+    // Tasks stamped before these stamps are dropped instead of being run,
+    // it's how the tasks in the deques of workers are stopped
+    std::atomic<uint64_t> _taskStamp;
+    std::atomic<uint64_t> _stopAllStamp;
+    std::unordered_map<int, uint64_t> _stopTypeStamps; // guarded by _queueMutex
+    // The latest stop stamp of the types hashed to each slot, so that workers only lock
+    // _queueMutex to look up the exact type when a task may have been stopped
+    static const int STOP_TYPE_SLOT_COUNT = 64;
+    std::atomic<uint64_t> _stopTypeSlots[STOP_TYPE_SLOT_COUNT];
 
-    ThreadSafeQueue<Task> _taskQueue;
     std::atomic<bool> _isDone;
     std::atomic<bool> _isStop;
 
-    //IDEA: std::atomic<int> isn't supported by ndk-r10e while compiling with `armeabi` arch.
-    // So using a mutex here instead.
-    int _idleThreadNum;  // how many threads are waiting
-    std::mutex _idleThreadNumMutex;
+    std::atomic<int> _idleThreadNum;  // how many threads are waiting
 
     std::mutex _mutex;
     std::condition_variable _cv;
@@ -225,6 +257,9 @@ private:
     int _maxThreadNum;
     int _initedThreadNum;
 
+    // Guards resizing a cached pool and _lastShrinkTime, tasks may be pushed from several threads
+    std::mutex _resizeMutex;
+
     struct timeval _lastShrinkTime;
     float _shrinkInterval;
     int _shrinkStep;
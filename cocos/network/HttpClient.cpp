@@ -26,8 +26,10 @@
  ****************************************************************************/
 
 #include "network/HttpClient.h"
-#include <queue>
+#include <algorithm>
+#include <unordered_map>
 #include <errno.h>
+#include <limits.h>
 #include <curl/curl.h>
 #include "platform/CCFileUtils.h"
 #include "platform/CCApplication.h"
@@ -42,6 +44,14 @@ typedef int int32_t;
 
 static HttpClient* _httpClient = nullptr; // pointer to singleton
 
+// curl_multi_poll() can be interrupted by curl_multi_wakeup() from another thread,
+// older libcurl versions can only poll for new requests
+#if LIBCURL_VERSION_NUM >= 0x074400
+#define CC_CURL_MULTI_WAKEUP 1
+#else
+#define CC_CURL_MULTI_WAKEUP 0
+#endif
+
 typedef size_t (*write_callback)(void *ptr, size_t size, size_t nmemb, void *stream);
 
 // Callback function used by libcurl for collect response data
@@ -71,97 +81,6 @@ static size_t writeHeaderData(void *ptr, size_t size, size_t nmemb, void *stream
 }
 
 
-static int processGetTask(HttpClient* client, HttpRequest* request, write_callback callback, void *stream, long *errorCode, write_callback headerCallback, void *headerStream, char* errorBuffer);
-static int processPostTask(HttpClient* client, HttpRequest* request, write_callback callback, void *stream, long *errorCode, write_callback headerCallback, void *headerStream, char* errorBuffer);
-static int processPutTask(HttpClient* client,  HttpRequest* request, write_callback callback, void *stream, long *errorCode, write_callback headerCallback, void *headerStream, char* errorBuffer);
-static int processDeleteTask(HttpClient* client,  HttpRequest* request, write_callback callback, void *stream, long *errorCode, write_callback headerCallback, void *headerStream, char* errorBuffer);
-// int processDownloadTask(HttpRequest *task, write_callback callback, void *stream, int32_t *errorCode);
-
-// Worker thread
-void HttpClient::networkThread()
-{
-    increaseThreadCount();
-
-    while (true)
-    {
-        HttpRequest *request;
-
-        // step 1: send http request if the requestQueue isn't empty
-        {
-            std::lock_guard<std::mutex> lock(_requestQueueMutex);
-            while (_requestQueue.empty())
-            {
-                _sleepCondition.wait(_requestQueueMutex);
-            }
-            request = _requestQueue.at(0);
-            _requestQueue.erase(0);
-        }
-
-        if (request == _requestSentinel) {
-            break;
-        }
-
-        // step 2: libcurl sync access
-        
-        // Create a HttpResponse object, the default setting is http access failed
-        HttpResponse *response = new (std::nothrow) HttpResponse(request);
-
-        processResponse(response, _responseMessage);
-
-
-        // add response packet into queue
-        _responseQueueMutex.lock();
-        _responseQueue.pushBack(response);
-        _responseQueueMutex.unlock();
-
-        _schedulerMutex.lock();
-        if (nullptr != _scheduler)
-        {
-            _scheduler->performFunctionInCocosThread(CC_CALLBACK_0(HttpClient::dispatchResponseCallbacks, this));
-        }
-        _schedulerMutex.unlock();
-    }
-    
-    // cleanup: if worker thread received quit signal, clean up un-completed request queue
-    _requestQueueMutex.lock();
-    _requestQueue.clear();
-    _requestQueueMutex.unlock();
-
-    _responseQueueMutex.lock();
-    _responseQueue.clear();
-    _responseQueueMutex.unlock();
-
-    decreaseThreadCountAndMayDeleteThis();
-}
-
-// Worker thread
-void HttpClient::networkThreadAlone(HttpRequest* request, HttpResponse* response)
-{
-    increaseThreadCount();
-
-    char responseMessage[RESPONSE_BUFFER_SIZE] = { 0 };
-    processResponse(response, responseMessage);
-
-    _schedulerMutex.lock();
-    if (nullptr != _scheduler)
-    {
-        _scheduler->performFunctionInCocosThread([this, response, request]{
-            const ccHttpRequestCallback& callback = request->getResponseCallback();
-
-            if (callback != nullptr)
-            {
-                callback(this, response);
-            }
-            response->release();
-            // do not release in other thread
-            request->release();
-        });
-    }
-    _schedulerMutex.unlock();
-
-    decreaseThreadCountAndMayDeleteThis();
-}
-
 //Configure curl's timeout property
 static bool configureCURL(HttpClient* client, HttpRequest* request, CURL* handle, char* errorBuffer)
 {
@@ -272,10 +191,19 @@ public:
         
     }
 
-    /// @param responseCode Null not allowed
-    bool perform(long *responseCode)
+    CURL* getHandle() const
+    {
+        return _curl;
+    }
+
+    /**
+     * @brief Checks the result of a finished transfer
+     * @param result Result of the transfer reported by the multi handle
+     * @param responseCode Null not allowed
+     */
+    bool finish(CURLcode result, long *responseCode)
     {
-        if (CURLE_OK != curl_easy_perform(_curl))
+        if (CURLE_OK != result)
             return false;
         CURLcode code = curl_easy_getinfo(_curl, CURLINFO_RESPONSE_CODE, responseCode);
         if (code != CURLE_OK || !(*responseCode >= 200 && *responseCode < 300)) {
@@ -288,49 +216,271 @@ public:
     }
 };
 
-//Process Get Request
-static int processGetTask(HttpClient* client, HttpRequest* request, write_callback callback, void* stream, long* responseCode, write_callback headerCallback, void* headerStream, char* errorBuffer)
+// A request running on the network thread's multi handle
+struct HttpTransfer
 {
+    HttpRequest* request;
+    HttpResponse* response;
+    std::string host;
+    char errorBuffer[HttpClient::RESPONSE_BUFFER_SIZE];
     CURLRaii curl;
-    bool ok = curl.init(client, request, callback, stream, headerCallback, headerStream, errorBuffer)
-            && curl.setOption(CURLOPT_FOLLOWLOCATION, true)
-            && curl.perform(responseCode);
-    return ok ? 0 : 1;
+};
+
+// "scheme://user@host:port/path" -> "host:port", requests are limited per host with it
+static std::string getHostOfUrl(const std::string& url)
+{
+    size_t begin = url.find("://");
+    begin = (begin == std::string::npos) ? 0 : begin + 3;
+    size_t end = url.find_first_of("/?#", begin);
+    std::string host = url.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+    size_t at = host.rfind('@');
+    if (at != std::string::npos)
+        host.erase(0, at + 1);
+    return host;
 }
 
-//Process POST Request
-static int processPostTask(HttpClient* client, HttpRequest* request, write_callback callback, void* stream, long* responseCode, write_callback headerCallback, void* headerStream, char* errorBuffer)
+// Sets up the easy handle of a transfer for its request type, the transfer is run by the multi handle
+static bool setupTransfer(HttpClient* client, HttpTransfer* transfer, CURLSH* share)
 {
-    CURLRaii curl;
-    bool ok = curl.init(client, request, callback, stream, headerCallback, headerStream, errorBuffer)
-            && curl.setOption(CURLOPT_POST, 1)
+    HttpRequest* request = transfer->request;
+    HttpResponse* response = transfer->response;
+    CURLRaii& curl = transfer->curl;
+
+    bool ok = curl.init(client, request, writeData, response->getResponseData(), writeHeaderData, response->getResponseHeader(), transfer->errorBuffer)
+            && curl.setOption(CURLOPT_PRIVATE, transfer)
+            && curl.setOption(CURLOPT_SHARE, share);
+    if (!ok)
+        return false;
+
+#if LIBCURL_VERSION_NUM >= 0x072B00
+    // Rather wait for a connection that can multiplex than open a new one
+    curl.setOption(CURLOPT_PIPEWAIT, 1L);
+#endif
+
+    switch (request->getRequestType())
+    {
+    case HttpRequest::Type::GET: // HTTP GET
+        return curl.setOption(CURLOPT_FOLLOWLOCATION, true);
+
+    case HttpRequest::Type::POST: // HTTP POST
+        return curl.setOption(CURLOPT_POST, 1)
             && curl.setOption(CURLOPT_POSTFIELDS, request->getRequestData())
-            && curl.setOption(CURLOPT_POSTFIELDSIZE, request->getRequestDataSize())
-            && curl.perform(responseCode);
-    return ok ? 0 : 1;
+            && curl.setOption(CURLOPT_POSTFIELDSIZE, request->getRequestDataSize());
+
+    case HttpRequest::Type::PUT:
+        return curl.setOption(CURLOPT_CUSTOMREQUEST, "PUT")
+            && curl.setOption(CURLOPT_POSTFIELDS, request->getRequestData())
+            && curl.setOption(CURLOPT_POSTFIELDSIZE, request->getRequestDataSize());
+
+    case HttpRequest::Type::DELETE:
+        return curl.setOption(CURLOPT_CUSTOMREQUEST, "DELETE")
+            && curl.setOption(CURLOPT_FOLLOWLOCATION, true);
+
+    default:
+        CCASSERT(false, "CCHttpClient: unknown request type, only GET, POST, PUT or DELETE is supported");
+        return false;
+    }
 }
 
-//Process PUT Request
-static int processPutTask(HttpClient* client, HttpRequest* request, write_callback callback, void* stream, long* responseCode, write_callback headerCallback, void* headerStream, char* errorBuffer)
+// Inserts behind the requests with the same or a higher priority, so equal priorities keep their order
+static void insertRequestByPriority(Vector<HttpRequest*>& queue, HttpRequest* request)
 {
-    CURLRaii curl;
-    bool ok = curl.init(client, request, callback, stream, headerCallback, headerStream, errorBuffer)
-            && curl.setOption(CURLOPT_CUSTOMREQUEST, "PUT")
-            && curl.setOption(CURLOPT_POSTFIELDS, request->getRequestData())
-            && curl.setOption(CURLOPT_POSTFIELDSIZE, request->getRequestDataSize())
-            && curl.perform(responseCode);
-    return ok ? 0 : 1;
+    ssize_t index = queue.size();
+    while (index > 0 && queue.at(index - 1)->getPriority() < request->getPriority())
+    {
+        --index;
+    }
+    queue.insert(index, request);
 }
 
-//Process DELETE Request
-static int processDeleteTask(HttpClient* client, HttpRequest* request, write_callback callback, void* stream, long* responseCode, write_callback headerCallback, void* headerStream, char* errorBuffer)
+// Worker thread, runs all requests on one curl multi handle.
+// The multi handle keeps connections and DNS results alive between requests,
+// and the share handle lets requests resume TLS sessions.
+void HttpClient::networkThread()
 {
-    CURLRaii curl;
-    bool ok = curl.init(client, request, callback, stream, headerCallback, headerStream, errorBuffer)
-            && curl.setOption(CURLOPT_CUSTOMREQUEST, "DELETE")
-            && curl.setOption(CURLOPT_FOLLOWLOCATION, true)
-            && curl.perform(responseCode);
-    return ok ? 0 : 1;
+    increaseThreadCount();
+
+    CURLM* multi = curl_multi_init();
+    _requestQueueMutex.lock();
+    _multiHandle = multi;
+    _requestQueueMutex.unlock();
+    CURLSH* share = curl_share_init();
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+#ifdef CURLPIPE_MULTIPLEX
+    curl_multi_setopt(multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+#endif
+
+    std::vector<HttpTransfer*> transfers;
+    std::unordered_map<std::string, int> hostTransferCount;
+    std::vector<HttpResponse*> finished;
+    bool quit = false;
+
+    while (!quit)
+    {
+        // step 1: start queued requests, highest priority first, while their host has a free slot
+        {
+            std::lock_guard<std::mutex> lock(_requestQueueMutex);
+            while (transfers.empty() && _requestQueue.empty())
+            {
+                _sleepCondition.wait(_requestQueueMutex);
+            }
+
+            int maxPerHost = getMaxConnectionsPerHost();
+            curl_multi_setopt(multi, CURLMOPT_MAX_HOST_CONNECTIONS, (long)(maxPerHost > 0 ? maxPerHost : 0));
+
+            ssize_t i = 0;
+            while (i < _requestQueue.size())
+            {
+                HttpRequest* request = _requestQueue.at(i);
+                if (request == _requestSentinel)
+                {
+                    quit = true;
+                    break;
+                }
+
+                std::string host = getHostOfUrl(request->getUrl());
+                int& count = hostTransferCount[host];
+                if (maxPerHost > 0 && count >= maxPerHost)
+                {
+                    ++i;
+                    continue;
+                }
+
+                // Create a HttpResponse object, the default setting is http access failed
+                HttpTransfer* transfer = new (std::nothrow) HttpTransfer();
+                transfer->request = request;
+                transfer->response = new (std::nothrow) HttpResponse(request);
+                transfer->host = host;
+                transfer->errorBuffer[0] = '\0';
+
+                // the request keeps the reference taken in send()
+                _requestQueue.erase(i);
+
+                if (setupTransfer(this, transfer, share) && curl_multi_add_handle(multi, transfer->curl.getHandle()) == CURLM_OK)
+                {
+                    ++count;
+                    transfers.push_back(transfer);
+                }
+                else
+                {
+                    transfer->response->setSucceed(false);
+                    transfer->response->setErrorBuffer(transfer->errorBuffer);
+                    finished.push_back(transfer->response);
+                    delete transfer;
+                }
+            }
+        }
+
+        if (quit)
+        {
+            break;
+        }
+
+        // step 2: libcurl async access
+        int running = 0;
+        curl_multi_perform(multi, &running);
+
+        CURLMsg* msg = nullptr;
+        int msgsLeft = 0;
+        while ((msg = curl_multi_info_read(multi, &msgsLeft)) != nullptr)
+        {
+            if (msg->msg != CURLMSG_DONE)
+                continue;
+
+            HttpTransfer* transfer = nullptr;
+            curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char**)&transfer);
+            CURLcode result = msg->data.result;
+            curl_multi_remove_handle(multi, msg->easy_handle);
+
+            // write data to HttpResponse
+            long responseCode = -1;
+            bool succeed = transfer->curl.finish(result, &responseCode);
+            HttpResponse* response = transfer->response;
+            response->setResponseCode(responseCode);
+            response->setSucceed(succeed);
+            if (!succeed)
+            {
+                if (transfer->errorBuffer[0] == '\0' && result != CURLE_OK)
+                {
+                    strncpy(transfer->errorBuffer, curl_easy_strerror(result), RESPONSE_BUFFER_SIZE - 1);
+                    transfer->errorBuffer[RESPONSE_BUFFER_SIZE - 1] = '\0';
+                }
+                response->setErrorBuffer(transfer->errorBuffer);
+            }
+            finished.push_back(response);
+
+            --hostTransferCount[transfer->host];
+            transfers.erase(std::find(transfers.begin(), transfers.end(), transfer));
+            // cleans up the easy handle, which writes the cookie jar
+            delete transfer;
+        }
+
+        // step 3: add response packets into queue
+        if (!finished.empty())
+        {
+            _responseQueueMutex.lock();
+            for (auto response : finished)
+            {
+                _responseQueue.pushBack(response);
+            }
+            _responseQueueMutex.unlock();
+
+            _schedulerMutex.lock();
+            if (nullptr != _scheduler)
+            {
+                for (size_t i = 0, count = finished.size(); i < count; ++i)
+                {
+                    _scheduler->performFunctionInCocosThread(CC_CALLBACK_0(HttpClient::dispatchResponseCallbacks, this));
+                }
+            }
+            _schedulerMutex.unlock();
+            finished.clear();
+        }
+
+        // step 4: wait for network activity, curl wakes up by itself for its timeouts,
+        // and send() wakes it up for new requests
+        if (!transfers.empty())
+        {
+#if CC_CURL_MULTI_WAKEUP
+            curl_multi_poll(multi, nullptr, 0, INT_MAX, nullptr);
+#else
+            curl_multi_wait(multi, nullptr, 0, 10, nullptr);
+#endif
+        }
+    }
+
+    // cleanup: if worker thread received quit signal, abort running requests
+    for (auto transfer : transfers)
+    {
+        curl_multi_remove_handle(multi, transfer->curl.getHandle());
+        HttpResponse* response = transfer->response;
+        HttpRequest* request = transfer->request;
+        delete transfer;
+        response->release();
+        request->release();
+    }
+    for (auto response : finished)
+    {
+        response->getHttpRequest()->release();
+        response->release();
+    }
+    _requestQueueMutex.lock();
+    _multiHandle = nullptr;
+    _requestQueueMutex.unlock();
+    curl_multi_cleanup(multi);
+    curl_share_cleanup(share);
+
+    // clean up un-completed request queue
+    _requestQueueMutex.lock();
+    _requestQueue.clear();
+    _requestQueueMutex.unlock();
+
+    _responseQueueMutex.lock();
+    _responseQueue.clear();
+    _responseQueueMutex.unlock();
+
+    decreaseThreadCountAndMayDeleteThis();
 }
 
 // HttpClient implementation
@@ -363,9 +513,8 @@ void HttpClient::destroyInstance()
 
     thiz->_requestQueueMutex.lock();
     thiz->_requestQueue.pushBack(thiz->_requestSentinel);
+    thiz->wakeUpNetworkThread();
     thiz->_requestQueueMutex.unlock();
-
-    thiz->_sleepCondition.notify_one();
     thiz->decreaseThreadCountAndMayDeleteThis();
 
     CCLOG("HttpClient::destroyInstance() finished!");
@@ -443,26 +592,43 @@ void HttpClient::send(HttpRequest* request)
     request->retain();
 
     _requestQueueMutex.lock();
-    _requestQueue.pushBack(request);
-    _requestQueueMutex.unlock();
-
+    insertRequestByPriority(_requestQueue, request);
     // Notify thread start to work
-    _sleepCondition.notify_one();
+    wakeUpNetworkThread();
+    _requestQueueMutex.unlock();
 }
 
+// Requests don't wait for each other anymore, so this is the same as send()
 void HttpClient::sendImmediate(HttpRequest* request)
 {
+    if (false == lazyInitThreadSemaphore())
+    {
+        return;
+    }
+
     if(!request)
     {
         return;
     }
 
     request->retain();
-    // Create a HttpResponse object, the default setting is http access failed
-    HttpResponse *response = new (std::nothrow) HttpResponse(request);
 
-    auto t = std::thread(&HttpClient::networkThreadAlone, this, request, response);
-    t.detach();
+    _requestQueueMutex.lock();
+    insertRequestByPriority(_requestQueue, request);
+    wakeUpNetworkThread();
+    _requestQueueMutex.unlock();
+}
+
+void HttpClient::wakeUpNetworkThread()
+{
+    // the thread either sleeps on the condition when idle, or in curl while transfers run
+    _sleepCondition.notify_one();
+#if CC_CURL_MULTI_WAKEUP
+    if (_multiHandle)
+    {
+        curl_multi_wakeup((CURLM*)_multiHandle);
+    }
+#endif
 }
 
 // Poll and notify main thread if responses exists in queue
@@ -496,74 +662,6 @@ void HttpClient::dispatchResponseCallbacks()
     }
 }
 
-// Process Response
-void HttpClient::processResponse(HttpResponse* response, char* responseMessage)
-{
-    auto request = response->getHttpRequest();
-    long responseCode = -1;
-    int retValue = 0;
-
-    // Process the request -> get response packet
-    switch (request->getRequestType())
-    {
-    case HttpRequest::Type::GET: // HTTP GET
-        retValue = processGetTask(this, request,
-            writeData,
-            response->getResponseData(),
-            &responseCode,
-            writeHeaderData,
-            response->getResponseHeader(),
-            responseMessage);
-        break;
-
-    case HttpRequest::Type::POST: // HTTP POST
-        retValue = processPostTask(this, request,
-            writeData,
-            response->getResponseData(),
-            &responseCode,
-            writeHeaderData,
-            response->getResponseHeader(),
-            responseMessage);
-        break;
-
-    case HttpRequest::Type::PUT:
-        retValue = processPutTask(this, request,
-            writeData,
-            response->getResponseData(),
-            &responseCode,
-            writeHeaderData,
-            response->getResponseHeader(),
-            responseMessage);
-        break;
-
-    case HttpRequest::Type::DELETE:
-        retValue = processDeleteTask(this, request,
-            writeData,
-            response->getResponseData(),
-            &responseCode,
-            writeHeaderData,
-            response->getResponseHeader(),
-            responseMessage);
-        break;
-
-    default:
-        CCASSERT(false, "CCHttpClient: unknown request type, only GET, POST, PUT or DELETE is supported");
-        break;
-    }
-
-    // write data to HttpResponse
-    response->setResponseCode(responseCode);
-    if (retValue != 0)
-    {
-        response->setSucceed(false);
-        response->setErrorBuffer(responseMessage);
-    }
-    else
-    {
-        response->setSucceed(true);
-    }
-}
-
 void HttpClient::increaseThreadCount()
 {
     _threadCountMutex.lock();
@@ -149,6 +149,30 @@ public:
      */
     CC_DEPRECATED_ATTRIBUTE int getTimeoutForRead();
 
+    /**
+     * Set the maximum number of requests running at the same time against one host.
+     * Further requests to that host wait in the queue, highest priority first.
+     * Only the curl backend limits requests, 0 means no limit.
+     *
+     * @param value the maximum number of concurrent requests per host.
+     */
+    void setMaxConnectionsPerHost(int value)
+    {
+        std::lock_guard<std::mutex> lock(_maxConnectionsPerHostMutex);
+        _maxConnectionsPerHost = value;
+    }
+
+    /**
+     * Get the maximum number of concurrent requests per host.
+     *
+     * @return int the maximum number of concurrent requests per host.
+     */
+    int getMaxConnectionsPerHost()
+    {
+        std::lock_guard<std::mutex> lock(_maxConnectionsPerHostMutex);
+        return _maxConnectionsPerHost;
+    }
+
     HttpCookie* getCookie() const {return _cookie; }
 
     std::mutex& getCookieFileMutex() {return _cookieFileMutex;}
@@ -165,6 +189,8 @@ private:
      */
     bool lazyInitThreadSemaphore();
     void networkThread();
+    // Must be called with _requestQueueMutex locked.
+    void wakeUpNetworkThread();
     void networkThreadAlone(HttpRequest* request, HttpResponse* response);
     /** Poll function called from main thread to dispatch callbacks when http requests finished **/
     void dispatchResponseCallbacks();
@@ -182,6 +208,9 @@ private:
     int _timeoutForRead;
     std::mutex _timeoutForReadMutex;
 
+    int _maxConnectionsPerHost = 6;
+    std::mutex _maxConnectionsPerHostMutex;
+
     int  _threadCount;
     std::mutex _threadCountMutex;
 
@@ -190,6 +219,8 @@ private:
 
     Vector<HttpRequest*>  _requestQueue;
     std::mutex _requestQueueMutex;
+    // curl multi handle of the network thread while it runs, guarded by _requestQueueMutex
+    void* _multiHandle = nullptr;
 
     Vector<HttpResponse*> _responseQueue;
     std::mutex _responseQueueMutex;
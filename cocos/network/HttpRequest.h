@@ -90,6 +90,7 @@ public:
     , _callback(nullptr)
     , _userData(nullptr)
     , _timeoutInSeconds(10.0f)
+    , _priority(0)
     {
     }
 
@@ -284,6 +285,27 @@ public:
         return _timeoutInSeconds;
     }
 
+    /**
+     * Set the priority of the request, requests with a higher priority are started first.
+     * The default priority is 0. It only matters while requests wait for a free connection.
+     *
+     * @param priority the priority of the request.
+     */
+    inline void setPriority(int priority)
+    {
+        _priority = priority;
+    }
+
+    /**
+     * Get the priority of the request.
+     *
+     * @return int the priority of the request.
+     */
+    inline int getPriority() const
+    {
+        return _priority;
+    }
+
 protected:
     // properties
     Type                        _requestType;    /// kHttpRequestGet, kHttpRequestPost or other enums
@@ -294,6 +316,7 @@ protected:
     void*                       _userData;      /// You can add your customed data here
     std::vector<std::string>    _headers;       /// custom http headers
     float _timeoutInSeconds;
+    int _priority;
 };
 
 }
@@ -194,6 +194,7 @@ static std::vector<cocos2d::network::WebSocket*>* __websocketInstances = nullptr
         data.isBinary = true;
         data.issued = 0;
         data.ext = nullptr;
+        data.owner = std::shared_ptr<void>((__bridge_retained void*)nsData, [](void* p){ CFRelease(p); });
         _delegate->onMessage(_ccws, data);
     }
     else
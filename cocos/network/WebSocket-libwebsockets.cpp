@@ -37,7 +37,8 @@
 #include <thread>
 #include <mutex>
 #include <queue>
-#include <list>
+#include <deque>
+#include <unordered_map>
 #include <signal.h>
 #include <errno.h>
 #include "network/WebSocket.h"
@@ -52,6 +53,8 @@
 
 #define WS_RX_BUFFER_SIZE (65536)
 #define WS_RESERVE_RECEIVE_BUFFER_SIZE (4096)
+// lws_service returns earlier if there's network activity or wakeUpWebSocketThread is called
+#define WS_SERVICE_TIMEOUT_MS (1000)
 
 #define  LOG_TAG    "WebSocket.cpp"
 
@@ -208,6 +211,9 @@ private:
     int onConnectionError();
     int onConnectionClosed();
 
+    // Changes the state to closing, returns false if the connection is already closing or closed
+    bool requestClose();
+
     struct lws_vhost* createVhost(struct lws_protocols* protocols, int& sslConnection);
 
 private:
@@ -246,11 +252,65 @@ private:
 enum WS_MSG {
     WS_MSG_TO_SUBTRHEAD_SENDING_STRING = 0,
     WS_MSG_TO_SUBTRHEAD_SENDING_BINARY,
-    WS_MSG_TO_SUBTHREAD_CREATE_CONNECTION
+    WS_MSG_TO_SUBTHREAD_CREATE_CONNECTION,
+    WS_MSG_TO_SUBTHREAD_CLOSE_CONNECTION,
+    WS_MSG_TO_SUBTHREAD_INSTANCE_DESTROYED
 };
 
 class WsThreadHelper;
 
+// Define a WebSocket frame
+class WebSocketFrame
+{
+public:
+    WebSocketFrame()
+        : _payload(nullptr)
+        , _payloadLength(0)
+        , _frameLength(0)
+    {
+    }
+
+    bool init(unsigned char* buf, ssize_t len)
+    {
+        if (buf == nullptr && len > 0)
+            return false;
+
+        if (!_data.empty())
+        {
+            LOGD("WebSocketFrame was initialized, should not init it again!\n");
+            return false;
+        }
+
+        _data.reserve(LWS_PRE + len);
+        _data.resize(LWS_PRE, 0x00);
+        if (len > 0)
+        {
+            _data.insert(_data.end(), buf, buf + len);
+        }
+
+        _payload = _data.data() + LWS_PRE;
+        _payloadLength = len;
+        _frameLength = len;
+        return true;
+    }
+
+    void update(ssize_t issued)
+    {
+        _payloadLength -= issued;
+        _payload += issued;
+    }
+
+    unsigned char* getPayload() const { return _payload; }
+    ssize_t getPayloadLength() const { return _payloadLength; }
+    ssize_t getFrameLength() const { return _frameLength; }
+private:
+    unsigned char* _payload;
+    ssize_t _payloadLength;
+
+    ssize_t _frameLength;
+    std::vector<unsigned char> _data;
+};
+
 static std::vector<WebSocketImpl*>* __websocketInstances = nullptr;
 static std::mutex __instanceMutex;
 static struct lws_context* __wsContext = nullptr;
@@ -325,6 +385,108 @@ private:
 
 unsigned int WsMessage::__id = 0;
 
+static void deleteWsMessage(WsMessage* msg)
+{
+    auto data = (cocos2d::network::WebSocket::Data*)msg->data;
+    if (data != nullptr)
+    {
+        CC_SAFE_FREE(data->bytes);
+        delete ((WebSocketFrame*)data->ext);
+        delete data;
+    }
+    delete msg;
+}
+
+/**
+ *  @brief Lock-free queue with one producer thread and one consumer thread.
+ *  Nodes released by the consumer are reused by the producer, so nothing is allocated once the queue
+ *  has grown to the size of a burst. It's the unbounded SPSC queue described by Dmitry Vyukov.
+ */
+template<typename T>
+class SPSCQueue
+{
+public:
+    SPSCQueue()
+    {
+        Node* node = new (std::nothrow) Node();
+        _tail = node;
+        _head = node;
+        _first = node;
+        _tailCopy = node;
+    }
+
+    ~SPSCQueue()
+    {
+        Node* node = _first;
+        while (node != nullptr)
+        {
+            Node* next = node->next;
+            delete node;
+            node = next;
+        }
+    }
+
+    // Invoked in producer thread
+    void push(T value)
+    {
+        Node* node = allocNode();
+        node->next.store(nullptr, std::memory_order_relaxed);
+        node->value = std::move(value);
+        _head->next.store(node, std::memory_order_release);
+        _head = node;
+    }
+
+    // Invoked in consumer thread
+    bool pop(T& value)
+    {
+        Node* tail = _tail.load(std::memory_order_relaxed);
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (next == nullptr)
+            return false;
+
+        value = std::move(next->value);
+        next->value = T();
+        // The old tail can be reused by the producer from now on
+        _tail.store(next, std::memory_order_release);
+        return true;
+    }
+
+private:
+    struct Node
+    {
+        Node() : next(nullptr), value() {}
+        std::atomic<Node*> next;
+        T value;
+    };
+
+    Node* allocNode()
+    {
+        // Nodes between _first and the tail were consumed
+        if (_first != _tailCopy)
+        {
+            Node* node = _first;
+            _first = _first->next;
+            return node;
+        }
+        _tailCopy = _tail.load(std::memory_order_acquire);
+        if (_first != _tailCopy)
+        {
+            Node* node = _first;
+            _first = _first->next;
+            return node;
+        }
+        return new (std::nothrow) Node();
+    }
+
+    // Consumer side, the last consumed node
+    std::atomic<Node*> _tail;
+
+    // Producer side
+    Node* _head;
+    Node* _first;
+    Node* _tailCopy;
+};
+
 /**
  *  @brief Websocket thread helper, it's used for sending message between UI thread and websocket thread.
  */
@@ -340,6 +502,8 @@ public:
     void quitWebSocketThread();
 
     // Sends message to Cocos thread. It's needed to be invoked in Websocket thread.
+    // Messages are delivered in batches, one function is performed in Cocos thread for all the messages
+    // sent before it runs.
     void sendMessageToCocosThread(const std::function<void()>& cb);
 
     // Sends message to Websocket thread. It's needs to be invoked in Cocos thread.
@@ -354,12 +518,33 @@ public:
 
 protected:
     void wsThreadEntryFunc();
+    void wakeUpWebSocketThread();
+    void handleSubThreadMessage(WsMessage* msg);
 public:
-    std::list<WsMessage*>* _subThreadWsMessageQueue;
-    std::mutex   _subThreadWsMessageQueueMutex;
+    // Sending messages of every connection which wait for LWS_CALLBACK_CLIENT_WRITEABLE, only used in websocket thread.
+    std::unordered_map<WebSocketImpl*, std::deque<WsMessage*>> _pendingSendMessages;
     std::thread* _subThreadInstance;
 private:
-    bool _needQuit;
+    struct CocosThreadMessages
+    {
+        CocosThreadMessages() : isFlushScheduled(false) {}
+        SPSCQueue<std::function<void()>> queue;
+        std::atomic<bool> isFlushScheduled;
+    };
+
+    SPSCQueue<WsMessage*> _subThreadWsMessageQueue;
+    // Used in onSubThreadLoop only, kept to reuse their memory
+    std::vector<WsMessage*> _receivedMessages;
+    std::vector<void*> _destroyedInstances;
+    // Shared with the flushing function, which may run after the helper is destroyed
+    std::shared_ptr<CocosThreadMessages> _cocosThreadMessages;
+
+    // Guards the context used for waking up the websocket thread while it's being destroyed
+    std::mutex _wakeUpMutex;
+    struct lws_context* _wakeUpContext;
+    std::atomic<bool> _isWakeUpPending;
+
+    std::atomic<bool> _needQuit;
 };
 
 // Wrapper for converting websocket callback from static function to member function of WebSocket class.
@@ -393,16 +578,30 @@ public:
 // Implementation of WsThreadHelper
 WsThreadHelper::WsThreadHelper()
 : _subThreadInstance(nullptr)
+, _cocosThreadMessages(std::make_shared<CocosThreadMessages>())
+, _wakeUpContext(nullptr)
+, _isWakeUpPending(false)
 , _needQuit(false)
 {
-    _subThreadWsMessageQueue = new (std::nothrow) std::list<WsMessage*>();
 }
 
 WsThreadHelper::~WsThreadHelper()
 {
     joinWebSocketThread();
     CC_SAFE_DELETE(_subThreadInstance);
-    delete _subThreadWsMessageQueue;
+
+    WsMessage* msg = nullptr;
+    while (_subThreadWsMessageQueue.pop(msg))
+    {
+        deleteWsMessage(msg);
+    }
+    for (auto& pending : _pendingSendMessages)
+    {
+        for (auto pendingMsg : pending.second)
+        {
+            deleteWsMessage(pendingMsg);
+        }
+    }
 }
 
 bool WsThreadHelper::createWebSocketThread()
@@ -415,48 +614,110 @@ bool WsThreadHelper::createWebSocketThread()
 void WsThreadHelper::quitWebSocketThread()
 {
     _needQuit = true;
+    wakeUpWebSocketThread();
+}
+
+void WsThreadHelper::wakeUpWebSocketThread()
+{
+    std::lock_guard<std::mutex> lk(_wakeUpMutex);
+    if (_wakeUpContext != nullptr)
+    {
+        // Makes the polling in lws_service return, it's safe to be invoked in other threads
+        lws_cancel_service(_wakeUpContext);
+    }
+}
+
+void WsThreadHelper::handleSubThreadMessage(WsMessage* msg)
+{
+    auto ws = (WebSocketImpl*)msg->user;
+    if (msg->what == WS_MSG_TO_SUBTHREAD_INSTANCE_DESTROYED)
+    {
+        // ws is a dangling pointer here, it's only used as the key
+        auto iter = _pendingSendMessages.find(ws);
+        if (iter != _pendingSendMessages.end())
+        {
+            for (auto pendingMsg : iter->second)
+            {
+                deleteWsMessage(pendingMsg);
+            }
+            _pendingSendMessages.erase(iter);
+        }
+        deleteWsMessage(msg);
+        return;
+    }
+
+    // REFINE: ws may be a invalid pointer
+    if (msg->what == WS_MSG_TO_SUBTHREAD_CREATE_CONNECTION)
+    {
+        ws->onClientOpenConnectionRequest();
+        deleteWsMessage(msg);
+        return;
+    }
+
+    if (msg->what == WS_MSG_TO_SUBTHREAD_CLOSE_CONNECTION)
+    {
+        deleteWsMessage(msg);
+    }
+    else
+    {
+        _pendingSendMessages[ws].push_back(msg);
+    }
+
+    // Sending data and closing are both done in LWS_CALLBACK_CLIENT_WRITEABLE
+    if (ws->_wsInstance != nullptr)
+    {
+        lws_callback_on_writable(ws->_wsInstance);
+    }
 }
 
 void WsThreadHelper::onSubThreadLoop()
 {
     if (__wsContext)
     {
-        //        _readyStateMutex.unlock();
-        __wsHelper->_subThreadWsMessageQueueMutex.lock();
-        bool isEmpty = __wsHelper->_subThreadWsMessageQueue->empty();
+        _isWakeUpPending = false;
+
+        WsMessage* msg = nullptr;
+        while (_subThreadWsMessageQueue.pop(msg))
+        {
+            _receivedMessages.push_back(msg);
+        }
 
-        if (!isEmpty)
+        // Messages followed by the destruction of their instance are dropped, their pointers are dangling.
+        // Walks backwards since a new instance may be allocated at the address of a destroyed one.
+        for (auto iter = _receivedMessages.rbegin(); iter != _receivedMessages.rend(); ++iter)
         {
-            auto iter = __wsHelper->_subThreadWsMessageQueue->begin();
-            for (; iter != __wsHelper->_subThreadWsMessageQueue->end(); )
+            WsMessage* receivedMsg = *iter;
+            bool isDestroyed = std::find(_destroyedInstances.begin(), _destroyedInstances.end(), receivedMsg->user) != _destroyedInstances.end();
+            if (receivedMsg->what == WS_MSG_TO_SUBTHREAD_INSTANCE_DESTROYED)
             {
-                auto msg = (*iter);
-                auto ws = (WebSocketImpl*)msg->user;
-                // REFINE: ws may be a invalid pointer
-                if (msg->what == WS_MSG_TO_SUBTHREAD_CREATE_CONNECTION)
+                if (!isDestroyed)
                 {
-                    ws->onClientOpenConnectionRequest();
-                    delete *iter;
-                    iter = __wsHelper->_subThreadWsMessageQueue->erase(iter);
+                    _destroyedInstances.push_back(receivedMsg->user);
                 }
-                else
-                {
-                    ++iter;
-                }
-
+            }
+            else if (isDestroyed)
+            {
+                deleteWsMessage(receivedMsg);
+                *iter = nullptr;
+            }
+        }
 
+        for (auto receivedMsg : _receivedMessages)
+        {
+            if (receivedMsg != nullptr)
+            {
+                handleSubThreadMessage(receivedMsg);
             }
         }
-        __wsHelper->_subThreadWsMessageQueueMutex.unlock();
+        _receivedMessages.clear();
+        _destroyedInstances.clear();
 
         // The second parameter passed to 'lws_service' means the timeout in milliseconds while polling websocket events.
-        // The lower value the better, otherwise, it may trigger high CPU usage.
-        // We set 2ms in 'lws_service' then sleep 3ms to make lower CPU cost.
-        // Since messages are received in websocket thread and user code is in cocos thread, we need to post event to
-        // cocos thread and trigger user callbacks by 'Scheduler::performFunctionInCocosThread'. If game's fps is set
-        // to 60 (16.66ms), the latency will be (2ms + 3ms + 16.66ms + internet delay) > 21ms
-        lws_service(__wsContext, 2);
-        std::this_thread::sleep_for(std::chrono::milliseconds(3));
+        // The thread sleeps in polling until there's network activity or new messages from cocos thread wake it up,
+        // LWS_CALLBACK_CLIENT_WRITEABLE is only requested while a connection has something to send or is closing.
+        // Received messages are posted to cocos thread in batches by 'Scheduler::performFunctionInCocosThread',
+        // so the latency is about (one frame + internet delay).
+        lws_service(__wsContext, WS_SERVICE_TIMEOUT_MS);
     }
 }
 
@@ -474,10 +735,18 @@ void WsThreadHelper::onSubThreadStarted()
 
     lws_context_creation_info creationInfo = convertToContextCreationInfo(__defaultProtocols, true);
     __wsContext = lws_create_context(&creationInfo);
+
+    std::lock_guard<std::mutex> lk(_wakeUpMutex);
+    _wakeUpContext = __wsContext;
 }
 
 void WsThreadHelper::onSubThreadEnded()
 {
+    {
+        std::lock_guard<std::mutex> lk(_wakeUpMutex);
+        _wakeUpContext = nullptr;
+    }
+
     if (__wsContext != nullptr)
     {
         lws_context_destroy(__wsContext);
@@ -501,13 +770,34 @@ void WsThreadHelper::wsThreadEntryFunc()
 
 void WsThreadHelper::sendMessageToCocosThread(const std::function<void()>& cb)
 {
-    cocos2d::Application::getInstance()->getScheduler()->performFunctionInCocosThread(cb);
+    std::shared_ptr<CocosThreadMessages> messages = _cocosThreadMessages;
+    messages->queue.push(cb);
+
+    if (!messages->isFlushScheduled.exchange(true))
+    {
+        cocos2d::Application::getInstance()->getScheduler()->performFunctionInCocosThread([messages](){
+            // Messages sent after this are delivered by the next flush
+            messages->isFlushScheduled = false;
+
+            std::function<void()> callback;
+            while (messages->queue.pop(callback))
+            {
+                callback();
+                callback = nullptr;
+            }
+        });
+    }
 }
 
 void WsThreadHelper::sendMessageToWebSocketThread(WsMessage *msg)
 {
-    std::lock_guard<std::mutex> lk(_subThreadWsMessageQueueMutex);
-    _subThreadWsMessageQueue->push_back(msg);
+    _subThreadWsMessageQueue.push(msg);
+
+    // The websocket thread clears the flag before reading the queue, one wake up is enough for a burst of messages
+    if (!_isWakeUpPending.exchange(true))
+    {
+        wakeUpWebSocketThread();
+    }
 }
 
 void WsThreadHelper::joinWebSocketThread()
@@ -518,58 +808,6 @@ void WsThreadHelper::joinWebSocketThread()
     }
 }
 
-// Define a WebSocket frame
-class WebSocketFrame
-{
-public:
-    WebSocketFrame()
-        : _payload(nullptr)
-        , _payloadLength(0)
-        , _frameLength(0)
-    {
-    }
-
-    bool init(unsigned char* buf, ssize_t len)
-    {
-        if (buf == nullptr && len > 0)
-            return false;
-
-        if (!_data.empty())
-        {
-            LOGD("WebSocketFrame was initialized, should not init it again!\n");
-            return false;
-        }
-
-        _data.reserve(LWS_PRE + len);
-        _data.resize(LWS_PRE, 0x00);
-        if (len > 0)
-        {
-            _data.insert(_data.end(), buf, buf + len);
-        }
-
-        _payload = _data.data() + LWS_PRE;
-        _payloadLength = len;
-        _frameLength = len;
-        return true;
-    }
-
-    void update(ssize_t issued)
-    {
-        _payloadLength -= issued;
-        _payload += issued;
-    }
-
-    unsigned char* getPayload() const { return _payload; }
-    ssize_t getPayloadLength() const { return _payloadLength; }
-    ssize_t getFrameLength() const { return _frameLength; }
-private:
-    unsigned char* _payload;
-    ssize_t _payloadLength;
-
-    ssize_t _frameLength;
-    std::vector<unsigned char> _data;
-};
-
 //
 
 void WebSocketImpl::closeAllConnections()
@@ -640,7 +878,15 @@ WebSocketImpl::~WebSocketImpl()
         }
     }
 
-    if (__websocketInstances == nullptr || __websocketInstances->empty())
+    if (__websocketInstances != nullptr && !__websocketInstances->empty())
+    {
+        // Releases the messages which were not sent
+        WsMessage* msg = new (std::nothrow) WsMessage();
+        msg->what = WS_MSG_TO_SUBTHREAD_INSTANCE_DESTROYED;
+        msg->user = this;
+        __wsHelper->sendMessageToWebSocketThread(msg);
+    }
+    else
     {
         __wsHelper->quitWebSocketThread();
         LOGD("before join ws thread\n");
@@ -802,6 +1048,11 @@ void WebSocketImpl::close()
         _readyStateMutex.unlock();
     }
 
+    WsMessage* msg = new (std::nothrow) WsMessage();
+    msg->what = WS_MSG_TO_SUBTHREAD_CLOSE_CONNECTION;
+    msg->user = this;
+    __wsHelper->sendMessageToWebSocketThread(msg);
+
     {
         std::unique_lock<std::mutex> lkClose(_closeMutex);
         _closeCondition.wait(lkClose);
@@ -814,11 +1065,22 @@ void WebSocketImpl::close()
 }
 
 void WebSocketImpl::closeAsync()
+{
+    if (requestClose())
+    {
+        WsMessage* msg = new (std::nothrow) WsMessage();
+        msg->what = WS_MSG_TO_SUBTHREAD_CLOSE_CONNECTION;
+        msg->user = this;
+        __wsHelper->sendMessageToWebSocketThread(msg);
+    }
+}
+
+bool WebSocketImpl::requestClose()
 {
     if (_closeState != CloseState::NONE)
     {
         LOGD("close was invoked, don't invoke it again!\n");
-        return;
+        return false;
     }
 
     _closeState = CloseState::ASYNC_CLOSING;
@@ -828,10 +1090,11 @@ void WebSocketImpl::closeAsync()
     if (_readyState == cocos2d::network::WebSocket::State::CLOSED || _readyState == cocos2d::network::WebSocket::State::CLOSING)
     {
         LOGD("closeAsync: WebSocket (%p) was closed, no need to close it again!\n", this);
-        return;
+        return false;
     }
 
     _readyState = cocos2d::network::WebSocket::State::CLOSING;
+    return true;
 }
 
 cocos2d::network::WebSocket::State WebSocketImpl::getReadyState() const
@@ -1034,34 +1297,22 @@ int WebSocketImpl::onClientWritable()
         }
     }
 
+    // The messages of this connection, they're only touched in websocket thread
+    std::deque<WsMessage*>* messages = nullptr;
+    bool isClosing = false;
+
     do
     {
-        std::lock_guard<std::mutex> lk(__wsHelper->_subThreadWsMessageQueueMutex);
-
-        if (__wsHelper->_subThreadWsMessageQueue->empty())
+        auto iter = __wsHelper->_pendingSendMessages.find(this);
+        if (iter == __wsHelper->_pendingSendMessages.end() || iter->second.empty())
         {
             break;
         }
-
-        std::list<WsMessage*>::iterator iter = __wsHelper->_subThreadWsMessageQueue->begin();
-
-        while (iter != __wsHelper->_subThreadWsMessageQueue->end())
-        {
-            WsMessage* msg = *iter;
-            if (msg->user == this)
-            {
-                break;
-            }
-            else
-            {
-                ++iter;
-            }
-        }
+        messages = &iter->second;
 
         ssize_t bytesWrite = 0;
-        if (iter != __wsHelper->_subThreadWsMessageQueue->end())
         {
-            WsMessage* subThreadMsg = *iter;
+            WsMessage* subThreadMsg = messages->front();
 
             cocos2d::network::WebSocket::Data* data = (cocos2d::network::WebSocket::Data*)subThreadMsg->data;
 
@@ -1091,7 +1342,7 @@ int WebSocketImpl::onClientWritable()
                     delete frame;
                     CC_SAFE_FREE(data->bytes);
                     CC_SAFE_DELETE(data);
-                    __wsHelper->_subThreadWsMessageQueue->erase(iter);
+                    messages->pop_front();
                     CC_SAFE_DELETE(subThreadMsg);
                     break;
                 }
@@ -1133,10 +1384,10 @@ int WebSocketImpl::onClientWritable()
                 delete ((WebSocketFrame*)data->ext);
                 data->ext = nullptr;
                 CC_SAFE_DELETE(data);
-                __wsHelper->_subThreadWsMessageQueue->erase(iter);
+                messages->pop_front();
                 CC_SAFE_DELETE(subThreadMsg);
 
-                closeAsync();
+                isClosing = requestClose();
             }
             else if (bytesWrite < frame->getPayloadLength())
             {
@@ -1165,14 +1416,14 @@ int WebSocketImpl::onClientWritable()
                 {
                     LOGD("ERROR: msg(%u), remaining(%d) < bytesWrite(%d)\n", subThreadMsg->id, (int)remaining, (int)frame->getFrameLength());
                     LOGD("Drop the msg(%u)\n", subThreadMsg->id);
-                    closeAsync();
+                    isClosing = requestClose();
                 }
 
                 CC_SAFE_FREE(data->bytes);
                 delete ((WebSocketFrame*)data->ext);
                 data->ext = nullptr;
                 CC_SAFE_DELETE(data);
-                __wsHelper->_subThreadWsMessageQueue->erase(iter);
+                messages->pop_front();
                 CC_SAFE_DELETE(subThreadMsg);
 
                 LOGD("-----------------------------------------------------------\n");
@@ -1181,7 +1432,8 @@ int WebSocketImpl::onClientWritable()
 
     } while(false);
 
-    if (_wsInstance != nullptr)
+    // Only asks for the next callback if there's more to send, or to return -1 for closing
+    if (_wsInstance != nullptr && (isClosing || (messages != nullptr && !messages->empty())))
     {
         lws_callback_on_writable(_wsInstance);
     }
@@ -1213,7 +1465,7 @@ int WebSocketImpl::onClientReceivedData(void* in, ssize_t len)
 
     if (remainingSize == 0 && isFinalFragment)
     {
-        std::vector<char>* frameData = new (std::nothrow) std::vector<char>(std::move(_receivedData));
+        std::shared_ptr<std::vector<char>> frameData = std::make_shared<std::vector<char>>(std::move(_receivedData));
 
         // reset capacity of received data buffer
         _receivedData.reserve(WS_RESERVE_RECEIVE_BUFFER_SIZE);
@@ -1236,6 +1488,7 @@ int WebSocketImpl::onClientReceivedData(void* in, ssize_t len)
             data.isBinary = isBinary;
             data.bytes = (char*)frameData->data();
             data.len = frameSize;
+            data.owner = frameData;
 
             if (*isDestroyed)
             {
@@ -1245,8 +1498,6 @@ int WebSocketImpl::onClientReceivedData(void* in, ssize_t len)
             {
                 _delegate->onMessage(_ws, data);
             }
-
-            delete frameData;
         });
     }
 
@@ -31,6 +31,7 @@
 #include "platform/CCStdC.h"
 #include "base/CCRef.h"
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -93,6 +94,8 @@ public:
         ssize_t len, issued;
         bool isBinary;
         void* ext;
+        /** Owns the memory pointed to by bytes if not empty, hold a copy of it to use bytes after onMessage returns. */
+        std::shared_ptr<void> owner;
     };
 
     /**
@@ -33,6 +33,7 @@ THE SOFTWARE.
 #include "base/CCData.h"
 #include "base/ccConfig.h" // CC_USE_JPEG, CC_USE_TIFF, CC_USE_WEBP
 #include "base/ccUtils.h"
+#include "base/CCPixelTransform.h"
 
 #ifndef MIN
 #define MIN(x,y) (((x) > (y)) ? (y) : (x))
@@ -2094,14 +2095,9 @@ void Image::premultipliedAlpha()
 {
     if (PNG_PREMULTIPLIED_ALPHA_ENABLED && _renderFormat == Image::PixelFormat::RGBA8888)
     {
-        unsigned int* fourBytes = (unsigned int*)_data;
-        for(int i = 0; i < _width * _height; i++)
-        {
-            unsigned char* p = _data + i * 4;
-            fourBytes[i] = CC_RGB_PREMULTIPLY_ALPHA(p[0], p[1], p[2], p[3]);
-        }
-
-        _hasPremultipliedAlpha = true;
+        PixelTransform transform;
+        transform.premultiplyAlpha = true;
+        _hasPremultipliedAlpha = ccTransformPixels(transform, _data, _data, _width, _height);
     }
     else
     {
@@ -42,6 +42,15 @@ static_assert(sizeof(float) == sizeof(GLfloat), "ERROR: GLfloat isn't equal to f
 
 namespace
 {
+    inline void deleteVertexArrays(GLsizei n, const GLuint* arrays)
+    {
+#if CC_TARGET_PLATFORM == CC_PLATFORM_IOS
+        glDeleteVertexArraysOES(n, arrays);
+#else
+        glDeleteVertexArrays(n, arrays);
+#endif
+    }
+
     void attach(GLenum location, const RenderTarget* target)
     {
         if (nullptr != dynamic_cast<const Texture2D*>(target))
@@ -53,6 +62,18 @@ namespace
             GL_CHECK(glFramebufferRenderbuffer(GL_FRAMEBUFFER, location, GL_RENDERBUFFER, target->getHandle()));
         }
     }
+    
+    std::vector<std::string>& getUniformNames()
+    {
+        static std::vector<std::string> __names;
+        return __names;
+    }
+    
+    std::unordered_map<std::string, uint32_t>& getUniformName2Handle()
+    {
+        static std::unordered_map<std::string, uint32_t> __name2handle;
+        return __name2handle;
+    }
 } // namespace {
 
 DeviceGraphics* DeviceGraphics::getInstance()
@@ -337,25 +358,35 @@ void DeviceGraphics::setProgram(Program *program)
 }
 
 void DeviceGraphics::setTexture(const std::string& name, Texture* texture, int slot)
+{
+    setTexture(getUniformHandle(name), texture, slot);
+}
+
+void DeviceGraphics::setTexture(uint32_t handle, Texture* texture, int slot)
 {
     if (slot >= _caps.maxTextureUnits)
     {
         RENDERER_LOGW("Can not set texture %s at stage %d, max texture exceed: %d",
-                 name.c_str(), slot, _caps.maxTextureUnits);
+                 getUniformName(handle).c_str(), slot, _caps.maxTextureUnits);
         return;
     }
     
     _nextState.setTexture(slot, texture);
-    setUniformi(name, slot);
+    setUniform(handle, &slot, sizeof(int), UniformElementType::INT);
 }
 
 void DeviceGraphics::setTextureArray(const std::string& name, const std::vector<Texture*>& textures, const std::vector<int>& slots)
+{
+    setTextureArray(getUniformHandle(name), textures, slots);
+}
+
+void DeviceGraphics::setTextureArray(uint32_t handle, const std::vector<Texture*>& textures, const std::vector<int>& slots)
 {
     auto len = textures.size();
     if (len >= _caps.maxTextureUnits)
     {
         RENDERER_LOGW("Can not set %d textures for %s, max texture exceed: %d",
-                 (int)len, name.c_str(), _caps.maxTextureUnits);
+                 (int)len, getUniformName(handle).c_str(), _caps.maxTextureUnits);
         return;
     }
     for (size_t i = 0; i < len; ++i)
@@ -364,7 +395,7 @@ void DeviceGraphics::setTextureArray(const std::string& name, const std::vector<
         _nextState.setTexture(slot, textures[i]);
     }
     
-    setUniformiv(name, slots.size(), slots.data());
+    setUniformiv(handle, slots.size(), slots.data());
 }
 
 void DeviceGraphics::setPrimitiveType(PrimitiveType type)
@@ -378,11 +409,12 @@ void DeviceGraphics::draw(size_t base, GLsizei count)
     commitDepthStates();
     commitStencilStates();
     commitCullMode();
-    commitVertexBuffer();
     
     auto nextIndexBuffer = _nextState.getIndexBuffer();
-    if (_currentState.getIndexBuffer() != nextIndexBuffer)
+    if (!commitVertexArray())
     {
+        commitVertexBuffer();
+        // the state cache skips redundant binds, the index buffer may differ from _currentState after using vertex arrays
         GL_CHECK(ccBindBuffer(GL_ELEMENT_ARRAY_BUFFER, nextIndexBuffer ? nextIndexBuffer->getHandle() : 0));
     }
     
@@ -404,13 +436,16 @@ void DeviceGraphics::draw(size_t base, GLsizei count)
     
     //commit uniforms
     const auto& uniformsInfo = _nextState.getProgram()->getUniforms();
+    size_t uniformCount = _uniforms.size();
     for (const auto& uniformInfo : uniformsInfo)
     {
-        auto iter = _uniforms.find(uniformInfo.name);
-        if (_uniforms.end() == iter)
+        if (uniformInfo.handle >= uniformCount)
+            continue;
+        
+        auto& uniform = _uniforms[uniformInfo.handle];
+        if (nullptr == uniform.value)
             continue;
         
-        auto& uniform = iter->second;
         if (!programDirty && !uniform.dirty)
             continue;
         
@@ -434,20 +469,56 @@ void DeviceGraphics::draw(size_t base, GLsizei count)
     _currentState = std::move(_nextState);
 }
 
+uint32_t DeviceGraphics::getUniformHandle(const std::string& name)
+{
+    auto& name2handle = getUniformName2Handle();
+    auto iter = name2handle.find(name);
+    if (name2handle.end() != iter)
+        return iter->second;
+    
+    auto& names = getUniformNames();
+    uint32_t handle = (uint32_t)names.size();
+    names.push_back(name);
+    name2handle.emplace(name, handle);
+    return handle;
+}
+
+bool DeviceGraphics::isUniformHandleValid(uint32_t handle)
+{
+    return handle < getUniformNames().size();
+}
+
+const std::string& DeviceGraphics::getUniformName(uint32_t handle)
+{
+    static const std::string EMPTY_NAME;
+    const auto& names = getUniformNames();
+    if (handle >= names.size())
+        return EMPTY_NAME;
+    
+    return names[handle];
+}
+
 void DeviceGraphics::setUniform(const std::string& name, const void* v, size_t bytes, UniformElementType elementType)
 {
-    auto iter = _uniforms.find(name);
-    if (iter == _uniforms.end())
-    {
-        Uniform uniform(v, bytes, elementType);
-        _uniforms[name] = std::move(uniform);
-    }
-    else
+    setUniform(getUniformHandle(name), v, bytes, elementType);
+}
+
+void DeviceGraphics::setUniform(uint32_t handle, const void* v, size_t bytes, UniformElementType elementType)
+{
+    // Only handles issued by getUniformHandle() are accepted, _uniforms is sized by them.
+    if (!isUniformHandleValid(handle))
     {
-        auto& uniform = iter->second;
-        uniform.dirty = true;
-        uniform.setValue(v, bytes);
+        RENDERER_LOGW("Invalid uniform handle: %u", handle);
+        return;
     }
+
+    if (handle >= _uniforms.size())
+        _uniforms.resize(handle + 1);
+    
+    auto& uniform = _uniforms[handle];
+    uniform.dirty = true;
+    uniform.elementType = elementType;
+    uniform.setValue(v, bytes);
 }
 
 void DeviceGraphics::setUniformi(const std::string& name, int i1)
@@ -478,6 +549,11 @@ void DeviceGraphics::setUniformiv(const std::string& name, size_t count, const i
     setUniform(name, value, count * sizeof(int), UniformElementType::INT);
 }
 
+void DeviceGraphics::setUniformiv(uint32_t handle, size_t count, const int* value)
+{
+    setUniform(handle, value, count * sizeof(int), UniformElementType::INT);
+}
+
 void DeviceGraphics::setUniformf(const std::string& name, float f1)
 {
     setUniform(name, &f1, sizeof(float), UniformElementType::FLOAT);
@@ -506,6 +582,11 @@ void DeviceGraphics::setUniformfv(const std::string& name, size_t count, const f
     setUniform(name, value, count * sizeof(float), UniformElementType::FLOAT);
 }
 
+void DeviceGraphics::setUniformfv(uint32_t handle, size_t count, const float* value)
+{
+    setUniform(handle, value, count * sizeof(float), UniformElementType::FLOAT);
+}
+
 void DeviceGraphics::setUniformVec2(const std::string& name, const cocos2d::Vec2& value)
 {
     setUniform(name, &value, sizeof(Vec2), UniformElementType::FLOAT);
@@ -541,6 +622,11 @@ void DeviceGraphics::setUniformMat4(const std::string& name, const cocos2d::Mat4
     setUniform(name, value.m, 16 * sizeof(float), UniformElementType::FLOAT);
 }
 
+void DeviceGraphics::setUniformMat4(uint32_t handle, const cocos2d::Mat4& value)
+{
+    setUniform(handle, value.m, 16 * sizeof(float), UniformElementType::FLOAT);
+}
+
 //
 // Priviate funcitons.
 //
@@ -564,6 +650,18 @@ DeviceGraphics::DeviceGraphics()
     _newAttributes.resize(_caps.maxVertexAttributes);
     _enabledAtrributes.resize(_caps.maxVertexAttributes);
     
+#if CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID
+    _vertexArraySupported = glGenVertexArraysOESEXT && glBindVertexArrayOESEXT && glDeleteVertexArraysOESEXT &&
+                            supportGLExtension("GL_OES_vertex_array_object");
+#elif CC_TARGET_PLATFORM == CC_PLATFORM_IOS
+    _vertexArraySupported = supportGLExtension("GL_OES_vertex_array_object");
+#elif CC_TARGET_PLATFORM == CC_PLATFORM_MAC
+    _vertexArraySupported = supportGLExtension("GL_APPLE_vertex_array_object");
+#else
+    _vertexArraySupported = glGenVertexArrays && glBindVertexArray && glDeleteVertexArrays;
+#endif
+    _uniforms.reserve(64);
+    
     // Make sure _currentState and _nextState have enough sapce for textures.
     _currentState.setTexture(_caps.maxTextureUnits, nullptr);
     _nextState.setTexture(_caps.maxTextureUnits, nullptr);
@@ -573,6 +671,10 @@ DeviceGraphics::DeviceGraphics()
 
 DeviceGraphics::~DeviceGraphics()
 {
+    resetVertexArray();
+    for (const auto& iter : _vertexArrays)
+        deleteVertexArrays(1, &iter.second);
+    
     delete _glExtensions;
     RENDERER_SAFE_RELEASE(_frameBuffer);
 }
@@ -650,6 +752,87 @@ void DeviceGraphics::restoreTexture(uint32_t index)
     }
 }
 
+void DeviceGraphics::resetVertexArray()
+{
+    if (0 == _boundVertexArray)
+        return;
+    
+    GL_CHECK(glBindVertexArray(0));
+    _boundVertexArray = 0;
+    _defaultAttributesDirty = true;
+}
+
+void DeviceGraphics::onBufferDestroyed(GLuint buffer)
+{
+    for (auto iter = _vertexArrays.begin(); iter != _vertexArrays.end();)
+    {
+        if (iter->first.vertexBuffer == buffer || iter->first.indexBuffer == buffer)
+        {
+            if (iter->second == _boundVertexArray)
+                resetVertexArray();
+            deleteVertexArrays(1, &iter->second);
+            iter = _vertexArrays.erase(iter);
+        }
+        else
+            ++iter;
+    }
+}
+
+void DeviceGraphics::onProgramDestroyed(uint32_t programID)
+{
+    for (auto iter = _vertexArrays.begin(); iter != _vertexArrays.end();)
+    {
+        if (iter->first.programID == programID)
+        {
+            if (iter->second == _boundVertexArray)
+                resetVertexArray();
+            deleteVertexArrays(1, &iter->second);
+            iter = _vertexArrays.erase(iter);
+        }
+        else
+            ++iter;
+    }
+    
+    for (auto iter = _attributeBindings.begin(); iter != _attributeBindings.end();)
+    {
+        if ((uint32_t)(iter->first >> 32) == programID)
+            iter = _attributeBindings.erase(iter);
+        else
+            ++iter;
+    }
+    
+    _boundVertexArrayKey = VertexArrayKey();
+}
+
+const std::vector<DeviceGraphics::AttributeBinding>& DeviceGraphics::getAttributeBindings(const Program* program, const VertexFormat& format)
+{
+    uint64_t key = (uint64_t)program->getID() << 32 | format.getID();
+    auto iter = _attributeBindings.find(key);
+    if (iter != _attributeBindings.end())
+        return iter->second;
+    
+    auto& bindings = _attributeBindings[key];
+    for (const auto& attr : program->getAttributes())
+    {
+        const auto& el = format.getElement(attr.name);
+        if (!el.isValid())
+        {
+            RENDERER_LOGW("Can not find vertex attribute: %s", attr.name.c_str());
+            continue;
+        }
+        
+        AttributeBinding binding;
+        binding.location = attr.location;
+        binding.num = el.num;
+        binding.type = ENUM_CLASS_TO_GLENUM(el.type);
+        binding.normalize = el.normalize;
+        binding.stride = el.stride;
+        binding.offset = el.offset;
+        bindings.push_back(binding);
+    }
+    return bindings;
+}
+
 void DeviceGraphics::restoreIndexBuffer()
 {
     auto ib = _currentState.getIndexBuffer();
@@ -995,7 +1178,7 @@ void DeviceGraphics::commitVertexBuffer()
     }
     
     bool attrsDirty = false;
-    if (_currentState.maxStream != _nextState.maxStream)
+    if (_defaultAttributesDirty || _currentState.maxStream != _nextState.maxStream)
         attrsDirty = true;
     else if (_currentState.getProgram() != _nextState.getProgram())
         attrsDirty = true;
@@ -1014,6 +1197,7 @@ void DeviceGraphics::commitVertexBuffer()
     
     if (attrsDirty)
     {
+        _defaultAttributesDirty = false;
         for (int i = 0; i < _caps.maxVertexAttributes; ++i)
             _newAttributes[i] = 0;
         
@@ -1026,32 +1210,22 @@ void DeviceGraphics::commitVertexBuffer()
             GL_CHECK(ccBindBuffer(GL_ARRAY_BUFFER, vb->getHandle()));
             
             auto vboffset = _nextState.getVertexBufferOffset(i);
-            const auto& attributes = _nextState.getProgram()->getAttributes();
-            auto usedAttriLen = attributes.size();
-            for (int j = 0; j < usedAttriLen; ++j)
+            for (const auto& binding : getAttributeBindings(_nextState.getProgram(), vb->getFormat()))
             {
-                const auto& attr = attributes[j];
-                const auto& el = vb->getFormat().getElement(attr.name);
-                if (!el.isValid())
+                if (0 == _enabledAtrributes[binding.location])
                 {
-                    RENDERER_LOGW("Can not find vertex attribute: %s", attr.name.c_str());
-                    continue;
+                    GL_CHECK(ccEnableVertexAttribArray(binding.location));
+                    _enabledAtrributes[binding.location] = 1;
                 }
-                
-                if (0 == _enabledAtrributes[attr.location])
-                {
-                    GL_CHECK(ccEnableVertexAttribArray(attr.location));
-                    _enabledAtrributes[attr.location] = 1;
-                }
-                _newAttributes[attr.location] = 1;
+                _newAttributes[binding.location] = 1;
                 
                 // glVertexAttribPointer (GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const GLvoid *pointer);
-                GL_CHECK(ccVertexAttribPointer(attr.location,
-                                      el.num,
-                                      ENUM_CLASS_TO_GLENUM(el.type),
-                                      el.normalize,
-                                      el.stride,
-                                      (GLvoid*)(el.offset + vboffset * el.stride)));
+                GL_CHECK(ccVertexAttribPointer(binding.location,
+                                      binding.num,
+                                      binding.type,
+                                      binding.normalize,
+                                      binding.stride,
+                                      (GLvoid*)(binding.offset + vboffset * binding.stride)));
             }
         }
         
@@ -1067,6 +1241,61 @@ void DeviceGraphics::commitVertexBuffer()
     }
 }
 
+bool DeviceGraphics::commitVertexArray()
+{
+    // multiple streams and draws without buffers take the default vertex array path
+    VertexBuffer* vb = _nextState.maxStream == 0 ? _nextState.getVertexBuffer(0) : nullptr;
+    Program* program = _nextState.getProgram();
+    if (!_vertexArraySupported || !vb || !program)
+    {
+        resetVertexArray();
+        return false;
+    }
+    
+    IndexBuffer* ib = _nextState.getIndexBuffer();
+    VertexArrayKey key;
+    key.programID = program->getID();
+    key.formatID = vb->getFormat().getID();
+    key.vertexBuffer = vb->getHandle();
+    key.indexBuffer = ib ? ib->getHandle() : 0;
+    key.vertexOffset = _nextState.getVertexBufferOffset(0);
+    if (0 != _boundVertexArray && key == _boundVertexArrayKey)
+        return true;
+    
+    GLuint vao = 0;
+    auto iter = _vertexArrays.find(key);
+    if (iter != _vertexArrays.end())
+    {
+        vao = iter->second;
+        GL_CHECK(glBindVertexArray(vao));
+    }
+    else
+    {
+        GL_CHECK(glGenVertexArrays(1, &vao));
+        GL_CHECK(glBindVertexArray(vao));
+        
+        // the array buffer binding isn't vertex array state, keep the state cache in sync
+        GL_CHECK(ccBindBuffer(GL_ARRAY_BUFFER, key.vertexBuffer));
+        for (const auto& binding : getAttributeBindings(program, vb->getFormat()))
+        {
+            GL_CHECK(glEnableVertexAttribArray(binding.location));
+            GL_CHECK(glVertexAttribPointer(binding.location,
+                                           binding.num,
+                                           binding.type,
+                                           binding.normalize,
+                                           binding.stride,
+                                           (GLvoid*)(binding.offset + key.vertexOffset * binding.stride)));
+        }
+        // bound directly, the state cache tracks the bindings of the default vertex array
+        GL_CHECK(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, key.indexBuffer));
+        _vertexArrays.emplace(key, vao);
+    }
+    
+    _boundVertexArray = vao;
+    _boundVertexArrayKey = key;
+    return true;
+}
+
 void DeviceGraphics::commitTextures()
 {
     const auto& curTextureUnits = _currentState.getTextureUnits();
@@ -1092,33 +1321,29 @@ void DeviceGraphics::commitTextures()
 // Uniform
 //
 DeviceGraphics::Uniform::Uniform()
-: dirty(true)
-, value(nullptr)
+: value(nullptr)
+, capacity(0)
+, dirty(true)
 , elementType(UniformElementType::FLOAT)
 {}
 
 DeviceGraphics::Uniform::Uniform(const void* v, size_t bytes, UniformElementType elementType_)
-: dirty(true)
-, value(nullptr)
+: value(nullptr)
+, capacity(0)
+, dirty(true)
 , elementType(elementType_)
 {
     setValue(v, bytes);
 }
 
 DeviceGraphics::Uniform::Uniform(Uniform&& h)
+: value(h.value)
+, capacity(h.capacity)
+, dirty(h.dirty)
+, elementType(h.elementType)
 {
-    if (this == &h)
-        return;
-
-    if (value != nullptr)
-    {
-        free(value);
-    }
-    value = h.value;
     h.value = nullptr;
-    
-    dirty = h.dirty;
-    elementType = h.elementType;
+    h.capacity = 0;
 }
 
 DeviceGraphics::Uniform::~Uniform()
@@ -1142,7 +1367,9 @@ DeviceGraphics::Uniform& DeviceGraphics::Uniform::operator=(Uniform&& h)
         free(value);
     }
     value = h.value;
+    capacity = h.capacity;
     h.value = nullptr;
+    h.capacity = 0;
     elementType = h.elementType;
     
     return *this;
@@ -1150,9 +1377,13 @@ DeviceGraphics::Uniform& DeviceGraphics::Uniform::operator=(Uniform&& h)
 
 void DeviceGraphics::Uniform::setValue(const void* v, size_t bytes)
 {
-    if (value)
-        free(value);
-    value = malloc(bytes);
+    if (bytes > capacity)
+    {
+        if (value)
+            free(value);
+        value = malloc(bytes);
+        capacity = bytes;
+    }
     memcpy(value, v, bytes);
 }
 
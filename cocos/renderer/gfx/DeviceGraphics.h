@@ -45,6 +45,7 @@ class FrameBuffer;
 class VertexBuffer;
 class IndexBuffer;
 class Program;
+class VertexFormat;
 class Texture;
 
 class DeviceGraphics final : public Ref
@@ -98,19 +99,31 @@ public:
     void setVertexBuffer(int stream, VertexBuffer* buffer, int start = 0);
     void setIndexBuffer(IndexBuffer *buffer);
     void setProgram(Program *program);
+    // Draws bind vertex array objects if supported, call it before code outside of the device
+    // touches vertex attributes or index buffer bindings, at the end of a frame for example.
+    void resetVertexArray();
     void setTexture(const std::string& name, Texture* texture, int slot);
+    void setTexture(uint32_t handle, Texture* texture, int slot);
     void setTextureArray(const std::string& name, const std::vector<Texture*>& textures, const std::vector<int>& slots);
+    void setTextureArray(uint32_t handle, const std::vector<Texture*>& textures, const std::vector<int>& slots);
+    
+    // Uniform names are interned into dense integer handles, the handle version setters avoid hashing strings.
+    static uint32_t getUniformHandle(const std::string& name);
+    static const std::string& getUniformName(uint32_t handle);
+    static bool isUniformHandleValid(uint32_t handle);
     
     void setUniformi(const std::string& name, int i1);
     void setUniformi(const std::string& name, int i1, int i2);
     void setUniformi(const std::string& name, int i1, int i2, int i3);
     void setUniformi(const std::string& name, int i1, int i2, int i3, int i4);
     void setUniformiv(const std::string& name, size_t count, const int* value);
+    void setUniformiv(uint32_t handle, size_t count, const int* value);
     void setUniformf(const std::string& name, float f1);
     void setUniformf(const std::string& name, float f1, float f2);
     void setUniformf(const std::string& name, float f1, float f2, float f3);
     void setUniformf(const std::string& name, float f1, float f2, float f3, float f4);
     void setUniformfv(const std::string& name, size_t count, const float* value);
+    void setUniformfv(uint32_t handle, size_t count, const float* value);
     void setUniformVec2(const std::string& name, const cocos2d::Vec2& value);
     void setUniformVec3(const std::string& name, const cocos2d::Vec3& value);
     void setUniformVec4(const std::string& name, const cocos2d::Vec4& value);
@@ -118,7 +131,9 @@ public:
     void setUniformMat3(const std::string& name, float* value);
     void setUniformMat4(const std::string& name, float* value);
     void setUniformMat4(const std::string& name, const cocos2d::Mat4& value);
+    void setUniformMat4(uint32_t handle, const cocos2d::Mat4& value);
     void setUniform(const std::string& name, const void* v, size_t bytes, UniformElementType elementType);
+    void setUniform(uint32_t handle, const void* v, size_t bytes, UniformElementType elementType);
 
     void setPrimitiveType(PrimitiveType type);
     
@@ -135,9 +150,12 @@ private:
 
         Uniform& operator=(Uniform&& h);
 
+        // Reuses the memory if it is big enough.
         void setValue(const void* v, size_t bytes);
 
+        // nullptr if the uniform is never set
         void* value;
+        size_t capacity;
         bool dirty;
         UniformElementType elementType;
     private:
@@ -149,16 +167,63 @@ private:
     ~DeviceGraphics();
     CC_DISALLOW_COPY_ASSIGN_AND_MOVE(DeviceGraphics);
     
+    // Attribute layout of a program bound to a vertex format, resolved once.
+    struct AttributeBinding
+    {
+        GLuint location;
+        GLint num;
+        GLenum type;
+        GLboolean normalize;
+        GLsizei stride;
+        size_t offset;
+    };
+
+    // Everything a vertex array object captures.
+    struct VertexArrayKey
+    {
+        uint32_t programID = 0;
+        uint32_t formatID = 0;
+        GLuint vertexBuffer = 0;
+        GLuint indexBuffer = 0;
+        int32_t vertexOffset = 0;
+
+        inline bool operator==(const VertexArrayKey& o) const
+        {
+            return programID == o.programID && formatID == o.formatID && vertexBuffer == o.vertexBuffer &&
+                   indexBuffer == o.indexBuffer && vertexOffset == o.vertexOffset;
+        }
+    };
+
+    struct VertexArrayKeyHash
+    {
+        inline size_t operator()(const VertexArrayKey& key) const
+        {
+            size_t hash = key.programID;
+            hash = hash * 31 + key.formatID;
+            hash = hash * 31 + key.vertexBuffer;
+            hash = hash * 31 + key.indexBuffer;
+            hash = hash * 31 + (size_t)key.vertexOffset;
+            return hash;
+        }
+    };
+
     inline void initStates();
     inline void initCaps();
     void restoreTexture(uint32_t index);
     void restoreIndexBuffer();
+    const std::vector<AttributeBinding>& getAttributeBindings(const Program* program, const VertexFormat& format);
+    // Deletes the vertex array objects referencing the buffer, its name may be reused.
+    void onBufferDestroyed(GLuint buffer);
+    // Drops the vertex arrays and attribute bindings of the program, programID is Program::getID().
+    void onProgramDestroyed(uint32_t programID);
 
     inline void commitBlendStates();
     inline void commitDepthStates();
     inline void commitStencilStates();
     inline void commitCullMode();
     inline void commitVertexBuffer();
+    // Returns false if vertex array objects can't be used for the draw.
+    inline bool commitVertexArray();
     inline void commitTextures();
 
     int _vx;
@@ -179,13 +244,24 @@ private:
     FrameBuffer *_frameBuffer;
     std::vector<int> _enabledAtrributes;
     std::vector<int> _newAttributes;
-    std::unordered_map<std::string, Uniform> _uniforms;
+    // indexed by program id << 32 | vertex format id
+    std::unordered_map<uint64_t, std::vector<AttributeBinding>> _attributeBindings;
+    std::unordered_map<VertexArrayKey, GLuint, VertexArrayKeyHash> _vertexArrays;
+    VertexArrayKey _boundVertexArrayKey;
+    GLuint _boundVertexArray = 0;
+    bool _vertexArraySupported = false;
+    // attributes of the default vertex array may differ from _currentState after drawing with vertex arrays
+    bool _defaultAttributesDirty = false;
+    // indexed by uniform handle
+    std::vector<Uniform> _uniforms;
     
     State _nextState;
     State _currentState;
     
     friend class IndexBuffer;
+    friend class VertexBuffer;
     friend class Texture2D;
+    friend class Program;
 };
 
 RENDERER_END
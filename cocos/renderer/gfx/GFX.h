@@ -26,6 +26,7 @@
 
 #include "IndexBuffer.h"
 #include "VertexBuffer.h"
+#include "TransientGeometry.h"
 #include "DeviceGraphics.h"
 #include "FrameBuffer.h"
 #include "State.h"
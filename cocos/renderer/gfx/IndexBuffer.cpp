@@ -68,6 +68,11 @@ bool IndexBuffer::init(DeviceGraphics* device, IndexFormat format, Usage usage,
 
     // update
     glGenBuffers(1, &_glID);
+    if (_glID == 0)
+    {
+        RENDERER_LOGE("Failed to create index buffer.");
+        return false;
+    }
     update(0, data, dataByteLength);
 
     // stats
@@ -91,6 +96,8 @@ void IndexBuffer::update(uint32_t offset, const void* data, size_t dataByteLengt
     }
 
     GLenum glUsage = (GLenum)_usage;
+    // the index buffer binding belongs to the bound vertex array
+    _device->resetVertexArray();
     ccBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _glID);
     if (!data)
     {
@@ -110,11 +117,34 @@ void IndexBuffer::update(uint32_t offset, const void* data, size_t dataByteLengt
     _device->restoreIndexBuffer();
 }
 
+void IndexBuffer::updateSubData(uint32_t offset, const void* data, size_t dataByteLength)
+{
+    if (_glID == 0)
+    {
+        RENDERER_LOGE("The buffer is destroyed");
+        return;
+    }
+
+    if (dataByteLength + offset > _bytes)
+    {
+        RENDERER_LOGE("Failed to update index buffer data, bytes exceed.");
+        return;
+    }
+
+    // the index buffer binding belongs to the bound vertex array
+    _device->resetVertexArray();
+    ccBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _glID);
+    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, (GLintptr)offset, (GLsizeiptr)dataByteLength, (const GLvoid*)data);
+    _device->restoreIndexBuffer();
+}
+
 void IndexBuffer::destroy()
 {
     if (_glID == 0)
         return;
     
+    if (_device)
+        _device->onBufferDestroyed(_glID);
     ccDeleteBuffers(1, &_glID);
     //REFINE:    _device._stats.ib -= _bytes;
     _glID = 0;
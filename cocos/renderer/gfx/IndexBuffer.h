@@ -42,6 +42,8 @@ public:
 
     bool init(DeviceGraphics* device, IndexFormat format, Usage usage, const void* data, size_t dataByteLength, uint32_t numIndices);
     void update(uint32_t offset, const void* data, size_t dataByteLength);
+    // Unlike update(), never reallocates the storage even if offset is 0.
+    void updateSubData(uint32_t offset, const void* data, size_t dataByteLength);
 
     inline uint32_t getCount() const { return _numIndices; }
     inline void setCount(uint32_t numIndices) { _numIndices = numIndices; }
@@ -24,6 +24,7 @@
 
 #include "Program.h"
 #include "GFXUtils.h"
+#include "DeviceGraphics.h"
 
 #include <unordered_map>
 #include <stdlib.h>
@@ -234,14 +235,18 @@ void Program::Uniform::setUniform(const void* value, UniformElementType elementT
 
 Program::Program()
 : _device(nullptr)
+, _binaryFormat(0)
 , _id(0)
 , _linked(false)
+, _linkedFromBinary(false)
 {
 
 }
 
 Program::~Program()
 {
+    if (_device)
+        _device->onProgramDestroyed(_id);
     GL_CHECK(glDeleteProgram(_glID));
 }
 
@@ -259,23 +264,91 @@ bool Program::init(DeviceGraphics* device, const char* vertSource, const char* f
     return true;
 }
 
-void Program::link()
+bool Program::isBinarySupported(DeviceGraphics* device)
 {
-    if (_linked) {
-        return;
+#if CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID
+    static int supported = -1;
+    if (supported == -1)
+    {
+        GLint numFormats = 0;
+        if (glGetProgramBinaryOES && glProgramBinaryOES && device->supportGLExtension("GL_OES_get_program_binary"))
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS_OES, &numFormats);
+        supported = numFormats > 0 ? 1 : 0;
     }
+    return supported == 1;
+#else
+    return false;
+#endif
+}
+
+void Program::setBinary(GLenum format, const void* data, size_t length)
+{
+    _binaryFormat = format;
+    _binary.assign((const uint8_t*)data, (const uint8_t*)data + length);
+}
+
+bool Program::getBinary(GLenum* format, std::vector<uint8_t>* data) const
+{
+#if CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID
+    if (!_linked || !isBinarySupported(_device))
+        return false;
+
+    GLint length = 0;
+    GL_CHECK(glGetProgramiv(_glID, GL_PROGRAM_BINARY_LENGTH_OES, &length));
+    if (length <= 0)
+        return false;
+
+    data->resize(length);
+    GLsizei written = 0;
+    glGetProgramBinaryOES(_glID, length, &written, format, data->data());
+    if (glGetError() != GL_NO_ERROR || written <= 0)
+        return false;
+
+    data->resize(written);
+    return true;
+#else
+    return false;
+#endif
+}
+
+GLuint Program::linkBinary()
+{
+#if CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID
+    if (!isBinarySupported(_device))
+        return 0;
+
+    GLuint program = glCreateProgram();
+    glProgramBinaryOES(program, _binaryFormat, _binary.data(), (GLint)_binary.size());
 
+    // An unknown format raises GL_INVALID_ENUM and a driver update may invalidate the binary,
+    // in both cases the link status is false.
+    GLint status = GL_FALSE;
+    glGetError();
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status == GL_FALSE)
+    {
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+#else
+    return 0;
+#endif
+}
+
+GLuint Program::linkSources()
+{
     GLuint vertShader;
     bool ok = _createShader(GL_VERTEX_SHADER, _vertSource, &vertShader);
     if (!ok)
-        return;
+        return 0;
 
     GLuint fragShader;
     ok = _createShader(GL_FRAGMENT_SHADER, _fragSource, &fragShader);
     if (!ok)
     {
         glDeleteShader(vertShader);
-        return;
+        return 0;
     }
 
     GLuint program = glCreateProgram();
@@ -294,11 +367,34 @@ void Program::link()
         glDeleteShader(vertShader);
         glDeleteShader(fragShader);
         glDeleteProgram(program);
-        return;
+        return 0;
     }
 
     glDeleteShader(vertShader);
     glDeleteShader(fragShader);
+    return program;
+}
+
+void Program::link()
+{
+    if (_linked) {
+        return;
+    }
+
+    GLuint program = 0;
+    if (!_binary.empty())
+    {
+        program = linkBinary();
+        _linkedFromBinary = program != 0;
+        _binary.clear();
+        _binary.shrink_to_fit();
+    }
+
+    if (program == 0)
+        program = linkSources();
+
+    if (program == 0)
+        return;
 
     _glID = program;
 
@@ -359,6 +455,7 @@ void Program::link()
                 }
 
                 uniform.name = uniformName;
+                uniform.handle = DeviceGraphics::getUniformHandle(uniform.name);
                 GL_CHECK(uniform.location = glGetUniformLocation(program, uniformName));
 
                 GLenum err = glGetError();
@@ -50,6 +50,8 @@ public:
     struct Uniform
     {
         std::string name;
+        // handle of the name, see DeviceGraphics::getUniformHandle()
+        uint32_t handle;
         GLsizei size;
         GLint location;
         GLenum type;
@@ -69,15 +71,30 @@ public:
     inline const std::vector<Attribute>& getAttributes() const { return _attributes; }
     inline const std::vector<Uniform>& getUniforms() const { return _uniforms; }
     inline bool isLinked() const { return _linked; }
+    // Links from the binary set by setBinary() if any, falls back to compiling the sources if the driver rejects it.
     void link();
+
+    // Whether the device can save and load program binaries (GL_OES_get_program_binary).
+    static bool isBinarySupported(DeviceGraphics* device);
+    // Must be called before link().
+    void setBinary(GLenum format, const void* data, size_t length);
+    // Retrieves the binary of a linked program, returns false if it is not available.
+    bool getBinary(GLenum* format, std::vector<uint8_t>* data) const;
+    inline bool isLinkedFromBinary() const { return _linkedFromBinary; }
 private:
+    GLuint linkBinary();
+    GLuint linkSources();
+
     DeviceGraphics* _device;
     std::vector<Attribute> _attributes;
     std::vector<Uniform> _uniforms;
     std::string _vertSource;
     std::string _fragSource;
+    std::vector<uint8_t> _binary;
+    GLenum _binaryFormat;
     uint32_t _id;
     bool _linked;
+    bool _linkedFromBinary;
 };
 
 RENDERER_END
@@ -0,0 +1,139 @@
+/****************************************************************************
+ Copyright (c) 2018 Xiamen Yaji Software Co., Ltd.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+
+#include "TransientGeometry.h"
+#include "VertexBuffer.h"
+#include "IndexBuffer.h"
+
+RENDERER_BEGIN
+
+TransientGeometry::TransientGeometry()
+: _current(0)
+, _vertexBytes(0)
+, _maxVertices(0)
+, _maxIndices(0)
+, _vertexOffset(0)
+, _indexOffset(0)
+, _flushedVertices(0)
+, _flushedIndices(0)
+{
+
+}
+
+TransientGeometry::~TransientGeometry()
+{
+    for (auto& buffers : _ring)
+    {
+        RENDERER_SAFE_RELEASE(buffers.vertexBuffer);
+        RENDERER_SAFE_RELEASE(buffers.indexBuffer);
+    }
+}
+
+bool TransientGeometry::init(DeviceGraphics* device, VertexFormat* format, uint32_t maxVertices, uint32_t maxIndices, uint32_t numFrames)
+{
+    if (maxVertices > 65536)
+    {
+        RENDERER_LOGW("TransientGeometry: maxVertices %u exceeds the range of 16 bits indices.", maxVertices);
+        maxVertices = 65536;
+    }
+    if (numFrames == 0)
+        numFrames = 1;
+    if (format == nullptr || maxVertices == 0 || maxIndices == 0)
+        return false;
+
+    _ring.resize(numFrames);
+    for (auto& buffers : _ring)
+    {
+        buffers.vertexBuffer = new (std::nothrow) VertexBuffer();
+        buffers.indexBuffer = new (std::nothrow) IndexBuffer();
+        if (buffers.vertexBuffer == nullptr || buffers.indexBuffer == nullptr ||
+            !buffers.vertexBuffer->init(device, format, Usage::DYNAMIC, nullptr, 0, maxVertices) ||
+            !buffers.indexBuffer->init(device, IndexFormat::UINT16, Usage::DYNAMIC, nullptr, 0, maxIndices))
+        {
+            RENDERER_LOGW("TransientGeometry: failed to create the buffers of %u vertices and %u indices.", maxVertices, maxIndices);
+            return false;
+        }
+    }
+
+    _maxVertices = maxVertices;
+    _maxIndices = maxIndices;
+    _vertexBytes = (uint32_t)_ring[0].vertexBuffer->getBytes() / maxVertices;
+    _vertexData.resize(_vertexBytes * maxVertices);
+    _indexData.resize(maxIndices);
+    _current = 0;
+    _vertexOffset = _indexOffset = 0;
+    _flushedVertices = _flushedIndices = 0;
+    return true;
+}
+
+bool TransientGeometry::allocate(uint32_t numVertices, uint32_t numIndices, Allocation* allocation)
+{
+    if (_vertexOffset + numVertices > _maxVertices || _indexOffset + numIndices > _maxIndices)
+        return false;
+
+    const auto& buffers = _ring[_current];
+    allocation->vertexBuffer = buffers.vertexBuffer;
+    allocation->indexBuffer = buffers.indexBuffer;
+    allocation->vertexStart = _vertexOffset;
+    allocation->indexStart = _indexOffset;
+    allocation->vertices = _vertexData.data() + _vertexOffset * _vertexBytes;
+    allocation->indices = _indexData.data() + _indexOffset;
+
+    _vertexOffset += numVertices;
+    _indexOffset += numIndices;
+    return true;
+}
+
+void TransientGeometry::flush()
+{
+    const auto& buffers = _ring[_current];
+    if (_vertexOffset > _flushedVertices)
+    {
+        buffers.vertexBuffer->updateSubData(_flushedVertices * _vertexBytes,
+                                            _vertexData.data() + _flushedVertices * _vertexBytes,
+                                            (_vertexOffset - _flushedVertices) * _vertexBytes);
+        _flushedVertices = _vertexOffset;
+    }
+
+    if (_indexOffset > _flushedIndices)
+    {
+        buffers.indexBuffer->updateSubData(_flushedIndices * sizeof(uint16_t),
+                                           _indexData.data() + _flushedIndices,
+                                           (_indexOffset - _flushedIndices) * sizeof(uint16_t));
+        _flushedIndices = _indexOffset;
+    }
+}
+
+void TransientGeometry::nextFrame()
+{
+    if (_ring.empty())
+        return;
+
+    _current = (_current + 1) % _ring.size();
+    _vertexOffset = _indexOffset = 0;
+    _flushedVertices = _flushedIndices = 0;
+}
+
+RENDERER_END
@@ -0,0 +1,105 @@
+/****************************************************************************
+ Copyright (c) 2018 Xiamen Yaji Software Co., Ltd.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+
+#pragma once
+
+#include <vector>
+#include "../Macro.h"
+#include "../Types.h"
+#include "base/CCRef.h"
+
+RENDERER_BEGIN
+
+class DeviceGraphics;
+class VertexFormat;
+class VertexBuffer;
+class IndexBuffer;
+
+/**
+ * Allocator of geometry that lives for one frame only, such as sprite and label batches.
+ * Allocations are sub-allocated with a bump pointer from large vertex and index buffers, and are
+ * uploaded with one glBufferSubData per buffer in flush(). The buffers are used as a ring of
+ * numFrames entries, so the buffer written in a frame isn't the one the GPU may still read from,
+ * which avoids both driver stalls and orphaning many small buffers.
+ */
+class TransientGeometry final : public Ref
+{
+public:
+    struct Allocation
+    {
+        VertexBuffer* vertexBuffer = nullptr;
+        IndexBuffer* indexBuffer = nullptr;
+        // first vertex of the allocation, indices written to the allocation have to be offset by it
+        uint32_t vertexStart = 0;
+        // first index of the allocation, use it as the start of the input assembler
+        uint32_t indexStart = 0;
+        // memory to write vertices and indices to, valid until flush()
+        uint8_t* vertices = nullptr;
+        uint16_t* indices = nullptr;
+    };
+
+    RENDERER_DEFINE_CREATE_METHOD_5(TransientGeometry, init, DeviceGraphics*, VertexFormat*, uint32_t, uint32_t, uint32_t)
+
+    TransientGeometry();
+    virtual ~TransientGeometry();
+
+    // maxVertices can't exceed 65536 since indices are 16 bits.
+    bool init(DeviceGraphics* device, VertexFormat* format, uint32_t maxVertices, uint32_t maxIndices, uint32_t numFrames);
+
+    // Returns false if the buffers of the frame are full.
+    bool allocate(uint32_t numVertices, uint32_t numIndices, Allocation* allocation);
+    // Uploads the data allocated since the last flush, must be called before drawing the allocations.
+    void flush();
+    // Switches to the buffers of the next frame, the allocations of the previous frame become invalid.
+    void nextFrame();
+
+    inline uint32_t getVertexBytes() const { return _vertexBytes; }
+    inline uint32_t getAllocatedVertices() const { return _vertexOffset; }
+    inline uint32_t getAllocatedIndices() const { return _indexOffset; }
+
+private:
+    struct Buffers
+    {
+        VertexBuffer* vertexBuffer = nullptr;
+        IndexBuffer* indexBuffer = nullptr;
+    };
+
+    std::vector<Buffers> _ring;
+    size_t _current;
+
+    std::vector<uint8_t> _vertexData;
+    std::vector<uint16_t> _indexData;
+    uint32_t _vertexBytes;
+    uint32_t _maxVertices;
+    uint32_t _maxIndices;
+    uint32_t _vertexOffset;
+    uint32_t _indexOffset;
+    uint32_t _flushedVertices;
+    uint32_t _flushedIndices;
+
+    CC_DISALLOW_COPY_ASSIGN_AND_MOVE(TransientGeometry)
+};
+
+RENDERER_END
@@ -55,6 +55,11 @@ bool VertexBuffer::init(DeviceGraphics* device, VertexFormat* format, Usage usag
 
     // update
     glGenBuffers(1, &_glID);
+    if (_glID == 0)
+    {
+        RENDERER_LOGE("Failed to create vertex buffer.");
+        return false;
+    }
     update(0, data, dataByteLength);
 
     // stats
@@ -107,6 +112,25 @@ void VertexBuffer::update(uint32_t offset, const void* data, size_t dataByteLeng
     ccBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
+void VertexBuffer::updateSubData(uint32_t offset, const void* data, size_t dataByteLength)
+{
+    if (_glID == 0)
+    {
+        RENDERER_LOGE("The buffer is destroyed");
+        return;
+    }
+
+    if (dataByteLength + offset > _bytes)
+    {
+        RENDERER_LOGE("Failed to update vertex buffer data, bytes exceed.");
+        return;
+    }
+
+    ccBindBuffer(GL_ARRAY_BUFFER, _glID);
+    glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)offset, (GLsizeiptr)dataByteLength, (const GLvoid*)data);
+    ccBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
 void VertexBuffer::destroy()
 {
     if (_glID == 0)
@@ -114,6 +138,8 @@ void VertexBuffer::destroy()
     
     CC_SAFE_RELEASE_NULL(_format);
     
+    if (_device)
+        _device->onBufferDestroyed(_glID);
     ccDeleteBuffers(1, &_glID);
     //REFINE:    _device._stats.ib -= _bytes;
     
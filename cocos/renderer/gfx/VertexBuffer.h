@@ -44,6 +44,8 @@ public:
 
     bool init(DeviceGraphics* device, VertexFormat* format, Usage usage, const void* data, size_t dataByteLength, uint32_t numVertices);
     void update(uint32_t offset, const void* data, size_t dataByteLength);
+    // Unlike update(), never reallocates the storage even if offset is 0.
+    void updateSubData(uint32_t offset, const void* data, size_t dataByteLength);
 
     inline uint32_t getCount() const { return _numVertices; }
     inline void setCount(uint32_t numVertices) { _numVertices = numVertices; }
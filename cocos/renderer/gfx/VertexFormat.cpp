@@ -26,6 +26,8 @@
 
 RENDERER_BEGIN
 
+static uint32_t _genID = 0;
+
 static uint32_t attrTypeBytes(AttribType attrType)
 {
     if (attrType == AttribType::INT8) {
@@ -49,10 +51,13 @@ static uint32_t attrTypeBytes(AttribType attrType)
 }
 
 VertexFormat::VertexFormat()
+: _bytes(0)
+, _id(++_genID)
 {
 }
 
 VertexFormat::VertexFormat(const std::vector<Info>& infos)
+: _id(++_genID)
 {
     _bytes = 0;
 #if GFX_DEBUG > 0
@@ -107,9 +112,10 @@ VertexFormat& VertexFormat::operator=(const VertexFormat& o)
     if (this != &o)
     {
         _attr2el = o._attr2el;
+        _bytes = o._bytes;
+        _id = o._id;
 #if GFX_DEBUG > 0
         _elements = o._elements;
-        _bytes = o._bytes;
 #endif
     }
     return *this;
@@ -120,10 +126,12 @@ VertexFormat& VertexFormat::operator=(VertexFormat&& o)
     if (this != &o)
     {
         _attr2el = std::move(o._attr2el);
-#if GFX_DEBUG > 0
-        _elements = std::move(o._elements);
         _bytes = o._bytes;
+        _id = o._id;
         o._bytes = 0;
+        o._id = ++_genID;
+#if GFX_DEBUG > 0
+        _elements = std::move(o._elements);
 #endif
     }
     return *this;
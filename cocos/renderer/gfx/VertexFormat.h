@@ -89,6 +89,8 @@ public:
     VertexFormat& operator=(VertexFormat&& o);
 
     const Element& getElement(const std::string& attrName) const;
+    // Formats with the same id have the same layout.
+    inline uint32_t getID() const { return _id; }
 
 private:
     std::unordered_map<std::string, Element> _attr2el;
@@ -96,6 +98,7 @@ private:
     std::vector<Element> _elements;
 #endif
     uint32_t _bytes;
+    uint32_t _id;
 
     friend class VertexBuffer;
 };
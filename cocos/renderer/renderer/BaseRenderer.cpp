@@ -24,6 +24,11 @@
 
 #include "BaseRenderer.h"
 #include <new>
+#include <string.h>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include "base/CCThreadPool.h"
 #include "gfx/DeviceGraphics.h"
 #include "gfx/Texture2D.h"
 #include "ProgramLib.h"
@@ -35,9 +40,128 @@
 #include "Camera.h"
 #include "INode.h"
 #include "Model.h"
+#include "Config.h"
 
 RENDERER_BEGIN
 
+namespace
+{
+    // Buckets are resolved in parallel if draw items x stages exceeds this.
+    const size_t PARALLEL_DISPATCH_THRESHOLD = 4096;
+    const size_t MIN_ITEMS_PER_JOB = 1024;
+    
+    struct ParallelJob
+    {
+        std::function<void(size_t)> fn;
+        size_t count = 0;
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> done{0};
+        std::mutex mutex;
+        std::condition_variable cv;
+        
+        // Returns false if there are no more chunks.
+        bool runNext()
+        {
+            size_t index = next++;
+            if (index >= count)
+                return false;
+            
+            fn(index);
+            if (++done == count)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                cv.notify_one();
+            }
+            return true;
+        }
+    };
+    
+    // Runs fn(0) ... fn(count - 1) on the calling thread and the default thread pool. The calling
+    // thread runs the chunks that are not picked up by the pool yet, so it never waits for busy
+    // pool threads to start, only for chunks that are in progress.
+    void parallelFor(size_t count, const std::function<void(size_t)>& fn)
+    {
+        auto job = std::make_shared<ParallelJob>();
+        job->fn = fn;
+        job->count = count;
+        
+        auto pool = cocos2d::experimental::ThreadPool::getDefaultThreadPool();
+        for (size_t i = 1; i < count; ++i)
+        {
+            pool->pushTask([job](int /*threadId*/) {
+                job->runNext();
+            });
+        }
+        
+        while (job->runNext())
+            ;
+        
+        std::unique_lock<std::mutex> lock(job->mutex);
+        job->cv.wait(lock, [&job]() { return job->done == job->count; });
+    }
+
+    // Maps a float to an unsigned integer whose order is the same as the float order.
+    inline uint32_t floatToSortable(float value)
+    {
+        uint32_t bits = 0;
+        memcpy(&bits, &value, sizeof(bits));
+        return (bits & 0x80000000) ? ~bits : (bits | 0x80000000);
+    }
+    
+    // Stable LSD radix sort on 64 bits sort keys, 8 bits a pass. It sorts indices instead of
+    // items to avoid copying StageItem. A pass is skipped if all keys have the same digit, so
+    // keys that only use a few bits only pay for them.
+    void radixSort(const std::vector<BaseRenderer::StageItem>& items,
+                   std::vector<uint32_t>& indices,
+                   std::vector<uint32_t>& temp)
+    {
+        uint32_t count = (uint32_t)items.size();
+        indices.resize(count);
+        temp.resize(count);
+        for (uint32_t i = 0; i < count; ++i)
+            indices[i] = i;
+        
+        if (0 == count)
+            return;
+        
+        uint32_t histograms[8][256];
+        memset(histograms, 0, sizeof(histograms));
+        for (const auto& item : items)
+        {
+            for (int pass = 0; pass < 8; ++pass)
+                ++histograms[pass][(item.sortKey >> (pass * 8)) & 0xff];
+        }
+        
+        uint32_t* src = indices.data();
+        uint32_t* dst = temp.data();
+        for (int pass = 0; pass < 8; ++pass)
+        {
+            int shift = pass * 8;
+            uint32_t* histogram = histograms[pass];
+            if (count == histogram[(items[0].sortKey >> shift) & 0xff])
+                continue;
+            
+            uint32_t offset = 0;
+            for (int i = 0; i < 256; ++i)
+            {
+                uint32_t num = histogram[i];
+                histogram[i] = offset;
+                offset += num;
+            }
+            
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                uint32_t index = src[i];
+                dst[histogram[(items[index].sortKey >> shift) & 0xff]++] = index;
+            }
+            std::swap(src, dst);
+        }
+        
+        if (src != indices.data())
+            indices.swap(temp);
+    }
+}
+
 BaseRenderer::BaseRenderer()
 {
     _drawItems.reserve(100);
@@ -74,9 +198,12 @@ bool BaseRenderer::init(DeviceGraphics* device, std::vector<ProgramLib::Template
     return true;
 }
 
-void BaseRenderer::registerStage(const std::string& name, const StageCallback& callback)
+void BaseRenderer::registerStage(const std::string& name, const StageCallback& callback, SortMode sortMode)
 {
-    _stage2fn.emplace(std::make_pair(name, callback));
+    Stage stage;
+    stage.callback = callback;
+    stage.sortMode = sortMode;
+    _stage2fn.emplace(std::make_pair(name, stage));
 }
 
 // protected functions
@@ -99,89 +226,283 @@ void BaseRenderer::render(const View& view, const Scene* scene)
     _device->clear(view.clearFlags, &clearColor, view.depth, view.stencil);
     
     // get all draw items
-    _drawItems.clear();
-    int modelViewId = -1;
-    uint32_t drawItemCount = 0;
-    DrawItem drawItem;
-    for (const auto& model : scene->getModels())
+    updateDrawItems(scene);
+    
+    // dispatch draw items to different stage
+    dispatchStageItems(view);
+    
+    // render stages
+    std::unordered_map<std::string, Stage>::iterator foundIter;
+    for (const auto& stageInfo : _stageInfos)
     {
-        modelViewId = model->getViewId();
-        if (view.cullingByID)
+        foundIter = _stage2fn.find(stageInfo.stage);
+        if (_stage2fn.end() != foundIter)
         {
-            if (modelViewId != view.id)
-                continue;
+            auto& stage = foundIter->second;
+            stage.callback(view, sortStageItems(view, *stageInfo.items, stage.sortMode));
         }
-        else
+    }
+    
+    // others share the GL context, leave the default vertex array bound
+    _device->resetVertexArray();
+}
+
+void BaseRenderer::dispatchStageItems(const View& view)
+{
+    size_t stageCount = view.stages.size();
+    if (_stageItems.size() < stageCount)
+        _stageItems.resize(stageCount);
+    
+    _stageIDs.resize(stageCount);
+    for (size_t i = 0; i < stageCount; ++i)
+        _stageIDs[i] = Config::getStageID(view.stages[i]);
+    
+    size_t itemCount = _drawItems.size();
+    _itemTechniques.resize(itemCount * stageCount);
+    if (itemCount * stageCount >= PARALLEL_DISPATCH_THRESHOLD && itemCount >= 2 * MIN_ITEMS_PER_JOB)
+    {
+        size_t jobCount = itemCount / MIN_ITEMS_PER_JOB;
+        size_t itemsPerJob = (itemCount + jobCount - 1) / jobCount;
+        parallelFor(jobCount, [&](size_t index) {
+            size_t begin = index * itemsPerJob;
+            resolveTechniques(view, begin, std::min(begin + itemsPerJob, itemCount));
+        });
+    }
+    else
+        resolveTechniques(view, 0, itemCount);
+    
+    // gather the items of each stage, keep the order of draw items
+    _stageInfos.clear();
+    StageItem stageItem;
+    StageInfo stageInfo;
+    for (size_t stageIndex = 0; stageIndex < stageCount; ++stageIndex)
+    {
+        auto& stageItems = _stageItems[stageIndex];
+        stageItems.clear();
+        
+        Technique** techniques = _itemTechniques.data() + stageIndex * itemCount;
+        for (size_t i = 0; i < itemCount; ++i)
         {
-            if (-1 != modelViewId)
+            if (nullptr == techniques[i])
                 continue;
+            
+            const auto& item = _drawItems[i];
+            stageItem.model = item.model;
+            stageItem.ia = item.ia;
+            stageItem.effect = item.effect;
+            stageItem.defines = item.defines;
+            stageItem.technique = techniques[i];
+            stageItem.sortKey = 0;
+            
+            stageItems.push_back(stageItem);
         }
         
-        drawItemCount = model->getDrawItemCount();
-        for (uint32_t i = 0; i < drawItemCount; ++i)
+        stageInfo.stage = view.stages[stageIndex];
+        stageInfo.items = &stageItems;
+        _stageInfos.push_back(std::move(stageInfo));
+    }
+}
+
+void BaseRenderer::resolveTechniques(const View& view, size_t begin, size_t end)
+{
+    size_t stageCount = _stageIDs.size();
+    size_t itemCount = _drawItems.size();
+    int modelViewId = -1;
+    bool visible = false;
+    for (size_t i = begin; i < end; ++i)
+    {
+        const auto& item = _drawItems[i];
+        modelViewId = item.model->getViewId();
+        if (view.cullingByID)
+            visible = modelViewId == view.id;
+        else
+            visible = -1 == modelViewId;
+        
+        for (size_t stageIndex = 0; stageIndex < stageCount; ++stageIndex)
         {
-            model->extractDrawItem(drawItem, i);
-            _drawItems.push_back(drawItem);
+            _itemTechniques[stageIndex * itemCount + i] = visible ? item.effect->getTechnique(_stageIDs[stageIndex]) : nullptr;
         }
     }
+}
+
+void BaseRenderer::updateDrawItems(const Scene* scene)
+{
+    if (_cachedSceneID == scene->getID() && _cachedVersion == scene->getVersion())
+        return;
     
-    // dispatch draw items to different stage
-    _stageInfos.clear();
-    StageItem stageItem;
-    StageInfo stageInfo;
-    std::vector<StageItem> stageItems;
-    for (const auto& stage : view.stages)
+    bool rebuild = _cachedSceneID != scene->getID() || _cachedModelsVersion != scene->getModelsVersion();
+    
+    // only extract draw items of the models whose effects or input assemblers are changed
+    if (!rebuild)
     {
-        for (const auto& item : _drawItems)
+        for (const auto& model : scene->getDirtyModels())
         {
-            auto tech = item.effect->getTechnique(stage);
-            if (tech)
+            if (0 == (model->getDirtyFlags() & Model::DRAW_ITEMS))
+                continue;
+            
+            auto foundIter = _modelDrawItems.find(model);
+            if (_modelDrawItems.end() == foundIter ||
+                foundIter->second.count != model->getDrawItemCount())
             {
-                stageItem.model = item.model;
-                stageItem.ia = item.ia;
-                stageItem.effect = item.effect;
-                stageItem.defines = item.defines;
-                stageItem.technique = tech;
-                stageItem.sortKey = -1;
-                
-                stageItems.push_back(stageItem);
+                rebuild = true;
+                break;
             }
+            
+            const auto& range = foundIter->second;
+            for (uint32_t i = 0; i < range.count; ++i)
+                model->extractDrawItem(_drawItems[range.offset + i], i);
         }
+    }
+    
+    if (rebuild)
+    {
+        _drawItems.clear();
+        _modelDrawItems.clear();
         
-        stageInfo.stage = stage;
-        stageInfo.items = &stageItems;
-        _stageInfos.push_back(std::move(stageInfo));
+        bool retainedMode = scene->isRetainedMode();
+        uint32_t drawItemCount = 0;
+        DrawItem drawItem;
+        DrawItemRange range;
+        for (const auto& model : scene->getModels())
+        {
+            drawItemCount = model->getDrawItemCount();
+            range.offset = (uint32_t)_drawItems.size();
+            range.count = drawItemCount;
+            for (uint32_t i = 0; i < drawItemCount; ++i)
+            {
+                model->extractDrawItem(drawItem, i);
+                _drawItems.push_back(drawItem);
+            }
+            
+            // models are added again every frame if not in retained mode, no need to track them
+            if (retainedMode)
+                _modelDrawItems.emplace(model, range);
+        }
     }
     
-    // render stages
-    std::unordered_map<std::string, StageCallback>::iterator foundIter;
-    for (const auto& stageInfo : _stageInfos)
+    _cachedSceneID = scene->getID();
+    _cachedModelsVersion = scene->getModelsVersion();
+    _cachedVersion = scene->getVersion();
+}
+
+uint64_t BaseRenderer::getStateSortKey(const StageItem& item, float viewZ)
+{
+    // key layout: | program 16 bits | pass states 16 bits | texture 24 bits | depth 8 bits |
+    uint64_t stateKey = 0;
+    uint64_t depthKey = 0;
+    
+    const auto& passes = item.technique->getPasses();
+    if (!passes.empty())
     {
-        foundIter = _stage2fn.find(stageInfo.stage);
-        if (_stage2fn.end() != foundIter)
+        // pass states are hashed by the pass, they're not part of the key cached by the effect
+        uint32_t hash = passes.at(0)->getStateHash();
+        stateKey = (hash ^ (hash >> 16)) & 0xffff;
+    }
+    
+    uint64_t cachedKey = 0;
+    if (!item.effect->getCachedSortKey(item.technique, &cachedKey))
+    {
+        cachedKey = getProgramTextureSortKey(item);
+        item.effect->setCachedSortKey(item.technique, cachedKey);
+    }
+    
+    // front to back, only the exponent is used so items of similar distance are grouped together
+    float distance = viewZ < 0 ? -viewZ : 0;
+    depthKey = (floatToSortable(distance) >> 23) & 0xff;
+    
+    return cachedKey | (stateKey << 32) | depthKey;
+}
+
+uint64_t BaseRenderer::getProgramTextureSortKey(const StageItem& item)
+{
+    uint64_t programKey = 0;
+    uint64_t textureKey = 0;
+    
+    const auto& passes = item.technique->getPasses();
+    if (!passes.empty())
+    {
+        uint32_t key = _programLib->getKey(passes.at(0)->_programName, item.effect);
+        programKey = (key ^ (key >> 16)) & 0xffff;
+    }
+    
+    // only the first texture is taken into account, it is the main texture in most cases
+    Technique::Parameter::Type paramType = Technique::Parameter::Type::UNKNOWN;
+    for (const auto& param : item.technique->getParameters())
+    {
+        paramType = param.getType();
+        if (Technique::Parameter::Type::TEXTURE_2D != paramType &&
+            Technique::Parameter::Type::TEXTURE_CUBE != paramType)
+            continue;
+        
+        const auto& prop = item.effect->getProperty(param.getHandle());
+        Texture* texture = _defaultTexture;
+        if (nullptr != prop.getValue())
         {
-            auto& fn = foundIter->second;
-            fn(view, *stageInfo.items);
+            if (prop.getCount() > 1)
+                texture = static_cast<Texture**>(prop.getValue())[0];
+            else
+                texture = static_cast<Texture*>(prop.getValue());
         }
+        
+        if (texture)
+            textureKey = texture->getHandle() & 0xffffff;
+        break;
     }
+    
+    return (programKey << 48) | (textureKey << 8);
+}
+
+const std::vector<BaseRenderer::StageItem>& BaseRenderer::sortStageItems(const View& view, std::vector<StageItem>& items, SortMode sortMode)
+{
+    if (SortMode::NONE == sortMode || items.size() < 2)
+        return items;
+    
+    const float* matView = view.matView.m;
+    for (auto& item : items)
+    {
+        // z of model origin in view space, it is negative if the model is in front of the camera
+        const float* matWorld = item.model->getWorldMatrix().m;
+        float viewZ = matView[2] * matWorld[12] + matView[6] * matWorld[13] + matView[10] * matWorld[14] + matView[14];
+        
+        if (SortMode::STATE == sortMode)
+            item.sortKey = getStateSortKey(item, viewZ);
+        else
+        {
+            // Farther items have smaller view z, so they are drawn first. Render states are not
+            // used here, swapping overlapped transparent items with the same depth changes the
+            // result, and 2D content relies on submission order.
+            item.sortKey = (uint64_t)floatToSortable(viewZ) << 32;
+        }
+    }
+    
+    radixSort(items, _sortIndices, _sortIndicesTemp);
+    
+    _sortedItems.clear();
+    for (const auto& index : _sortIndices)
+        _sortedItems.push_back(items[index]);
+    
+    return _sortedItems;
 }
 
 void BaseRenderer::draw(const StageItem& item)
 {
+    static const uint32_t modelHandle = DeviceGraphics::getUniformHandle("model");
+    static const uint32_t normalMatrixHandle = DeviceGraphics::getUniformHandle("normalMatrix");
+    
     Mat4 worldMatrix = item.model->getWorldMatrix();
-    _device->setUniformMat4("model", worldMatrix.m);
+    _device->setUniformMat4(modelHandle, worldMatrix);
 
     //REFINE: add Mat3
     worldMatrix.inverse();
     worldMatrix.transpose();
-    _device->setUniformMat4("normalMatrix", worldMatrix.m);
+    _device->setUniformMat4(normalMatrixHandle, worldMatrix);
     
     // set technique uniforms
     auto ia = item.ia;
     Technique::Parameter::Type propType = Technique::Parameter::Type::UNKNOWN;
     for (const auto& param : item.technique->getParameters())
     {
-        Effect::Property* prop = const_cast<Effect::Property*>(&item.effect->getProperty(param.getName()));
+        Effect::Property* prop = const_cast<Effect::Property*>(&item.effect->getProperty(param.getHandle()));
         
         if (Effect::Property::Type::UNKNOWN == prop->getType())
             *prop = param;
@@ -217,12 +538,12 @@ void BaseRenderer::draw(const StageItem& item)
                 for (int i = 0; i < param.getCount(); ++i)
                     slots.push_back(allocTextureUnit());
                 
-                _device->setTextureArray(param.getName(),
+                _device->setTextureArray(param.getHandle(),
                                          std::move(prop->getTextureArray()),
                                          slots);
             }
             else
-                _device->setTexture(param.getName(),
+                _device->setTexture(param.getHandle(),
                                     (renderer::Texture *)(prop->getValue()),
                                     allocTextureUnit());
         }
@@ -251,9 +572,9 @@ void BaseRenderer::draw(const StageItem& item)
             if (Effect::Property::Type::INT == propType ||
                 Effect::Property::Type::INT2 == propType ||
                 Effect::Property::Type::INT4 == propType)
-                _device->setUniformiv(param.getName(), bytes / sizeof(int), (const int*)prop->getValue());
+                _device->setUniformiv(param.getHandle(), bytes / sizeof(int), (const int*)prop->getValue());
             else
-                _device->setUniformfv(param.getName(), bytes / sizeof(float), (const float*)prop->getValue());
+                _device->setUniformfv(param.getHandle(), bytes / sizeof(float), (const float*)prop->getValue());
         }
         
         // for each pass
@@ -270,7 +591,7 @@ void BaseRenderer::draw(const StageItem& item)
             _device->setPrimitiveType(ia->_primitiveType);
             
             // set program
-            auto program = _programLib->getProgram(pass->_programName, *(item.defines));
+            auto program = _programLib->getProgram(pass->_programName, item.effect);
             _device->setProgram(program);
             
             // cull mode
@@ -55,9 +55,20 @@ public:
         Effect* effect = nullptr;
         ValueMap* defines = nullptr;
         Technique* technique = nullptr;
-        int sortKey = -1;
+        uint64_t sortKey = 0;
     };
     typedef std::function<void(const View&, const std::vector<StageItem>&)> StageCallback;
+    
+    // How the items of a stage are ordered before they are passed to the stage callback.
+    enum class SortMode : uint8_t
+    {
+        // Keep the order in which the models are added to the scene.
+        NONE,
+        // Group items by program, pass states and textures, then front to back.
+        STATE,
+        // Back to front, items with the same depth keep their submission order.
+        BACK_TO_FRONT
+    };
 
     BaseRenderer();
     
@@ -65,7 +76,7 @@ public:
     bool init(DeviceGraphics* device, std::vector<ProgramLib::Template>& programTemplates, Texture2D* defaultTexture);
     virtual ~BaseRenderer();
     
-    void registerStage(const std::string& name, const StageCallback& callback);
+    void registerStage(const std::string& name, const StageCallback& callback, SortMode sortMode = SortMode::NONE);
     ProgramLib* getProgramLib() const { return _programLib; }
     
 protected:
@@ -78,6 +89,20 @@ protected:
         std::string stage = "";
     };
     
+    struct Stage
+    {
+        StageCallback callback;
+        SortMode sortMode = SortMode::NONE;
+    };
+    
+    void updateDrawItems(const Scene* scene);
+    void dispatchStageItems(const View& view);
+    void resolveTechniques(const View& view, size_t begin, size_t end);
+    uint64_t getStateSortKey(const StageItem& item, float viewZ);
+    // The parts of the state sort key which only change with the effect, cached by the effect.
+    uint64_t getProgramTextureSortKey(const StageItem& item);
+    const std::vector<StageItem>& sortStageItems(const View& view, std::vector<StageItem>& items, SortMode sortMode);
+    
     void resetTextureUint();
     int allocTextureUnit();
     void reset();
@@ -87,9 +112,33 @@ protected:
     DeviceGraphics* _device = nullptr;
     ProgramLib* _programLib = nullptr;
     Texture2D* _defaultTexture = nullptr;
-    std::unordered_map<std::string, StageCallback> _stage2fn;
+    std::unordered_map<std::string, Stage> _stage2fn;
+    
+    // Draw items of all the models in the scene. If the scene is not changed they are reused
+    // by next frame, in retained mode only the draw items of changed models are updated.
     std::vector<DrawItem> _drawItems;
+    struct DrawItemRange
+    {
+        uint32_t offset = 0;
+        uint32_t count = 0;
+    };
+    std::unordered_map<const Model*, DrawItemRange> _modelDrawItems;
+    // 0 if no scene is cached, see Scene::getID()
+    uint32_t _cachedSceneID = 0;
+    uint32_t _cachedModelsVersion = 0;
+    uint32_t _cachedVersion = 0;
     std::vector<StageInfo> _stageInfos;
+    
+    // Items of each stage of current view, kept between frames to avoid allocations.
+    std::vector<std::vector<StageItem>> _stageItems;
+    std::vector<int> _stageIDs;
+    // Technique of every draw item for every stage, nullptr if the item is not drawn in the stage.
+    std::vector<Technique*> _itemTechniques;
+    
+    // scratch buffers of radix sort, kept between frames to avoid allocations
+    std::vector<StageItem> _sortedItems;
+    std::vector<uint32_t> _sortIndices;
+    std::vector<uint32_t> _sortIndicesTemp;
 
     CC_DISALLOW_COPY_ASSIGN_AND_MOVE(BaseRenderer);
 };
@@ -24,6 +24,8 @@
 
 #include "Effect.h"
 #include "Config.h"
+#include "ProgramLib.h"
+#include "gfx/DeviceGraphics.h"
 
 RENDERER_BEGIN
 
@@ -38,9 +40,21 @@ void Effect::init(const Vector<Technique*>& techniques,
     _properties = properties;
     _defineTemplates = defineTemplates;
     
+    _handle2property.clear();
+    for (auto& iter : _properties)
+        cacheProperty(iter.first, &iter.second);
+    
     for (const auto defineTemplate: _defineTemplates)
         _cachedNameValues.emplace(defineTemplate.at("name").asString(),
                                   defineTemplate.at("value"));
+    
+    _sortKeys.clear();
+    _defineMask = 0;
+    _defineValues.clear();
+    _defineValues.resize(_defineTemplates.size());
+    for (size_t i = 0, len = _defineTemplates.size(); i < len; ++i)
+        updateDefine(i, _defineTemplates[i].at("value"));
+    updateDefinesID();
 }
 
 Effect::~Effect()
@@ -53,11 +67,16 @@ void Effect::clear()
 {
     _techniques.clear();
     _defineTemplates.clear();
+    _sortKeys.clear();
 }
 
 Technique* Effect::getTechnique(const std::string& stage) const
 {
-    int stageID = Config::getStageID(stage);
+    return getTechnique(Config::getStageID(stage));
+}
+
+Technique* Effect::getTechnique(int stageID) const
+{
     if (-1 == stageID)
         return nullptr;
     
@@ -84,17 +103,60 @@ Value Effect::getDefineValue(const std::string& name) const
 
 void Effect::setDefineValue(const std::string& name, const Value& value)
 {
-    for (auto& def : _defineTemplates)
+    for (size_t i = 0, len = _defineTemplates.size(); i < len; ++i)
     {
+        auto& def = _defineTemplates[i];
         if (name == def.at("name").asString())
         {
             def["value"] = value;
             _cachedNameValues[name] = value;
+            if (updateDefine(i, value))
+                updateDefinesID();
+            _sortKeys.clear();
             return;
         }
     }
 }
 
+bool Effect::updateDefine(size_t index, const Value& value)
+{
+    bool enabled = value.asBool();
+    if (index < 64)
+    {
+        if (enabled)
+            _defineMask |= 1ULL << index;
+        else
+            _defineMask &= ~(1ULL << index);
+    }
+    
+    // only integer defines are substituted into the shader sources, see ProgramLib
+    DefineValue defineValue;
+    defineValue.isInteger = value.getType() == Value::Type::INTEGER || value.getType() == Value::Type::UNSIGNED;
+    defineValue.value = defineValue.isInteger ? value.asInt() : 0;
+    
+    auto& oldValue = _defineValues[index];
+    bool changed = oldValue.isInteger != defineValue.isInteger || oldValue.value != defineValue.value;
+    oldValue = defineValue;
+    return changed || index >= 64;
+}
+
+void Effect::updateDefinesID()
+{
+    // in the order of the effect defines, ProgramLib maps it to the define order of each program
+    std::string layout;
+    for (size_t i = 0, len = _defineTemplates.size(); i < len; ++i)
+    {
+        const auto& def = _defineTemplates[i];
+        layout += def.at("name").asString();
+        if (_defineValues[i].isInteger)
+            layout += "=" + def.at("value").asString();
+        if (i >= 64)
+            layout += def.at("value").asBool() ? "+" : "-";
+        layout += "\n";
+    }
+    _definesID = ProgramLib::getDefinesID(layout);
+}
+
 ValueMap* Effect::extractDefines()
 {
 //    for (auto& def : _defineTemplates)
@@ -112,9 +174,48 @@ const Effect::Property& Effect::getProperty(const std::string& name) const
         return _properties.at(name);
 }
 
+const Effect::Property& Effect::getProperty(uint32_t handle) const
+{
+    static Property EMPTY_PROPERTY;
+    if (handle >= _handle2property.size() || nullptr == _handle2property[handle])
+        return EMPTY_PROPERTY;
+    else
+        return *_handle2property[handle];
+}
+
 void Effect::setProperty(const std::string& name, const Property& property)
 {
-    _properties[name] = property;
+    auto& prop = _properties[name];
+    prop = property;
+    cacheProperty(name, &prop);
+    _sortKeys.clear();
+}
+
+bool Effect::getCachedSortKey(const Technique* technique, uint64_t* key) const
+{
+    for (const auto& sortKey : _sortKeys)
+    {
+        if (sortKey.first == technique)
+        {
+            *key = sortKey.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+void Effect::setCachedSortKey(const Technique* technique, uint64_t key)
+{
+    _sortKeys.emplace_back(technique, key);
+}
+
+void Effect::cacheProperty(const std::string& name, Property* property)
+{
+    uint32_t handle = DeviceGraphics::getUniformHandle(name);
+    if (handle >= _handle2property.size())
+        _handle2property.resize(handle + 1, nullptr);
+    
+    _handle2property[handle] = property;
 }
 
 RENDERER_END
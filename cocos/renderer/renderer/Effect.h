@@ -48,22 +48,56 @@ public:
     void clear();
     
     Technique* getTechnique(const std::string& stage) const;
+    // stageID is the value returned by Config::getStageID()
+    Technique* getTechnique(int stageID) const;
     const Vector<Technique*>& getTechniques() const { return _techniques; }
     Value getDefineValue(const std::string& name) const;
     const std::vector<ValueMap>& getDefines() const { return _defineTemplates; }
     void setDefineValue(const std::string& name, const Value& value);
     ValueMap* extractDefines();
+    inline const ValueMap* extractDefines() const { return &_cachedNameValues; }
+    // Bit i is set if the i-th define of getDefines() is enabled, defines after the 64th are
+    // taken into account by getDefinesID().
+    inline uint64_t getDefineMask() const { return _defineMask; }
+    // Id of the define names and the values of integer defines, see ProgramLib::getDefinesID().
+    // Together with the define mask it identifies the define state of the effect.
+    inline uint32_t getDefinesID() const { return _definesID; }
     
     const Property& getProperty(const std::string& name) const;
+    const Property& getProperty(uint32_t handle) const;
     void setProperty(const std::string& name, const Property& property);
     
     const std::unordered_map<std::string, Property>& getProperties() const { return _properties; }
     
+    // Program and texture bits of the state sort key of the technique, see BaseRenderer::getStateSortKey().
+    // The cached keys are dropped when defines or properties are changed.
+    bool getCachedSortKey(const Technique* technique, uint64_t* key) const;
+    void setCachedSortKey(const Technique* technique, uint64_t key);
+    
 private:
     Vector<Technique*> _techniques;
     std::vector<ValueMap> _defineTemplates;
     ValueMap _cachedNameValues;
     std::unordered_map<std::string, Property> _properties;
+    // properties indexed by uniform handle, points to the values of _properties
+    std::vector<Property*> _handle2property;
+    
+    struct DefineValue
+    {
+        bool isInteger = false;
+        int32_t value = 0;
+    };
+    // values of integer defines, indexed as _defineTemplates
+    std::vector<DefineValue> _defineValues;
+    uint64_t _defineMask = 0;
+    uint32_t _definesID = 0;
+    // an effect has a few techniques, a linear search is fine
+    std::vector<std::pair<const Technique*, uint64_t>> _sortKeys;
+    
+    void cacheProperty(const std::string& name, Property* property);
+    // returns true if the defines id needs to be updated
+    bool updateDefine(size_t index, const Value& value);
+    void updateDefinesID();
 };
 
 RENDERER_END
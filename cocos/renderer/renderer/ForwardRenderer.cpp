@@ -49,7 +49,8 @@ bool ForwardRenderer::init(DeviceGraphics* device, std::vector<ProgramLib::Templ
     BaseRenderer::init(device, programTemplates, defaultTexture);
     _width = width;
     _height = height;
-    registerStage("transparent", std::bind(&ForwardRenderer::transparentStage, this, std::placeholders::_1, std::placeholders::_2));
+    registerStage("opaque", std::bind(&ForwardRenderer::opaqueStage, this, std::placeholders::_1, std::placeholders::_2), SortMode::STATE);
+    registerStage("transparent", std::bind(&ForwardRenderer::transparentStage, this, std::placeholders::_1, std::placeholders::_2), SortMode::BACK_TO_FRONT);
     return true;
 }
 
@@ -61,7 +62,10 @@ void ForwardRenderer::render(Scene* scene)
     for (auto camera : cameras)
         BaseRenderer::render(camera->extractView(_width, _height), scene);
     
-    scene->removeModels();
+    if (scene->isRetainedMode())
+        scene->clearDirtyModels();
+    else
+        scene->removeModels();
 }
 
 void ForwardRenderer::renderCamera(Camera* camera, Scene* scene)
@@ -77,15 +81,35 @@ void ForwardRenderer::renderCamera(Camera* camera, Scene* scene)
     View view = camera->extractView(width, height);
     BaseRenderer::render(view, scene);
     
-    scene->removeModels();
+    if (scene->isRetainedMode())
+        scene->clearDirtyModels();
+    else
+        scene->removeModels();
+}
+
+void ForwardRenderer::updateViewUniforms(const View& view)
+{
+    static const uint32_t viewHandle = DeviceGraphics::getUniformHandle("view");
+    static const uint32_t projHandle = DeviceGraphics::getUniformHandle("proj");
+    static const uint32_t viewProjHandle = DeviceGraphics::getUniformHandle("viewProj");
+    
+    _device->setUniformMat4(viewHandle, view.matView);
+    _device->setUniformMat4(projHandle, view.matProj);
+    _device->setUniformMat4(viewProjHandle, view.matViewProj);
+}
+
+void ForwardRenderer::opaqueStage(const View& view, const std::vector<StageItem>& items)
+{
+    updateViewUniforms(view);
+    
+    // items are sorted by render states, so adjacent items share programs and textures
+    for (const auto& item : items)
+        draw(item);
 }
 
 void ForwardRenderer::transparentStage(const View& view, const std::vector<StageItem>& items)
 {
-    // update uniforms
-    _device->setUniformMat4("view", view.matView);
-    _device->setUniformMat4("proj", view.matProj);
-    _device->setUniformMat4("viewProj", view.matViewProj);
+    updateViewUniforms(view);
 
 //    RENDERER_LOGD("StageItem count: %d", (int)items.size());
     // draw it
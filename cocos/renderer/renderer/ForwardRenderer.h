@@ -39,6 +39,8 @@ public:
     void renderCamera(Camera* camera, Scene* scene);
 
 private:
+    void updateViewUniforms(const View& view);
+    void opaqueStage(const View& view, const std::vector<StageItem>& items);
     void transparentStage(const View& view, const std::vector<StageItem>& items);
 
     int _width = 0;
@@ -25,6 +25,8 @@
 #include "InputAssembler.h"
 #include "gfx/VertexBuffer.h"
 #include "gfx/IndexBuffer.h"
+#include "gfx/TransientGeometry.h"
+#include <string.h>
 
 RENDERER_BEGIN
 
@@ -92,6 +94,29 @@ bool InputAssembler::init(VertexBuffer* vb,
     return true;
 }
 
+bool InputAssembler::initTransient(TransientGeometry* geometry,
+                                   const void* vertices, uint32_t numVertices,
+                                   const uint16_t* indices, uint32_t numIndices,
+                                   PrimitiveType pt/* = PrimitiveType::TRIANGLES*/)
+{
+    TransientGeometry::Allocation allocation;
+    if (!geometry->allocate(numVertices, numIndices, &allocation))
+        return false;
+
+    memcpy(allocation.vertices, vertices, (size_t)numVertices * geometry->getVertexBytes());
+    // rebase the indices on the shared vertex buffer
+    uint16_t vertexStart = (uint16_t)allocation.vertexStart;
+    for (uint32_t i = 0; i < numIndices; ++i)
+        allocation.indices[i] = indices[i] + vertexStart;
+
+    setVertexBuffer(allocation.vertexBuffer);
+    setIndexBuffer(allocation.indexBuffer);
+    _start = (int)allocation.indexStart;
+    _count = (int)numIndices;
+    _primitiveType = pt;
+    return true;
+}
+
 void InputAssembler::setVertexBuffer(VertexBuffer* vb)
 {
     RENDERER_SAFE_RELEASE(_vertexBuffer);
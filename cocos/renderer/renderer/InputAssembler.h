@@ -31,6 +31,7 @@ RENDERER_BEGIN
 
 class VertexBuffer;
 class IndexBuffer;
+class TransientGeometry;
 
 class InputAssembler
 {
@@ -46,6 +47,12 @@ public:
     bool init(VertexBuffer* vb,
               IndexBuffer* ib,
               PrimitiveType pt = PrimitiveType::TRIANGLES);
+    // Copies the geometry to a new allocation of the transient geometry and draws from it, the indices
+    // are relative to the given vertices. Valid for the current frame only, returns false if it's full.
+    bool initTransient(TransientGeometry* geometry,
+                       const void* vertices, uint32_t numVertices,
+                       const uint16_t* indices, uint32_t numIndices,
+                       PrimitiveType pt = PrimitiveType::TRIANGLES);
     
     uint32_t getPrimitiveCount() const;
 
@@ -25,6 +25,7 @@
 #include "Model.h"
 #include "Effect.h"
 #include "InputAssembler.h"
+#include "Scene.h"
 
 RENDERER_BEGIN
 
@@ -74,14 +75,22 @@ Model::~Model()
     ccCArrayFree(_effects);
 }
 
+void Model::setWorldMatix(const Mat4& matrix)
+{
+    _worldMatrix = matrix;
+    setDirty(WORLD_MATRIX);
+}
+
 void Model::addInputAssembler(const InputAssembler& ia)
 {
     _inputAssemblers.push_back(std::move(ia));
+    setDirty(INPUT_ASSEMBLER);
 }
 
 void Model::clearInputAssemblers()
 {
     _inputAssemblers.clear();
+    setDirty(INPUT_ASSEMBLER);
 }
 
 void Model::addEffect(Effect* effect)
@@ -92,12 +101,23 @@ void Model::addEffect(Effect* effect)
     ccCArrayAppendValue(_effects, effect);
     
     _defines.push_back(effect->extractDefines());
+    setDirty(EFFECT);
 }
 
 void Model::clearEffects()
 {
     ccCArrayRemoveAllValues(_effects);
     _defines.clear();
+    setDirty(EFFECT);
+}
+
+void Model::setDirty(uint8_t flags)
+{
+    // only notify the scene the first time the model becomes dirty in a frame
+    if (NONE == _dirtyFlags && nullptr != _scene)
+        _scene->addDirtyModel(this);
+    
+    _dirtyFlags |= flags;
 }
 
 void Model::extractDrawItem(DrawItem& out, uint32_t index) const
@@ -133,6 +153,9 @@ void Model::reset()
     _inputAssemblers.clear();
     
     _defines.clear();
+    
+    _scene = nullptr;
+    _dirtyFlags = NONE;
 }
 
 RENDERER_END
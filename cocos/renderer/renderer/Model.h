@@ -38,6 +38,7 @@ class Effect;
 class InputAssembler;
 class Model;
 class INode;
+class Scene;
 
 struct DrawItem
 {
@@ -62,18 +63,35 @@ private:
 class Model
 {
 public:
+    // What is changed since the model is rendered last time, only used in retained mode of Scene.
+    enum DirtyFlag : uint8_t
+    {
+        NONE = 0,
+        WORLD_MATRIX = 1 << 0,
+        EFFECT = 1 << 1,
+        INPUT_ASSEMBLER = 1 << 2,
+        // Changes that need the draw items of the model to be extracted again.
+        DRAW_ITEMS = EFFECT | INPUT_ASSEMBLER
+    };
+    
     Model();
     ~Model();
     
     inline uint32_t getInputAssemblerCount() const { return (uint32_t)_inputAssemblers.size(); }
+    inline const InputAssembler& getInputAssembler(uint32_t index) const { return _inputAssemblers[index]; }
+    inline uint32_t getEffectCount() const { return (uint32_t)_effects->num; }
+    inline Effect* getEffect(uint32_t index) const { return (Effect*)_effects->arr[index]; }
     
     inline bool isDynamicIA() const { return _dynamicIA; }
-    inline void setDynamicIA(bool value) { _dynamicIA =  value; }
+    inline void setDynamicIA(bool value) { if (_dynamicIA != value) { _dynamicIA = value; setDirty(INPUT_ASSEMBLER); } }
     
     inline uint32_t getDrawItemCount() const { return _dynamicIA ? 1 :  (uint32_t)_inputAssemblers.size(); }
-    inline void setWorldMatix(const Mat4& matrix) { _worldMatrix = std::move(matrix); }
+    void setWorldMatix(const Mat4& matrix);
     inline const Mat4& getWorldMatrix() const { return _worldMatrix; }
     
+    inline uint8_t getDirtyFlags() const { return _dirtyFlags; }
+    inline void clearDirtyFlags() { _dirtyFlags = NONE; }
+    
     inline void setViewId(int val) { _viewID = val; }
     inline int getViewId() const { return _viewID; }
     
@@ -85,7 +103,13 @@ public:
 
 private:
     friend class ModelPool;
+    friend class Scene;
     void reset();
+    void setDirty(uint8_t flags);
+    
+    // the scene the model is added to
+    Scene* _scene = nullptr;
+    uint8_t _dirtyFlags = NONE;
     
     Mat4 _worldMatrix;
     ccCArray* _effects = ccCArrayNew(2);
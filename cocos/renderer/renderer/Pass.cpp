@@ -40,6 +40,7 @@ Pass::~Pass()
 void Pass::setCullMode(CullMode cullMode)
 {
     _cullMode = cullMode;
+    _stateHashDirty = true;
 }
 
 void Pass::setBlend(BlendOp blendEq,
@@ -58,6 +59,7 @@ void Pass::setBlend(BlendOp blendEq,
     _blendSrcAlpha = blendSrcAlpha;
     _blendDstAlpha = blendDstAlpha;
     _blendColor = blendColor;
+    _stateHashDirty = true;
 }
 
 void Pass::setDepth(bool depthTest, bool depthWrite, DepthFunc depthFunc)
@@ -65,6 +67,7 @@ void Pass::setDepth(bool depthTest, bool depthWrite, DepthFunc depthFunc)
     _depthTest = depthTest;
     _depthWrite = depthWrite;
     _depthFunc = depthFunc;
+    _stateHashDirty = true;
 }
 
 void Pass::setStencilFront(StencilFunc stencilFunc,
@@ -83,6 +86,7 @@ void Pass::setStencilFront(StencilFunc stencilFunc,
     _stencilZFailOpFront = stencilZFailOp;
     _stencilZPassOpFront = stencilZPassOp;
     _stencilWriteMaskFront = stencilWriteMask;
+    _stateHashDirty = true;
 }
 
 void Pass::setStencilBack(StencilFunc stencilFunc,
@@ -101,6 +105,64 @@ void Pass::setStencilBack(StencilFunc stencilFunc,
     _stencilZFailOpBack = stencilZFailOp;
     _stencilZPassOpBack = stencilZPassOp;
     _stencilWriteMaskBack = stencilWriteMask;
+    _stateHashDirty = true;
+}
+
+uint32_t Pass::getStateHash() const
+{
+    if (!_stateHashDirty)
+        return _stateHash;
+    
+    // FNV-1a over all the states that affect the GL pipeline
+    uint32_t hash = 2166136261u;
+    auto combine = [&hash](uint32_t value) {
+        for (int i = 0; i < 4; ++i)
+        {
+            hash ^= (value >> (i * 8)) & 0xff;
+            hash *= 16777619u;
+        }
+    };
+    
+    combine((uint32_t)_cullMode);
+    
+    combine(_blend);
+    if (_blend)
+    {
+        combine((uint32_t)_blendEq);
+        combine((uint32_t)_blendAlphaEq);
+        combine((uint32_t)_blendSrc);
+        combine((uint32_t)_blendDst);
+        combine((uint32_t)_blendSrcAlpha);
+        combine((uint32_t)_blendDstAlpha);
+        combine(_blendColor);
+    }
+    
+    combine(_depthTest);
+    combine(_depthWrite);
+    combine((uint32_t)_depthFunc);
+    
+    combine(_stencilTest);
+    if (_stencilTest)
+    {
+        combine((uint32_t)_stencilFuncFront);
+        combine(_stencilRefFront);
+        combine(_stencilMaskFront);
+        combine((uint32_t)_stencilFailOpFront);
+        combine((uint32_t)_stencilZFailOpFront);
+        combine((uint32_t)_stencilZPassOpFront);
+        combine(_stencilWriteMaskFront);
+        combine((uint32_t)_stencilFuncBack);
+        combine(_stencilRefBack);
+        combine(_stencilMaskBack);
+        combine((uint32_t)_stencilFailOpBack);
+        combine((uint32_t)_stencilZFailOpBack);
+        combine((uint32_t)_stencilZPassOpBack);
+        combine(_stencilWriteMaskBack);
+    }
+    
+    _stateHash = hash;
+    _stateHashDirty = false;
+    return _stateHash;
 }
 
 RENDERER_END
@@ -63,14 +63,22 @@ public:
                         StencilOp stencilZFailOp = StencilOp::KEEP,
                         StencilOp stencilZPassOp = StencilOp::KEEP,
                         uint8_t stencilWriteMask = 0xff);
-    inline void setStencilTest(bool value) { _stencilTest = value; }
+    inline void setStencilTest(bool value) { _stencilTest = value; _stateHashDirty = true; }
     inline bool getStencilTest() const { return _stencilTest; }
     inline void setProgramName(const std::string& programName) { _programName = programName; }
-    inline void disableStencilTest() { _stencilTest = false; }
+    inline const std::string& getProgramName() const { return _programName; }
+    inline void disableStencilTest() { _stencilTest = false; _stateHashDirty = true; }
+    
+    // Hash of cull/blend/depth/stencil states, used to group draw items with same render states.
+    uint32_t getStateHash() const;
     
 private:
     friend class BaseRenderer;
     
+    // cached state hash
+    mutable uint32_t _stateHash = 0;
+    mutable bool _stateHashDirty = true;
+    
     // blending
     bool _blend = false;
     BlendOp _blendEq = BlendOp::ADD;
@@ -25,15 +25,29 @@
 #include "ProgramLib.h"
 #include "../gfx/Program.h"
 #include "gfx/DeviceGraphics.h"
+#include "Effect.h"
+#include "Technique.h"
+#include "Pass.h"
+#include "platform/CCFileUtils.h"
 
-#include <regex>
 #include <string>
-#include <sstream>
-#include <iostream>
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
 
 namespace {
     uint32_t _shdID = 0;
 
+    const char* FOR_PRAGMA = "#pragma for ";
+    const size_t FOR_PRAGMA_LENGTH = strlen(FOR_PRAGMA);
+    const char* END_FOR_PRAGMA = "#pragma endFor";
+    const size_t END_FOR_PRAGMA_LENGTH = strlen(END_FOR_PRAGMA);
+    const char* IN_RANGE = " in range(";
+    const size_t IN_RANGE_LENGTH = strlen(IN_RANGE);
+
+    const uint32_t BINARY_CACHE_MAGIC = 0x42504343; // "CCPB"
+    const uint32_t BINARY_CACHE_VERSION = 1;
+
     std::string generateDefines(const cocos2d::ValueMap& defMap)
     {
         std::string ret;
@@ -47,78 +61,207 @@ namespace {
         return ret;
     }
 
-    std::string replaceMacroNums(const std::string str, const cocos2d::ValueMap& defMap)
+    inline bool isIdentifierChar(char c)
+    {
+        return isalnum((unsigned char)c) || c == '_';
+    }
+
+    inline size_t skipSpaces(const std::string& text, size_t pos)
     {
-        cocos2d::ValueMap cache;
-        std::string tmp = str;
+        while (pos < text.size() && isspace((unsigned char)text[pos]))
+            ++pos;
+        return pos;
+    }
+
+    bool parseInt(const std::string& text, size_t& pos, int32_t* out)
+    {
+        size_t begin = pos;
+        int64_t value = 0;
+        while (pos < text.size() && isdigit((unsigned char)text[pos]) && value <= INT32_MAX)
+            value = value * 10 + (text[pos++] - '0');
+
+        if (pos == begin || value > INT32_MAX)
+            return false;
+
+        *out = (int32_t)value;
+        return true;
+    }
+
+    // Replaces whole identifiers which are names of integer defines with their values.
+    std::string replaceMacroNums(const std::string& str, const cocos2d::ValueMap& defMap)
+    {
+        std::unordered_map<std::string, std::string> nums;
         for (const auto& def : defMap)
         {
             if (def.second.getType() == cocos2d::Value::Type::INTEGER || def.second.getType() == cocos2d::Value::Type::UNSIGNED)
             {
-                cache.emplace(def.first, def.second);
+                nums.emplace(def.first, def.second.asString());
             }
         }
+        if (nums.empty())
+            return str;
 
-        for (const auto& def : cache)
+        std::string ret;
+        ret.reserve(str.size());
+        std::string identifier;
+        size_t pos = 0;
+        const size_t length = str.size();
+        while (pos < length)
         {
-            std::regex pattern(def.first);
-            tmp = std::regex_replace(tmp, pattern, def.second.asString());
-        }
-        return tmp;
-    }
-
-    using RegexReplaceCallback = std::function<std::string(const std::match_results<std::string::const_iterator>&)>;
-
-    static std::string regexReplaceString(const std::string& text, const std::string& pattern, const RegexReplaceCallback& replaceCallback)
-    {
-        std::string ret = text;
-        std::regex re(pattern);
-
-        std::string::const_iterator text_iter = text.cbegin();
-        std::match_results<std::string::const_iterator> results;
+            char c = str[pos];
+            if (!isIdentifierChar(c))
+            {
+                ret += c;
+                ++pos;
+                continue;
+            }
 
-        size_t start = 0;
-        size_t offset = 0;
-        while (std::regex_search(text_iter, text.end(), results, re))
-        {
-            offset = start + results.position();
-            std::string replacement = replaceCallback(results);
-            ret = ret.replace(offset, results.length(), replacement);
-            start = offset + replacement.length();
+            size_t begin = pos;
+            while (pos < length && isIdentifierChar(str[pos]))
+                ++pos;
 
-            text_iter = results[0].second;
+            // number literals such as 1e5 are kept as they are
+            if (!isdigit((unsigned char)c))
+            {
+                identifier.assign(str, begin, pos - begin);
+                auto iter = nums.find(identifier);
+                if (iter != nums.end())
+                {
+                    ret += iter->second;
+                    continue;
+                }
+            }
+            ret.append(str, begin, pos - begin);
         }
-
         return ret;
     }
 
+    // Parses "#pragma for <var> in range(<begin>, <end>)" starting at pos,
+    // returns the position after the closing parenthesis or npos if it doesn't match.
+    size_t parseForPragma(const std::string& text, size_t pos, std::string* var, int32_t* begin, int32_t* end)
+    {
+        pos += FOR_PRAGMA_LENGTH;
+        size_t varBegin = pos;
+        while (pos < text.size() && isIdentifierChar(text[pos]))
+            ++pos;
+        if (pos == varBegin)
+            return std::string::npos;
+        var->assign(text, varBegin, pos - varBegin);
+
+        if (text.compare(pos, IN_RANGE_LENGTH, IN_RANGE) != 0)
+            return std::string::npos;
+
+        pos = skipSpaces(text, pos + IN_RANGE_LENGTH);
+        if (!parseInt(text, pos, begin))
+            return std::string::npos;
+
+        pos = skipSpaces(text, pos);
+        if (pos >= text.size() || text[pos] != ',')
+            return std::string::npos;
+
+        pos = skipSpaces(text, pos + 1);
+        if (!parseInt(text, pos, end))
+            return std::string::npos;
+
+        pos = skipSpaces(text, pos);
+        if (pos >= text.size() || text[pos] != ')')
+            return std::string::npos;
+
+        return pos + 1;
+    }
+
+    // Expands
+    //     #pragma for i in range(0, 2)
+    //     light{i}
+    //     #pragma endFor
+    // to light0 light1. Loops can't be nested.
     std::string unrollLoops(const std::string& text)
     {
-        auto func = [](const std::match_results<std::string::const_iterator>& results) -> std::string {
-            assert(results.size() == 5);
-            std::string snippet = results[4].str();
-            std::string replacePatternStr = "\\{" + results[1].str() + "\\}";
-            std::regex replacePattern(replacePatternStr);
+        std::string ret;
+        std::string var;
+        std::string placeholder;
+        char number[16] = {0};
+        size_t pos = 0;
+        while (true)
+        {
+            size_t forPos = text.find(FOR_PRAGMA, pos);
+            if (forPos == std::string::npos)
+                break;
+
+            int32_t begin = 0;
+            int32_t end = 0;
+            size_t bodyBegin = parseForPragma(text, forPos, &var, &begin, &end);
+            // the body contains one character at least
+            size_t bodyEnd = bodyBegin == std::string::npos ? std::string::npos : text.find(END_FOR_PRAGMA, bodyBegin + 1);
+            if (bodyEnd == std::string::npos)
+            {
+                // not a valid loop, keep it as it is
+                ret.append(text, pos, forPos + 1 - pos);
+                pos = forPos + 1;
+                continue;
+            }
 
-            int32_t parsedBegin = atoi(results[2].str().c_str());
-            int32_t parsedEnd = atoi(results[3].str().c_str());
-            if (parsedBegin < 0 || parsedEnd < 0)
+            ret.append(text, pos, forPos - pos);
+            placeholder = "{" + var + "}";
+            for (int32_t i = begin; i < end; ++i)
             {
-                RENDERER_LOGE("Unroll For Loops Error: begin and end of range must be an int num.");
+                snprintf(number, sizeof(number), "%d", i);
+                size_t snippetPos = bodyBegin;
+                size_t found;
+                while ((found = text.find(placeholder, snippetPos)) < bodyEnd)
+                {
+                    ret.append(text, snippetPos, found - snippetPos);
+                    ret += number;
+                    snippetPos = found + placeholder.size();
+                }
+                ret.append(text, snippetPos, bodyEnd - snippetPos);
             }
+            pos = bodyEnd + END_FOR_PRAGMA_LENGTH;
+        }
+        ret.append(text, pos, std::string::npos);
+        return ret;
+    }
 
-            std::string unroll;
-            char tmp[256] = {0};
-            for (int32_t i = parsedBegin; i < parsedEnd; ++i)
+    // FNV-1a, stable between runs so it can be used as the key of saved binaries
+    uint64_t hashSources(const std::string& vert, const std::string& frag)
+    {
+        uint64_t hash = 14695981039346656037ULL;
+        auto hashString = [&hash](const std::string& str) {
+            for (unsigned char c : str)
             {
-                snprintf(tmp, 256, "%d", i);
-                std::string replaceFormat(tmp);
-                unroll += std::regex_replace(snippet, replacePattern, replaceFormat);
+                hash ^= c;
+                hash *= 1099511628211ULL;
             }
-            return unroll;
+            hash ^= 0xff;
+            hash *= 1099511628211ULL;
         };
+        hashString(vert);
+        hashString(frag);
+        return hash;
+    }
 
-        return regexReplaceString(text, "#pragma for (\\w+) in range\\(\\s*(\\d+)\\s*,\\s*(\\d+)\\s*\\)([\\s\\S]+?)#pragma endFor", func);
+    std::string getDriverInfo()
+    {
+        std::string ret;
+        const GLenum names[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+        for (GLenum name : names)
+        {
+            const char* str = (const char*)glGetString(name);
+            if (str)
+                ret += str;
+            ret += "\n";
+        }
+        return ret;
+    }
+
+    template<typename T>
+    bool readValue(const unsigned char* bytes, size_t size, size_t& pos, T* out)
+    {
+        if (pos + sizeof(T) > size)
+            return false;
+        memcpy(out, bytes + pos, sizeof(T));
+        pos += sizeof(T);
+        return true;
     }
 }
 
@@ -133,6 +276,7 @@ ProgramLib::ProgramLib(DeviceGraphics* device, std::vector<Template>& templates)
 : _device(device)
 {
     RENDERER_SAFE_RETAIN(_device);
+    _binaryCachePath = FileUtils::getInstance()->getWritablePath() + "program_binaries.bin";
     
     for (auto& templ : templates)
         define(templ.name, templ.vert, templ.frag, templ.defines);
@@ -190,57 +334,376 @@ void ProgramLib::define(const std::string& name, const std::string& vert, const
     templ.defines = defines;
 }
 
-uint32_t ProgramLib::getKey(const std::string& name, const ValueMap& defines)
+uint32_t ProgramLib::getDefinesID(const std::string& layout)
+{
+    static std::unordered_map<std::string, uint32_t> ids;
+    auto iter = ids.find(layout);
+    if (iter != ids.end())
+        return iter->second;
+
+    uint32_t id = (uint32_t)ids.size() + 1;
+    ids.emplace(layout, id);
+    return id;
+}
+
+bool ProgramLib::getVariantKey(const std::string& name, const ValueMap& defines, VariantKey* key) const
 {
     auto iter = _templates.find(name);
-    assert(iter != _templates.end());
-
-    auto& tmpl = iter->second;
-    int32_t key = 0;
-    for (auto& tmplDefs : tmpl.defines) {
-        auto& tmplDefMap = tmplDefs.asValueMap();
-        std::string tempName = tmplDefMap["name"].asString();
-        auto iter2 = defines.find(tempName);
-        if (iter2 == defines.end()) {
-            continue;
+    if (iter == _templates.end())
+        return false;
+
+    // every key of the template is built here, in the order of the template defines
+    const auto& tmpl = iter->second;
+    std::string layout;
+    uint64_t mask = 0;
+    uint32_t index = 0;
+    for (const auto& tmplDef : tmpl.defines)
+    {
+        const std::string& defName = tmplDef.asValueMap().at("name").asString();
+        layout += defName;
+
+        auto defIter = defines.find(defName);
+        if (defIter != defines.end())
+        {
+            const Value& value = defIter->second;
+            bool enabled = value.asBool();
+            if (value.getType() == Value::Type::INTEGER || value.getType() == Value::Type::UNSIGNED)
+                layout += "=" + value.asString();
+            if (index < 64)
+                mask |= enabled ? (1ULL << index) : 0;
+            else
+                layout += enabled ? "+" : "-";
         }
-//        const auto& value = iter2->second;
-//        key |= tmplDefs._map(100); //IDEA:
-        uint32_t offset = tmplDefMap["_offset"].asUnsignedInt();
-        key |= 1 << offset;
+        else if (index >= 64)
+            layout += "-";
+
+        layout += "\n";
+        ++index;
+    }
+
+    key->defineMask = mask;
+    key->definesID = getDefinesID(layout);
+    key->templateID = tmpl.id;
+    return true;
+}
+
+bool ProgramLib::getVariantKey(const std::string& name, const Effect* effect, VariantKey* key) const
+{
+    auto iter = _templates.find(name);
+    if (iter == _templates.end())
+        return false;
+
+    // the define mask and id of the effect follow the define order of the effect, which differs
+    // from the template one, translate them once per effect define state
+    VariantKey effectKey;
+    effectKey.defineMask = effect->getDefineMask();
+    effectKey.definesID = effect->getDefinesID();
+    effectKey.templateID = iter->second.id;
+
+    auto keyIter = _effectKeys.find(effectKey);
+    if (keyIter != _effectKeys.end())
+    {
+        *key = keyIter->second;
+        return true;
     }
 
-    return key << 8 | tmpl.id;
+    getVariantKey(name, *effect->extractDefines(), key);
+    _effectKeys.emplace(effectKey, *key);
+    return true;
+}
+
+uint32_t ProgramLib::getKey(const std::string& name, const ValueMap& defines)
+{
+    VariantKey key;
+    bool ok = getVariantKey(name, defines, &key);
+    assert(ok);
+    size_t hash = VariantKeyHash()(key);
+    return (uint32_t)(hash ^ ((uint64_t)hash >> 32));
+}
+
+uint32_t ProgramLib::getKey(const std::string& name, const Effect* effect)
+{
+    VariantKey key;
+    bool ok = getVariantKey(name, effect, &key);
+    assert(ok);
+    size_t hash = VariantKeyHash()(key);
+    return (uint32_t)(hash ^ ((uint64_t)hash >> 32));
 }
 
 Program* ProgramLib::getProgram(const std::string& name, const ValueMap& defines)
 {
-    uint32_t key = getKey(name, defines);
+    VariantKey key;
+    if (!getVariantKey(name, defines, &key))
+        return nullptr;
+
+    return getProgram(key, name, defines);
+}
+
+Program* ProgramLib::getProgram(const std::string& name, Effect* effect)
+{
+    VariantKey key;
+    if (!getVariantKey(name, effect, &key))
+        return nullptr;
+
+    return getProgram(key, name, *effect->extractDefines());
+}
+
+Program* ProgramLib::getProgram(const VariantKey& key, const std::string& name, const ValueMap& defines)
+{
     auto iter = _cache.find(key);
     if (iter != _cache.end()) {
         iter->second->retain();
         return iter->second;
     }
 
-    Program* program = nullptr;
+    Program* program = createProgram(name, defines);
+    if (program)
+        _cache.emplace(key, program);
+
+    return program;
+}
+
+void ProgramLib::precompile(Effect* effect, const ValueVector& variants)
+{
+    const ValueMap& defines = *effect->extractDefines();
+    VariantKey key;
+    for (const auto& technique : effect->getTechniques())
+    {
+        for (const auto& pass : technique->getPasses())
+        {
+            const std::string& programName = pass->getProgramName();
+            if (!getVariantKey(programName, effect, &key))
+            {
+                RENDERER_LOGW("Failed to precompile program %s: not defined.", programName.c_str());
+                continue;
+            }
+
+            if (_cache.find(key) == _cache.end())
+            {
+                Program* program = createProgram(programName, defines);
+                if (program)
+                    _cache.emplace(key, program);
+            }
+
+            // every variant overrides some of the current define values of the effect
+            for (const auto& variant : variants)
+            {
+                if (variant.getType() != Value::Type::MAP)
+                    continue;
+
+                ValueMap variantDefines = defines;
+                for (const auto& define : variant.asValueMap())
+                    variantDefines[define.first] = define.second;
+
+                getVariantKey(programName, variantDefines, &key);
+                if (_cache.find(key) != _cache.end())
+                    continue;
+
+                Program* program = createProgram(programName, variantDefines);
+                if (program)
+                    _cache.emplace(key, program);
+            }
+        }
+    }
+}
+
+void ProgramLib::setBinaryCachePath(const std::string& path)
+{
+    _binaryCachePath = path;
+    _binaryCacheLoaded = false;
+    _binarySupported = false;
+    _binaries.clear();
+}
+
+Program* ProgramLib::createProgram(const std::string& name, const ValueMap& defines)
+{
     // get template
     auto templIter = _templates.find(name);
-    if (templIter != _templates.end())
-    {
-        const auto& tmpl = templIter->second;
-        std::string customDef = generateDefines(defines) + "\n";
-        std::string vert = replaceMacroNums(tmpl.vert, defines);
-        vert = customDef + unrollLoops(vert);
-        std::string frag = replaceMacroNums(tmpl.frag, defines);
-        frag = customDef + unrollLoops(frag);
-
-        program = new Program();
-        program->init(_device, vert.c_str(), frag.c_str());
-        program->link();
-        _cache.emplace(key, program);
+    if (templIter == _templates.end())
+        return nullptr;
+
+    if (!_binaryCacheLoaded)
+        loadBinaryCache();
+
+    const auto& tmpl = templIter->second;
+    std::string customDef = generateDefines(defines) + "\n";
+    std::string vert = customDef + unrollLoops(replaceMacroNums(tmpl.vert, defines));
+    std::string frag = customDef + unrollLoops(replaceMacroNums(tmpl.frag, defines));
+
+    Program* program = new Program();
+    program->init(_device, vert.c_str(), frag.c_str());
+
+    uint64_t sourceHash = 0;
+    bool hasBinary = false;
+    if (_binarySupported)
+    {
+        sourceHash = hashSources(vert, frag);
+        auto binaryIter = _binaries.find(sourceHash);
+        if (binaryIter != _binaries.end())
+        {
+            const auto& binary = binaryIter->second;
+            program->setBinary(binary.format, binary.data.data(), binary.data.size());
+            _binaries.erase(binaryIter);
+            hasBinary = true;
+        }
+    }
+
+    program->link();
+
+    if (_binarySupported && !program->isLinkedFromBinary())
+    {
+        // a binary rejected by the driver is replaced in place, so the file doesn't keep stale entries
+        if (hasBinary)
+            replaceBinary(sourceHash, program);
+        else if (program->isLinked())
+            saveBinary(sourceHash, program);
     }
 
     return program;
 }
 
+bool ProgramLib::readBinaryCache(std::unordered_map<uint64_t, ProgramBinary>* binaries, bool* needsCompact) const
+{
+    auto fileUtils = FileUtils::getInstance();
+    if (!fileUtils->isFileExist(_binaryCachePath))
+        return false;
+
+    Data data = fileUtils->getDataFromFile(_binaryCachePath);
+    const unsigned char* bytes = data.getBytes();
+    size_t size = data.getSize();
+    size_t pos = 0;
+
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    uint32_t driverInfoLength = 0;
+    std::string driverInfo = getDriverInfo();
+    if (!readValue(bytes, size, pos, &magic) || magic != BINARY_CACHE_MAGIC ||
+        !readValue(bytes, size, pos, &version) || version != BINARY_CACHE_VERSION ||
+        !readValue(bytes, size, pos, &driverInfoLength) || driverInfoLength != driverInfo.size() ||
+        pos + driverInfoLength > size || memcmp(bytes + pos, driverInfo.data(), driverInfoLength) != 0)
+    {
+        return false;
+    }
+    pos += driverInfoLength;
+
+    // binaries appended later replace the earlier ones with the same hash,
+    // an entry truncated by an interrupted write ends the loading
+    uint64_t sourceHash = 0;
+    uint32_t format = 0;
+    uint32_t length = 0;
+    size_t count = 0;
+    while (readValue(bytes, size, pos, &sourceHash) &&
+           readValue(bytes, size, pos, &format) &&
+           readValue(bytes, size, pos, &length) &&
+           pos + length <= size)
+    {
+        auto& binary = (*binaries)[sourceHash];
+        binary.format = format;
+        binary.data.assign(bytes + pos, bytes + pos + length);
+        pos += length;
+        ++count;
+    }
+
+    *needsCompact = count != binaries->size() || pos != size;
+    return true;
+}
+
+void ProgramLib::writeBinaryCache(const std::unordered_map<uint64_t, ProgramBinary>& binaries) const
+{
+    FILE* fp = fopen(_binaryCachePath.c_str(), "wb");
+    if (!fp)
+    {
+        RENDERER_LOGW("Failed to open program binary cache: %s", _binaryCachePath.c_str());
+        return;
+    }
+
+    writeBinaryCacheHeader(fp);
+    for (const auto& entry : binaries)
+        writeBinaryCacheEntry(fp, entry.first, entry.second.format, entry.second.data);
+    fclose(fp);
+}
+
+void ProgramLib::writeBinaryCacheHeader(FILE* fp) const
+{
+    std::string driverInfo = getDriverInfo();
+    uint32_t driverInfoLength = (uint32_t)driverInfo.size();
+    fwrite(&BINARY_CACHE_MAGIC, sizeof(BINARY_CACHE_MAGIC), 1, fp);
+    fwrite(&BINARY_CACHE_VERSION, sizeof(BINARY_CACHE_VERSION), 1, fp);
+    fwrite(&driverInfoLength, sizeof(driverInfoLength), 1, fp);
+    fwrite(driverInfo.data(), 1, driverInfoLength, fp);
+}
+
+void ProgramLib::writeBinaryCacheEntry(FILE* fp, uint64_t sourceHash, uint32_t format, const std::vector<uint8_t>& data) const
+{
+    uint32_t length = (uint32_t)data.size();
+    fwrite(&sourceHash, sizeof(sourceHash), 1, fp);
+    fwrite(&format, sizeof(format), 1, fp);
+    fwrite(&length, sizeof(length), 1, fp);
+    fwrite(data.data(), 1, length, fp);
+}
+
+void ProgramLib::loadBinaryCache()
+{
+    _binaryCacheLoaded = true;
+    _binarySupported = !_binaryCachePath.empty() && Program::isBinarySupported(_device);
+    if (!_binarySupported)
+        return;
+
+    bool needsCompact = false;
+    if (!readBinaryCache(&_binaries, &needsCompact))
+    {
+        // binaries of another driver are useless, start over
+        _binaries.clear();
+        FileUtils::getInstance()->removeFile(_binaryCachePath);
+        return;
+    }
+
+    // drop the replaced and truncated entries left by earlier runs
+    if (needsCompact)
+        writeBinaryCache(_binaries);
+}
+
+void ProgramLib::saveBinary(uint64_t sourceHash, const Program* program)
+{
+    GLenum format = 0;
+    std::vector<uint8_t> data;
+    if (!program->getBinary(&format, &data))
+        return;
+
+    // the hash is new to the file, appending it keeps every entry unique
+    bool newFile = !FileUtils::getInstance()->isFileExist(_binaryCachePath);
+    FILE* fp = fopen(_binaryCachePath.c_str(), "ab");
+    if (!fp)
+    {
+        RENDERER_LOGW("Failed to open program binary cache: %s", _binaryCachePath.c_str());
+        return;
+    }
+
+    if (newFile)
+        writeBinaryCacheHeader(fp);
+    writeBinaryCacheEntry(fp, sourceHash, format, data);
+    fclose(fp);
+}
+
+void ProgramLib::replaceBinary(uint64_t sourceHash, const Program* program)
+{
+    // the binaries already used by this run aren't kept in memory, read them back from the file
+    std::unordered_map<uint64_t, ProgramBinary> binaries;
+    bool needsCompact = false;
+    if (!readBinaryCache(&binaries, &needsCompact))
+        binaries.clear();
+
+    GLenum format = 0;
+    ProgramBinary binary;
+    if (program->isLinked() && program->getBinary(&format, &binary.data))
+    {
+        binary.format = format;
+        binaries[sourceHash] = std::move(binary);
+    }
+    else
+        binaries.erase(sourceHash);
+
+    writeBinaryCache(binaries);
+}
+
 RENDERER_END
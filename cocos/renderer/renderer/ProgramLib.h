@@ -30,11 +30,14 @@
 #include <string>
 #include <vector>
 #include <functional>
+#include <unordered_map>
+#include <stdio.h>
 
 RENDERER_BEGIN
 
 class DeviceGraphics;
 class Program;
+class Effect;
 
 class ProgramLib final
 {
@@ -51,17 +54,84 @@ public:
     ProgramLib(DeviceGraphics* device, std::vector<Template>& templates);
     ~ProgramLib();
 
+    // Returns a unique id of the define layout string, which contains the define names
+    // and the values of integer defines, see Effect::getDefinesID().
+    static uint32_t getDefinesID(const std::string& layout);
+
     void define(const std::string& name, const std::string& vert, const std::string& frag, ValueVector& defines);
+    // Hash of the program variant, the same for all draws sharing the program.
     uint32_t getKey(const std::string& name, const ValueMap& defines);
+    uint32_t getKey(const std::string& name, const Effect* effect);
 
     //note: the return value needs to be released by its 'release' method.
     Program* getProgram(const std::string& name, const ValueMap& defines);
+    // Looks up the variant by the define mask of the effect, doesn't walk the defines.
+    Program* getProgram(const std::string& name, Effect* effect);
+
+    // Compiles the programs of all passes of the effect ahead of time, so that the first frame drawing
+    // with the effect doesn't stall on shader compilation. Besides the current define values, a program
+    // is compiled for each of the variants, every one a map overriding some of the effect defines.
+    void precompile(Effect* effect, const ValueVector& variants = ValueVector());
+
+    // Linked program binaries are saved to the file and reused by later runs if the device
+    // supports it. The cache is dropped when the GPU or the driver version changes.
+    // Defaults to "program_binaries.bin" in the writable path, an empty path disables the cache.
+    void setBinaryCachePath(const std::string& path);
 
 private:
+    // identifies a program variant exactly
+    struct VariantKey
+    {
+        uint64_t defineMask = 0;
+        uint32_t definesID = 0;
+        uint32_t templateID = 0;
+
+        inline bool operator==(const VariantKey& other) const
+        {
+            return defineMask == other.defineMask && definesID == other.definesID && templateID == other.templateID;
+        }
+    };
+
+    struct VariantKeyHash
+    {
+        inline size_t operator()(const VariantKey& key) const
+        {
+            uint64_t hash = key.defineMask * 0x9E3779B97F4A7C15ULL;
+            hash ^= ((uint64_t)key.definesID << 32 | key.templateID) + (hash >> 29);
+            return (size_t)(hash ^ (hash >> 32));
+        }
+    };
+
+    struct ProgramBinary
+    {
+        uint32_t format = 0;
+        std::vector<uint8_t> data;
+    };
+
+    bool getVariantKey(const std::string& name, const ValueMap& defines, VariantKey* key) const;
+    bool getVariantKey(const std::string& name, const Effect* effect, VariantKey* key) const;
+    Program* getProgram(const VariantKey& key, const std::string& name, const ValueMap& defines);
+    Program* createProgram(const std::string& name, const ValueMap& defines);
+    void loadBinaryCache();
+    bool readBinaryCache(std::unordered_map<uint64_t, ProgramBinary>* binaries, bool* needsCompact) const;
+    void writeBinaryCache(const std::unordered_map<uint64_t, ProgramBinary>& binaries) const;
+    void writeBinaryCacheHeader(FILE* fp) const;
+    void writeBinaryCacheEntry(FILE* fp, uint64_t sourceHash, uint32_t format, const std::vector<uint8_t>& data) const;
+    void saveBinary(uint64_t sourceHash, const Program* program);
+    void replaceBinary(uint64_t sourceHash, const Program* program);
+
     DeviceGraphics* _device = nullptr;
     const char* _precision = "#ifdef GL_ES\nprecision highp float;\n#endif\n";
     std::unordered_map<std::string, Template> _templates;
-    std::unordered_map<uint32_t, Program*> _cache;
+    std::unordered_map<VariantKey, Program*, VariantKeyHash> _cache;
+    // keys made of the effect define mask and id, mapped to the keys in the template define order
+    mutable std::unordered_map<VariantKey, VariantKey, VariantKeyHash> _effectKeys;
+
+    // binaries loaded from the cache file, indexed by the hash of the processed sources
+    std::unordered_map<uint64_t, ProgramBinary> _binaries;
+    std::string _binaryCachePath;
+    bool _binaryCacheLoaded = false;
+    bool _binarySupported = false;
 };
 
 RENDERER_END
@@ -32,9 +32,20 @@
 
 RENDERER_BEGIN
 
+static uint32_t _genID = 0;
+
 Scene::Scene()
+: _id(++_genID)
 {
     _models.reserve(500);
+    _dirtyModels.reserve(100);
+}
+
+Scene::~Scene()
+{
+    // return the models to the pool, they point to this scene
+    removeModels();
+    RENDERER_SAFE_RELEASE(_debugCamera);
 }
 
 void Scene::reset()
@@ -76,6 +87,9 @@ Model* Scene::getModel(uint32_t index)
 void Scene::addModel(Model* model)
 {
     _models.push_back(model);
+    model->_scene = this;
+    model->clearDirtyFlags();
+    onModelsChanged();
 }
 
 void Scene::removeModel(Model* model)
@@ -83,8 +97,16 @@ void Scene::removeModel(Model* model)
     auto iter = std::find(_models.begin(), _models.end(), model);
     if (_models.end() != iter)
     {
+        if (Model::NONE != model->getDirtyFlags())
+        {
+            auto dirtyIter = std::find(_dirtyModels.begin(), _dirtyModels.end(), model);
+            if (_dirtyModels.end() != dirtyIter)
+                _dirtyModels.erase(dirtyIter);
+        }
+        
         ModelPool::returnModel(model);
         _models.erase(iter);
+        onModelsChanged();
     }
 }
 
@@ -94,6 +116,61 @@ void Scene::removeModels()
         ModelPool::returnModel(model);
 
     _models.clear();
+    _dirtyModels.clear();
+    onModelsChanged();
+}
+
+void Scene::removeModelsFrom(uint32_t index)
+{
+    if (index >= _models.size())
+        return;
+    
+    for (auto iter = _models.begin() + index; iter != _models.end(); ++iter)
+    {
+        auto model = *iter;
+        if (Model::NONE != model->getDirtyFlags())
+        {
+            auto dirtyIter = std::find(_dirtyModels.begin(), _dirtyModels.end(), model);
+            if (_dirtyModels.end() != dirtyIter)
+                _dirtyModels.erase(dirtyIter);
+        }
+        ModelPool::returnModel(model);
+    }
+    
+    _models.erase(_models.begin() + index, _models.end());
+    onModelsChanged();
+}
+
+void Scene::setRetainedMode(bool value)
+{
+    if (_retainedMode == value)
+        return;
+    
+    // Retained models would be added again by the next frame.
+    if (_retainedMode)
+        removeModels();
+    
+    _retainedMode = value;
+}
+
+void Scene::clearDirtyModels()
+{
+    for (const auto& model : _dirtyModels)
+        model->clearDirtyFlags();
+    
+    _dirtyModels.clear();
+}
+
+void Scene::addDirtyModel(Model* model)
+{
+    _dirtyModels.push_back(model);
+    ++_version;
+}
+
+void Scene::onModelsChanged()
+{
+    ++_modelsVersion;
+    ++_version;
 }
 
 Light* Scene::getLight(uint32_t index)
@@ -40,6 +40,10 @@ class Scene
 {
 public:
     Scene();
+    ~Scene();
+    
+    // Unique in the process, unlike the address which may be reused by a new scene.
+    inline uint32_t getID() const { return _id; }
     
     void reset();
     void setDebugCamera(Camera* debugCamera);
@@ -57,8 +61,22 @@ public:
     void addModel(Model* model);
     void removeModel(Model* model);
     void removeModels();
+    // Removes the models from index to the end.
+    void removeModelsFrom(uint32_t index);
     inline const std::vector<Model*>& getModels() const { return _models; }
     
+    // In retained mode models are kept after rendering, they should be updated in place and
+    // removed explicitly. Otherwise all models are removed after every frame.
+    void setRetainedMode(bool value);
+    inline bool isRetainedMode() const { return _retainedMode; }
+    // Increased when models are added or removed.
+    inline uint32_t getModelsVersion() const { return _modelsVersion; }
+    // Increased when models are added, removed or changed.
+    inline uint32_t getVersion() const { return _version; }
+    // Models changed since last clearDirtyModels().
+    inline const std::vector<Model*>& getDirtyModels() const { return _dirtyModels; }
+    void clearDirtyModels();
+    
     // light
     inline uint32_t getLightCount() const { return (uint32_t)_lights.size(); }
     Light* getLight(uint32_t index);
@@ -70,12 +88,22 @@ public:
     void removeView(View* view);
     
 private:
+    friend class Model;
+    void addDirtyModel(Model* model);
+    void onModelsChanged();
+    
     //REFINE: optimize speed.
     Vector<Camera*> _cameras;
     Vector<Light*> _lights;
     std::vector<Model*> _models;
     Vector<View*> _views;
     Camera* _debugCamera = nullptr;
+    
+    uint32_t _id = 0;
+    bool _retainedMode = false;
+    uint32_t _modelsVersion = 0;
+    uint32_t _version = 0;
+    std::vector<Model*> _dirtyModels;
 };
 
 RENDERER_END
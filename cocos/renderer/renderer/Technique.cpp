@@ -26,7 +26,7 @@
 #include "Config.h"
 #include "Pass.h"
 #include "gfx/Texture.h"
-#include "gfx/Texture.h"
+#include "gfx/DeviceGraphics.h"
 
 RENDERER_BEGIN
 
@@ -61,6 +61,7 @@ Technique::Parameter::Parameter()
 
 Technique::Parameter::Parameter(const std::string& name, Type type)
 : _name(name)
+, _handle(DeviceGraphics::getUniformHandle(name))
 , _type(type)
 , _count(1)
 {
@@ -101,6 +102,7 @@ Technique::Parameter::Parameter(const std::string& name, Type type)
 
 Technique::Parameter::Parameter(const std::string& name, Type type, int* value, uint8_t count)
 : _name(name)
+, _handle(DeviceGraphics::getUniformHandle(name))
 , _type(type)
 , _count(count)
 {
@@ -135,6 +137,7 @@ Technique::Parameter::Parameter(const std::string& name, Type type, int* value,
 
 Technique::Parameter::Parameter(const std::string& name, Type type, float* value, uint8_t count)
 : _name(name)
+, _handle(DeviceGraphics::getUniformHandle(name))
 , _type(type)
 , _count(count)
 {
@@ -186,6 +189,7 @@ Technique::Parameter::Parameter(const std::string& name, Type type, float* value
 
 Technique::Parameter::Parameter(const std::string& name, Type type, Texture* value)
 : _name(name)
+, _handle(DeviceGraphics::getUniformHandle(name))
 , _count(1)
 , _type(type)
 {
@@ -199,6 +203,7 @@ Technique::Parameter::Parameter(const std::string& name, Type type, Texture* val
 
 Technique::Parameter::Parameter(const std::string& name, Type type, const std::vector<Texture*>& textures)
 : _name(name)
+, _handle(DeviceGraphics::getUniformHandle(name))
 , _count(textures.size())
 , _type(type)
 {
@@ -226,6 +231,7 @@ Technique::Parameter::Parameter(Parameter&& rh)
     freeValue();
     
     _name = rh._name;
+    _handle = rh._handle;
     _type = rh._type;
     _value = rh._value;
     _count = rh._count;
@@ -296,6 +302,7 @@ void Technique::Parameter::setTexture(renderer::Texture *texture)
 void Technique::Parameter::copyValue(const Parameter& rh)
 {
     _name = rh._name;
+    _handle = rh._handle;
     _type = rh._type;
     _count = rh._count;
     _bytes = rh._bytes;
@@ -83,6 +83,8 @@ public:
         
         inline Type getType() const { return _type; }
         inline const std::string& getName() const { return _name; }
+        // uniform handle of the name, see DeviceGraphics::getUniformHandle()
+        inline uint32_t getHandle() const { return _handle; }
         inline uint8_t getCount() const { return _count; }
         inline void* getValue() const { return _value; }
         inline uint16_t getBytes() const { return _bytes; };
@@ -98,6 +100,7 @@ public:
         void copyValue(const Parameter& rh);
         
         std::string _name = "";
+        uint32_t _handle = UINT32_MAX;
         // how many elements, for example, how many INT2 or how many MAT2
         uint8_t _count = 0;
         Type _type = Type::UNKNOWN;
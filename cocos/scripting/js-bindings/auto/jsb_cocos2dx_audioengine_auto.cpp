@@ -91,6 +91,34 @@ static bool js_audioengine_AudioProfile_set_minDelay(se::State& s)
 }
 SE_BIND_PROP_SET(js_audioengine_AudioProfile_set_minDelay)
 
+static bool js_audioengine_AudioProfile_get_priority(se::State& s)
+{
+    cocos2d::experimental::AudioProfile* cobj = (cocos2d::experimental::AudioProfile*)s.nativeThisObject();
+    SE_PRECONDITION2(cobj, false, "js_audioengine_AudioProfile_get_priority : Invalid Native Object");
+
+    CC_UNUSED bool ok = true;
+    se::Value jsret;
+    ok &= int32_to_seval(cobj->priority, &jsret);
+    s.rval() = jsret;
+    return true;
+}
+SE_BIND_PROP_GET(js_audioengine_AudioProfile_get_priority)
+
+static bool js_audioengine_AudioProfile_set_priority(se::State& s)
+{
+    const auto& args = s.args();
+    cocos2d::experimental::AudioProfile* cobj = (cocos2d::experimental::AudioProfile*)s.nativeThisObject();
+    SE_PRECONDITION2(cobj, false, "js_audioengine_AudioProfile_set_priority : Invalid Native Object");
+
+    CC_UNUSED bool ok = true;
+    int arg0 = 0;
+    do { int32_t tmp = 0; ok &= seval_to_int32(args[0], &tmp); arg0 = (int)tmp; } while(false);
+    SE_PRECONDITION2(ok, false, "js_audioengine_AudioProfile_set_priority : Error processing new value");
+    cobj->priority = arg0;
+    return true;
+}
+SE_BIND_PROP_SET(js_audioengine_AudioProfile_set_priority)
+
 SE_DECLARE_FINALIZE_FUNC(js_cocos2d_experimental_AudioProfile_finalize)
 
 static bool js_audioengine_AudioProfile_constructor(se::State& s)
@@ -126,6 +154,7 @@ bool js_register_audioengine_AudioProfile(se::Object* obj)
     cls->defineProperty("name", _SE(js_audioengine_AudioProfile_get_name), _SE(js_audioengine_AudioProfile_set_name));
     cls->defineProperty("maxInstances", _SE(js_audioengine_AudioProfile_get_maxInstances), _SE(js_audioengine_AudioProfile_set_maxInstances));
     cls->defineProperty("minDelay", _SE(js_audioengine_AudioProfile_get_minDelay), _SE(js_audioengine_AudioProfile_set_minDelay));
+    cls->defineProperty("priority", _SE(js_audioengine_AudioProfile_get_priority), _SE(js_audioengine_AudioProfile_set_priority));
     cls->defineFinalizeFunction(_SE(js_cocos2d_experimental_AudioProfile_finalize));
     cls->install();
     JSBClassType::registerClass<cocos2d::experimental::AudioProfile>(cls);
@@ -786,6 +786,43 @@ static bool js_extension_AssetsManagerEx_setVerifyCallback(se::State& s)
 }
 SE_BIND_FUNC(js_extension_AssetsManagerEx_setVerifyCallback)
 
+static bool js_extension_AssetsManagerEx_setMD5Verification(se::State& s)
+{
+    cocos2d::extension::AssetsManagerEx* cobj = (cocos2d::extension::AssetsManagerEx*)s.nativeThisObject();
+    SE_PRECONDITION2(cobj, false, "js_extension_AssetsManagerEx_setMD5Verification : Invalid Native Object");
+    const auto& args = s.args();
+    size_t argc = args.size();
+    CC_UNUSED bool ok = true;
+    if (argc == 1) {
+        bool arg0;
+        ok &= seval_to_boolean(args[0], &arg0);
+        SE_PRECONDITION2(ok, false, "js_extension_AssetsManagerEx_setMD5Verification : Error processing arguments");
+        cobj->setMD5Verification(arg0);
+        return true;
+    }
+    SE_REPORT_ERROR("wrong number of arguments: %d, was expecting %d", (int)argc, 1);
+    return false;
+}
+SE_BIND_FUNC(js_extension_AssetsManagerEx_setMD5Verification)
+
+static bool js_extension_AssetsManagerEx_isMD5VerificationEnabled(se::State& s)
+{
+    cocos2d::extension::AssetsManagerEx* cobj = (cocos2d::extension::AssetsManagerEx*)s.nativeThisObject();
+    SE_PRECONDITION2(cobj, false, "js_extension_AssetsManagerEx_isMD5VerificationEnabled : Invalid Native Object");
+    const auto& args = s.args();
+    size_t argc = args.size();
+    CC_UNUSED bool ok = true;
+    if (argc == 0) {
+        bool result = cobj->isMD5VerificationEnabled();
+        ok &= boolean_to_seval(result, &s.rval());
+        SE_PRECONDITION2(ok, false, "js_extension_AssetsManagerEx_isMD5VerificationEnabled : Error processing arguments");
+        return true;
+    }
+    SE_REPORT_ERROR("wrong number of arguments: %d, was expecting %d", (int)argc, 0);
+    return false;
+}
+SE_BIND_FUNC(js_extension_AssetsManagerEx_isMD5VerificationEnabled)
+
 static bool js_extension_AssetsManagerEx_getStoragePath(se::State& s)
 {
     cocos2d::extension::AssetsManagerEx* cobj = (cocos2d::extension::AssetsManagerEx*)s.nativeThisObject();
@@ -1202,6 +1239,8 @@ bool js_register_extension_AssetsManagerEx(se::Object* obj)
     cls->defineFunction("checkUpdate", _SE(js_extension_AssetsManagerEx_checkUpdate));
     cls->defineFunction("getTotalBytes", _SE(js_extension_AssetsManagerEx_getTotalBytes));
     cls->defineFunction("setVerifyCallback", _SE(js_extension_AssetsManagerEx_setVerifyCallback));
+    cls->defineFunction("setMD5Verification", _SE(js_extension_AssetsManagerEx_setMD5Verification));
+    cls->defineFunction("isMD5VerificationEnabled", _SE(js_extension_AssetsManagerEx_isMD5VerificationEnabled));
     cls->defineFunction("getStoragePath", _SE(js_extension_AssetsManagerEx_getStoragePath));
     cls->defineFunction("update", _SE(js_extension_AssetsManagerEx_update));
     cls->defineFunction("setEventCallback", _SE(js_extension_AssetsManagerEx_setEventCallback));
@@ -55,6 +55,8 @@ SE_DECLARE_FUNC(js_extension_AssetsManagerEx_loadRemoteManifest);
 SE_DECLARE_FUNC(js_extension_AssetsManagerEx_checkUpdate);
 SE_DECLARE_FUNC(js_extension_AssetsManagerEx_getTotalBytes);
 SE_DECLARE_FUNC(js_extension_AssetsManagerEx_setVerifyCallback);
+SE_DECLARE_FUNC(js_extension_AssetsManagerEx_setMD5Verification);
+SE_DECLARE_FUNC(js_extension_AssetsManagerEx_isMD5VerificationEnabled);
 SE_DECLARE_FUNC(js_extension_AssetsManagerEx_getStoragePath);
 SE_DECLARE_FUNC(js_extension_AssetsManagerEx_update);
 SE_DECLARE_FUNC(js_extension_AssetsManagerEx_setEventCallback);
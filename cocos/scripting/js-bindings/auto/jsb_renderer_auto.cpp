@@ -77,6 +77,53 @@ static bool js_renderer_ProgramLib_getKey(se::State& s)
 }
 SE_BIND_FUNC(js_renderer_ProgramLib_getKey)
 
+static bool js_renderer_ProgramLib_setBinaryCachePath(se::State& s)
+{
+    cocos2d::renderer::ProgramLib* cobj = (cocos2d::renderer::ProgramLib*)s.nativeThisObject();
+    SE_PRECONDITION2(cobj, false, "js_renderer_ProgramLib_setBinaryCachePath : Invalid Native Object");
+    const auto& args = s.args();
+    size_t argc = args.size();
+    CC_UNUSED bool ok = true;
+    if (argc == 1) {
+        std::string arg0;
+        ok &= seval_to_std_string(args[0], &arg0);
+        SE_PRECONDITION2(ok, false, "js_renderer_ProgramLib_setBinaryCachePath : Error processing arguments");
+        cobj->setBinaryCachePath(arg0);
+        return true;
+    }
+    SE_REPORT_ERROR("wrong number of arguments: %d, was expecting %d", (int)argc, 1);
+    return false;
+}
+SE_BIND_FUNC(js_renderer_ProgramLib_setBinaryCachePath)
+
+static bool js_renderer_ProgramLib_precompile(se::State& s)
+{
+    cocos2d::renderer::ProgramLib* cobj = (cocos2d::renderer::ProgramLib*)s.nativeThisObject();
+    SE_PRECONDITION2(cobj, false, "js_renderer_ProgramLib_precompile : Invalid Native Object");
+    const auto& args = s.args();
+    size_t argc = args.size();
+    CC_UNUSED bool ok = true;
+    if (argc == 1) {
+        cocos2d::renderer::Effect* arg0 = nullptr;
+        ok &= seval_to_native_ptr(args[0], &arg0);
+        SE_PRECONDITION2(ok, false, "js_renderer_ProgramLib_precompile : Error processing arguments");
+        cobj->precompile(arg0);
+        return true;
+    }
+    if (argc == 2) {
+        cocos2d::renderer::Effect* arg0 = nullptr;
+        cocos2d::ValueVector arg1;
+        ok &= seval_to_native_ptr(args[0], &arg0);
+        ok &= seval_to_ccvaluevector(args[1], &arg1);
+        SE_PRECONDITION2(ok, false, "js_renderer_ProgramLib_precompile : Error processing arguments");
+        cobj->precompile(arg0, arg1);
+        return true;
+    }
+    SE_REPORT_ERROR("wrong number of arguments: %d, was expecting %d", (int)argc, 1);
+    return false;
+}
+SE_BIND_FUNC(js_renderer_ProgramLib_precompile)
+
 SE_DECLARE_FINALIZE_FUNC(js_cocos2d_renderer_ProgramLib_finalize)
 
 static bool js_renderer_ProgramLib_constructor(se::State& s)
@@ -118,6 +165,8 @@ bool js_register_renderer_ProgramLib(se::Object* obj)
 
     cls->defineFunction("getProgram", _SE(js_renderer_ProgramLib_getProgram));
     cls->defineFunction("define", _SE(js_renderer_ProgramLib_define));
+    cls->defineFunction("precompile", _SE(js_renderer_ProgramLib_precompile));
+    cls->defineFunction("setBinaryCachePath", _SE(js_renderer_ProgramLib_setBinaryCachePath));
     cls->defineFunction("getKey", _SE(js_renderer_ProgramLib_getKey));
     cls->defineFinalizeFunction(_SE(js_cocos2d_renderer_ProgramLib_finalize));
     cls->install();
@@ -2381,6 +2430,43 @@ static bool js_renderer_Scene_removeLight(se::State& s)
 }
 SE_BIND_FUNC(js_renderer_Scene_removeLight)
 
+static bool js_renderer_Scene_setRetainedMode(se::State& s)
+{
+    cocos2d::renderer::Scene* cobj = (cocos2d::renderer::Scene*)s.nativeThisObject();
+    SE_PRECONDITION2(cobj, false, "js_renderer_Scene_setRetainedMode : Invalid Native Object");
+    const auto& args = s.args();
+    size_t argc = args.size();
+    CC_UNUSED bool ok = true;
+    if (argc == 1) {
+        bool arg0;
+        ok &= seval_to_boolean(args[0], &arg0);
+        SE_PRECONDITION2(ok, false, "js_renderer_Scene_setRetainedMode : Error processing arguments");
+        cobj->setRetainedMode(arg0);
+        return true;
+    }
+    SE_REPORT_ERROR("wrong number of arguments: %d, was expecting %d", (int)argc, 1);
+    return false;
+}
+SE_BIND_FUNC(js_renderer_Scene_setRetainedMode)
+
+static bool js_renderer_Scene_isRetainedMode(se::State& s)
+{
+    cocos2d::renderer::Scene* cobj = (cocos2d::renderer::Scene*)s.nativeThisObject();
+    SE_PRECONDITION2(cobj, false, "js_renderer_Scene_isRetainedMode : Invalid Native Object");
+    const auto& args = s.args();
+    size_t argc = args.size();
+    CC_UNUSED bool ok = true;
+    if (argc == 0) {
+        bool result = cobj->isRetainedMode();
+        ok &= boolean_to_seval(result, &s.rval());
+        SE_PRECONDITION2(ok, false, "js_renderer_Scene_isRetainedMode : Error processing arguments");
+        return true;
+    }
+    SE_REPORT_ERROR("wrong number of arguments: %d, was expecting %d", (int)argc, 0);
+    return false;
+}
+SE_BIND_FUNC(js_renderer_Scene_isRetainedMode)
+
 SE_DECLARE_FINALIZE_FUNC(js_cocos2d_renderer_Scene_finalize)
 
 static bool js_renderer_Scene_constructor(se::State& s)
@@ -2426,6 +2512,8 @@ bool js_register_renderer_Scene(se::Object* obj)
     cls->defineFunction("removeView", _SE(js_renderer_Scene_removeView));
     cls->defineFunction("addLight", _SE(js_renderer_Scene_addLight));
     cls->defineFunction("removeLight", _SE(js_renderer_Scene_removeLight));
+    cls->defineFunction("setRetainedMode", _SE(js_renderer_Scene_setRetainedMode));
+    cls->defineFunction("isRetainedMode", _SE(js_renderer_Scene_isRetainedMode));
     cls->defineFinalizeFunction(_SE(js_cocos2d_renderer_Scene_finalize));
     cls->install();
     JSBClassType::registerClass<cocos2d::renderer::Scene>(cls);
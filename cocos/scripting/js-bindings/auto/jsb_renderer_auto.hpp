@@ -10,6 +10,8 @@ bool js_register_cocos2d_renderer_ProgramLib(se::Object* obj);
 bool register_all_renderer(se::Object* obj);
 SE_DECLARE_FUNC(js_renderer_ProgramLib_getProgram);
 SE_DECLARE_FUNC(js_renderer_ProgramLib_define);
+SE_DECLARE_FUNC(js_renderer_ProgramLib_precompile);
+SE_DECLARE_FUNC(js_renderer_ProgramLib_setBinaryCachePath);
 SE_DECLARE_FUNC(js_renderer_ProgramLib_getKey);
 SE_DECLARE_FUNC(js_renderer_ProgramLib_ProgramLib);
 
@@ -150,5 +152,7 @@ SE_DECLARE_FUNC(js_renderer_Scene_setDebugCamera);
 SE_DECLARE_FUNC(js_renderer_Scene_removeView);
 SE_DECLARE_FUNC(js_renderer_Scene_addLight);
 SE_DECLARE_FUNC(js_renderer_Scene_removeLight);
+SE_DECLARE_FUNC(js_renderer_Scene_setRetainedMode);
+SE_DECLARE_FUNC(js_renderer_Scene_isRetainedMode);
 SE_DECLARE_FUNC(js_renderer_Scene_Scene);
 
@@ -28,6 +28,9 @@
 #include "cocos/scripting/js-bindings/manual/jsb_global.h"
 #include "cocos/scripting/js-bindings/event/CustomEventTypes.h"
 
+#include <algorithm>
+#include <iterator>
+
 namespace {
     se::Value _tickVal;
     std::vector<se::Object*> _jsTouchObjPool;
@@ -36,11 +39,36 @@ namespace {
     se::Object* _jsKeyboardEventObj = nullptr;
     se::Object* _jsResizeEventObj = nullptr;
     bool _inited = false;
+
+    struct PendingInputEvent
+    {
+        enum class Kind : uint8_t
+        {
+            TOUCH,
+            MOUSE,
+            KEYBOARD
+        };
+
+        Kind kind = Kind::TOUCH;
+        cocos2d::TouchEvent touch;
+        cocos2d::MouseEvent mouse;
+        cocos2d::KeyboardEvent keyboard;
+    };
+    std::vector<PendingInputEvent> _pendingInputEvents;
+    std::vector<PendingInputEvent> _dispatchingInputEvents;
+
+    const uint32_t TOUCH_DATA_INITIAL_CAPACITY = 16;
+    se::Object* _jsTouchDataArray = nullptr; // Float32Array, [x, y] per touch
+    se::Object* _jsTouchIdArray = nullptr; // Int32Array, identifier per touch
+    uint32_t _touchDataCapacity = 0;
+    se::Object* _jsMouseDataArray = nullptr; // Float32Array, [x, y, button]
 }
 
 namespace cocos2d
 {
-    std::unordered_map<std::string, EventDispatcher::Node*> EventDispatcher::_listeners;
+    std::unordered_map<std::string, uint32_t> EventDispatcher::_customEventIDs;
+    std::vector<std::string> EventDispatcher::_customEventNames;
+    std::vector<EventDispatcher::ListenerList> EventDispatcher::_listeners;
 
     void EventDispatcher::init()
     {
@@ -86,180 +114,409 @@ namespace cocos2d
             _jsResizeEventObj->decRef();
             _jsResizeEventObj = nullptr;
         }
+
+        if (_jsTouchDataArray != nullptr)
+        {
+            _jsTouchDataArray->unroot();
+            _jsTouchDataArray->decRef();
+            _jsTouchDataArray = nullptr;
+        }
+
+        if (_jsTouchIdArray != nullptr)
+        {
+            _jsTouchIdArray->unroot();
+            _jsTouchIdArray->decRef();
+            _jsTouchIdArray = nullptr;
+        }
+        _touchDataCapacity = 0;
+
+        if (_jsMouseDataArray != nullptr)
+        {
+            _jsMouseDataArray->unroot();
+            _jsMouseDataArray->decRef();
+            _jsMouseDataArray = nullptr;
+        }
+
+        _pendingInputEvents.clear();
         _inited = false;
         _tickVal.setUndefined();
     }
 
-void EventDispatcher::dispatchTouchEvent(const struct TouchEvent& touchEvent)
-{
-    if (!se::ScriptEngine::getInstance()->isValid())
-        return;
+namespace {
 
-    se::AutoHandleScope scope;
-    assert(_inited);
+    const char* getTouchEventName(TouchEvent::Type type)
+    {
+        switch (type) {
+            case TouchEvent::Type::BEGAN:
+                return "onTouchStart";
+            case TouchEvent::Type::MOVED:
+                return "onTouchMove";
+            case TouchEvent::Type::ENDED:
+                return "onTouchEnd";
+            case TouchEvent::Type::CANCELLED:
+                return "onTouchCancel";
+            default:
+                assert(false);
+                return nullptr;
+        }
+    }
 
-    if (_jsTouchObjArray == nullptr)
+    const char* getMouseEventName(MouseEvent::Type type)
     {
-        _jsTouchObjArray = se::Object::createArrayObject(0);
-        _jsTouchObjArray->root();
+        switch (type) {
+            case MouseEvent::Type::DOWN:
+                return "onMouseDown";
+            case MouseEvent::Type::MOVE:
+                return "onMouseMove";
+            case MouseEvent::Type::UP:
+                return "onMouseUp";
+            case MouseEvent::Type::WHEEL:
+                return "onMouseWheel";
+            default:
+                assert(false);
+                return nullptr;
+        }
     }
 
-    _jsTouchObjArray->setProperty("length", se::Value(touchEvent.touches.size()));
+    bool getJSFunction(const char* name, se::Value* funcVal)
+    {
+        return __jsbObj->getProperty(name, funcVal) && funcVal->isObject() && funcVal->toObject()->isFunction();
+    }
 
-    while (_jsTouchObjPool.size() < touchEvent.touches.size())
+    se::Object* createRootedTypedArray(se::Object::TypedArrayType type, size_t byteLength)
     {
-        se::Object* touchObj = se::Object::createPlainObject();
-        touchObj->root();
-        _jsTouchObjPool.push_back(touchObj);
+        std::vector<uint8_t> zeros(byteLength, 0);
+        se::Object* obj = se::Object::createTypedArray(type, zeros.data(), byteLength);
+        obj->root();
+        return obj;
     }
 
-    uint32_t touchIndex = 0;
-    int poolIndex = 0;
-    for (const auto& touch : touchEvent.touches)
+    void ensureTouchDataCapacity(uint32_t touchCount)
     {
-        se::Object* jsTouch = _jsTouchObjPool.at(poolIndex++);
-        jsTouch->setProperty("identifier", se::Value(touch.index));
-        jsTouch->setProperty("clientX", se::Value(touch.x));
-        jsTouch->setProperty("clientY", se::Value(touch.y));
-        jsTouch->setProperty("pageX", se::Value(touch.x));
-        jsTouch->setProperty("pageY", se::Value(touch.y));
-
-        _jsTouchObjArray->setArrayElement(touchIndex, se::Value(jsTouch));
-        ++touchIndex;
+        if (touchCount <= _touchDataCapacity)
+            return;
+
+        uint32_t capacity = std::max(std::max(_touchDataCapacity * 2, touchCount), TOUCH_DATA_INITIAL_CAPACITY);
+
+        if (_jsTouchDataArray != nullptr)
+        {
+            _jsTouchDataArray->unroot();
+            _jsTouchDataArray->decRef();
+        }
+        if (_jsTouchIdArray != nullptr)
+        {
+            _jsTouchIdArray->unroot();
+            _jsTouchIdArray->decRef();
+        }
+
+        _jsTouchDataArray = createRootedTypedArray(se::Object::TypedArrayType::FLOAT32, capacity * 2 * sizeof(float));
+        _jsTouchIdArray = createRootedTypedArray(se::Object::TypedArrayType::INT32, capacity * sizeof(int32_t));
+        _touchDataCapacity = capacity;
+
+        __jsbObj->setProperty("touchData", se::Value(_jsTouchDataArray));
+        __jsbObj->setProperty("touchIds", se::Value(_jsTouchIdArray));
     }
 
-    const char* eventName = nullptr;
-    switch (touchEvent.type) {
-        case TouchEvent::Type::BEGAN:
-            eventName = "onTouchStart";
-            break;
-        case TouchEvent::Type::MOVED:
-            eventName = "onTouchMove";
-            break;
-        case TouchEvent::Type::ENDED:
-            eventName = "onTouchEnd";
-            break;
-        case TouchEvent::Type::CANCELLED:
-            eventName = "onTouchCancel";
-            break;
-        default:
-            assert(false);
-            break;
+    // Fast path: the touches are written into jsb.touchData ([x, y] per touch) and jsb.touchIds,
+    // then jsb.onTouchData(type, count) is invoked once, type being the value of TouchEvent::Type.
+    // Both arrays are reallocated when more touches arrive than they can hold, so JS must not cache them.
+    bool dispatchTouchData(const TouchEvent& touchEvent)
+    {
+        se::Value funcVal;
+        if (!getJSFunction("onTouchData", &funcVal))
+            return false;
+
+        uint32_t touchCount = (uint32_t)touchEvent.touches.size();
+        ensureTouchDataCapacity(touchCount);
+
+        uint8_t* data = nullptr;
+        size_t length = 0;
+        _jsTouchDataArray->getTypedArrayData(&data, &length);
+        float* positions = (float*)data;
+        _jsTouchIdArray->getTypedArrayData(&data, &length);
+        int32_t* ids = (int32_t*)data;
+
+        for (uint32_t i = 0; i < touchCount; ++i)
+        {
+            const auto& touch = touchEvent.touches[i];
+            positions[i * 2] = touch.x;
+            positions[i * 2 + 1] = touch.y;
+            ids[i] = touch.index;
+        }
+
+        se::ValueArray args;
+        args.push_back(se::Value((int32_t)touchEvent.type));
+        args.push_back(se::Value(touchCount));
+        funcVal.toObject()->call(args, nullptr);
+        return true;
     }
 
-    se::Value callbackVal;
-    if (__jsbObj->getProperty(eventName, &callbackVal) && !callbackVal.isNullOrUndefined())
+    void dispatchTouchObjects(const TouchEvent& touchEvent)
     {
+        const char* eventName = getTouchEventName(touchEvent.type);
+        se::Value callbackVal;
+        if (eventName == nullptr || !__jsbObj->getProperty(eventName, &callbackVal) || callbackVal.isNullOrUndefined())
+            return;
+
+        if (_jsTouchObjArray == nullptr)
+        {
+            _jsTouchObjArray = se::Object::createArrayObject(0);
+            _jsTouchObjArray->root();
+        }
+
+        _jsTouchObjArray->setProperty("length", se::Value(touchEvent.touches.size()));
+
+        while (_jsTouchObjPool.size() < touchEvent.touches.size())
+        {
+            se::Object* touchObj = se::Object::createPlainObject();
+            touchObj->root();
+            _jsTouchObjPool.push_back(touchObj);
+        }
+
+        uint32_t touchIndex = 0;
+        int poolIndex = 0;
+        for (const auto& touch : touchEvent.touches)
+        {
+            se::Object* jsTouch = _jsTouchObjPool.at(poolIndex++);
+            jsTouch->setProperty("identifier", se::Value(touch.index));
+            jsTouch->setProperty("clientX", se::Value(touch.x));
+            jsTouch->setProperty("clientY", se::Value(touch.y));
+            jsTouch->setProperty("pageX", se::Value(touch.x));
+            jsTouch->setProperty("pageY", se::Value(touch.y));
+
+            _jsTouchObjArray->setArrayElement(touchIndex, se::Value(jsTouch));
+            ++touchIndex;
+        }
+
         se::ValueArray args;
         args.push_back(se::Value(_jsTouchObjArray));
         callbackVal.toObject()->call(args, nullptr);
     }
-}
 
-void EventDispatcher::dispatchMouseEvent(const struct MouseEvent& mouseEvent)
-{
-    if (!se::ScriptEngine::getInstance()->isValid())
-        return;
+    // Fast path: jsb.mouseData holds [x, y, button] (wheel deltas in x and y for WHEEL),
+    // then jsb.onMouseData(type) is invoked, type being the value of MouseEvent::Type.
+    bool dispatchMouseData(const MouseEvent& mouseEvent)
+    {
+        se::Value funcVal;
+        if (!getJSFunction("onMouseData", &funcVal))
+            return false;
 
-    se::AutoHandleScope scope;
-    assert(_inited);
+        if (_jsMouseDataArray == nullptr)
+        {
+            _jsMouseDataArray = createRootedTypedArray(se::Object::TypedArrayType::FLOAT32, 3 * sizeof(float));
+            __jsbObj->setProperty("mouseData", se::Value(_jsMouseDataArray));
+        }
 
-    if (_jsMouseEventObj == nullptr)
-    {
-        _jsMouseEventObj = se::Object::createPlainObject();
-        _jsMouseEventObj->root();
-    }
+        uint8_t* data = nullptr;
+        size_t length = 0;
+        _jsMouseDataArray->getTypedArrayData(&data, &length);
+        float* values = (float*)data;
+        values[0] = mouseEvent.x;
+        values[1] = mouseEvent.y;
+        values[2] = mouseEvent.button;
 
-    const auto& xVal = se::Value(mouseEvent.x);
-    const auto& yVal = se::Value(mouseEvent.y);
-    const MouseEvent::Type type = mouseEvent.type;
+        se::ValueArray args;
+        args.push_back(se::Value((int32_t)mouseEvent.type));
+        funcVal.toObject()->call(args, nullptr);
+        return true;
+    }
 
-    if (type == MouseEvent::Type::WHEEL)
+    void dispatchMouseObject(const MouseEvent& mouseEvent)
     {
-        _jsMouseEventObj->setProperty("wheelDeltaX", xVal);
-        _jsMouseEventObj->setProperty("wheelDeltaY", yVal);
+        if (_jsMouseEventObj == nullptr)
+        {
+            _jsMouseEventObj = se::Object::createPlainObject();
+            _jsMouseEventObj->root();
+        }
+
+        const auto& xVal = se::Value(mouseEvent.x);
+        const auto& yVal = se::Value(mouseEvent.y);
+        const MouseEvent::Type type = mouseEvent.type;
+
+        if (type == MouseEvent::Type::WHEEL)
+        {
+            _jsMouseEventObj->setProperty("wheelDeltaX", xVal);
+            _jsMouseEventObj->setProperty("wheelDeltaY", yVal);
+        }
+        else
+        {
+            if (type == MouseEvent::Type::DOWN || type == MouseEvent::Type::UP)
+            {
+                _jsMouseEventObj->setProperty("button", se::Value(mouseEvent.button));
+            }
+            _jsMouseEventObj->setProperty("x", xVal);
+            _jsMouseEventObj->setProperty("y", yVal);
+        }
+
+        const char* eventName = getMouseEventName(type);
+        se::Value callbackVal;
+        if (eventName != nullptr && __jsbObj->getProperty(eventName, &callbackVal) && !callbackVal.isNullOrUndefined())
+        {
+            se::ValueArray args;
+            args.push_back(se::Value(_jsMouseEventObj));
+            callbackVal.toObject()->call(args, nullptr);
+        }
     }
-    else
+
+    void dispatchKeyboardObject(const KeyboardEvent& keyboardEvent)
     {
-        if (type == MouseEvent::Type::DOWN || type == MouseEvent::Type::UP)
+        if (_jsKeyboardEventObj == nullptr)
         {
-            _jsMouseEventObj->setProperty("button", se::Value(mouseEvent.button));
+            _jsKeyboardEventObj = se::Object::createPlainObject();
+            _jsKeyboardEventObj->root();
         }
-        _jsMouseEventObj->setProperty("x", xVal);
-        _jsMouseEventObj->setProperty("y", yVal);
-    }
 
-    const char* eventName = nullptr;
-    switch (type) {
-        case MouseEvent::Type::DOWN:
-            eventName = "onMouseDown";
-            break;
-        case MouseEvent::Type::MOVE:
-            eventName = "onMouseMove";
-            break;
-        case MouseEvent::Type::UP:
-            eventName = "onMouseUp";
-            break;
-        case MouseEvent::Type::WHEEL:
-            eventName = "onMouseWheel";
-            break;
-        default:
-            assert(false);
-            break;
+        const char* eventName = nullptr;
+        switch (keyboardEvent.action) {
+            case KeyboardEvent::Action::PRESS:
+            case KeyboardEvent::Action::REPEAT:
+                eventName = "onKeyDown";
+                break;
+            case KeyboardEvent::Action::RELEASE:
+                eventName = "onKeyUp";
+                break;
+            default:
+                assert(false);
+                break;
+        }
+
+        se::Value callbackVal;
+        if (eventName != nullptr && __jsbObj->getProperty(eventName, &callbackVal) && !callbackVal.isNullOrUndefined())
+        {
+            _jsKeyboardEventObj->setProperty("altKey", se::Value(keyboardEvent.altKeyActive));
+            _jsKeyboardEventObj->setProperty("ctrlKey", se::Value(keyboardEvent.ctrlKeyActive));
+            _jsKeyboardEventObj->setProperty("metaKey", se::Value(keyboardEvent.metaKeyActive));
+            _jsKeyboardEventObj->setProperty("shiftKey", se::Value(keyboardEvent.shiftKeyActive));
+            _jsKeyboardEventObj->setProperty("repeat", se::Value(keyboardEvent.action == KeyboardEvent::Action::REPEAT));
+            _jsKeyboardEventObj->setProperty("keyCode", se::Value(keyboardEvent.key));
+
+            se::ValueArray args;
+            args.push_back(se::Value(_jsKeyboardEventObj));
+            callbackVal.toObject()->call(args, nullptr);
+        }
     }
 
-    se::Value callbackVal;
-    if (__jsbObj->getProperty(eventName, &callbackVal) && !callbackVal.isNullOrUndefined())
+} // end of anonymous namespace
+
+void EventDispatcher::dispatchTouchEvent(const struct TouchEvent& touchEvent)
+{
+    if (!se::ScriptEngine::getInstance()->isValid())
+        return;
+
+    assert(_inited);
+
+    // Merge into the previous MOVED event if nothing else was queued in between,
+    // keeping only the latest position of each touch id.
+    if (touchEvent.type == TouchEvent::Type::MOVED && !_pendingInputEvents.empty())
     {
-        se::ValueArray args;
-        args.push_back(se::Value(_jsMouseEventObj));
-        callbackVal.toObject()->call(args, nullptr);
+        auto& last = _pendingInputEvents.back();
+        if (last.kind == PendingInputEvent::Kind::TOUCH && last.touch.type == TouchEvent::Type::MOVED)
+        {
+            auto& touches = last.touch.touches;
+            for (const auto& touch : touchEvent.touches)
+            {
+                auto iter = std::find_if(touches.begin(), touches.end(), [&touch](const TouchInfo& info) {
+                    return info.index == touch.index;
+                });
+                if (iter != touches.end())
+                    *iter = touch;
+                else
+                    touches.push_back(touch);
+            }
+            return;
+        }
     }
+
+    _pendingInputEvents.emplace_back();
+    auto& pending = _pendingInputEvents.back();
+    pending.kind = PendingInputEvent::Kind::TOUCH;
+    pending.touch = touchEvent;
 }
 
-void EventDispatcher::dispatchKeyboardEvent(const struct KeyboardEvent& keyboardEvent)
+void EventDispatcher::dispatchMouseEvent(const struct MouseEvent& mouseEvent)
 {
     if (!se::ScriptEngine::getInstance()->isValid())
         return;
 
-
-    se::AutoHandleScope scope;
     assert(_inited);
 
-    if (_jsKeyboardEventObj == nullptr)
+    // Consecutive moves only keep the latest position, consecutive wheel events accumulate their deltas.
+    if (!_pendingInputEvents.empty())
     {
-        _jsKeyboardEventObj = se::Object::createPlainObject();
-        _jsKeyboardEventObj->root();
+        auto& last = _pendingInputEvents.back();
+        if (last.kind == PendingInputEvent::Kind::MOUSE && last.mouse.type == mouseEvent.type)
+        {
+            if (mouseEvent.type == MouseEvent::Type::MOVE)
+            {
+                last.mouse = mouseEvent;
+                return;
+            }
+            else if (mouseEvent.type == MouseEvent::Type::WHEEL)
+            {
+                last.mouse.x += mouseEvent.x;
+                last.mouse.y += mouseEvent.y;
+                return;
+            }
+        }
     }
 
-    const char* eventName = nullptr;
-    switch (keyboardEvent.action) {
-        case KeyboardEvent::Action::PRESS:
-        case KeyboardEvent::Action::REPEAT:
-            eventName = "onKeyDown";
-            break;
-        case KeyboardEvent::Action::RELEASE:
-            eventName = "onKeyUp";
-            break;
-        default:
-            assert(false);
-            break;
+    _pendingInputEvents.emplace_back();
+    auto& pending = _pendingInputEvents.back();
+    pending.kind = PendingInputEvent::Kind::MOUSE;
+    pending.mouse = mouseEvent;
+}
+
+void EventDispatcher::flushInputEvents()
+{
+    if (_pendingInputEvents.empty())
+        return;
+
+    if (!se::ScriptEngine::getInstance()->isValid())
+    {
+        _pendingInputEvents.clear();
+        return;
     }
 
-    se::Value callbackVal;
-    if (__jsbObj->getProperty(eventName, &callbackVal) && !callbackVal.isNullOrUndefined())
+    se::AutoHandleScope scope;
+    assert(_inited);
+
+    // Events queued by the JS callbacks are delivered on the next flush.
+    _dispatchingInputEvents.swap(_pendingInputEvents);
+    for (const auto& pending : _dispatchingInputEvents)
     {
-        _jsKeyboardEventObj->setProperty("altKey", se::Value(keyboardEvent.altKeyActive));
-        _jsKeyboardEventObj->setProperty("ctrlKey", se::Value(keyboardEvent.ctrlKeyActive));
-        _jsKeyboardEventObj->setProperty("metaKey", se::Value(keyboardEvent.metaKeyActive));
-        _jsKeyboardEventObj->setProperty("shiftKey", se::Value(keyboardEvent.shiftKeyActive));
-        _jsKeyboardEventObj->setProperty("repeat", se::Value(keyboardEvent.action == KeyboardEvent::Action::REPEAT));
-        _jsKeyboardEventObj->setProperty("keyCode", se::Value(keyboardEvent.key));
+        if (!_inited)
+            break;
 
-        se::ValueArray args;
-        args.push_back(se::Value(_jsKeyboardEventObj));
-        callbackVal.toObject()->call(args, nullptr);
+        if (pending.kind == PendingInputEvent::Kind::TOUCH)
+        {
+            if (!dispatchTouchData(pending.touch))
+                dispatchTouchObjects(pending.touch);
+        }
+        else if (pending.kind == PendingInputEvent::Kind::MOUSE)
+        {
+            if (!dispatchMouseData(pending.mouse))
+                dispatchMouseObject(pending.mouse);
+        }
+        else
+        {
+            dispatchKeyboardObject(pending.keyboard);
+        }
     }
+    _dispatchingInputEvents.clear();
+}
+
+void EventDispatcher::dispatchKeyboardEvent(const struct KeyboardEvent& keyboardEvent)
+{
+    if (!se::ScriptEngine::getInstance()->isValid())
+        return;
+
+    assert(_inited);
+
+    // Queued with touch and mouse events so JS receives all input in the order it happened.
+    _pendingInputEvents.emplace_back();
+    auto& pending = _pendingInputEvents.back();
+    pending.kind = PendingInputEvent::Kind::KEYBOARD;
+    pending.keyboard = keyboardEvent;
 }
     
 void EventDispatcher::dispatchTickEvent(float dt)
@@ -267,6 +524,8 @@ void EventDispatcher::dispatchTickEvent(float dt)
     if (!se::ScriptEngine::getInstance()->isValid())
         return;
 
+    flushInputEvents();
+
     se::AutoHandleScope scope;
     if (_tickVal.isUndefined())
     {
@@ -328,9 +587,9 @@ static void dispatchEnterBackgroundOrForegroundEvent(const char* funcName)
 void EventDispatcher::dispatchEnterBackgroundEvent()
 {
     // dispatch to Native
+    static const uint32_t eventID = EventDispatcher::getCustomEventID(EVENT_COME_TO_BACKGROUND);
     CustomEvent event;
-    event.name = EVENT_COME_TO_BACKGROUND;
-    EventDispatcher::dispatchCustomEvent(event);
+    EventDispatcher::dispatchCustomEvent(eventID, event);
 
     // dispatch to JavaScript
     dispatchEnterBackgroundOrForegroundEvent("onHide");
@@ -339,42 +598,83 @@ void EventDispatcher::dispatchEnterBackgroundEvent()
 void EventDispatcher::dispatchEnterForegroundEvent()
 {
     // dispatch to Native
+    static const uint32_t eventID = EventDispatcher::getCustomEventID(EVENT_COME_TO_FOREGROUND);
     CustomEvent event;
-    event.name = EVENT_COME_TO_FOREGROUND;
-    EventDispatcher::dispatchCustomEvent(event);
+    EventDispatcher::dispatchCustomEvent(eventID, event);
 
     // dispatch to JavaScript
     dispatchEnterBackgroundOrForegroundEvent("onShow");
 }
 
-uint32_t EventDispatcher::addCustomEventListener(const std::string& eventName, const CustomEventListener& listener)
+uint32_t EventDispatcher::getCustomEventID(const std::string& eventName)
 {
-    static uint32_t __listenerIDCounter = 0;
-    uint32_t listenerID = ++__listenerIDCounter;
-    listenerID = listenerID == 0 ? 1 : listenerID;
+    auto iter = _customEventIDs.find(eventName);
+    if (iter != _customEventIDs.end())
+        return iter->second;
+
+    _customEventNames.push_back(eventName);
+    _listeners.emplace_back();
+    uint32_t eventID = (uint32_t)_customEventNames.size();
+    _customEventIDs.emplace(eventName, eventID);
+    return eventID;
+}
+
+const std::string& EventDispatcher::getCustomEventName(uint32_t eventID)
+{
+    static const std::string emptyName;
+    if (eventID == 0 || eventID > _customEventNames.size())
+        return emptyName;
+
+    return _customEventNames[eventID - 1];
+}
 
-    Node* newNode = new Node();
-    newNode->listener = listener;
-    newNode->listenerID = listenerID;
-    newNode->next = nullptr;
+EventDispatcher::ListenerList* EventDispatcher::findListenerList(uint32_t eventID)
+{
+    if (eventID == 0 || eventID > _listeners.size())
+        return nullptr;
+
+    return &_listeners[eventID - 1];
+}
 
-    auto iter = _listeners.find(eventName);
-    if (iter == _listeners.end())
+void EventDispatcher::compactListenerList(ListenerList& list)
+{
+    if (list.hasRemovedListeners)
     {
-        _listeners.emplace(eventName, newNode);
+        list.listeners.erase(std::remove_if(list.listeners.begin(), list.listeners.end(), [](const Listener& listener) {
+            return listener.listenerID == 0;
+        }), list.listeners.end());
+        list.hasRemovedListeners = false;
     }
-    else
+
+    if (!list.addedWhileDispatching.empty())
     {
-        Node* node = iter->second;
-        assert(node != nullptr);
-        Node* prev = nullptr;
-        while (node != nullptr)
-        {
-            prev = node;
-            node = node->next;
-        }
-        prev->next = newNode;
+        std::move(list.addedWhileDispatching.begin(), list.addedWhileDispatching.end(), std::back_inserter(list.listeners));
+        list.addedWhileDispatching.clear();
     }
+}
+
+uint32_t EventDispatcher::addCustomEventListener(const std::string& eventName, const CustomEventListener& listener)
+{
+    return addCustomEventListener(getCustomEventID(eventName), listener);
+}
+
+uint32_t EventDispatcher::addCustomEventListener(uint32_t eventID, const CustomEventListener& listener)
+{
+    ListenerList* list = findListenerList(eventID);
+    if (list == nullptr)
+        return 0;
+
+    static uint32_t __listenerIDCounter = 0;
+    uint32_t listenerID = ++__listenerIDCounter;
+    listenerID = listenerID == 0 ? 1 : listenerID;
+
+    // Listeners added from a listener of the same event are called from the next dispatch on,
+    // the array being dispatched must not grow.
+    if (list->dispatchDepth > 0)
+        list->addedWhileDispatching.push_back({listener, listenerID});
+    else
+        list->listeners.push_back({listener, listenerID});
+
     return listenerID;
 }
 
@@ -383,70 +683,98 @@ void EventDispatcher::removeCustomEventListener(const std::string& eventName, ui
     if (eventName.empty())
         return;
 
+    auto iter = _customEventIDs.find(eventName);
+    if (iter != _customEventIDs.end())
+        removeCustomEventListener(iter->second, listenerID);
+}
+
+void EventDispatcher::removeCustomEventListener(uint32_t eventID, uint32_t listenerID)
+{
     if (listenerID == 0)
         return;
 
-    auto iter = _listeners.find(eventName);
-    if (iter != _listeners.end())
-    {
-        Node* prev = nullptr;
-        Node* node = iter->second;
-        while (node != nullptr)
-        {
-            if (node->listenerID == listenerID)
-            {
-                if (prev != nullptr)
-                {
-                    prev->next = node->next;
-                }
-                else if (node->next)
-                {
-                    _listeners[eventName] = node->next;
-                }
-                else
-                {
-                    _listeners.erase(iter);
-                }
+    ListenerList* list = findListenerList(eventID);
+    if (list == nullptr)
+        return;
 
-                delete node;
-                return;
-            }
+    auto isTarget = [listenerID](const Listener& listener) {
+        return listener.listenerID == listenerID;
+    };
 
-            prev = node;
-            node = node->next;
+    auto iter = std::find_if(list->listeners.begin(), list->listeners.end(), isTarget);
+    if (iter != list->listeners.end())
+    {
+        // The listener may be the one being called, leave a tombstone and erase it once the dispatch is over.
+        if (list->dispatchDepth > 0)
+        {
+            iter->listenerID = 0;
+            list->hasRemovedListeners = true;
+        }
+        else
+        {
+            list->listeners.erase(iter);
         }
+        return;
     }
+
+    iter = std::find_if(list->addedWhileDispatching.begin(), list->addedWhileDispatching.end(), isTarget);
+    if (iter != list->addedWhileDispatching.end())
+        list->addedWhileDispatching.erase(iter);
 }
 
 void EventDispatcher::removeAllCustomEventListeners(const std::string& eventName)
 {
-    auto iter = _listeners.find(eventName);
-    if (iter != _listeners.end())
+    auto iter = _customEventIDs.find(eventName);
+    if (iter != _customEventIDs.end())
+        removeAllCustomEventListeners(iter->second);
+}
+
+void EventDispatcher::removeAllCustomEventListeners(uint32_t eventID)
+{
+    ListenerList* list = findListenerList(eventID);
+    if (list == nullptr)
+        return;
+
+    list->addedWhileDispatching.clear();
+    if (list->dispatchDepth > 0)
     {
-        Node* node = iter->second;
-        while (node != nullptr)
-        {
-            delete node;
-            node = node->next;
-        }
-        _listeners.erase(iter);
+        for (auto& listener : list->listeners)
+            listener.listenerID = 0;
+        list->hasRemovedListeners = !list->listeners.empty();
+    }
+    else
+    {
+        list->listeners.clear();
     }
 }
 
 void EventDispatcher::dispatchCustomEvent(const CustomEvent& event)
 {
-    auto iter = _listeners.find(event.name);
-    if (iter != _listeners.end())
+    auto iter = _customEventIDs.find(event.name);
+    if (iter != _customEventIDs.end())
+        dispatchCustomEvent(iter->second, event);
+}
+
+void EventDispatcher::dispatchCustomEvent(uint32_t eventID, const CustomEvent& event)
+{
+    ListenerList* list = findListenerList(eventID);
+    if (list == nullptr || list->listeners.empty())
+        return;
+
+    ++list->dispatchDepth;
+    const size_t count = list->listeners.size();
+    for (size_t i = 0; i < count; ++i)
     {
-        Node* next = nullptr;
-        Node* node = iter->second;
-        while (node != nullptr)
-        {
-            next = node->next;
-            node->listener(event);
-            node = next;
-        }
+        // A listener may intern a new event name and reallocate _listeners, so index it again every time.
+        // The listener array itself is moved along and stays in place.
+        Listener& listener = _listeners[eventID - 1].listeners[i];
+        if (listener.listenerID != 0)
+            listener.callback(event);
     }
+
+    list = &_listeners[eventID - 1];
+    if (--list->dispatchDepth == 0)
+        compactListenerList(*list);
 }
     
 } // end of namespace cocos2d
@@ -115,8 +115,12 @@ public:
     static void init();
     static void destroy();
 
+    // Touch, mouse and keyboard events are queued and delivered to JS in order once per frame by
+    // flushInputEvents(). Consecutive move events are coalesced, so JS only sees the latest position of each touch.
     static void dispatchTouchEvent(const struct TouchEvent& touchEvent);
     static void dispatchMouseEvent(const struct MouseEvent& mouseEvent);
+    // Called by dispatchTickEvent() before "gameTick"; platforms may call it earlier if needed.
+    static void flushInputEvents();
     static void dispatchKeyboardEvent(const struct KeyboardEvent& keyboardEvent);
     static void dispatchTickEvent(float dt);
     static void dispatchResizeEvent(int width, int height);
@@ -124,19 +128,42 @@ public:
     static void dispatchEnterForegroundEvent();
 
     using CustomEventListener = std::function<void(const CustomEvent&)>;
+    // Event names are interned to non-zero ids, the id of a name never changes during the process lifetime.
+    // Native code that fires an event often should keep its id and use the id based overloads.
+    static uint32_t getCustomEventID(const std::string& eventName);
+    static const std::string& getCustomEventName(uint32_t eventID);
+
     static uint32_t addCustomEventListener(const std::string& eventName, const CustomEventListener& listener);
+    static uint32_t addCustomEventListener(uint32_t eventID, const CustomEventListener& listener);
     static void removeCustomEventListener(const std::string& eventName, uint32_t listenerID);
+    static void removeCustomEventListener(uint32_t eventID, uint32_t listenerID);
     static void removeAllCustomEventListeners(const std::string& eventName);
+    static void removeAllCustomEventListeners(uint32_t eventID);
     static void dispatchCustomEvent(const CustomEvent& event);
+    // `event.name` is not read, listeners that need the name can use getCustomEventName(eventID).
+    static void dispatchCustomEvent(uint32_t eventID, const CustomEvent& event);
 
 private:
-    struct Node
+    struct Listener
+    {
+        CustomEventListener callback;
+        uint32_t listenerID; // 0 once removed while the list is being dispatched
+    };
+
+    struct ListenerList
     {
-        CustomEventListener listener;
-        uint32_t listenerID;
-        struct Node* next;
+        std::vector<Listener> listeners;
+        std::vector<Listener> addedWhileDispatching;
+        uint32_t dispatchDepth = 0;
+        bool hasRemovedListeners = false;
     };
-    static std::unordered_map<std::string, Node*> _listeners;
+
+    static ListenerList* findListenerList(uint32_t eventID);
+    static void compactListenerList(ListenerList& list);
+
+    static std::unordered_map<std::string, uint32_t> _customEventIDs;
+    static std::vector<std::string> _customEventNames; // indexed by event id - 1
+    static std::vector<ListenerList> _listeners; // indexed by event id - 1
 };
     
 } // end of namespace cocos2d
@@ -33,6 +33,81 @@
 
 namespace se {
  
+    namespace {
+        void getTypedArrayInfo(Object::TypedArrayType type, size_t byteLength, JsTypedArrayType* typedArrayType, size_t* elementLength)
+        {
+            switch (type) {
+                case Object::TypedArrayType::INT8:
+                    *typedArrayType = JsArrayTypeInt8;
+                    *elementLength = byteLength;
+                    break;
+                case Object::TypedArrayType::INT16:
+                    *typedArrayType = JsArrayTypeInt16;
+                    *elementLength = byteLength / 2;
+                    break;
+                case Object::TypedArrayType::INT32:
+                    *typedArrayType = JsArrayTypeInt32;
+                    *elementLength = byteLength / 4;
+                    break;
+                case Object::TypedArrayType::UINT8:
+                    *typedArrayType = JsArrayTypeUint8;
+                    *elementLength = byteLength;
+                    break;
+                case Object::TypedArrayType::UINT16:
+                    *typedArrayType = JsArrayTypeUint16;
+                    *elementLength = byteLength / 2;
+                    break;
+                case Object::TypedArrayType::UINT32:
+                    *typedArrayType = JsArrayTypeUint32;
+                    *elementLength = byteLength / 4;
+                    break;
+                case Object::TypedArrayType::FLOAT32:
+                    *typedArrayType = JsArrayTypeFloat32;
+                    *elementLength = byteLength / 4;
+                    break;
+                case Object::TypedArrayType::FLOAT64:
+                    *typedArrayType = JsArrayTypeFloat64;
+                    *elementLength = byteLength / 8;
+                    break;
+                default:
+                    assert(false); // Should never go here.
+                    break;
+            }
+        }
+
+        struct ExternalBufferContents
+        {
+            void* contents;
+            size_t byteLength;
+            Object::BufferContentsFreeFunc freeFunc;
+            void* freeUserData;
+        };
+
+        void CHAKRA_CALLBACK externalBufferFinalizeCallback(void* data)
+        {
+            ExternalBufferContents* buffer = (ExternalBufferContents*)data;
+            buffer->freeFunc(buffer->contents, buffer->byteLength, buffer->freeUserData);
+            delete buffer;
+        }
+
+        JsValueRef createExternalArrayBuffer(void* contents, size_t byteLength, Object::BufferContentsFreeFunc freeFunc, void* freeUserData)
+        {
+            ExternalBufferContents* buffer = new ExternalBufferContents();
+            buffer->contents = contents;
+            buffer->byteLength = byteLength;
+            buffer->freeFunc = freeFunc;
+            buffer->freeUserData = freeUserData;
+
+            JsValueRef jsobj = JS_INVALID_REFERENCE;
+            if (JsNoError != JsCreateExternalArrayBuffer(contents, (unsigned int)byteLength, externalBufferFinalizeCallback, buffer, &jsobj))
+            {
+                externalBufferFinalizeCallback(buffer);
+                return JS_INVALID_REFERENCE;
+            }
+            return jsobj;
+        }
+    }
+
     Object::Object()
     : _cls(nullptr)
     , _obj(JS_INVALID_REFERENCE)
@@ -97,44 +172,7 @@ namespace se {
 
         JsTypedArrayType typedArrayType;
         size_t elementLength = 0;
-
-        switch (type) {
-            case TypedArrayType::INT8:
-                typedArrayType = JsArrayTypeInt8;
-                elementLength = byteLength;
-                break;
-            case TypedArrayType::INT16:
-                typedArrayType = JsArrayTypeInt16;
-                elementLength = byteLength / 2;
-                break;
-            case TypedArrayType::INT32:
-                typedArrayType = JsArrayTypeInt32;
-                elementLength = byteLength / 4;
-                break;
-            case TypedArrayType::UINT8:
-                typedArrayType = JsArrayTypeUint8;
-                elementLength = byteLength;
-                break;
-            case TypedArrayType::UINT16:
-                typedArrayType = JsArrayTypeUint16;
-                elementLength = byteLength / 2;
-                break;
-            case TypedArrayType::UINT32:
-                typedArrayType = JsArrayTypeUint32;
-                elementLength = byteLength / 4;
-                break;
-            case TypedArrayType::FLOAT32:
-                typedArrayType = JsArrayTypeFloat32;
-                elementLength = byteLength / 4;
-                break;
-            case TypedArrayType::FLOAT64:
-                typedArrayType = JsArrayTypeFloat64;
-                elementLength = byteLength / 8;
-                break;
-            default:
-                assert(false); // Should never go here.
-                break;
-        }
+        getTypedArrayInfo(type, byteLength, &typedArrayType, &elementLength);
 
         Object* obj = nullptr;
         JsValueRef jsobj;
@@ -152,6 +190,39 @@ namespace se {
         return obj;
     }
 
+    Object* Object::createExternalArrayBufferObject(void* contents, size_t byteLength, BufferContentsFreeFunc freeFunc, void* freeUserData)
+    {
+        JsValueRef jsobj = createExternalArrayBuffer(contents, byteLength, freeFunc, freeUserData);
+        if (jsobj == JS_INVALID_REFERENCE)
+            return nullptr;
+
+        Object* obj = Object::_createJSObject(nullptr, jsobj);
+        return obj;
+    }
+
+    Object* Object::createExternalTypedArray(TypedArrayType type, void* contents, size_t byteLength, BufferContentsFreeFunc freeFunc, void* freeUserData)
+    {
+        if (type == TypedArrayType::NONE || type == TypedArrayType::UINT8_CLAMPED)
+        {
+            SE_LOGE("Doesn't support to create typed array of type %d with Object::createExternalTypedArray API!", (int)type);
+            freeFunc(contents, byteLength, freeUserData);
+            return nullptr;
+        }
+
+        JsValueRef arrayBuffer = createExternalArrayBuffer(contents, byteLength, freeFunc, freeUserData);
+        if (arrayBuffer == JS_INVALID_REFERENCE)
+            return nullptr;
+
+        JsTypedArrayType typedArrayType;
+        size_t elementLength = 0;
+        getTypedArrayInfo(type, byteLength, &typedArrayType, &elementLength);
+
+        JsValueRef jsobj;
+        _CHECK(JsCreateTypedArray(typedArrayType, arrayBuffer, 0, (unsigned int)elementLength, &jsobj));
+        Object* obj = Object::_createJSObject(nullptr, jsobj);
+        return obj;
+    }
+
     Object* Object::createUint8TypedArray(uint8_t* data, size_t dataCount)
     {
         return createTypedArray(TypedArrayType::UINT8, data, dataCount);
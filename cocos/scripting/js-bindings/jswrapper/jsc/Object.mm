@@ -105,6 +105,38 @@ namespace se {
     {
         free(bytes);
     }
+
+    namespace {
+        struct ExternalBufferContents
+        {
+            size_t byteLength;
+            Object::BufferContentsFreeFunc freeFunc;
+            void* freeUserData;
+        };
+
+        void externalBufferBytesDeallocator(void* bytes, void* deallocatorContext)
+        {
+            ExternalBufferContents* buffer = (ExternalBufferContents*)deallocatorContext;
+            buffer->freeFunc(bytes, buffer->byteLength, buffer->freeUserData);
+            delete buffer;
+        }
+
+        JSTypedArrayType toJSCTypedArrayType(Object::TypedArrayType type)
+        {
+            switch (type) {
+                case Object::TypedArrayType::INT8: return kJSTypedArrayTypeInt8Array;
+                case Object::TypedArrayType::INT16: return kJSTypedArrayTypeInt16Array;
+                case Object::TypedArrayType::INT32: return kJSTypedArrayTypeInt32Array;
+                case Object::TypedArrayType::UINT8: return kJSTypedArrayTypeUint8Array;
+                case Object::TypedArrayType::UINT8_CLAMPED: return kJSTypedArrayTypeUint8ClampedArray;
+                case Object::TypedArrayType::UINT16: return kJSTypedArrayTypeUint16Array;
+                case Object::TypedArrayType::UINT32: return kJSTypedArrayTypeUint32Array;
+                case Object::TypedArrayType::FLOAT32: return kJSTypedArrayTypeFloat32Array;
+                case Object::TypedArrayType::FLOAT64: return kJSTypedArrayTypeFloat64Array;
+                default: return kJSTypedArrayTypeNone;
+            }
+        }
+    }
 #endif
 
     Object* Object::createArrayBufferObject(void* data, size_t byteLength)
@@ -279,6 +311,66 @@ namespace se {
         return obj;
     }
 
+    Object* Object::createExternalArrayBufferObject(void* contents, size_t byteLength, BufferContentsFreeFunc freeFunc, void* freeUserData)
+    {
+#if (__MAC_OS_X_VERSION_MAX_ALLOWED >= 101200 || __IPHONE_OS_VERSION_MAX_ALLOWED >= 100000)
+        if (isSupportTypedArrayAPI())
+        {
+            ExternalBufferContents* buffer = new ExternalBufferContents();
+            buffer->byteLength = byteLength;
+            buffer->freeFunc = freeFunc;
+            buffer->freeUserData = freeUserData;
+
+            JSValueRef exception = nullptr;
+            JSObjectRef jsobj = JSObjectMakeArrayBufferWithBytesNoCopy(__cx, contents, byteLength, externalBufferBytesDeallocator, buffer, &exception);
+            if (exception != nullptr)
+            {
+                ScriptEngine::getInstance()->_clearException(exception);
+                externalBufferBytesDeallocator(contents, buffer);
+                return nullptr;
+            }
+
+            Object* obj = Object::_createJSObject(nullptr, jsobj);
+            if (obj != nullptr)
+                obj->_type = Type::ARRAY_BUFFER;
+            return obj;
+        }
+#endif
+        // Typed array API isn't available, the contents have to be copied.
+        Object* obj = createArrayBufferObject(contents, byteLength);
+        freeFunc(contents, byteLength, freeUserData);
+        return obj;
+    }
+
+    Object* Object::createExternalTypedArray(TypedArrayType type, void* contents, size_t byteLength, BufferContentsFreeFunc freeFunc, void* freeUserData)
+    {
+#if (__MAC_OS_X_VERSION_MAX_ALLOWED >= 101200 || __IPHONE_OS_VERSION_MAX_ALLOWED >= 100000)
+        if (isSupportTypedArrayAPI() && type != TypedArrayType::NONE && type != TypedArrayType::UINT8_CLAMPED)
+        {
+            ExternalBufferContents* buffer = new ExternalBufferContents();
+            buffer->byteLength = byteLength;
+            buffer->freeFunc = freeFunc;
+            buffer->freeUserData = freeUserData;
+
+            JSValueRef exception = nullptr;
+            JSObjectRef jsobj = JSObjectMakeTypedArrayWithBytesNoCopy(__cx, toJSCTypedArrayType(type), contents, byteLength, externalBufferBytesDeallocator, buffer, &exception);
+            if (exception != nullptr)
+            {
+                ScriptEngine::getInstance()->_clearException(exception);
+                externalBufferBytesDeallocator(contents, buffer);
+                return nullptr;
+            }
+
+            // Leave _type unknown, it will be resolved by JSValueGetTypedArrayType on demand.
+            return Object::_createJSObject(nullptr, jsobj);
+        }
+#endif
+        // Typed array API isn't available, the contents have to be copied.
+        Object* obj = createTypedArray(type, contents, byteLength);
+        freeFunc(contents, byteLength, freeUserData);
+        return obj;
+    }
+
     Object* Object::createUint8TypedArray(uint8_t* data, size_t dataCount)
     {
         return createTypedArray(TypedArrayType::UINT8, data, dataCount);
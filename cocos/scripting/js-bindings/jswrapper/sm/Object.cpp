@@ -205,6 +205,21 @@ namespace se {
         return obj;
     }
 
+    Object* Object::createExternalArrayBufferObject(void* contents, size_t byteLength, BufferContentsFreeFunc freeFunc, void* freeUserData)
+    {
+        // SpiderMonkey could only take over buffers allocated by js_malloc, the contents have to be copied.
+        Object* obj = createArrayBufferObject(contents, byteLength);
+        freeFunc(contents, byteLength, freeUserData);
+        return obj;
+    }
+
+    Object* Object::createExternalTypedArray(TypedArrayType type, void* contents, size_t byteLength, BufferContentsFreeFunc freeFunc, void* freeUserData)
+    {
+        Object* obj = createTypedArray(type, contents, byteLength);
+        freeFunc(contents, byteLength, freeUserData);
+        return obj;
+    }
+
     Object* Object::createUint8TypedArray(uint8_t* data, size_t dataCount)
     {
         return createTypedArray(TypedArrayType::UINT8, data, dataCount);
@@ -30,12 +30,112 @@
 #include "ScriptEngine.hpp"
 #include "../MappingUtils.hpp"
 
+#include <unordered_set>
+
 namespace se {
 
     std::unordered_map<Object*, void*> __objectMap; // Currently, the value `void*` is always nullptr
     
     namespace {
         v8::Isolate* __isolate = nullptr;
+
+        struct ExternalBufferContents
+        {
+            v8::Global<v8::ArrayBuffer> handle;
+            void* contents;
+            size_t byteLength;
+            Object::BufferContentsFreeFunc freeFunc;
+            void* freeUserData;
+        };
+
+        // External buffers whose Array Buffer hasn't been collected yet, they're released in Object::cleanup.
+        std::unordered_set<ExternalBufferContents*> __externalBuffers;
+
+        void externalBufferSecondPassCallback(const v8::WeakCallbackInfo<ExternalBufferContents>& data)
+        {
+            ExternalBufferContents* buffer = data.GetParameter();
+            data.GetIsolate()->AdjustAmountOfExternalAllocatedMemory(-(int64_t)buffer->byteLength);
+            buffer->freeFunc(buffer->contents, buffer->byteLength, buffer->freeUserData);
+            delete buffer;
+        }
+
+        void externalBufferWeakCallback(const v8::WeakCallbackInfo<ExternalBufferContents>& data)
+        {
+            // Only resetting handles is allowed in the first pass, the contents are released in the second one.
+            ExternalBufferContents* buffer = data.GetParameter();
+            buffer->handle.Reset();
+            __externalBuffers.erase(buffer);
+            data.SetSecondPassCallback(externalBufferSecondPassCallback);
+        }
+
+        v8::Local<v8::ArrayBuffer> createExternalArrayBuffer(void* contents, size_t byteLength, Object::BufferContentsFreeFunc freeFunc, void* freeUserData)
+        {
+            v8::Local<v8::ArrayBuffer> jsobj = v8::ArrayBuffer::New(__isolate, contents, byteLength, v8::ArrayBufferCreationMode::kExternalized);
+
+            ExternalBufferContents* buffer = new ExternalBufferContents();
+            buffer->handle.Reset(__isolate, jsobj);
+            buffer->handle.SetWeak(buffer, externalBufferWeakCallback, v8::WeakCallbackType::kParameter);
+            buffer->contents = contents;
+            buffer->byteLength = byteLength;
+            buffer->freeFunc = freeFunc;
+            buffer->freeUserData = freeUserData;
+            __externalBuffers.insert(buffer);
+
+            // Let GC know about the memory held by the buffer, or it may never be collected.
+            __isolate->AdjustAmountOfExternalAllocatedMemory((int64_t)byteLength);
+            return jsobj;
+        }
+
+        bool checkTypedArrayType(Object::TypedArrayType type)
+        {
+            if (type == Object::TypedArrayType::NONE)
+            {
+                SE_LOGE("Don't pass se::Object::TypedArrayType::NONE to createTypedArray API!");
+                return false;
+            }
+
+            if (type == Object::TypedArrayType::UINT8_CLAMPED)
+            {
+                SE_LOGE("Doesn't support to create Uint8ClampedArray with Object::createTypedArray API!");
+                return false;
+            }
+            return true;
+        }
+
+        v8::Local<v8::Object> createTypedArrayWithBuffer(Object::TypedArrayType type, v8::Local<v8::ArrayBuffer> jsobj, size_t byteLength)
+        {
+            v8::Local<v8::Object> arr;
+            switch (type) {
+                case Object::TypedArrayType::INT8:
+                    arr = v8::Int8Array::New(jsobj, 0, byteLength);
+                    break;
+                case Object::TypedArrayType::INT16:
+                    arr = v8::Int16Array::New(jsobj, 0, byteLength / 2);
+                    break;
+                case Object::TypedArrayType::INT32:
+                    arr = v8::Int32Array::New(jsobj, 0, byteLength / 4);
+                    break;
+                case Object::TypedArrayType::UINT8:
+                    arr = v8::Uint8Array::New(jsobj, 0, byteLength);
+                    break;
+                case Object::TypedArrayType::UINT16:
+                    arr = v8::Uint16Array::New(jsobj, 0, byteLength / 2);
+                    break;
+                case Object::TypedArrayType::UINT32:
+                    arr = v8::Uint32Array::New(jsobj, 0, byteLength / 4);
+                    break;
+                case Object::TypedArrayType::FLOAT32:
+                    arr = v8::Float32Array::New(jsobj, 0, byteLength / 4);
+                    break;
+                case Object::TypedArrayType::FLOAT64:
+                    arr = v8::Float64Array::New(jsobj, 0, byteLength / 8);
+                    break;
+                default:
+                    assert(false); // Should never go here.
+                    break;
+            }
+            return arr;
+        }
     }
 
     Object::Object()
@@ -155,6 +255,15 @@ namespace se {
         }
 
         __objectMap.clear();
+
+        for (auto buffer : __externalBuffers)
+        {
+            buffer->handle.Reset();
+            buffer->freeFunc(buffer->contents, buffer->byteLength, buffer->freeUserData);
+            delete buffer;
+        }
+        __externalBuffers.clear();
+
         __isolate = nullptr;
     }
 
@@ -212,50 +321,34 @@ namespace se {
     
     Object* Object::createTypedArray(TypedArrayType type, void* data, size_t byteLength)
     {
-        if (type == TypedArrayType::NONE)
-        {
-            SE_LOGE("Don't pass se::Object::TypedArrayType::NONE to createTypedArray API!");
+        if (!checkTypedArrayType(type))
             return nullptr;
-        }
 
-        if (type == TypedArrayType::UINT8_CLAMPED)
+        v8::Local<v8::ArrayBuffer> jsobj = v8::ArrayBuffer::New(__isolate, byteLength);
+        memcpy(jsobj->GetContents().Data(), data, byteLength);
+        v8::Local<v8::Object> arr = createTypedArrayWithBuffer(type, jsobj, byteLength);
+
+        Object* obj = Object::_createJSObject(nullptr, arr);
+        return obj;
+    }
+
+    Object* Object::createExternalArrayBufferObject(void* contents, size_t byteLength, BufferContentsFreeFunc freeFunc, void* freeUserData)
+    {
+        v8::Local<v8::ArrayBuffer> jsobj = createExternalArrayBuffer(contents, byteLength, freeFunc, freeUserData);
+        Object* obj = Object::_createJSObject(nullptr, jsobj);
+        return obj;
+    }
+
+    Object* Object::createExternalTypedArray(TypedArrayType type, void* contents, size_t byteLength, BufferContentsFreeFunc freeFunc, void* freeUserData)
+    {
+        if (!checkTypedArrayType(type))
         {
-            SE_LOGE("Doesn't support to create Uint8ClampedArray with Object::createTypedArray API!");
+            freeFunc(contents, byteLength, freeUserData);
             return nullptr;
         }
 
-        v8::Local<v8::ArrayBuffer> jsobj = v8::ArrayBuffer::New(__isolate, byteLength);
-        memcpy(jsobj->GetContents().Data(), data, byteLength);
-        v8::Local<v8::Object> arr;
-        switch (type) {
-            case TypedArrayType::INT8:
-                arr = v8::Int8Array::New(jsobj, 0, byteLength);
-                break;
-            case TypedArrayType::INT16:
-                arr = v8::Int16Array::New(jsobj, 0, byteLength / 2);
-                break;
-            case TypedArrayType::INT32:
-                arr = v8::Int32Array::New(jsobj, 0, byteLength / 4);
-                break;
-            case TypedArrayType::UINT8:
-                arr = v8::Uint8Array::New(jsobj, 0, byteLength);
-                break;
-            case TypedArrayType::UINT16:
-                arr = v8::Uint16Array::New(jsobj, 0, byteLength / 2);
-                break;
-            case TypedArrayType::UINT32:
-                arr = v8::Uint32Array::New(jsobj, 0, byteLength / 4);
-                break;
-            case TypedArrayType::FLOAT32:
-                arr = v8::Float32Array::New(jsobj, 0, byteLength / 4);
-                break;
-            case TypedArrayType::FLOAT64:
-                arr = v8::Float64Array::New(jsobj, 0, byteLength / 8);
-                break;
-            default:
-                assert(false); // Should never go here.
-                break;
-        }
+        v8::Local<v8::ArrayBuffer> jsobj = createExternalArrayBuffer(contents, byteLength, freeFunc, freeUserData);
+        v8::Local<v8::Object> arr = createTypedArrayWithBuffer(type, jsobj, byteLength);
 
         Object* obj = Object::_createJSObject(nullptr, arr);
         return obj;
@@ -105,6 +105,37 @@ namespace se {
          */
         static Object* createArrayBufferObject(void* bytes, size_t byteLength);
 
+        /**
+         *  @brief The function used to release the backing store of an external Array Buffer.
+         *  @param[in] contents The pointer passed to `createExternalArrayBufferObject` or `createExternalTypedArray`.
+         *  @param[in] byteLength The number of bytes pointed to by contents.
+         *  @param[in] userData The user data passed along with the free function.
+         */
+        typedef void (*BufferContentsFreeFunc)(void* contents, size_t byteLength, void* userData);
+
+        /**
+         *  @brief Creates a JavaScript Array Buffer object which takes over an existing native buffer without copying it.
+         *  @param[in] contents A pointer to the byte buffer to be used as the backing store of the Array Buffer object.
+         *  @param[in] byteLength The number of bytes pointed to by the parameter contents.
+         *  @param[in] freeFunc The function to release contents, it's invoked after the Array Buffer is garbage collected or the script engine is cleaned up.
+         *  @param[in] freeUserData The user data passed to freeFunc.
+         *  @return A Array Buffer Object whose backing store is contents, or nullptr if there is an error.
+         *  @note The return value (non-null) has to be released manually. The ownership of contents is transferred to the script engine, even if nullptr is returned.
+         */
+        static Object* createExternalArrayBufferObject(void* contents, size_t byteLength, BufferContentsFreeFunc freeFunc, void* freeUserData = nullptr);
+
+        /**
+         *  @brief Creates a JavaScript Typed Array Object with specified format which takes over an existing native buffer without copying it.
+         *  @param[in] type The format of typed array.
+         *  @param[in] contents A pointer to the byte buffer to be used as the backing store of the Typed Array object.
+         *  @param[in] byteLength The number of bytes pointed to by the parameter contents.
+         *  @param[in] freeFunc The function to release contents, it's invoked after the Typed Array is garbage collected or the script engine is cleaned up.
+         *  @param[in] freeUserData The user data passed to freeFunc.
+         *  @return A JavaScript Typed Array Object whose backing store is contents, or nullptr if there is an error.
+         *  @note The return value (non-null) has to be released manually. The ownership of contents is transferred to the script engine, even if nullptr is returned.
+         */
+        static Object* createExternalTypedArray(TypedArrayType type, void* contents, size_t byteLength, BufferContentsFreeFunc freeFunc, void* freeUserData = nullptr);
+
         /**
          *  @brief Creates a JavaScript Object from a JSON formatted string.
          *  @param[in] jsonStr The utf-8 string containing the JSON string to be parsed.
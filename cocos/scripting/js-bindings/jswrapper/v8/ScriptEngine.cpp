@@ -38,12 +38,21 @@
 #include "debugger/node.h"
 #endif
 
+#include <stdio.h>
+
 uint32_t __jsbInvocationCount = 0;
 uint32_t __jsbStackFrameLimit = 20;
 
 #define RETRUN_VAL_IF_FAIL(cond, val) \
     if (!(cond)) return val
 
+// ScriptCompiler::CreateCodeCache() can produce a cache after the script ran, older versions only while compiling.
+#if V8_MAJOR_VERSION > 6 || (V8_MAJOR_VERSION == 6 && V8_MINOR_VERSION >= 7)
+#define SE_CREATE_CODE_CACHE_AFTER_RUN 1
+#else
+#define SE_CREATE_CODE_CACHE_AFTER_RUN 0
+#endif
+
 namespace se {
 
     Class* __jsb_CCPrivateData_class = nullptr;
@@ -65,6 +74,77 @@ namespace se {
             ScriptEngine::getInstance()->garbageCollect();
         }
 
+        // Small scripts compile fast enough, reading a cache file would cost more.
+        const ssize_t CODE_CACHE_MIN_SCRIPT_LENGTH = 1024;
+        const uint32_t CODE_CACHE_MAGIC = 0x43433856; // "V8CC"
+
+        // FNV-1a, stable between runs so it can be used for cache file names and keys
+        uint64_t hashBytes(const char* data, size_t length, uint64_t hash = 14695981039346656037ULL)
+        {
+            for (size_t i = 0; i < length; ++i)
+            {
+                hash ^= (uint8_t)data[i];
+                hash *= 1099511628211ULL;
+            }
+            return hash;
+        }
+
+        // A cache file is named after the script's file name, its key covers the V8 version and the script content.
+        // Cache files start with CODE_CACHE_MAGIC and the key, followed by the data of v8::ScriptCompiler::CachedData.
+        v8::ScriptCompiler::CachedData* readCodeCache(const std::string& path, uint64_t key)
+        {
+            FILE* fp = fopen(path.c_str(), "rb");
+            if (fp == nullptr)
+                return nullptr;
+
+            uint32_t magic = 0;
+            uint64_t fileKey = 0;
+            uint8_t* data = nullptr;
+            long length = 0;
+            if (fread(&magic, sizeof(magic), 1, fp) == 1 && magic == CODE_CACHE_MAGIC
+                && fread(&fileKey, sizeof(fileKey), 1, fp) == 1 && fileKey == key
+                && fseek(fp, 0, SEEK_END) == 0)
+            {
+                length = ftell(fp) - (long)(sizeof(magic) + sizeof(fileKey));
+                if (length > 0 && fseek(fp, sizeof(magic) + sizeof(fileKey), SEEK_SET) == 0)
+                {
+                    data = new uint8_t[length];
+                    if (fread(data, 1, length, fp) != (size_t)length)
+                    {
+                        delete[] data;
+                        data = nullptr;
+                    }
+                }
+            }
+            fclose(fp);
+
+            if (data == nullptr)
+                return nullptr;
+            return new v8::ScriptCompiler::CachedData(data, (int)length, v8::ScriptCompiler::CachedData::BufferOwned);
+        }
+
+        void writeCodeCache(const std::string& path, uint64_t key, const v8::ScriptCompiler::CachedData* cachedData)
+        {
+            if (cachedData == nullptr || cachedData->length <= 0)
+                return;
+
+            // Write to a temporary file first, a half written cache must never be loaded.
+            std::string tmpPath = path + ".tmp";
+            FILE* fp = fopen(tmpPath.c_str(), "wb");
+            if (fp == nullptr)
+                return;
+
+            bool ok = fwrite(&CODE_CACHE_MAGIC, sizeof(CODE_CACHE_MAGIC), 1, fp) == 1
+                && fwrite(&key, sizeof(key), 1, fp) == 1
+                && fwrite(cachedData->data, 1, cachedData->length, fp) == (size_t)cachedData->length;
+            ok = (fclose(fp) == 0) && ok;
+
+            if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0)
+            {
+                remove(tmpPath.c_str());
+            }
+        }
+
         std::string stackTraceToString(v8::Local<v8::StackTrace> stack)
         {
             std::string stackStr;
@@ -622,6 +702,19 @@ namespace se {
         if (length < 0)
             length = strlen(script);
 
+        // Only scripts from files are cached, code built at runtime rarely comes back unchanged.
+        std::string cacheFilePath;
+        uint64_t cacheKey = 0;
+        if (!_codeCachePath.empty() && fileName != nullptr && length >= CODE_CACHE_MIN_SCRIPT_LENGTH)
+        {
+            char name[32] = {0};
+            snprintf(name, sizeof(name), "%016llx.v8cache", (unsigned long long)hashBytes(fileName, strlen(fileName)));
+            cacheFilePath = _codeCachePath + name;
+
+            const char* version = v8::V8::GetVersion();
+            cacheKey = hashBytes(script, length, hashBytes(version, strlen(version)));
+        }
+
         if (fileName == nullptr)
             fileName = "(no filename)";
 
@@ -634,9 +727,7 @@ namespace se {
             sourceUrl = sourceUrl.substr(prefixPos + prefixKey.length());
         }
 
-        std::string scriptStr(script, length);
-
-        v8::MaybeLocal<v8::String> source = v8::String::NewFromUtf8(_isolate, scriptStr.c_str(), v8::NewStringType::kNormal);
+        v8::MaybeLocal<v8::String> source = v8::String::NewFromUtf8(_isolate, script, v8::NewStringType::kNormal, (int)length);
         if (source.IsEmpty())
             return false;
 
@@ -645,7 +736,46 @@ namespace se {
             return false;
 
         v8::ScriptOrigin origin(originStr.ToLocalChecked());
-        v8::MaybeLocal<v8::Script> maybeScript = v8::Script::Compile(_context.Get(_isolate), source.ToLocalChecked(), &origin);
+
+        v8::ScriptCompiler::CachedData* cachedData = nullptr;
+        v8::ScriptCompiler::CompileOptions compileOptions = v8::ScriptCompiler::kNoCompileOptions;
+        if (!cacheFilePath.empty())
+        {
+            cachedData = readCodeCache(cacheFilePath, cacheKey);
+            if (cachedData != nullptr)
+                compileOptions = v8::ScriptCompiler::kConsumeCodeCache;
+#if !SE_CREATE_CODE_CACHE_AFTER_RUN
+            else
+                compileOptions = v8::ScriptCompiler::kProduceCodeCache;
+#endif
+        }
+
+        // The source takes the ownership of cachedData.
+        v8::ScriptCompiler::Source compilerSource(source.ToLocalChecked(), origin, cachedData);
+        v8::MaybeLocal<v8::Script> maybeScript = v8::ScriptCompiler::Compile(_context.Get(_isolate), &compilerSource, compileOptions);
+
+#if SE_CREATE_CODE_CACHE_AFTER_RUN
+        bool needsCodeCache = false;
+#endif
+        if (cachedData != nullptr && compilerSource.GetCachedData()->rejected)
+        {
+            // V8 flags changed or the file is corrupted, the script was compiled from source.
+            SE_LOGD("Code cache for %s was rejected\n", sourceUrl.c_str());
+#if SE_CREATE_CODE_CACHE_AFTER_RUN
+            needsCodeCache = true;
+#else
+            remove(cacheFilePath.c_str());
+#endif
+        }
+        else if (!cacheFilePath.empty() && cachedData == nullptr)
+        {
+#if SE_CREATE_CODE_CACHE_AFTER_RUN
+            needsCodeCache = true;
+#else
+            if (!maybeScript.IsEmpty())
+                writeCodeCache(cacheFilePath, cacheKey, compilerSource.GetCachedData());
+#endif
+        }
 
         bool success = false;
 
@@ -665,6 +795,16 @@ namespace se {
 
                 success = true;
             }
+
+#if SE_CREATE_CODE_CACHE_AFTER_RUN
+            // Functions compiled while running the script are part of the cache too.
+            if (success && needsCodeCache)
+            {
+                v8::ScriptCompiler::CachedData* newCachedData = v8::ScriptCompiler::CreateCodeCache(v8Script->GetUnboundScript());
+                writeCodeCache(cacheFilePath, cacheKey, newCachedData);
+                delete newCachedData;
+            }
+#endif
         }
 
 //        assert(success);
@@ -681,6 +821,13 @@ namespace se {
         return stackTraceToString(stack);
     }
 
+    void ScriptEngine::setCodeCachePath(const std::string& path)
+    {
+        _codeCachePath = path;
+        if (!_codeCachePath.empty() && _codeCachePath.back() != '/')
+            _codeCachePath += '/';
+    }
+
     void ScriptEngine::setFileOperationDelegate(const FileOperationDelegate& delegate)
     {
         _fileOperationDelegate = delegate;
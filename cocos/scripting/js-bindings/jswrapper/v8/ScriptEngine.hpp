@@ -218,6 +218,13 @@ namespace se {
          */
         bool runScript(const std::string& path, Value* rval = nullptr);
 
+        /**
+         *  @brief Enables the code cache for scripts evaluated with a file name.
+         *  @param[in] path A writable directory for the cache files, passing an empty string disables the code cache.
+         *  @note Compiled code is saved after the first run and reused on the next launch if the script and the V8 version didn't change.
+         */
+        void setCodeCachePath(const std::string& path);
+
         /**
          *  @brief Tests whether script engine is doing garbage collection.
          *  @return true if it's in garbage collection, otherwise false.
@@ -317,6 +324,7 @@ namespace se {
 
         FileOperationDelegate _fileOperationDelegate;
         ExceptionCallback _exceptionCallback;
+        std::string _codeCachePath;
 
 #if SE_ENABLE_INSPECTOR
         node::Environment* _env;
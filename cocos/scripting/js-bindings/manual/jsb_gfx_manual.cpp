@@ -27,6 +27,7 @@
 #include "cocos/scripting/js-bindings/auto/jsb_gfx_auto.hpp"
 #include "cocos/scripting/js-bindings/manual/jsb_conversions.hpp"
 #include "gfx/GFX.h"
+#include "renderer/InputAssembler.h"
 
 using namespace cocos2d;
 using namespace cocos2d::renderer;
@@ -118,9 +119,20 @@ static bool js_gfx_DeviceGraphics_setUniform(se::State& s)
     size_t argc = args.size();
     CC_UNUSED bool ok = true;
     if (argc == 2) {
-        std::string name;
-        ok = seval_to_std_string(args[0], &name);
-        SE_PRECONDITION2(ok, false, "Convert uniform name failed!");
+        // the uniform can be specified by name or by the handle returned by getUniformHandle()
+        uint32_t handle = 0;
+        if (args[0].isNumber())
+        {
+            handle = args[0].toUint32();
+            SE_PRECONDITION2(DeviceGraphics::isUniformHandleValid(handle), false, "Invalid uniform handle!");
+        }
+        else
+        {
+            std::string name;
+            ok = seval_to_std_string(args[0], &name);
+            SE_PRECONDITION2(ok, false, "Convert uniform name failed!");
+            handle = DeviceGraphics::getUniformHandle(name);
+        }
 
         se::Value arg1 = args[1];
         if (arg1.isObject())
@@ -131,7 +143,7 @@ static bool js_gfx_DeviceGraphics_setUniform(se::State& s)
                 uint8_t* data = nullptr;
                 size_t bytes = 0;
                 if (value->getTypedArrayData(&data, &bytes))
-                    cobj->setUniform(name, data, bytes, UniformElementType::FLOAT);
+                    cobj->setUniform(handle, data, bytes, UniformElementType::FLOAT);
             }
             else
             {
@@ -141,12 +153,12 @@ static bool js_gfx_DeviceGraphics_setUniform(se::State& s)
         else if (arg1.isNumber())
         {
             float number = arg1.toFloat();
-            cobj->setUniformf(name, number);
+            cobj->setUniform(handle, &number, sizeof(float), UniformElementType::FLOAT);
         }
         else if (arg1.isBoolean())
         {
             int v = arg1.toBoolean() ? 1 : 0;
-            cobj->setUniformi(name, v);
+            cobj->setUniform(handle, &v, sizeof(int), UniformElementType::INT);
         }
         else
         {
@@ -160,6 +172,23 @@ static bool js_gfx_DeviceGraphics_setUniform(se::State& s)
 }
 SE_BIND_FUNC(js_gfx_DeviceGraphics_setUniform)
 
+static bool js_gfx_DeviceGraphics_getUniformHandle(se::State& s)
+{
+    const auto& args = s.args();
+    size_t argc = args.size();
+    CC_UNUSED bool ok = true;
+    if (argc == 1) {
+        std::string name;
+        ok = seval_to_std_string(args[0], &name);
+        SE_PRECONDITION2(ok, false, "js_gfx_DeviceGraphics_getUniformHandle : Error processing arguments");
+        s.rval().setUint32(DeviceGraphics::getUniformHandle(name));
+        return true;
+    }
+    SE_REPORT_ERROR("wrong number of arguments: %d, was expecting %d", (int)argc, 1);
+    return false;
+}
+SE_BIND_FUNC(js_gfx_DeviceGraphics_getUniformHandle)
+
 static VertexFormat* getVertexFormatFromValue(const se::Value& elementVal)
 {
     std::vector<VertexFormat::Info> formatInfos;
@@ -837,6 +866,131 @@ static bool js_gfx_FrameBuffer_init(se::State& s)
 }
 SE_BIND_FUNC(js_gfx_FrameBuffer_init)
 
+se::Object* __jsb_cocos2d_renderer_TransientGeometry_proto = nullptr;
+se::Class* __jsb_cocos2d_renderer_TransientGeometry_class = nullptr;
+
+static bool js_cocos2d_renderer_TransientGeometry_finalize(se::State& s)
+{
+    cocos2d::renderer::TransientGeometry* cobj = (cocos2d::renderer::TransientGeometry*)s.nativeThisObject();
+    SE_PRECONDITION2(cobj, false, "js_cocos2d_renderer_TransientGeometry_finalize : Invalid Native Object");
+    cobj->release();
+    return true;
+}
+SE_BIND_FINALIZE_FUNC(js_cocos2d_renderer_TransientGeometry_finalize)
+
+// device, format, maxVertices, maxIndices, numFrames
+static bool js_gfx_TransientGeometry_constructor(se::State& s)
+{
+    CC_UNUSED bool ok = true;
+    const auto& args = s.args();
+    size_t argc = args.size();
+    if (5 == argc)
+    {
+        cocos2d::renderer::DeviceGraphics* device = nullptr;
+        ok &= seval_to_native_ptr(args[0], &device);
+        SE_PRECONDITION2(ok && args[1].isObject(), false, "js_gfx_TransientGeometry_constructor : Error processing arguments");
+        VertexFormat* format = static_cast<cocos2d::renderer::VertexFormat*>(args[1].toObject()->getPrivateData());
+        uint32_t maxVertices = 0;
+        uint32_t maxIndices = 0;
+        uint32_t numFrames = 0;
+        ok &= seval_to_uint32(args[2], &maxVertices);
+        ok &= seval_to_uint32(args[3], &maxIndices);
+        ok &= seval_to_uint32(args[4], &numFrames);
+        SE_PRECONDITION2(ok, false, "js_gfx_TransientGeometry_constructor : Error processing arguments");
+
+        auto geometry = new (std::nothrow) TransientGeometry();
+        if (geometry == nullptr || !geometry->init(device, format, maxVertices, maxIndices, numFrames))
+        {
+            CC_SAFE_DELETE(geometry);
+            SE_REPORT_ERROR("Failed to create the transient geometry!");
+            return false;
+        }
+        s.thisObject()->setPrivateData(geometry);
+        return true;
+    }
+    SE_REPORT_ERROR("wrong number of arguments: %d, was expecting %d", (int)argc, 5);
+    return false;
+}
+SE_BIND_CTOR(js_gfx_TransientGeometry_constructor, __jsb_cocos2d_renderer_TransientGeometry_class, js_cocos2d_renderer_TransientGeometry_finalize)
+
+// Copies the vertices and the Uint16Array indices of one draw into the current frame, returns
+// [vertexBuffer, indexBuffer, start, count] to be used as the draw data of a model, or null if it's full.
+static bool js_gfx_TransientGeometry_allocate(se::State& s)
+{
+    cocos2d::renderer::TransientGeometry* cobj = (cocos2d::renderer::TransientGeometry*)s.nativeThisObject();
+    SE_PRECONDITION2(cobj, false, "js_gfx_TransientGeometry_allocate : Invalid Native Object");
+    const auto& args = s.args();
+    size_t argc = args.size();
+    CC_UNUSED bool ok = true;
+    if (argc == 2) {
+        SE_PRECONDITION2(args[0].isObject() && args[0].toObject()->isTypedArray(), false, "arg0 isn't a typed array!");
+        SE_PRECONDITION2(args[1].isObject() && args[1].toObject()->isTypedArray(), false, "arg1 isn't a typed array!");
+
+        uint8_t* vertices = nullptr;
+        size_t verticesLen = 0;
+        uint8_t* indices = nullptr;
+        size_t indicesLen = 0;
+        ok &= args[0].toObject()->getTypedArrayData(&vertices, &verticesLen);
+        ok &= args[1].toObject()->getTypedArrayData(&indices, &indicesLen);
+        SE_PRECONDITION2(ok, false, "get typed array data failed!");
+
+        InputAssembler ia;
+        if (!ia.initTransient(cobj,
+                              vertices, (uint32_t)(verticesLen / cobj->getVertexBytes()),
+                              (const uint16_t*)indices, (uint32_t)(indicesLen / sizeof(uint16_t))))
+        {
+            s.rval().setNull();
+            return true;
+        }
+
+        se::HandleObject drawData(se::Object::createArrayObject(4));
+        drawData->setArrayElement(0, se::Value((unsigned long)ia.getVertexBuffer()));
+        drawData->setArrayElement(1, se::Value((unsigned long)ia.getIndexBuffer()));
+        drawData->setArrayElement(2, se::Value(ia.getStart()));
+        drawData->setArrayElement(3, se::Value(ia.getCount()));
+        s.rval().setObject(drawData);
+        return true;
+    }
+    SE_REPORT_ERROR("wrong number of arguments: %d, was expecting %d", (int)argc, 2);
+    return false;
+}
+SE_BIND_FUNC(js_gfx_TransientGeometry_allocate)
+
+static bool js_gfx_TransientGeometry_flush(se::State& s)
+{
+    cocos2d::renderer::TransientGeometry* cobj = (cocos2d::renderer::TransientGeometry*)s.nativeThisObject();
+    SE_PRECONDITION2(cobj, false, "js_gfx_TransientGeometry_flush : Invalid Native Object");
+    cobj->flush();
+    return true;
+}
+SE_BIND_FUNC(js_gfx_TransientGeometry_flush)
+
+static bool js_gfx_TransientGeometry_nextFrame(se::State& s)
+{
+    cocos2d::renderer::TransientGeometry* cobj = (cocos2d::renderer::TransientGeometry*)s.nativeThisObject();
+    SE_PRECONDITION2(cobj, false, "js_gfx_TransientGeometry_nextFrame : Invalid Native Object");
+    cobj->nextFrame();
+    return true;
+}
+SE_BIND_FUNC(js_gfx_TransientGeometry_nextFrame)
+
+bool js_register_gfx_TransientGeometry(se::Object* obj)
+{
+    auto cls = se::Class::create("TransientGeometry", obj, nullptr, _SE(js_gfx_TransientGeometry_constructor));
+    cls->defineFunction("allocate", _SE(js_gfx_TransientGeometry_allocate));
+    cls->defineFunction("flush", _SE(js_gfx_TransientGeometry_flush));
+    cls->defineFunction("nextFrame", _SE(js_gfx_TransientGeometry_nextFrame));
+    cls->defineFinalizeFunction(_SE(js_cocos2d_renderer_TransientGeometry_finalize));
+    cls->install();
+    JSBClassType::registerClass<cocos2d::renderer::TransientGeometry>(cls);
+
+    __jsb_cocos2d_renderer_TransientGeometry_proto = cls->getProto();
+    __jsb_cocos2d_renderer_TransientGeometry_class = cls;
+
+    se::ScriptEngine::getInstance()->clearException();
+    return true;
+}
+
 se::Object* __jsb_cocos2d_renderer_VertexFormat_proto = nullptr;
 se::Class* __jsb_cocos2d_renderer_VertexFormat_class = nullptr;
 
@@ -893,9 +1047,11 @@ bool jsb_register_gfx_manual(se::Object* global)
     se::Object* ns = nsVal.toObject();
     
     js_register_gfx_VertexFormat(ns);
+    js_register_gfx_TransientGeometry(ns);
     
     __jsb_cocos2d_renderer_DeviceGraphics_proto->defineFunction("clear", _SE(js_gfx_DeviceGraphics_clear));
     __jsb_cocos2d_renderer_DeviceGraphics_proto->defineFunction("setUniform", _SE(js_gfx_DeviceGraphics_setUniform));
+    __jsb_cocos2d_renderer_DeviceGraphics_proto->defineFunction("getUniformHandle", _SE(js_gfx_DeviceGraphics_getUniformHandle));
 
     __jsb_cocos2d_renderer_VertexBuffer_proto->defineFunction("init", _SE(js_gfx_VertexBuffer_init));
     __jsb_cocos2d_renderer_VertexBuffer_proto->defineFunction("update", _SE(js_gfx_VertexBuffer_update));
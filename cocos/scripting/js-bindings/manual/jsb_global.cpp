@@ -29,6 +29,7 @@
 
 #include "base/CCScheduler.h"
 #include "base/CCThreadPool.h"
+#include "base/CCPixelTransform.h"
 #include "network/HttpClient.h"
 #include "platform/CCApplication.h"
 #include "ui/edit-box/EditBox.h"
@@ -37,8 +38,6 @@
 #include "platform/android/jni/JniImp.h"
 #endif
 
-#include <regex>
-
 using namespace cocos2d;
 using namespace cocos2d::experimental;
 
@@ -168,6 +167,14 @@ void jsb_init_file_operation_delegate()
         assert(delegate.isValid());
 
         se::ScriptEngine::getInstance()->setFileOperationDelegate(delegate);
+
+#if SCRIPT_ENGINE_TYPE == SCRIPT_ENGINE_V8
+        std::string codeCachePath = FileUtils::getInstance()->getWritablePath() + "jsb_code_cache/";
+        if (FileUtils::getInstance()->createDirectory(codeCachePath))
+        {
+            se::ScriptEngine::getInstance()->setCodeCachePath(codeCachePath);
+        }
+#endif
     }
 }
 
@@ -235,6 +242,40 @@ namespace {
     }
     SE_BIND_FUNC(require)
 
+    // Appends the directory of the current script to every `requireModule(...)` call,
+    // a call counts if it isn't preceded by a letter or digit and is closed on the same line.
+    static std::string addScriptDirToModuleRequires(const std::string& source)
+    {
+        static const char KEY[] = "requireModule(";
+        static const size_t KEY_LENGTH = sizeof(KEY) - 1;
+        static const char ARG[] = ", currentScriptDir)";
+
+        std::string result;
+        result.reserve(source.length() + 1024);
+
+        size_t copied = 0;
+        size_t pos = source.find(KEY);
+        while (pos != std::string::npos)
+        {
+            char prev = pos > 0 ? source[pos - 1] : ' ';
+            bool isCall = !((prev >= 'A' && prev <= 'Z') || (prev >= 'a' && prev <= 'z') || (prev >= '0' && prev <= '9'));
+            size_t closePos = source.find_first_of(")\r\n", pos + KEY_LENGTH);
+            if (isCall && closePos != std::string::npos && source[closePos] == ')')
+            {
+                result.append(source, copied, closePos - copied);
+                result.append(ARG);
+                copied = closePos + 1;
+                pos = source.find(KEY, copied);
+            }
+            else
+            {
+                pos = source.find(KEY, pos + 1);
+            }
+        }
+        result.append(source, copied, std::string::npos);
+        return result;
+    }
+
     static bool doModuleRequire(const std::string& path, se::Value* ret, const std::string& prevScriptFileDir)
     {
         se::AutoHandleScope hs;
@@ -296,7 +337,7 @@ namespace {
             snprintf(suffix, sizeof(suffix), "\nwindow.module.exports = window.module.exports || exports;\n})('%s'); ", currentScriptFileDir.c_str());
 
             // Add current script path to require function invocation
-            scriptBuffer = prefix + std::regex_replace(scriptBuffer, std::regex("([^A-Za-z0-9]|^)requireModule\\((.*?)\\)"), "$1requireModule($2, currentScriptDir)") + suffix;
+            scriptBuffer = prefix + addScriptDirToModuleRequires(scriptBuffer) + suffix;
 
 //            FILE* fp = fopen("/Users/james/Downloads/test.txt", "wb");
 //            fwrite(scriptBuffer.c_str(), scriptBuffer.length(), 1, fp);
@@ -654,12 +695,22 @@ namespace
         uint8_t numberOfMipmaps = 0;
         bool hasAlpha = false;
         bool hasPremultipliedAlpha = false;
+        bool flipY = false;
         bool compressed = false;
         
         bool freeData = false;
     };
+
+    // Conversions requested by loadImage, they're applied while the image is still on the loading thread.
+    struct ImageOptions
+    {
+        bool flipY = false;
+        bool premultiplyAlpha = false;
+        // GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT_5_6_5 or GL_UNSIGNED_SHORT_4_4_4_4
+        uint32_t type = GL_UNSIGNED_BYTE;
+    };
     
-    struct ImageInfo* createImageInfo(const Image* img)
+    struct ImageInfo* createImageInfo(const Image* img, const ImageOptions& options)
     {
         struct ImageInfo* imgInfo = new struct ImageInfo();
         imgInfo->length = (uint32_t)img->getDataLen();
@@ -683,30 +734,91 @@ namespace
         // will create a big texture, and update its content with small pictures.
         // The big texture is RGBA888, then the small picture should be the same
         // format, or it will cause 0x502 error on OpenGL ES 2.
-        if (GL_RGB == imgInfo->glFormat)
+        // The requested flipY, premultiplied alpha and 16 bits format are applied in the same pass,
+        // so the pixels aren't touched again when they're uploaded on the GL thread.
+        bool isBGRA = img->getRenderFormat() == Image::PixelFormat::BGRA8888;
+        bool isRGB = GL_RGB == imgInfo->glFormat;
+        uint32_t srcBytesPerPixel = isRGB ? 3 : 4;
+        if (!imgInfo->compressed && imgInfo->numberOfMipmaps <= 1 && GL_UNSIGNED_BYTE == imgInfo->type &&
+            (isRGB || isBGRA || GL_RGBA == imgInfo->glFormat) &&
+            imgInfo->length == imgInfo->width * imgInfo->height * srcBytesPerPixel)
         {
-            imgInfo->length = img->getWidth() * img->getHeight() * 4;
-            uint8_t* dst = new uint8_t[imgInfo->length];
-            uint8_t* src = imgInfo->data;
-            for (uint32_t i = 0, length = imgInfo->length; i < length; i += 4)
+            PixelTransform transform;
+            transform.srcFormat = isRGB ? PixelTransform::Format::RGB888 : PixelTransform::Format::RGBA8888;
+            transform.swapRB = isBGRA;
+            transform.flipY = options.flipY;
+            transform.premultiplyAlpha = options.premultiplyAlpha && !isRGB && !imgInfo->hasPremultipliedAlpha;
+
+            if (GL_UNSIGNED_SHORT_5_6_5 == options.type)
             {
-                dst[i] = *src++;
-                dst[i + 1] = *src++;
-                dst[i + 2] = *src++;
-                dst[i + 3] = 255;
+                transform.dstFormat = PixelTransform::Format::RGB565;
+                imgInfo->glFormat = GL_RGB;
+                imgInfo->type = GL_UNSIGNED_SHORT_5_6_5;
+                imgInfo->hasAlpha = false;
+            }
+            else if (GL_UNSIGNED_SHORT_4_4_4_4 == options.type)
+            {
+                transform.dstFormat = PixelTransform::Format::RGBA4444;
+                imgInfo->glFormat = GL_RGBA;
+                imgInfo->type = GL_UNSIGNED_SHORT_4_4_4_4;
+                imgInfo->hasAlpha = true;
+            }
+            else
+            {
+                transform.dstFormat = PixelTransform::Format::RGBA8888;
+                imgInfo->glFormat = GL_RGBA;
+                imgInfo->hasAlpha = true;
+            }
+            imgInfo->glInternalFormat = imgInfo->glFormat;
+
+            if (isRGB || transform.dstFormat != PixelTransform::Format::RGBA8888 ||
+                transform.swapRB || transform.flipY || transform.premultiplyAlpha)
+            {
+                uint32_t dstBytesPerPixel = ccGetPixelTransformBytesPerPixel(transform.dstFormat);
+                uint8_t* src = imgInfo->data;
+                uint8_t* dst = src;
+                // The image isn't shared yet, so pixels of the same size are converted in place.
+                if (dstBytesPerPixel != srcBytesPerPixel)
+                {
+                    imgInfo->length = imgInfo->width * imgInfo->height * dstBytesPerPixel;
+                    dst = new uint8_t[imgInfo->length];
+                    imgInfo->data = dst;
+                    imgInfo->freeData = true;
+                }
+                ccTransformPixels(transform, src, dst, imgInfo->width, imgInfo->height);
+
+                imgInfo->bpp = dstBytesPerPixel * 8;
+                imgInfo->flipY = transform.flipY;
+                imgInfo->hasPremultipliedAlpha |= transform.premultiplyAlpha;
             }
-            imgInfo->data = dst;
-            imgInfo->hasAlpha = true;
-            imgInfo->bpp = 32;
-            imgInfo->glFormat = GL_RGBA;
-            imgInfo->glInternalFormat = GL_RGBA;
-            imgInfo->freeData = true;
         }
         
         return imgInfo;
     }
+
+    // Hands the pixels over to JS without copying them. A converted buffer is owned by the typed array,
+    // otherwise the image is retained until the typed array is garbage collected.
+    se::Object* createImageDataTypedArray(Image* img, struct ImageInfo* imgInfo)
+    {
+        if (imgInfo->freeData)
+        {
+            imgInfo->freeData = false;
+            return se::Object::createExternalTypedArray(se::Object::TypedArrayType::UINT8, imgInfo->data, imgInfo->length, [](void* contents, size_t byteLength, void* userData){
+                delete [] static_cast<uint8_t*>(contents);
+            });
+        }
+
+        img->retain();
+        return se::Object::createExternalTypedArray(se::Object::TypedArrayType::UINT8, imgInfo->data, imgInfo->length, [](void* contents, size_t byteLength, void* userData){
+            static_cast<Image*>(userData)->release();
+        }, img);
+    }
 }
 bool jsb_global_load_image(const std::string& path, const se::Value& callbackVal) {
+    return jsb_global_load_image(path, callbackVal, se::Value::Undefined);
+}
+
+bool jsb_global_load_image(const std::string& path, const se::Value& callbackVal, const se::Value& optionsVal) {
     if (path.empty())
     {
         se::ValueArray seArgs;
@@ -714,7 +826,19 @@ bool jsb_global_load_image(const std::string& path, const se::Value& callbackVal
         return true;
     }
 
-    auto initImageFunc = [path, callbackVal](const std::string& fullPath, unsigned char* imageData, int imageBytes){
+    ImageOptions options;
+    if (optionsVal.isObject())
+    {
+        se::Value tmp;
+        if (optionsVal.toObject()->getProperty("flipY", &tmp))
+            seval_to_boolean(tmp, &options.flipY);
+        if (optionsVal.toObject()->getProperty("premultiplyAlpha", &tmp))
+            seval_to_boolean(tmp, &options.premultiplyAlpha);
+        if (optionsVal.toObject()->getProperty("glType", &tmp) && tmp.isNumber())
+            seval_to_uint32(tmp, &options.type);
+    }
+
+    auto initImageFunc = [path, callbackVal, options](const std::string& fullPath, unsigned char* imageData, int imageBytes){
         Image* img = new (std::nothrow) Image();
 
         __threadPool->pushTask([=](int tid){
@@ -737,7 +861,7 @@ bool jsb_global_load_image(const std::string& path, const se::Value& callbackVal
             struct ImageInfo* imgInfo = nullptr;
             if(loadSucceed)
             {
-                imgInfo = createImageInfo(img);
+                imgInfo = createImageInfo(img, options);
             }
 
             Application::getInstance()->getScheduler()->performFunctionInCocosThread([=](){
@@ -747,14 +871,12 @@ bool jsb_global_load_image(const std::string& path, const se::Value& callbackVal
                 if (loadSucceed)
                 {
                     se::HandleObject retObj(se::Object::createPlainObject());
-                    Data data;
-                    data.copy(imgInfo->data, imgInfo->length);
-                    se::Value dataVal;
-                    Data_to_seval(data, &dataVal);
-                    retObj->setProperty("data", dataVal);
+                    se::HandleObject dataObj(createImageDataTypedArray(img, imgInfo));
+                    retObj->setProperty("data", se::Value(dataObj));
                     retObj->setProperty("width", se::Value(imgInfo->width));
                     retObj->setProperty("height", se::Value(imgInfo->height));
                     retObj->setProperty("premultiplyAlpha", se::Value(imgInfo->hasPremultipliedAlpha));
+                    retObj->setProperty("flipY", se::Value(imgInfo->flipY));
                     retObj->setProperty("bpp", se::Value(imgInfo->bpp));
                     retObj->setProperty("hasAlpha", se::Value(imgInfo->hasAlpha));
                     retObj->setProperty("compressed", se::Value(imgInfo->compressed));
@@ -852,7 +974,7 @@ static bool js_loadImage(se::State& s)
     const auto& args = s.args();
     size_t argc = args.size();
     CC_UNUSED bool ok = true;
-    if (argc == 2) {
+    if (argc == 2 || argc == 3) {
         std::string path;
         ok &= seval_to_std_string(args[0], &path);
         SE_PRECONDITION2(ok, false, "js_loadImage : Error processing arguments");
@@ -861,9 +983,13 @@ static bool js_loadImage(se::State& s)
         assert(callbackVal.isObject());
         assert(callbackVal.toObject()->isFunction());
 
+        // The optional options ask for pixels which are uploaded with UNPACK_FLIP_Y_WEBGL and
+        // UNPACK_PREMULTIPLY_ALPHA_WEBGL disabled, the flipY and premultiplyAlpha of the result tell what was done.
+        if (argc == 3)
+            return jsb_global_load_image(path, callbackVal, args[2]);
         return jsb_global_load_image(path, callbackVal);
     }
-    SE_REPORT_ERROR("wrong number of arguments: %d, was expecting %d", (int)argc, 2);
+    SE_REPORT_ERROR("wrong number of arguments: %d, was expecting %d or %d", (int)argc, 2, 3);
     return false;
 }
 SE_BIND_FUNC(js_loadImage)
@@ -1074,7 +1200,7 @@ SE_BIND_FUNC(JSB_hideInputBox)
 
 bool jsb_register_global_variables(se::Object* global)
 {
-    __threadPool = ThreadPool::newFixedThreadPool(3);
+    __threadPool = ThreadPool::newFixedThreadPool(ThreadPool::getDefaultThreadNum());
 
     global->defineFunction("require", _SE(require));
     global->defineFunction("requireModule", _SE(moduleRequire));
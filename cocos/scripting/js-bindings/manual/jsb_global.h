@@ -47,3 +47,5 @@ bool jsb_run_script_module(const std::string& filePath, se::Value* rval = nullpt
 void jsb_set_xxtea_key(const std::string& key);
 
 bool jsb_global_load_image(const std::string& path, const se::Value& callbackVal);
+// optionsVal may request flipY, premultiplyAlpha and a 16 bits glType, they're applied on the loading thread.
+bool jsb_global_load_image(const std::string& path, const se::Value& callbackVal, const se::Value& optionsVal);
@@ -149,7 +149,7 @@ SE_BIND_FUNC(Node_addChild)
 class ScheduleElement
 {
 public:
-    ScheduleElement(se::Object* target, se::Object* func, const std::string& key, uint32_t targetId, uint32_t funcId)
+    ScheduleElement(se::Object* target, se::Object* func, uint32_t key, uint32_t targetId, uint32_t funcId)
     : _target(target)
     , _func(func)
     , _key(key)
@@ -168,7 +168,7 @@ public:
         {
             _target = o._target;
             _func = o._func;
-            _key = std::move(o._key);
+            _key = o._key;
             _targetId = o._targetId;
             _funcId = o._funcId;
         }
@@ -177,7 +177,7 @@ public:
 
     inline se::Object* getTarget() const { return _target; }
     inline se::Object* getFunc() const { return _func; }
-    inline const std::string& getKey() const { return _key; }
+    inline uint32_t getKey() const { return _key; }
     inline uint32_t getTargetId() const { return _targetId; }
     inline uint32_t getFuncId() const { return _funcId; }
 
@@ -187,77 +187,69 @@ private:
 
     se::Object* _target;
     se::Object* _func;
-    std::string _key;
+    uint32_t _key;
     uint32_t _targetId;
     uint32_t _funcId;
 };
 
 static uint32_t __scheduleTargetIdCounter = 0;
 static uint32_t __scheduleFuncIdCounter = 0;
+static uint32_t __scheduleKeyCounter = 0;
 
 static const char* SCHEDULE_TARGET_ID_KEY = "__seScheTargetId";
 static const char* SCHEDULE_FUNC_ID_KEY = "__seScheFuncId";
+// Keys are integers natively, string keys from scripts are accepted in this form for compatibility.
+static const char SCHEDULE_KEY_PREFIX[] = "__node_schedule_key:";
 
 static std::unordered_map<uint32_t/*targetId*/, std::unordered_map<uint32_t/*funcId*/, ScheduleElement>> __js_target_schedulekey_map;
 static std::unordered_map<uint32_t/*targetId*/, std::pair<int/*priority*/, se::Object*>> __js_target_schedule_update_map;
 
+// Reverse index of __js_target_schedulekey_map, keys are unique across all targets.
+static std::unordered_map<uint32_t/*key*/, std::pair<uint32_t/*targetId*/, uint32_t/*funcId*/>> __js_schedule_key_map;
+
 static bool isScheduleExist(uint32_t jsFuncId, uint32_t jsTargetId, const ScheduleElement** outElement)
 {
-    bool found = false;
-    for (const auto& e : __js_target_schedulekey_map)
-    {
-        if (e.first == jsTargetId)
-        {
-            for (const auto& e2 : e.second)
-            {
-                if (e2.first == jsFuncId)
-                {
-                    *outElement = &e2.second;
-                    found = true;
-                    break;
-                }
-            }
-        }
-        if (found)
-        {
-            break;
-        }
-    }
+    *outElement = nullptr;
 
-    if (!found)
-    {
-        *outElement = nullptr;
-    }
+    auto funcObjKeyMapIter = __js_target_schedulekey_map.find(jsTargetId);
+    if (funcObjKeyMapIter == __js_target_schedulekey_map.end())
+        return false;
 
-    return found;
+    auto iter = funcObjKeyMapIter->second.find(jsFuncId);
+    if (iter == funcObjKeyMapIter->second.end())
+        return false;
+
+    *outElement = &iter->second;
+    return true;
 }
 
-static bool isScheduleExist(const std::string& key, uint32_t jsTargetId, const ScheduleElement** outElement)
+static bool isScheduleExist(uint32_t key, uint32_t jsTargetId, const ScheduleElement** outElement)
 {
-    bool found = false;
-    for (const auto& e : __js_target_schedulekey_map)
-    {
-        if (e.first == jsTargetId)
-        {
-            for (const auto& e2 : e.second)
-            {
-                if (e2.second.getKey() == key)
-                {
-                    *outElement = &e2.second;
-                    found = true;
-                    break;
-                }
-            }
-        }
-        if (found)
-            break;
-    }
+    *outElement = nullptr;
 
-    if (!found)
-    {
-        *outElement = nullptr;
-    }
-    return found;
+    auto iter = __js_schedule_key_map.find(key);
+    if (iter == __js_schedule_key_map.end() || iter->second.first != jsTargetId)
+        return false;
+
+    return isScheduleExist(iter->second.second, jsTargetId, outElement);
+}
+
+// Returns 0 if the value isn't a key generated by Scheduler_scheduleCommon.
+static uint32_t scheduleKeyFromValue(const se::Value& jsKey)
+{
+    if (!jsKey.isString())
+        return 0;
+
+    const std::string& str = jsKey.toString();
+    const size_t prefixLen = sizeof(SCHEDULE_KEY_PREFIX) - 1;
+    if (str.size() <= prefixLen || str.compare(0, prefixLen, SCHEDULE_KEY_PREFIX) != 0)
+        return 0;
+
+    char* end = nullptr;
+    unsigned long key = strtoul(str.c_str() + prefixLen, &end, 10);
+    if (*end != '\0' || key > UINT32_MAX)
+        return 0;
+    return (uint32_t)key;
 }
 
 static void removeSchedule(uint32_t jsFuncId, uint32_t jsTargetId, bool needDetachChild)
@@ -280,6 +272,7 @@ static void removeSchedule(uint32_t jsFuncId, uint32_t jsTargetId, bool needDeta
             func->decRef();
             target->decRef();
 
+            __js_schedule_key_map.erase(iter->second.getKey());
             funcMap.erase(iter);
         }
 
@@ -310,6 +303,8 @@ static void removeScheduleForThis(uint32_t jsTargetId, bool needDetachChild)
 
             func->decRef(); // Release jsFunc
             target->decRef(); // Release jsThis
+
+            __js_schedule_key_map.erase(e.second.getKey());
         }
 
         funcMap.clear();
@@ -343,6 +338,7 @@ static void removeAllSchedules(bool needDetachChild)
         funcMap.clear();
     }
     __js_target_schedulekey_map.clear();
+    __js_schedule_key_map.clear();
 }
 
 static void removeAllScheduleUpdates()
@@ -362,14 +358,7 @@ static void removeAllScheduleAndUpdate(bool needDetachChild)
 
 static bool isScheduleUpdateExist(uint32_t targetId)
 {
-    for (const auto& e : __js_target_schedule_update_map)
-    {
-        if (e.first == targetId)
-        {
-            return true;
-        }
-    }
-    return false;
+    return __js_target_schedule_update_map.find(targetId) != __js_target_schedule_update_map.end();
 }
 
 static void removeScheduleUpdate(uint32_t targetId)
@@ -415,6 +404,8 @@ static void insertSchedule(uint32_t funcId, uint32_t targetId, ScheduleElement&&
     element.getTarget()->incRef();
     element.getFunc()->incRef();
 
+    assert(__js_schedule_key_map.find(element.getKey()) == __js_schedule_key_map.end());
+    __js_schedule_key_map.emplace(element.getKey(), std::make_pair(targetId, funcId));
     funcKeyMap.emplace(funcId, std::move(element));
 }
 
@@ -422,24 +413,8 @@ static bool isTargetExistInScheduler(uint32_t targetId)
 {
     assert(targetId != 0);
 
-    // Iterating the schedule func map
-    for (const auto& e : __js_target_schedulekey_map)
-    {
-        if (e.first == targetId)
-        {
-            return true;
-        }
-    }
-
-    // Iterating the schedule update map
-    for (const auto& e : __js_target_schedule_update_map)
-    {
-        if (e.first == targetId)
-        {
-            return true;
-        }
-    }
-    return false;
+    return __js_target_schedulekey_map.find(targetId) != __js_target_schedulekey_map.end()
+        || __js_target_schedule_update_map.find(targetId) != __js_target_schedule_update_map.end();
 }
 
 class UnscheduleNotifier
@@ -465,8 +440,6 @@ private:
     uint32_t _targetId;
 };
 
-static uint32_t __idx = 0;
-
 static bool Scheduler_scheduleCommon(Scheduler* scheduler, const se::Value& jsThis, const se::Value& jsFunc, float interval, unsigned int repeat, float delay, bool isPaused, bool toRootTarget, const std::string& callFromDebug)
 {
     assert(jsThis.isObject());
@@ -474,7 +447,7 @@ static bool Scheduler_scheduleCommon(Scheduler* scheduler, const se::Value& jsTh
     assert(jsFunc.toObject()->isFunction());
     jsThis.toObject()->attachObject(jsFunc.toObject());
 
-    std::string key;
+    uint32_t key = 0;
 
     se::Value targetIdVal;
     se::Value funcIdVal;
@@ -499,7 +472,7 @@ static bool Scheduler_scheduleCommon(Scheduler* scheduler, const se::Value& jsTh
         if (found)
             key = scheduleElem->getKey();
 
-        if (found && !key.empty())
+        if (found && key != 0)
         {
             removeSchedule(funcId, targetId, true);
             scheduler->unschedule(key, reinterpret_cast<void*>(targetId));
@@ -530,7 +503,12 @@ static bool Scheduler_scheduleCommon(Scheduler* scheduler, const se::Value& jsTh
         }
     }
 
-    key = StringUtils::format("__node_schedule_key:%u", __idx++);
+    key = ++__scheduleKeyCounter;
+    // counter is probably overfollow, it maybe 0 which is invalid key. Increase 1.
+    if (key == 0)
+    {
+        key = ++__scheduleKeyCounter;
+    }
 
     se::Object* target = jsThis.toObject();
     insertSchedule(funcId, targetId, ScheduleElement(target, jsFunc.toObject(), key, targetId, funcId));
@@ -795,7 +773,7 @@ SE_BIND_FUNC(Node_unscheduleUpdate)
 
 static bool Scheduler_unscheduleCommon(Scheduler* scheduler, const se::Value& jsThis, const se::Value& jsFuncOrKey)
 {
-    std::string key;
+    uint32_t key = 0;
 
     bool found = false;
 
@@ -811,9 +789,9 @@ static bool Scheduler_unscheduleCommon(Scheduler* scheduler, const se::Value& js
 
     if (jsFuncOrKey.isString() || jsFuncOrKey.isNumber())
     {
-        key = jsFuncOrKey.toStringForce();
+        key = scheduleKeyFromValue(jsFuncOrKey);
         const ScheduleElement* scheduleElem = nullptr;
-        found = isScheduleExist(key, targetId, &scheduleElem);
+        found = key != 0 && isScheduleExist(key, targetId, &scheduleElem);
         if (found)
             funcId = scheduleElem->getFuncId();
     }
@@ -838,7 +816,7 @@ static bool Scheduler_unscheduleCommon(Scheduler* scheduler, const se::Value& js
         return true;
     }
 
-    if (found && !key.empty())
+    if (found && key != 0)
     {
         removeSchedule(funcId, targetId, true);
         scheduler->unschedule(key, reinterpret_cast<void*>(targetId));
@@ -879,11 +857,12 @@ static bool Scheduler_isScheduled(Scheduler* scheduler, const se::Value& jsThis,
     {
         if (jsFuncOrKey.isString() || jsFuncOrKey.isNumber())
         {
-            return scheduler->isScheduled(jsFuncOrKey.toStringForce(), reinterpret_cast<void*>(targetId));
+            uint32_t key = scheduleKeyFromValue(jsFuncOrKey);
+            return key != 0 && scheduler->isScheduled(key, reinterpret_cast<void*>(targetId));
         }
         else if (jsFuncOrKey.isObject())
         {
-            std::string key;
+            uint32_t key = 0;
             se::Value funcIdVal;
             if (jsFuncOrKey.toObject()->getProperty(SCHEDULE_FUNC_ID_KEY, &funcIdVal) && funcIdVal.isNumber())
             {
@@ -892,7 +871,7 @@ static bool Scheduler_isScheduled(Scheduler* scheduler, const se::Value& jsThis,
                 if (isScheduleExist(funcId, targetId, &scheduleElem))
                 {
                     key = scheduleElem->getKey();
-                    if (!key.empty())
+                    if (key != 0)
                     {
                         return scheduler->isScheduled(key, reinterpret_cast<void*>(targetId));
                     }
@@ -31,7 +31,10 @@
 #include "platform/CCGL.h"
 #include "cocos/base/CCGLUtils.h"
 
+#include <algorithm>
+#include <iterator>
 #include <regex>
+#include <vector>
 
 using namespace cocos2d;
 
@@ -141,6 +144,7 @@ namespace {
     const uint32_t GL_COMMAND_VERTEX_ATTRIB_4FV = 95;
     const uint32_t GL_COMMAND_VERTEX_ATTRIB_POINTER = 96;
     const uint32_t GL_COMMAND_VIEW_PORT = 97;
+    const uint32_t GL_COMMAND_COUNT = 98;
 
     const uint32_t GL_FLOAT_ARRAY = 1;
     const uint32_t GL_INT_ARRAY = 2;
@@ -3862,534 +3866,756 @@ static bool JSB_glGetShaderPrecisionFormat(se::State& s)
 }
 SE_BIND_FUNC(JSB_glGetShaderPrecisionFormat)
 
-static bool JSB_glFlushCommand(se::State& s) {
-    const auto& args = s.args();
-    int argc = (int)args.size();
-    SE_PRECONDITION2(argc == 3, false, "Invalid number of arguments" );
+// GL command stream
+//
+// The JS batching path records GL commands and flushes them to native in one call. Two formats are decoded:
+//
+// - Legacy, `_flushCommands(floatCount, Float32Array, commandCount)`: every lane is a float, including
+//   object handles and enums, so values above 2^24 lose precision.
+// - Version 2, `_flushCommandStream(typedArray, laneCount)`: 32-bit lanes holding an unsigned integer, a signed
+//   integer or a float as the command signature says. The first lane is the header
+//   `(GL_COMMAND_STREAM_MAGIC << 16) | GL_COMMAND_STREAM_VERSION`, every command starts with
+//   `(argumentLaneCount << 8) | commandID`, and array arguments are prefixed with their element count.
+//
+// Both formats are dispatched through the same jump table. Redundant binds, blend states and enable/disable
+// commands are skipped within a flush, the tracked state is reset at the beginning of every flush since
+// the native renderer modifies GL state directly.
 
-    bool ok = false;
-    uint32_t floatValueCount = 0;
-    ok = seval_to_uint32(args[0], &floatValueCount);
-    SE_PRECONDITION2(ok, false, "arg0 isn't a number!");
-    GLsizei count = 0;
-    GLvoid* data = nullptr;
-    ok = JSB_get_arraybufferview_dataptr(args[1], &count, &data);
-    SE_PRECONDITION2(ok, false, "Convert arg1 as typed array failed!");
+namespace {
 
-    uint32_t commandCount = 0;
-    ok = seval_to_uint32(args[2], &commandCount);
-    SE_PRECONDITION2(ok, false, "arg2 isn't a number!");
+    const uint32_t GL_COMMAND_STREAM_MAGIC = 0x474C; // 'GL'
+    const uint32_t GL_COMMAND_STREAM_VERSION = 2;
 
-    float* p = (float*)data;
-    float* end = p + floatValueCount;
-    uint32_t handledCommandCount = 0;
+    union GLCommandLane
+    {
+        GLuint u;
+        GLint i;
+        GLfloat f;
+    };
+    static_assert(sizeof(GLCommandLane) == 4, "Lanes of GL command stream should be 32 bits");
+
+    // Returns false if the command is skipped since it doesn't change any state.
+    typedef bool (*GLCommandHandler)(const GLCommandLane* args);
+
+    struct GLCommandInfo
+    {
+        const char* name = nullptr;
+        // One character per argument: 'u' GLuint/GLenum, 'i' GLint/GLsizei, 'f' GLfloat,
+        // 'F'/'I' an element count lane followed by that many float/int lanes (only as the last argument).
+        const char* signature = nullptr;
+        GLCommandHandler handler = nullptr;
+        uint32_t fixedLaneCount = 0;
+        bool hasArray = false;
+    };
+
+    GLCommandInfo __glCommands[GL_COMMAND_COUNT];
 
-    while (p < end) {
-        uint32_t commandID = (uint32_t)p[0];
-        ++handledCommandCount;
-        if (commandID == GL_COMMAND_ACTIVE_TEXTURE) {
-            LOG_GL_COMMAND("Flush: ACTIVE_TEXTURE\n");
-            JSB_GL_CHECK_VOID(glActiveTexture((GLenum)p[1]));
-            p += 2;
+    struct GLCommandCounters
+    {
+        uint32_t issued[GL_COMMAND_COUNT];
+        uint32_t skipped[GL_COMMAND_COUNT];
+    };
+
+    GLCommandCounters __glCommandCounters;
+
+    // Scratch lanes used to convert the legacy float format.
+    std::vector<GLCommandLane> __legacyCommandLanes;
+
+    const GLuint GL_STREAM_STATE_UNKNOWN = 0xFFFFFFFF;
+    const uint32_t GL_STREAM_MAX_TEXTURE_UNITS = 32;
+    const GLenum GL_STREAM_CAPS[] = {
+        GL_BLEND,
+        GL_CULL_FACE,
+        GL_DEPTH_TEST,
+        GL_DITHER,
+        GL_POLYGON_OFFSET_FILL,
+        GL_SAMPLE_ALPHA_TO_COVERAGE,
+        GL_SAMPLE_COVERAGE,
+        GL_SCISSOR_TEST,
+        GL_STENCIL_TEST
+    };
+    const uint32_t GL_STREAM_CAP_COUNT = sizeof(GL_STREAM_CAPS) / sizeof(GL_STREAM_CAPS[0]);
+
+    struct GLStreamState
+    {
+        GLuint activeTexture;
+        GLuint textures2D[GL_STREAM_MAX_TEXTURE_UNITS];
+        GLuint texturesCube[GL_STREAM_MAX_TEXTURE_UNITS];
+        GLuint framebuffer;
+        GLuint renderbuffer;
+        GLuint program;
+        GLuint blendEquationRGB;
+        GLuint blendEquationAlpha;
+        GLuint blendSrcRGB;
+        GLuint blendDstRGB;
+        GLuint blendSrcAlpha;
+        GLuint blendDstAlpha;
+        GLfloat blendColor[4];
+        bool blendColorValid;
+        // -1: unknown, 0: disabled, 1: enabled
+        int8_t caps[GL_STREAM_CAP_COUNT];
+
+        void reset()
+        {
+            activeTexture = GL_STREAM_STATE_UNKNOWN;
+            std::fill(std::begin(textures2D), std::end(textures2D), GL_STREAM_STATE_UNKNOWN);
+            std::fill(std::begin(texturesCube), std::end(texturesCube), GL_STREAM_STATE_UNKNOWN);
+            framebuffer = GL_STREAM_STATE_UNKNOWN;
+            renderbuffer = GL_STREAM_STATE_UNKNOWN;
+            program = GL_STREAM_STATE_UNKNOWN;
+            blendEquationRGB = blendEquationAlpha = GL_STREAM_STATE_UNKNOWN;
+            blendSrcRGB = blendDstRGB = blendSrcAlpha = blendDstAlpha = GL_STREAM_STATE_UNKNOWN;
+            blendColorValid = false;
+            std::fill(std::begin(caps), std::end(caps), -1);
         }
-        else if (commandID == GL_COMMAND_ATTACH_SHADER) {
-            LOG_GL_COMMAND("Flush: ATTACH_SHADER\n");
-            JSB_GL_CHECK_VOID(glAttachShader((GLuint)p[1], (GLuint)p[2]));
-            p += 3;
+    };
+
+    GLStreamState __streamState;
+
+    // Returns true if the value differs from the cached one, and updates the cache.
+    inline bool updateStreamState(GLuint& cached, GLuint value)
+    {
+        if (cached == value)
+            return false;
+        cached = value;
+        return true;
+    }
+
+    GLuint* getStreamTextureBinding(GLenum target)
+    {
+        GLuint unit = __streamState.activeTexture - GL_TEXTURE0;
+        if (__streamState.activeTexture == GL_STREAM_STATE_UNKNOWN || unit >= GL_STREAM_MAX_TEXTURE_UNITS)
+            return nullptr;
+
+        if (target == GL_TEXTURE_2D)
+            return &__streamState.textures2D[unit];
+        if (target == GL_TEXTURE_CUBE_MAP)
+            return &__streamState.texturesCube[unit];
+        return nullptr;
+    }
+
+    int8_t* getStreamCap(GLenum cap)
+    {
+        for (uint32_t i = 0; i < GL_STREAM_CAP_COUNT; ++i)
+        {
+            if (GL_STREAM_CAPS[i] == cap)
+                return &__streamState.caps[i];
+        }
+        return nullptr;
+    }
+
+    bool setStreamCap(GLenum cap, bool enabled)
+    {
+        int8_t* cached = getStreamCap(cap);
+        if (cached != nullptr)
+        {
+            if (*cached == (int8_t)enabled)
+                return false;
+            *cached = (int8_t)enabled;
         }
-        else if (commandID == GL_COMMAND_BIND_BUFFER) {
-            LOG_GL_COMMAND("Flush: BIND_BUFFER, %u\n", (GLuint)p[2]);
-            JSB_GL_CHECK_VOID(ccBindBuffer((GLenum)p[1], (GLuint)p[2]));
-            p += 3;
+
+        if (enabled)
+            JSB_GL_CHECK_VOID(glEnable(cap));
+        else
+            JSB_GL_CHECK_VOID(glDisable(cap));
+        return true;
+    }
+
+    bool setStreamBlendEquation(GLuint modeRGB, GLuint modeAlpha, bool separate)
+    {
+        if (__streamState.blendEquationRGB == modeRGB && __streamState.blendEquationAlpha == modeAlpha)
+            return false;
+        __streamState.blendEquationRGB = modeRGB;
+        __streamState.blendEquationAlpha = modeAlpha;
+
+        if (separate)
+            JSB_GL_CHECK_VOID(glBlendEquationSeparate(modeRGB, modeAlpha));
+        else
+            JSB_GL_CHECK_VOID(glBlendEquation(modeRGB));
+        return true;
+    }
+
+    bool setStreamBlendFunc(GLuint srcRGB, GLuint dstRGB, GLuint srcAlpha, GLuint dstAlpha, bool separate)
+    {
+        if (__streamState.blendSrcRGB == srcRGB && __streamState.blendDstRGB == dstRGB &&
+            __streamState.blendSrcAlpha == srcAlpha && __streamState.blendDstAlpha == dstAlpha)
+            return false;
+        __streamState.blendSrcRGB = srcRGB;
+        __streamState.blendDstRGB = dstRGB;
+        __streamState.blendSrcAlpha = srcAlpha;
+        __streamState.blendDstAlpha = dstAlpha;
+
+        if (separate)
+            JSB_GL_CHECK_VOID(glBlendFuncSeparate(srcRGB, dstRGB, srcAlpha, dstAlpha));
+        else
+            JSB_GL_CHECK_VOID(glBlendFunc(srcRGB, dstRGB));
+        return true;
+    }
+
+    // glVertexAttrib*fv read a fixed number of floats, the element count lane is only checked
+    // against the lanes of the command by the flush.
+    inline bool checkGLCommandElements(const GLCommandLane* countLane, GLint expected, const char* name)
+    {
+        if (countLane->i >= expected)
+            return true;
+
+        SE_REPORT_ERROR("GL command %s expects %d elements, got %d!", name, expected, countLane->i);
+        return false;
+    }
+
+    void registerGLCommand(uint32_t commandID, const char* name, const char* signature, GLCommandHandler handler)
+    {
+        assert(commandID < GL_COMMAND_COUNT);
+        GLCommandInfo& info = __glCommands[commandID];
+        info.name = name;
+        info.signature = signature;
+        info.handler = handler;
+        info.hasArray = false;
+        info.fixedLaneCount = 0;
+        for (const char* c = signature; *c != '\0'; ++c)
+        {
+            ++info.fixedLaneCount;
+            if (*c == 'F' || *c == 'I')
+            {
+                // Only the element count lane is fixed.
+                assert(c[1] == '\0');
+                info.hasArray = true;
+            }
         }
-        else if (commandID == GL_COMMAND_BIND_FRAME_BUFFER) {
-            LOG_GL_COMMAND("Flush: BIND_FRAME_BUFFER\n");
-            GLuint fbo = (GLuint)p[2];
+    }
+
+    void initGLCommands()
+    {
+        if (__glCommands[GL_COMMAND_ACTIVE_TEXTURE].handler != nullptr)
+            return;
+
+        registerGLCommand(GL_COMMAND_ACTIVE_TEXTURE, "ACTIVE_TEXTURE", "u", [](const GLCommandLane* a) {
+            if (!updateStreamState(__streamState.activeTexture, a[0].u))
+                return false;
+            JSB_GL_CHECK_VOID(glActiveTexture(a[0].u));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_ATTACH_SHADER, "ATTACH_SHADER", "uu", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glAttachShader(a[0].u, a[1].u));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_BIND_BUFFER, "BIND_BUFFER", "uu", [](const GLCommandLane* a) {
+            // ccBindBuffer has its own cache which is shared with the native renderer.
+            JSB_GL_CHECK_VOID(ccBindBuffer(a[0].u, a[1].u));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_BIND_FRAME_BUFFER, "BIND_FRAME_BUFFER", "uu", [](const GLCommandLane* a) {
+            GLuint fbo = a[1].u;
             if (fbo == 0)
                 fbo = __defaultFbo;
-            JSB_GL_CHECK_VOID(glBindFramebuffer((GLenum)p[1], fbo));
-            p += 3;
-        }
-        else if (commandID == GL_COMMAND_BIND_RENDER_BUFFER) {
-            LOG_GL_COMMAND("Flush: BIND_RENDER_BUFFER\n");
-            JSB_GL_CHECK_VOID(glBindRenderbuffer((GLenum)p[1], (GLuint)p[2]));
-            p += 3;
-        }
-        else if (commandID == GL_COMMAND_BIND_TEXTURE) {
-            LOG_GL_COMMAND("Flush: BIND_TEXTURE\n");
-            JSB_GL_CHECK_VOID(glBindTexture((GLenum)p[1], (GLuint)p[2]));
-            p += 3;
-        }
-        else if (commandID == GL_COMMAND_BLEND_COLOR) {
-            LOG_GL_COMMAND("Flush: BLEND_COLOR\n");
-            JSB_GL_CHECK_VOID(glBlendColor((GLclampf)p[1], (GLclampf)p[2], (GLclampf)p[3], (GLclampf)p[4]));
-            p += 5;
-        }
-        else if (commandID == GL_COMMAND_BLEND_EQUATION) {
-            LOG_GL_COMMAND("Flush: BLEND_EQUATION\n");
-            JSB_GL_CHECK_VOID(glBlendEquation((GLenum)p[1]));
-            p += 2;
-        }
-        else if (commandID == GL_COMMAND_BLEND_EQUATION_SEPARATE) {
-            LOG_GL_COMMAND("Flush: BLEND_EQUATION_SEPARATE\n");
-            JSB_GL_CHECK_VOID(glBlendEquationSeparate((GLenum)p[1], (GLenum)p[2]));
-            p += 3;
-        }
-        else if (commandID == GL_COMMAND_BLEND_FUNC) {
-            LOG_GL_COMMAND("Flush: BLEND_FUNC\n");
-            JSB_GL_CHECK_VOID(glBlendFunc((GLenum)p[1], (GLenum)p[2]));
-            p += 3;
-        }
-        else if (commandID == GL_COMMAND_BLEND_FUNC_SEPARATE) {
-            LOG_GL_COMMAND("Flush: BLEND_FUNC_SEPARATE\n");
-            JSB_GL_CHECK_VOID(glBlendFuncSeparate((GLenum)p[1], (GLenum)p[2], (GLenum)p[3], (GLenum)p[4]));
-            p += 5;
-        }
-        else if (commandID == GL_COMMAND_CLEAR) {
-            LOG_GL_COMMAND("Flush: CLEAR\n");
-            JSB_GL_CHECK_VOID(glClear((GLbitfield)p[1]));
-            p += 2;
-        }
-        else if (commandID == GL_COMMAND_CLEAR_COLOR) {
-            LOG_GL_COMMAND("Flush: CLEAR_COLOR\n");
-            JSB_GL_CHECK_VOID(glClearColor((GLclampf)p[1], (GLclampf)p[2], (GLclampf)p[3], (GLclampf)p[4]));
-            p += 5;
-        }
-        else if (commandID == GL_COMMAND_CLEAR_DEPTH) {
-            LOG_GL_COMMAND("Flush: CLEAR_DEPTH\n");
-            JSB_GL_CHECK_VOID(glClearDepthf(p[1]));
-            p += 2;
-        }
-        else if (commandID == GL_COMMAND_CLEAR_STENCIL) {
-            LOG_GL_COMMAND("Flush: CLEAR_STENCIL\n");
-            JSB_GL_CHECK_VOID(glClearStencil((GLint)p[1]));
-            p += 2;
-        }
-        else if (commandID == GL_COMMAND_COLOR_MASK) {
-            LOG_GL_COMMAND("Flush: COLOR_MASK\n");
-            JSB_GL_CHECK_VOID(glColorMask((GLboolean)p[1], (GLboolean)p[2], (GLboolean)p[3], (GLboolean)p[4]));
-            p += 5;
-        }
-        else if (commandID == GL_COMMAND_COMPILE_SHADER) {
-            LOG_GL_COMMAND("Flush: COMPILE_SHADER\n");
-            JSB_GL_CHECK_VOID(glCompileShader((GLuint)p[1]));
-            p += 2;
-        }
-        else if (commandID == GL_COMMAND_COPY_TEX_IMAGE_2D) {
-            LOG_GL_COMMAND("Flush: COPY_TEX_IMAGE_2D\n");
-            JSB_GL_CHECK_VOID(glCopyTexImage2D((GLenum)p[1], (GLint)p[2], (GLenum)p[3], (GLint)p[4], (GLint)p[5], (GLsizei)p[6], (GLsizei)p[7], (GLint)p[8]));
-            p += 9;
-        }
-        else if (commandID == GL_COMMAND_COPY_TEX_SUB_IMAGE_2D) {
-            LOG_GL_COMMAND("Flush: COPY_TEX_SUB_IMAGE_2D\n");
-            JSB_GL_CHECK_VOID(glCopyTexSubImage2D((GLenum)p[1], (GLint)p[2], (GLint)p[3], (GLint)p[4], (GLint)p[5], (GLint)p[6], (GLsizei)p[7], (GLsizei)p[8]));
-            p += 9;
-        }
-        else if (commandID == GL_COMMAND_CULL_FACE) {
-            LOG_GL_COMMAND("Flush: CULL_FACE\n");
-            JSB_GL_CHECK_VOID(glCullFace((GLenum)p[1]));
-            p += 2;
-        }
-        else if (commandID == GL_COMMAND_DELETE_BUFFER) {
-            LOG_GL_COMMAND("Flush: DELETE_BUFFER\n");
-            GLuint id = (GLuint)p[1];
+            if (a[0].u == GL_FRAMEBUFFER && !updateStreamState(__streamState.framebuffer, fbo))
+                return false;
+            JSB_GL_CHECK_VOID(glBindFramebuffer(a[0].u, fbo));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_BIND_RENDER_BUFFER, "BIND_RENDER_BUFFER", "uu", [](const GLCommandLane* a) {
+            if (a[0].u == GL_RENDERBUFFER && !updateStreamState(__streamState.renderbuffer, a[1].u))
+                return false;
+            JSB_GL_CHECK_VOID(glBindRenderbuffer(a[0].u, a[1].u));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_BIND_TEXTURE, "BIND_TEXTURE", "uu", [](const GLCommandLane* a) {
+            GLuint* cached = getStreamTextureBinding(a[0].u);
+            if (cached != nullptr && !updateStreamState(*cached, a[1].u))
+                return false;
+            JSB_GL_CHECK_VOID(glBindTexture(a[0].u, a[1].u));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_BLEND_COLOR, "BLEND_COLOR", "ffff", [](const GLCommandLane* a) {
+            GLfloat* cached = __streamState.blendColor;
+            if (__streamState.blendColorValid &&
+                cached[0] == a[0].f && cached[1] == a[1].f && cached[2] == a[2].f && cached[3] == a[3].f)
+                return false;
+            for (int i = 0; i < 4; ++i)
+                cached[i] = a[i].f;
+            __streamState.blendColorValid = true;
+            JSB_GL_CHECK_VOID(glBlendColor(a[0].f, a[1].f, a[2].f, a[3].f));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_BLEND_EQUATION, "BLEND_EQUATION", "u", [](const GLCommandLane* a) {
+            return setStreamBlendEquation(a[0].u, a[0].u, false);
+        });
+        registerGLCommand(GL_COMMAND_BLEND_EQUATION_SEPARATE, "BLEND_EQUATION_SEPARATE", "uu", [](const GLCommandLane* a) {
+            return setStreamBlendEquation(a[0].u, a[1].u, true);
+        });
+        registerGLCommand(GL_COMMAND_BLEND_FUNC, "BLEND_FUNC", "uu", [](const GLCommandLane* a) {
+            return setStreamBlendFunc(a[0].u, a[1].u, a[0].u, a[1].u, false);
+        });
+        registerGLCommand(GL_COMMAND_BLEND_FUNC_SEPARATE, "BLEND_FUNC_SEPARATE", "uuuu", [](const GLCommandLane* a) {
+            return setStreamBlendFunc(a[0].u, a[1].u, a[2].u, a[3].u, true);
+        });
+        registerGLCommand(GL_COMMAND_CLEAR, "CLEAR", "u", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glClear(a[0].u));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_CLEAR_COLOR, "CLEAR_COLOR", "ffff", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glClearColor(a[0].f, a[1].f, a[2].f, a[3].f));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_CLEAR_DEPTH, "CLEAR_DEPTH", "f", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glClearDepthf(a[0].f));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_CLEAR_STENCIL, "CLEAR_STENCIL", "i", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glClearStencil(a[0].i));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_COLOR_MASK, "COLOR_MASK", "uuuu", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glColorMask((GLboolean)(a[0].u != 0), (GLboolean)(a[1].u != 0), (GLboolean)(a[2].u != 0), (GLboolean)(a[3].u != 0)));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_COMPILE_SHADER, "COMPILE_SHADER", "u", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glCompileShader(a[0].u));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_COPY_TEX_IMAGE_2D, "COPY_TEX_IMAGE_2D", "uiuiiiii", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glCopyTexImage2D(a[0].u, a[1].i, a[2].u, a[3].i, a[4].i, a[5].i, a[6].i, a[7].i));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_COPY_TEX_SUB_IMAGE_2D, "COPY_TEX_SUB_IMAGE_2D", "uiiiiiii", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glCopyTexSubImage2D(a[0].u, a[1].i, a[2].i, a[3].i, a[4].i, a[5].i, a[6].i, a[7].i));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_CULL_FACE, "CULL_FACE", "u", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glCullFace(a[0].u));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_DELETE_BUFFER, "DELETE_BUFFER", "u", [](const GLCommandLane* a) {
+            GLuint id = a[0].u;
             JSB_GL_CHECK_VOID(ccDeleteBuffers(1, &id));
             safeRemoveElementFromGLObjectMap(__webglBufferMap, id);
-            p += 2;
-        }
-        else if (commandID == GL_COMMAND_DELETE_FRAME_BUFFER) {
-            LOG_GL_COMMAND("Flush: DELETE_FRAME_BUFFER\n");
-            GLuint id = (GLuint)p[1];
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_DELETE_FRAME_BUFFER, "DELETE_FRAME_BUFFER", "u", [](const GLCommandLane* a) {
+            GLuint id = a[0].u;
             JSB_GL_CHECK_VOID(glDeleteFramebuffers(1, &id));
             safeRemoveElementFromGLObjectMap(__webglFramebufferMap, id);
-            p += 2;
-        }
-        else if (commandID == GL_COMMAND_DELETE_PROGRAM) {
-            LOG_GL_COMMAND("Flush: DELETE_PROGRAM\n");
-            GLuint id = (GLuint)p[1];
+            __streamState.framebuffer = GL_STREAM_STATE_UNKNOWN;
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_DELETE_PROGRAM, "DELETE_PROGRAM", "u", [](const GLCommandLane* a) {
+            GLuint id = a[0].u;
             JSB_GL_CHECK_VOID(glDeleteProgram(id));
             safeRemoveElementFromGLObjectMap(__webglProgramMap, id);
-            p += 2;
-        }
-        else if (commandID == GL_COMMAND_DELETE_RENDER_BUFFER) {
-            LOG_GL_COMMAND("Flush: DELETE_RENDER_BUFFER\n");
-            GLuint id = (GLuint)p[1];
+            __streamState.program = GL_STREAM_STATE_UNKNOWN;
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_DELETE_RENDER_BUFFER, "DELETE_RENDER_BUFFER", "u", [](const GLCommandLane* a) {
+            GLuint id = a[0].u;
             JSB_GL_CHECK_VOID(glDeleteRenderbuffers(1, &id));
             safeRemoveElementFromGLObjectMap(__webglRenderbufferMap, id);
-            p += 2;
-        }
-        else if (commandID == GL_COMMAND_DELETE_SHADER) {
-            LOG_GL_COMMAND("Flush: DELETE_SHADER\n");
-            GLuint id = (GLuint)p[1];
+            __streamState.renderbuffer = GL_STREAM_STATE_UNKNOWN;
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_DELETE_SHADER, "DELETE_SHADER", "u", [](const GLCommandLane* a) {
+            GLuint id = a[0].u;
             JSB_GL_CHECK_VOID(glDeleteShader(id));
             safeRemoveElementFromGLObjectMap(__webglShaderMap, id);
-            p += 2;
-        }
-        else if (commandID == GL_COMMAND_DELETE_TEXTURE) {
-            LOG_GL_COMMAND("Flush: DELETE_TEXTURE\n");
-            GLuint id = (GLuint)p[1];
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_DELETE_TEXTURE, "DELETE_TEXTURE", "u", [](const GLCommandLane* a) {
+            GLuint id = a[0].u;
             JSB_GL_CHECK_VOID(glDeleteTextures(1, &id));
             safeRemoveElementFromGLObjectMap(__webglTextureMap, id);
-            p += 2;
-        }
-        else if (commandID == GL_COMMAND_DEPTH_FUNC) {
-            LOG_GL_COMMAND("Flush: DEPTH_FUNC\n");
-            JSB_GL_CHECK_VOID(glDepthFunc((GLenum)p[1]));
-            p += 2;
-        }
-        else if (commandID == GL_COMMAND_DEPTH_MASK) {
-            LOG_GL_COMMAND("Flush: DEPTH_MASK\n");
-            JSB_GL_CHECK_VOID(glDepthMask((GLboolean)p[1]));
-            p += 2;
-        }
-        else if (commandID == GL_COMMAND_DEPTH_RANGE) {
-            LOG_GL_COMMAND("Flush: DEPTH_RANGE\n");
-            JSB_GL_CHECK_VOID(glDepthRangef(p[1], p[2]));
-            p += 3;
-        }
-        else if (commandID == GL_COMMAND_DETACH_SHADER) {
-            LOG_GL_COMMAND("Flush: DETACH_SHADER\n");
-            JSB_GL_CHECK_VOID(glDetachShader((GLuint)p[1], (GLuint) p[2]));
-            p += 3;
-        }
-        else if (commandID == GL_COMMAND_DISABLE) {
-            LOG_GL_COMMAND("Flush: DISABLE\n");
-            JSB_GL_CHECK_VOID(glDisable((GLenum)p[1]));
-            p += 2;
-        }
-        else if (commandID == GL_COMMAND_DISABLE_VERTEX_ATTRIB_ARRAY) {
-            LOG_GL_COMMAND("Flush: DISABLE_VERTEX_ATTRIB_ARRAY\n");
-            JSB_GL_CHECK_VOID(ccDisableVertexAttribArray((GLuint)p[1]));
-            p += 2;
-        }
-        else if (commandID == GL_COMMAND_DRAW_ARRAYS) {
-            LOG_GL_COMMAND("Flush: DRAW_ARRAYS, %u, %d, %d\n", (GLenum)p[1], (GLint)p[2], (int)p[3]);
-            JSB_GL_CHECK_VOID(glDrawArrays((GLenum)p[1], (GLint)p[2], (GLsizei)p[3]));
-            p += 4;
-        }
-        else if (commandID == GL_COMMAND_DRAW_ELEMENTS) {
-            LOG_GL_COMMAND("Flush: DRAW_ELEMENTS\n");
-            JSB_GL_CHECK_VOID(glDrawElements((GLenum)p[1], (GLsizei)p[2], (GLenum)p[3], (const GLvoid*)(intptr_t)p[4]));
-            p += 5;
-        }
-        else if (commandID == GL_COMMAND_ENABLE) {
-            LOG_GL_COMMAND("Flush: ENABLE\n");
-            JSB_GL_CHECK_VOID(glEnable((GLenum)p[1]));
-            p += 2;
-        }
-        else if (commandID == GL_COMMAND_ENABLE_VERTEX_ATTRIB_ARRAY) {
-            LOG_GL_COMMAND("Flush: ENABLE_VERTEX_ATTRIB_ARRAY, %u\n", (GLuint)p[1]);
-            JSB_GL_CHECK_VOID(ccEnableVertexAttribArray((GLuint)p[1]));
-            p += 2;
-        }
-        else if (commandID == GL_COMMAND_FINISH) {
-            LOG_GL_COMMAND("Flush: FINISH\n");
+            // Deleting a texture unbinds it from every unit.
+            std::fill(std::begin(__streamState.textures2D), std::end(__streamState.textures2D), GL_STREAM_STATE_UNKNOWN);
+            std::fill(std::begin(__streamState.texturesCube), std::end(__streamState.texturesCube), GL_STREAM_STATE_UNKNOWN);
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_DEPTH_FUNC, "DEPTH_FUNC", "u", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glDepthFunc(a[0].u));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_DEPTH_MASK, "DEPTH_MASK", "u", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glDepthMask((GLboolean)(a[0].u != 0)));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_DEPTH_RANGE, "DEPTH_RANGE", "ff", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glDepthRangef(a[0].f, a[1].f));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_DETACH_SHADER, "DETACH_SHADER", "uu", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glDetachShader(a[0].u, a[1].u));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_DISABLE, "DISABLE", "u", [](const GLCommandLane* a) {
+            return setStreamCap(a[0].u, false);
+        });
+        registerGLCommand(GL_COMMAND_DISABLE_VERTEX_ATTRIB_ARRAY, "DISABLE_VERTEX_ATTRIB_ARRAY", "u", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(ccDisableVertexAttribArray(a[0].u));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_DRAW_ARRAYS, "DRAW_ARRAYS", "uii", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glDrawArrays(a[0].u, a[1].i, a[2].i));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_DRAW_ELEMENTS, "DRAW_ELEMENTS", "uiuu", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glDrawElements(a[0].u, a[1].i, a[2].u, (const GLvoid*)(intptr_t)a[3].u));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_ENABLE, "ENABLE", "u", [](const GLCommandLane* a) {
+            return setStreamCap(a[0].u, true);
+        });
+        registerGLCommand(GL_COMMAND_ENABLE_VERTEX_ATTRIB_ARRAY, "ENABLE_VERTEX_ATTRIB_ARRAY", "u", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(ccEnableVertexAttribArray(a[0].u));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_FINISH, "FINISH", "", [](const GLCommandLane* a) {
             JSB_GL_CHECK_VOID(glFinish());
-            p += 1;
-        }
-        else if (commandID == GL_COMMAND_FLUSH) {
-            LOG_GL_COMMAND("Flush: FLUSH\n");
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_FLUSH, "FLUSH", "", [](const GLCommandLane* a) {
             JSB_GL_CHECK_VOID(glFlush());
-            p += 1;
-        }
-        else if (commandID == GL_COMMAND_FRAME_BUFFER_RENDER_BUFFER) {
-            LOG_GL_COMMAND("Flush: FRAME_BUFFER_RENDER_BUFFER\n");
-            JSB_GL_CHECK_VOID(WEBGL_framebufferRenderbuffer((GLenum)p[1], (GLenum)p[2], (GLenum)p[3], (GLuint)p[4]));
-            p += 5;
-        }
-        else if (commandID == GL_COMMAND_FRAME_BUFFER_TEXTURE_2D) {
-            LOG_GL_COMMAND("Flush: FRAME_BUFFER_TEXTURE_2D\n");
-            JSB_GL_CHECK_VOID(glFramebufferTexture2D((GLenum)p[1], (GLenum)p[2], (GLenum)p[3], (GLuint)p[4], (GLint)p[5]));
-            p += 6;
-        }
-        else if (commandID == GL_COMMAND_FRONT_FACE) {
-            LOG_GL_COMMAND("Flush: FRONT_FACE\n");
-            JSB_GL_CHECK_VOID(glFrontFace((GLenum)p[1]));
-            p += 2;
-        }
-        else if (commandID == GL_COMMAND_GENERATE_MIPMAP) {
-            LOG_GL_COMMAND("Flush: GENERATE_MIPMAP\n");
-            JSB_GL_CHECK_VOID(glGenerateMipmap((GLenum)p[1]));
-            p += 2;
-        }
-        else if (commandID == GL_COMMAND_HINT) {
-            LOG_GL_COMMAND("Flush: HINT\n");
-            JSB_GL_CHECK_VOID(glHint((GLenum)p[1], (GLenum)p[2]));;
-            p += 3;
-        }
-        else if (commandID == GL_COMMAND_LINE_WIDTH) {
-            LOG_GL_COMMAND("Flush: LINE_WIDTH\n");
-            JSB_GL_CHECK_VOID(glLineWidth(p[1]));
-            p += 2;
-        }
-        else if (commandID == GL_COMMAND_LINK_PROGRAM) {
-            LOG_GL_COMMAND("Flush: LINK_PROGRAM\n");
-            JSB_GL_CHECK_VOID(glLinkProgram((GLuint)p[1]));
-            p += 2;
-        }
-        else if (commandID == GL_COMMAND_PIXEL_STOREI) {
-            LOG_GL_COMMAND("Flush: PIXEL_STOREI\n");
-            JSB_GL_CHECK_VOID(ccPixelStorei((GLenum)p[1], (GLint)p[2]));
-            p += 3;
-        }
-        else if (commandID == GL_COMMAND_POLYGON_OFFSET) {
-            LOG_GL_COMMAND("Flush: POLYGON_OFFSET\n");
-            JSB_GL_CHECK_VOID(glPolygonOffset(p[1], p[2]));
-            p += 3;
-        }
-        else if (commandID == GL_COMMAND_RENDER_BUFFER_STORAGE) {
-            LOG_GL_COMMAND("Flush: RENDER_BUFFER_STORAGE\n");
-            JSB_GL_CHECK_VOID(WEBGL_renderbufferStorage((GLenum)p[1], (GLenum)p[2], (GLsizei)p[3], (GLsizei)p[4]));
-            p += 5;
-        }
-        else if (commandID == GL_COMMAND_SAMPLE_COVERAGE) {
-            LOG_GL_COMMAND("Flush: SAMPLE_COVERAGE\n");
-            JSB_GL_CHECK_VOID(glSampleCoverage(p[1], (GLboolean)p[2]));
-            p += 3;
-        }
-        else if (commandID == GL_COMMAND_SCISSOR) {
-            LOG_GL_COMMAND("Flush: SCISSOR\n");
-            JSB_GL_CHECK_VOID(ccScissor((GLint)p[1], (GLint)p[2], (GLsizei)p[3], (GLsizei)p[4]));
-            p += 5;
-        }
-        else if (commandID == GL_COMMAND_STENCIL_FUNC) {
-            LOG_GL_COMMAND("Flush: STENCIL_FUNC\n");
-            JSB_GL_CHECK_VOID(glStencilFunc((GLenum)p[1], (GLint)p[2], (GLuint)p[3]));
-            p += 4;
-        }
-        else if (commandID == GL_COMMAND_STENCIL_FUNC_SEPARATE) {
-            LOG_GL_COMMAND("Flush: STENCIL_FUNC_SEPARATE\n");
-            JSB_GL_CHECK_VOID(glStencilFuncSeparate((GLenum)p[1], (GLenum)p[2], (GLint)p[3], (GLuint)p[4]));
-            p += 5;
-        }
-        else if (commandID == GL_COMMAND_STENCIL_MASK) {
-            LOG_GL_COMMAND("Flush: STENCIL_MASK\n");
-            JSB_GL_CHECK_VOID(glStencilMask((GLuint)p[1]));
-            p += 2;
-        }
-        else if (commandID == GL_COMMAND_STENCIL_MASK_SEPARATE) {
-            LOG_GL_COMMAND("Flush: STENCIL_MASK_SEPARATE\n");
-            JSB_GL_CHECK_VOID(glStencilMaskSeparate((GLenum)p[1], (GLuint)p[2]));
-            p += 3;
-        }
-        else if (commandID == GL_COMMAND_STENCIL_OP) {
-            LOG_GL_COMMAND("Flush: STENCIL_OP\n");
-            JSB_GL_CHECK_VOID(glStencilOp((GLenum)p[1], (GLenum)p[2], (GLenum)p[3]));
-            p += 4;
-        }
-        else if (commandID == GL_COMMAND_STENCIL_OP_SEPARATE) {
-            LOG_GL_COMMAND("Flush: STENCIL_OP_SEPARATE\n");
-            JSB_GL_CHECK_VOID(glStencilOpSeparate((GLenum)p[1], (GLenum)p[2], (GLenum)p[3], (GLenum)p[4]));
-            p += 5;
-        }
-        else if (commandID == GL_COMMAND_TEX_PARAMETER_F) {
-            LOG_GL_COMMAND("Flush: TEX_PARAMETER_F\n");
-            JSB_GL_CHECK_VOID(glTexParameterf((GLenum)p[1], (GLenum)p[2], p[3]));
-            p += 4;
-        }
-        else if (commandID == GL_COMMAND_TEX_PARAMETER_I) {
-            LOG_GL_COMMAND("Flush: TEX_PARAMETER_I\n");
-            JSB_GL_CHECK_VOID(glTexParameteri((GLenum)p[1], (GLenum)p[2], (GLint)p[3]));
-            p += 4;
-        }
-        else if (commandID == GL_COMMAND_UNIFORM_1F) {
-            LOG_GL_COMMAND("Flush: UNIFORM_1F\n");
-            JSB_GL_CHECK_VOID(glUniform1f((GLint)p[1], p[2]));
-            p += 3;
-        }
-        else if (commandID == GL_COMMAND_UNIFORM_2F) {
-            LOG_GL_COMMAND("Flush: UNIFORM_2F\n");
-            JSB_GL_CHECK_VOID(glUniform2f((GLint)p[1], p[2], p[3]));
-            p += 4;
-        }
-        else if (commandID == GL_COMMAND_UNIFORM_3F) {
-            LOG_GL_COMMAND("Flush: UNIFORM_3F\n");
-            JSB_GL_CHECK_VOID(glUniform3f((GLint)p[1], p[2], p[3], p[4]));
-            p += 5;
-        }
-        else if (commandID == GL_COMMAND_UNIFORM_4F) {
-            LOG_GL_COMMAND("Flush: UNIFORM_4F\n");
-            JSB_GL_CHECK_VOID(glUniform4f((GLint)p[1], p[2], p[3], p[4], p[5]));
-            p += 6;
-        }
-        else if (commandID == GL_COMMAND_UNIFORM_1I) {
-            LOG_GL_COMMAND("Flush: UNIFORM_1I\n");
-            JSB_GL_CHECK_VOID(glUniform1i((GLint)p[1], (GLint)p[2]));
-            p += 3;
-        }
-        else if (commandID == GL_COMMAND_UNIFORM_2I) {
-            LOG_GL_COMMAND("Flush: UNIFORM_2I\n");
-            JSB_GL_CHECK_VOID(glUniform2i((GLint)p[1], (GLint)p[2], (GLint)p[3]));
-            p += 4;
-        }
-        else if (commandID == GL_COMMAND_UNIFORM_3I) {
-            LOG_GL_COMMAND("Flush: UNIFORM_3I\n");
-            JSB_GL_CHECK_VOID(glUniform3i((GLint)p[1], (GLint)p[2], (GLint)p[3], (GLint)p[4]));
-            p += 5;
-        }
-        else if (commandID == GL_COMMAND_UNIFORM_4I) {
-            LOG_GL_COMMAND("Flush: UNIFORM_4I\n");
-            JSB_GL_CHECK_VOID(glUniform4i((GLint)p[1], (GLint)p[2], (GLint)p[3], (GLint)p[4], (GLint)p[5]));
-            p += 6;
-        }
-        else if (commandID == GL_COMMAND_UNIFORM_1FV) {
-            LOG_GL_COMMAND("Flush: UNIFORM_1FV\n");
-            GLsizei elementCount = (GLsizei)p[2];
-            JSB_GL_CHECK_VOID(glUniform1fv((GLint)p[1], elementCount, &p[3]));
-            p += (elementCount + 3);
-        }
-        else if (commandID == GL_COMMAND_UNIFORM_2FV) {
-            LOG_GL_COMMAND("Flush: UNIFORM_2FV\n");
-            GLsizei elementCount = (GLsizei)p[2];
-            JSB_GL_CHECK_VOID(glUniform2fv((GLint)p[1], elementCount / 2, &p[3]));
-            p += (elementCount + 3);
-        }
-        else if (commandID == GL_COMMAND_UNIFORM_3FV) {
-            LOG_GL_COMMAND("Flush: UNIFORM_3FV\n");
-            GLsizei elementCount = (GLsizei)p[2];
-            JSB_GL_CHECK_VOID(glUniform3fv((GLint)p[1], elementCount / 3, &p[3]));
-            p += (elementCount + 3);
-        }
-        else if (commandID == GL_COMMAND_UNIFORM_4FV) {
-            LOG_GL_COMMAND("Flush: UNIFORM_4FV\n");
-            GLsizei elementCount = (GLsizei)p[2];
-            JSB_GL_CHECK_VOID(glUniform4fv((GLint)p[1], elementCount / 3, &p[3]));
-            p += (elementCount + 3);
-        }
-        else if (commandID == GL_COMMAND_UNIFORM_1IV) {
-            LOG_GL_COMMAND("Flush: UNIFORM_1IV\n");
-            GLsizei elementCount = (GLsizei)p[2];
-            GLint* intBuf = (GLint*)malloc(elementCount * sizeof(GLint));
-            for (GLsizei i = 0; i < elementCount; ++i)
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_FRAME_BUFFER_RENDER_BUFFER, "FRAME_BUFFER_RENDER_BUFFER", "uuuu", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(WEBGL_framebufferRenderbuffer(a[0].u, a[1].u, a[2].u, a[3].u));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_FRAME_BUFFER_TEXTURE_2D, "FRAME_BUFFER_TEXTURE_2D", "uuuui", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glFramebufferTexture2D(a[0].u, a[1].u, a[2].u, a[3].u, a[4].i));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_FRONT_FACE, "FRONT_FACE", "u", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glFrontFace(a[0].u));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_GENERATE_MIPMAP, "GENERATE_MIPMAP", "u", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glGenerateMipmap(a[0].u));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_HINT, "HINT", "uu", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glHint(a[0].u, a[1].u));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_LINE_WIDTH, "LINE_WIDTH", "f", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glLineWidth(a[0].f));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_LINK_PROGRAM, "LINK_PROGRAM", "u", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glLinkProgram(a[0].u));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_PIXEL_STOREI, "PIXEL_STOREI", "ui", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(ccPixelStorei(a[0].u, a[1].i));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_POLYGON_OFFSET, "POLYGON_OFFSET", "ff", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glPolygonOffset(a[0].f, a[1].f));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_RENDER_BUFFER_STORAGE, "RENDER_BUFFER_STORAGE", "uuii", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(WEBGL_renderbufferStorage(a[0].u, a[1].u, a[2].i, a[3].i));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_SAMPLE_COVERAGE, "SAMPLE_COVERAGE", "fu", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glSampleCoverage(a[0].f, (GLboolean)(a[1].u != 0)));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_SCISSOR, "SCISSOR", "iiii", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(ccScissor(a[0].i, a[1].i, a[2].i, a[3].i));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_STENCIL_FUNC, "STENCIL_FUNC", "uiu", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glStencilFunc(a[0].u, a[1].i, a[2].u));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_STENCIL_FUNC_SEPARATE, "STENCIL_FUNC_SEPARATE", "uuiu", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glStencilFuncSeparate(a[0].u, a[1].u, a[2].i, a[3].u));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_STENCIL_MASK, "STENCIL_MASK", "u", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glStencilMask(a[0].u));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_STENCIL_MASK_SEPARATE, "STENCIL_MASK_SEPARATE", "uu", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glStencilMaskSeparate(a[0].u, a[1].u));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_STENCIL_OP, "STENCIL_OP", "uuu", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glStencilOp(a[0].u, a[1].u, a[2].u));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_STENCIL_OP_SEPARATE, "STENCIL_OP_SEPARATE", "uuuu", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glStencilOpSeparate(a[0].u, a[1].u, a[2].u, a[3].u));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_TEX_PARAMETER_F, "TEX_PARAMETER_F", "uuf", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glTexParameterf(a[0].u, a[1].u, a[2].f));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_TEX_PARAMETER_I, "TEX_PARAMETER_I", "uui", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glTexParameteri(a[0].u, a[1].u, a[2].i));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_UNIFORM_1F, "UNIFORM_1F", "if", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glUniform1f(a[0].i, a[1].f));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_UNIFORM_2F, "UNIFORM_2F", "iff", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glUniform2f(a[0].i, a[1].f, a[2].f));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_UNIFORM_3F, "UNIFORM_3F", "ifff", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glUniform3f(a[0].i, a[1].f, a[2].f, a[3].f));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_UNIFORM_4F, "UNIFORM_4F", "iffff", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glUniform4f(a[0].i, a[1].f, a[2].f, a[3].f, a[4].f));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_UNIFORM_1I, "UNIFORM_1I", "ii", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glUniform1i(a[0].i, a[1].i));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_UNIFORM_2I, "UNIFORM_2I", "iii", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glUniform2i(a[0].i, a[1].i, a[2].i));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_UNIFORM_3I, "UNIFORM_3I", "iiii", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glUniform3i(a[0].i, a[1].i, a[2].i, a[3].i));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_UNIFORM_4I, "UNIFORM_4I", "iiiii", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glUniform4i(a[0].i, a[1].i, a[2].i, a[3].i, a[4].i));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_UNIFORM_1FV, "UNIFORM_1FV", "iF", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glUniform1fv(a[0].i, a[1].i, &a[2].f));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_UNIFORM_2FV, "UNIFORM_2FV", "iF", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glUniform2fv(a[0].i, a[1].i / 2, &a[2].f));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_UNIFORM_3FV, "UNIFORM_3FV", "iF", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glUniform3fv(a[0].i, a[1].i / 3, &a[2].f));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_UNIFORM_4FV, "UNIFORM_4FV", "iF", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glUniform4fv(a[0].i, a[1].i / 4, &a[2].f));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_UNIFORM_1IV, "UNIFORM_1IV", "iI", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glUniform1iv(a[0].i, a[1].i, &a[2].i));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_UNIFORM_2IV, "UNIFORM_2IV", "iI", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glUniform2iv(a[0].i, a[1].i / 2, &a[2].i));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_UNIFORM_3IV, "UNIFORM_3IV", "iI", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glUniform3iv(a[0].i, a[1].i / 3, &a[2].i));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_UNIFORM_4IV, "UNIFORM_4IV", "iI", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glUniform4iv(a[0].i, a[1].i / 4, &a[2].i));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_UNIFORM_MATRIX_2FV, "UNIFORM_MATRIX_2FV", "iuF", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glUniformMatrix2fv(a[0].i, a[2].i / 4, (GLboolean)(a[1].u != 0), &a[3].f));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_UNIFORM_MATRIX_3FV, "UNIFORM_MATRIX_3FV", "iuF", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glUniformMatrix3fv(a[0].i, a[2].i / 9, (GLboolean)(a[1].u != 0), &a[3].f));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_UNIFORM_MATRIX_4FV, "UNIFORM_MATRIX_4FV", "iuF", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glUniformMatrix4fv(a[0].i, a[2].i / 16, (GLboolean)(a[1].u != 0), &a[3].f));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_USE_PROGRAM, "USE_PROGRAM", "u", [](const GLCommandLane* a) {
+            if (!updateStreamState(__streamState.program, a[0].u))
+                return false;
+            JSB_GL_CHECK_VOID(glUseProgram(a[0].u));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_VALIDATE_PROGRAM, "VALIDATE_PROGRAM", "u", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glValidateProgram(a[0].u));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_VERTEX_ATTRIB_1F, "VERTEX_ATTRIB_1F", "uf", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glVertexAttrib1f(a[0].u, a[1].f));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_VERTEX_ATTRIB_2F, "VERTEX_ATTRIB_2F", "uff", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glVertexAttrib2f(a[0].u, a[1].f, a[2].f));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_VERTEX_ATTRIB_3F, "VERTEX_ATTRIB_3F", "ufff", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glVertexAttrib3f(a[0].u, a[1].f, a[2].f, a[3].f));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_VERTEX_ATTRIB_4F, "VERTEX_ATTRIB_4F", "uffff", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(glVertexAttrib4f(a[0].u, a[1].f, a[2].f, a[3].f, a[4].f));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_VERTEX_ATTRIB_1FV, "VERTEX_ATTRIB_1FV", "uF", [](const GLCommandLane* a) {
+            if (!checkGLCommandElements(&a[1], 1, "VERTEX_ATTRIB_1FV"))
+                return false;
+            JSB_GL_CHECK_VOID(glVertexAttrib1fv(a[0].u, &a[2].f));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_VERTEX_ATTRIB_2FV, "VERTEX_ATTRIB_2FV", "uF", [](const GLCommandLane* a) {
+            if (!checkGLCommandElements(&a[1], 2, "VERTEX_ATTRIB_2FV"))
+                return false;
+            JSB_GL_CHECK_VOID(glVertexAttrib2fv(a[0].u, &a[2].f));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_VERTEX_ATTRIB_3FV, "VERTEX_ATTRIB_3FV", "uF", [](const GLCommandLane* a) {
+            if (!checkGLCommandElements(&a[1], 3, "VERTEX_ATTRIB_3FV"))
+                return false;
+            JSB_GL_CHECK_VOID(glVertexAttrib3fv(a[0].u, &a[2].f));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_VERTEX_ATTRIB_4FV, "VERTEX_ATTRIB_4FV", "uF", [](const GLCommandLane* a) {
+            if (!checkGLCommandElements(&a[1], 4, "VERTEX_ATTRIB_4FV"))
+                return false;
+            JSB_GL_CHECK_VOID(glVertexAttrib4fv(a[0].u, &a[2].f));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_VERTEX_ATTRIB_POINTER, "VERTEX_ATTRIB_POINTER", "uiuuiu", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(ccVertexAttribPointer(a[0].u, a[1].i, a[2].u, (GLboolean)(a[3].u != 0), a[4].i, (const GLvoid*)(GLintptr)a[5].u));
+            return true;
+        });
+        registerGLCommand(GL_COMMAND_VIEW_PORT, "VIEW_PORT", "iiii", [](const GLCommandLane* a) {
+            JSB_GL_CHECK_VOID(ccViewport(a[0].i, a[1].i, a[2].i, a[3].i));
+            return true;
+        });
+    }
+
+    inline void executeGLCommand(uint32_t commandID, const GLCommandLane* args)
+    {
+        LOG_GL_COMMAND("Flush: %s\n", __glCommands[commandID].name);
+        if (__glCommands[commandID].handler(args))
+            ++__glCommandCounters.issued[commandID];
+        else
+            ++__glCommandCounters.skipped[commandID];
+    }
+
+    inline bool isValidGLCommand(uint32_t commandID)
+    {
+        return commandID < GL_COMMAND_COUNT && __glCommands[commandID].handler != nullptr;
+    }
+
+    bool flushCommandStream(const GLCommandLane* p, const GLCommandLane* end)
+    {
+        while (p < end)
+        {
+            uint32_t commandID = p->u & 0xFF;
+            uint32_t laneCount = p->u >> 8;
+            const GLCommandLane* args = p + 1;
+            p = args + laneCount;
+
+            if (!isValidGLCommand(commandID) || p > end)
             {
-                intBuf[i] = p[3+i];
+                SE_REPORT_ERROR("Invalid GL command %u with %u lanes!", commandID, laneCount);
+                return false;
             }
-            JSB_GL_CHECK_VOID(glUniform1iv((GLint)p[1], elementCount, intBuf));
-            free(intBuf);
-            p += (elementCount + 3);
-        }
-        else if (commandID == GL_COMMAND_UNIFORM_2IV) {
-            LOG_GL_COMMAND("Flush: UNIFORM_2IV\n");
-            GLsizei elementCount = (GLsizei)p[2];
-            GLint* intBuf = (GLint*)malloc(elementCount * sizeof(GLint));
-            for (GLsizei i = 0; i < elementCount; ++i)
+
+            const GLCommandInfo& info = __glCommands[commandID];
+            if (info.hasArray ? (laneCount < info.fixedLaneCount || (uint32_t)args[info.fixedLaneCount - 1].i != laneCount - info.fixedLaneCount)
+                              : laneCount != info.fixedLaneCount)
             {
-                intBuf[i] = p[3+i];
+                SE_REPORT_ERROR("Invalid lane count %u of GL command %s!", laneCount, info.name);
+                return false;
             }
-            JSB_GL_CHECK_VOID(glUniform2iv((GLint)p[1], elementCount / 2, intBuf));
-            free(intBuf);
-            p += (elementCount + 3);
+
+            executeGLCommand(commandID, args);
         }
-        else if (commandID == GL_COMMAND_UNIFORM_3IV) {
-            LOG_GL_COMMAND("Flush: UNIFORM_3IV\n");
-            GLsizei elementCount = (GLsizei)p[2];
-            GLint* intBuf = (GLint*)malloc(elementCount * sizeof(GLint));
-            for (GLsizei i = 0; i < elementCount; ++i)
+        return true;
+    }
+
+    bool flushLegacyCommands(const float* p, const float* end, uint32_t* handledCommandCount)
+    {
+        std::vector<GLCommandLane>& lanes = __legacyCommandLanes;
+        GLCommandLane lane;
+
+        while (p < end)
+        {
+            uint32_t commandID = (uint32_t)p[0];
+            ++p;
+            if (!isValidGLCommand(commandID))
             {
-                intBuf[i] = p[3+i];
+                SE_REPORT_ERROR("Invalid GL command %u!", commandID);
+                return false;
             }
-            JSB_GL_CHECK_VOID(glUniform3iv((GLint)p[1], elementCount / 3, intBuf));
-            free(intBuf);
-            p += (elementCount + 3);
-        }
-        else if (commandID == GL_COMMAND_UNIFORM_4IV) {
-            LOG_GL_COMMAND("Flush: UNIFORM_4IV\n");
-            GLsizei elementCount = (GLsizei)p[2];
-            GLint* intBuf = (GLint*)malloc(elementCount * sizeof(GLint));
-            for (GLsizei i = 0; i < elementCount; ++i)
+
+            lanes.clear();
+            for (const char* c = __glCommands[commandID].signature; *c != '\0' && p < end; ++c)
             {
-                intBuf[i] = p[3+i];
+                if (*c == 'u')
+                    lane.u = (GLuint)*p++;
+                else if (*c == 'i')
+                    lane.i = (GLint)*p++;
+                else if (*c == 'f')
+                    lane.f = *p++;
+                else
+                {
+                    GLsizei elementCount = (GLsizei)*p++;
+                    if (elementCount < 0 || elementCount > end - p)
+                    {
+                        SE_REPORT_ERROR("Invalid element count %d of GL command %s!", (int)elementCount, __glCommands[commandID].name);
+                        return false;
+                    }
+                    lane.i = elementCount;
+                    lanes.push_back(lane);
+                    for (GLsizei i = 0; i < elementCount; ++i)
+                    {
+                        if (*c == 'F')
+                            lane.f = *p++;
+                        else
+                            lane.i = (GLint)*p++;
+                        lanes.push_back(lane);
+                    }
+                    continue;
+                }
+                lanes.push_back(lane);
             }
-            JSB_GL_CHECK_VOID(glUniform4iv((GLint)p[1], elementCount / 4, intBuf));
-            free(intBuf);
-            p += (elementCount + 3);
-        }
-        else if (commandID == GL_COMMAND_UNIFORM_MATRIX_2FV) {
-            LOG_GL_COMMAND("Flush: UNIFORM_MATRIX_2FV\n");
-            GLsizei elementCount = (GLsizei)p[3];
-            JSB_GL_CHECK_VOID(glUniformMatrix2fv((GLint)p[1], elementCount / 4, (GLboolean)p[2], &p[4]));
-            p += (elementCount + 4);
-        }
-        else if (commandID == GL_COMMAND_UNIFORM_MATRIX_3FV) {
-            LOG_GL_COMMAND("Flush: UNIFORM_MATRIX_3FV\n");
-            GLsizei elementCount = (GLsizei)p[3];
-            JSB_GL_CHECK_VOID(glUniformMatrix3fv((GLint)p[1], elementCount / 9, (GLboolean)p[2], &p[4]));
-            p += (elementCount + 4);
-        }
-        else if (commandID == GL_COMMAND_UNIFORM_MATRIX_4FV) {
-            LOG_GL_COMMAND("Flush: UNIFORM_MATRIX_4FV\n");
-            GLsizei elementCount = (GLsizei)p[3];
-            JSB_GL_CHECK_VOID(glUniformMatrix4fv((GLint)p[1], elementCount / 16, (GLboolean)p[2], &p[4]));
-            p += (elementCount + 4);
-        }
-        else if (commandID == GL_COMMAND_USE_PROGRAM) {
-            LOG_GL_COMMAND("Flush: USE_PROGRAM\n");
-            JSB_GL_CHECK_VOID(glUseProgram((GLuint) p[1]));
-            p += 2;
-        }
-        else if (commandID == GL_COMMAND_VALIDATE_PROGRAM) {
-            LOG_GL_COMMAND("Flush: VALIDATE_PROGRAM\n");
-            JSB_GL_CHECK_VOID(glValidateProgram((GLuint) p[1]));
-            p += 2;
-        }
-        else if (commandID == GL_COMMAND_VERTEX_ATTRIB_1F) {
-            LOG_GL_COMMAND("Flush: VERTEX_ATTRIB_1F\n");
-            JSB_GL_CHECK_VOID(glVertexAttrib1f((GLuint)p[1], p[2]));
-            p += 3;
-        }
-        else if (commandID == GL_COMMAND_VERTEX_ATTRIB_2F) {
-            LOG_GL_COMMAND("Flush: VERTEX_ATTRIB_2F\n");
-            JSB_GL_CHECK_VOID(glVertexAttrib2f((GLuint)p[1], p[2], p[3]));
-            p += 4;
-        }
-        else if (commandID == GL_COMMAND_VERTEX_ATTRIB_3F) {
-            LOG_GL_COMMAND("Flush: VERTEX_ATTRIB_3F\n");
-            JSB_GL_CHECK_VOID(glVertexAttrib3f((GLuint)p[1], p[2], p[3], p[4]));
-            p += 5;
-        }
-        else if (commandID == GL_COMMAND_VERTEX_ATTRIB_4F) {
-            LOG_GL_COMMAND("Flush: VERTEX_ATTRIB_4F\n");
-            JSB_GL_CHECK_VOID(glVertexAttrib4f((GLuint)p[1], p[2], p[3], p[4], p[5]));
-            p += 6;
-        }
-        else if (commandID == GL_COMMAND_VERTEX_ATTRIB_1FV) {
-            LOG_GL_COMMAND("Flush: VERTEX_ATTRIB_1FV\n");
-            GLsizei elementCount = (GLsizei)p[2];
-            JSB_GL_CHECK_VOID(glVertexAttrib1fv((GLint)p[1], &p[3]));
-            p += (elementCount + 3);
-        }
-        else if (commandID == GL_COMMAND_VERTEX_ATTRIB_2FV) {
-            LOG_GL_COMMAND("Flush: VERTEX_ATTRIB_2FV\n");
-            GLsizei elementCount = (GLsizei)p[2];
-            JSB_GL_CHECK_VOID(glVertexAttrib2fv((GLint)p[1], &p[3]));
-            p += (elementCount + 3);
-        }
-        else if (commandID == GL_COMMAND_VERTEX_ATTRIB_3FV) {
-            LOG_GL_COMMAND("Flush: VERTEX_ATTRIB_3FV\n");
-            GLsizei elementCount = (GLsizei)p[2];
-            JSB_GL_CHECK_VOID(glVertexAttrib3fv((GLint)p[1], &p[3]));
-            p += (elementCount + 3);
-        }
-        else if (commandID == GL_COMMAND_VERTEX_ATTRIB_4FV) {
-            LOG_GL_COMMAND("Flush: VERTEX_ATTRIB_4FV\n");
-            GLsizei elementCount = (GLsizei)p[2];
-            JSB_GL_CHECK_VOID(glVertexAttrib4fv((GLint)p[1], &p[3]));
-            p += (elementCount + 3);
-        }
-        else if (commandID == GL_COMMAND_VERTEX_ATTRIB_POINTER) {
-            LOG_GL_COMMAND("Flush: VERTEX_ATTRIB_POINTER\n");
-            JSB_GL_CHECK_VOID(ccVertexAttribPointer((GLuint)p[1], (GLint)p[2], (GLenum)p[3], (GLboolean)p[4], (GLsizei)p[5], (const GLvoid*)(GLintptr)p[6]));
-            p += 7;
-        }
-        else if (commandID == GL_COMMAND_VIEW_PORT) {
-            LOG_GL_COMMAND("Flush: VIEW_PORT\n");
-            JSB_GL_CHECK_VOID(ccViewport((GLint)p[1], (GLint)p[2], (GLsizei)p[3], (GLsizei)p[4]));
-            p += 5;
-        }
-        else {
-            assert(false);
+
+            if (lanes.size() < __glCommands[commandID].fixedLaneCount)
+            {
+                SE_REPORT_ERROR("Truncated GL command %s!", __glCommands[commandID].name);
+                return false;
+            }
+
+            executeGLCommand(commandID, lanes.data());
+            ++(*handledCommandCount);
         }
+        return true;
     }
+}
+
+static bool JSB_glFlushCommand(se::State& s) {
+    const auto& args = s.args();
+    int argc = (int)args.size();
+    SE_PRECONDITION2(argc == 3, false, "Invalid number of arguments" );
+
+    bool ok = false;
+    uint32_t floatValueCount = 0;
+    ok = seval_to_uint32(args[0], &floatValueCount);
+    SE_PRECONDITION2(ok, false, "arg0 isn't a number!");
+    GLsizei count = 0;
+    GLvoid* data = nullptr;
+    ok = JSB_get_arraybufferview_dataptr(args[1], &count, &data);
+    SE_PRECONDITION2(ok, false, "Convert arg1 as typed array failed!");
+    SE_PRECONDITION2(floatValueCount * sizeof(float) <= (uint32_t)count, false, "arg0 is out of range!");
+
+    uint32_t commandCount = 0;
+    ok = seval_to_uint32(args[2], &commandCount);
+    SE_PRECONDITION2(ok, false, "arg2 isn't a number!");
+
+    const float* p = (const float*)data;
+    uint32_t handledCommandCount = 0;
+
+    __streamState.reset();
+    ok = flushLegacyCommands(p, p + floatValueCount, &handledCommandCount);
+    SE_PRECONDITION2(ok, false, "Flush GL commands failed!");
 
     assert(handledCommandCount == commandCount);
 
@@ -4397,9 +4623,65 @@ static bool JSB_glFlushCommand(se::State& s) {
 }
 SE_BIND_FUNC(JSB_glFlushCommand)
 
+static bool JSB_glFlushCommandStream(se::State& s) {
+    const auto& args = s.args();
+    int argc = (int)args.size();
+    SE_PRECONDITION2(argc == 2, false, "Invalid number of arguments" );
+
+    bool ok = false;
+    GLsizei count = 0;
+    GLvoid* data = nullptr;
+    ok = JSB_get_arraybufferview_dataptr(args[0], &count, &data);
+    SE_PRECONDITION2(ok, false, "Convert arg0 as typed array failed!");
+
+    uint32_t laneCount = 0;
+    ok = seval_to_uint32(args[1], &laneCount);
+    SE_PRECONDITION2(ok, false, "arg1 isn't a number!");
+    SE_PRECONDITION2(laneCount > 0 && laneCount * sizeof(GLCommandLane) <= (uint32_t)count, false, "arg1 is out of range!");
+
+    const GLCommandLane* p = (const GLCommandLane*)data;
+    uint32_t header = p[0].u;
+    SE_PRECONDITION2((header >> 16) == GL_COMMAND_STREAM_MAGIC && (header & 0xFFFF) == GL_COMMAND_STREAM_VERSION, false,
+                     "Unsupported GL command stream header!");
+
+    __streamState.reset();
+    ok = flushCommandStream(p + 1, p + laneCount);
+    SE_PRECONDITION2(ok, false, "Flush GL command stream failed!");
+
+    return true;
+}
+SE_BIND_FUNC(JSB_glFlushCommandStream)
+
+// Returns { <command name>: { issued: <count>, skipped: <count> } } for every command flushed since the last reset.
+static bool JSB_glGetCommandCounters(se::State& s) {
+    se::HandleObject obj(se::Object::createPlainObject());
+    for (uint32_t i = 0; i < GL_COMMAND_COUNT; ++i)
+    {
+        uint32_t issued = __glCommandCounters.issued[i];
+        uint32_t skipped = __glCommandCounters.skipped[i];
+        if (issued == 0 && skipped == 0)
+            continue;
+
+        se::HandleObject counter(se::Object::createPlainObject());
+        counter->setProperty("issued", se::Value(issued));
+        counter->setProperty("skipped", se::Value(skipped));
+        obj->setProperty(__glCommands[i].name, se::Value(counter));
+    }
+    s.rval().setObject(obj);
+    return true;
+}
+SE_BIND_FUNC(JSB_glGetCommandCounters)
+
+static bool JSB_glResetCommandCounters(se::State& s) {
+    memset(&__glCommandCounters, 0, sizeof(__glCommandCounters));
+    return true;
+}
+SE_BIND_FUNC(JSB_glResetCommandCounters)
+
 bool JSB_register_opengl(se::Object* obj)
 {
     glGetIntegerv(GL_FRAMEBUFFER_BINDING, &__defaultFbo);
+    initGLCommands();
 
     __jsb_WebGLObject_class = se::Class::create("WebGLObject", obj, nullptr, nullptr);
     __jsb_WebGLObject_class->install();
@@ -4569,6 +4851,10 @@ bool JSB_register_opengl(se::Object* obj)
 
     // NOT WEBGL standard functions
     __glObj->defineFunction("_flushCommands", _SE(JSB_glFlushCommand));
+    __glObj->defineFunction("_flushCommandStream", _SE(JSB_glFlushCommandStream));
+    __glObj->defineFunction("_getCommandCounters", _SE(JSB_glGetCommandCounters));
+    __glObj->defineFunction("_resetCommandCounters", _SE(JSB_glResetCommandCounters));
+    __glObj->setProperty("_COMMAND_STREAM_VERSION", se::Value(GL_COMMAND_STREAM_VERSION));
 
     se::ScriptEngine::getInstance()->addBeforeCleanupHook([](){
         __shaders.clear();
@@ -457,12 +457,13 @@ static void _addModelsFromTypedArray(cocos2d::renderer::Scene* scene, se::Object
     floatPtr += 2;
     cocos2d::Mat4 worldMatrix;
     cocos2d::renderer::InputAssembler ia;
+    
+    // In retained mode the models of last frame are updated in place, only changed ones become dirty.
+    uint32_t retainedCount = scene->isRetainedMode() ? scene->getModelCount() : 0;
     for (size_t i = 0; i < numOfModels; ++i)
     {
-        auto model = cocos2d::renderer::ModelPool::getOrCreateModel();
-        
         unsigned long addr = (unsigned long)(*doublePtr++);
-        model->addEffect(reinterpret_cast<cocos2d::renderer::Effect*>(addr));
+        auto effect = reinterpret_cast<cocos2d::renderer::Effect*>(addr);
         addr = (unsigned long)(*doublePtr++);
         ia.setVertexBuffer(reinterpret_cast<cocos2d::renderer::VertexBuffer*>(addr));
         addr = (unsigned long)(*doublePtr++);
@@ -470,21 +471,58 @@ static void _addModelsFromTypedArray(cocos2d::renderer::Scene* scene, se::Object
         
         floatPtr += 6;
         
-        model->setDynamicIA((bool)*floatPtr++);
-        model->setViewId((int)*floatPtr++);
+        bool dynamicIA = (bool)*floatPtr++;
+        int viewId = (int)*floatPtr++;
         
         memcpy(worldMatrix.m, floatPtr, 16);
-        model->setWorldMatix(worldMatrix);
         floatPtr += 16;
         
         ia.setStart(*floatPtr++);
         ia.setCount(*floatPtr++);
-        model->addInputAssembler(ia);
-        
-        scene->addModel(model);
         
         doublePtr += 10;
+        
+        if (i < retainedCount)
+        {
+            auto model = scene->getModel((uint32_t)i);
+            
+            if (1 != model->getEffectCount() || model->getEffect(0) != effect)
+            {
+                model->clearEffects();
+                model->addEffect(effect);
+            }
+            
+            if (1 != model->getInputAssemblerCount() ||
+                model->getInputAssembler(0).getVertexBuffer() != ia.getVertexBuffer() ||
+                model->getInputAssembler(0).getIndexBuffer() != ia.getIndexBuffer() ||
+                model->getInputAssembler(0).getStart() != ia.getStart() ||
+                model->getInputAssembler(0).getCount() != ia.getCount())
+            {
+                model->clearInputAssemblers();
+                model->addInputAssembler(ia);
+            }
+            
+            model->setDynamicIA(dynamicIA);
+            model->setViewId(viewId);
+            
+            if (0 != memcmp(model->getWorldMatrix().m, worldMatrix.m, sizeof(worldMatrix.m)))
+                model->setWorldMatix(worldMatrix);
+        }
+        else
+        {
+            auto model = cocos2d::renderer::ModelPool::getOrCreateModel();
+            model->addEffect(effect);
+            model->setDynamicIA(dynamicIA);
+            model->setViewId(viewId);
+            model->setWorldMatix(worldMatrix);
+            model->addInputAssembler(ia);
+            
+            scene->addModel(model);
+        }
     }
+    
+    if (retainedCount > (uint32_t)numOfModels)
+        scene->removeModelsFrom((uint32_t)numOfModels);
 }
 
 static bool js_renderer_ForwardRenderer_render(se::State& s)
@@ -135,7 +135,19 @@ void JSB_WebSocketDelegate::onMessage(WebSocket* ws, const WebSocket::Data& data
 
         if (data.isBinary)
         {
-            se::HandleObject dataObj(se::Object::createArrayBufferObject(data.bytes, data.len));
+            se::Object* arrayBuffer = nullptr;
+            if (data.owner != nullptr)
+            {
+                // Hand the frame over to JS without copying, it's kept alive until the Array Buffer is collected.
+                arrayBuffer = se::Object::createExternalArrayBufferObject(data.bytes, data.len, [](void* contents, size_t byteLength, void* userData){
+                    delete static_cast<std::shared_ptr<void>*>(userData);
+                }, new std::shared_ptr<void>(data.owner));
+            }
+            else
+            {
+                arrayBuffer = se::Object::createArrayBufferObject(data.bytes, data.len);
+            }
+            se::HandleObject dataObj(arrayBuffer);
             jsObj->setProperty("data", se::Value(dataObj));
         }
         else
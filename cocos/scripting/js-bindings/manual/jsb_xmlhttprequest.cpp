@@ -37,6 +37,7 @@
 #include <functional>
 #include <algorithm>
 #include <sstream>
+#include <memory>
 #include "cocos/scripting/js-bindings/jswrapper/SeApi.h"
 #include "cocos/scripting/js-bindings/manual/jsb_conversions.hpp"
 #include "cocos/network/HttpClient.h"
@@ -93,7 +94,7 @@ public:
     uint16_t getStatus() const { return _status; }
     const std::string& getStatusText() const { return _statusText; }
     const std::string& getResponseText() const { return _responseText; }
-    const cocos2d::Data& getResponseData() const { return _responseData; }
+    const std::shared_ptr<std::vector<char>>& getResponseBuffer() const { return _responseBuffer; }
     ResponseType getResponseType() const { return _responseType; }
     void setResponseType(ResponseType type) { _responseType = type; }
 
@@ -124,7 +125,8 @@ private:
     std::string _responseXML;
     std::string _statusText;
 
-    cocos2d::Data _responseData;
+    // Shared with the Array Buffers created from it, so the response is never copied.
+    std::shared_ptr<std::vector<char>> _responseBuffer;
 
     cocos2d::network::HttpRequest*  _httpRequest;
 //    cocos2d::EventListenerCustom* _resetDirectorListener;
@@ -359,7 +361,7 @@ void XMLHttpRequest::onResponse(HttpClient* client, HttpResponse* response)
     sprintf(statusString, "HTTP Status Code: %ld, tag = %s", statusCode, tag.c_str());
 
     _responseText.clear();
-    _responseData.clear();
+    _responseBuffer.reset();
 
     if (!response->isSucceed())
     {
@@ -405,7 +407,8 @@ void XMLHttpRequest::onResponse(HttpClient* client, HttpResponse* response)
     }
     else
     {
-        _responseData.copy((unsigned char*)buffer->data(), buffer->size());
+        _responseBuffer = std::make_shared<std::vector<char>>();
+        _responseBuffer->swap(*buffer);
     }
 
     _status = statusCode;
@@ -877,8 +880,15 @@ static bool XMLHttpRequest_getResponse(se::State& s)
             }
             else if (xhr->getResponseType() == XMLHttpRequest::ResponseType::ARRAY_BUFFER)
             {
-                const Data& data = xhr->getResponseData();
-                se::HandleObject seObj(se::Object::createArrayBufferObject(data.getBytes(), data.getSize()));
+                const auto& buffer = xhr->getResponseBuffer();
+                se::Object* arrayBuffer = nullptr;
+                if (buffer != nullptr)
+                {
+                    arrayBuffer = se::Object::createExternalArrayBufferObject(buffer->data(), buffer->size(), [](void* contents, size_t byteLength, void* userData){
+                        delete static_cast<std::shared_ptr<std::vector<char>>*>(userData);
+                    }, new std::shared_ptr<std::vector<char>>(buffer));
+                }
+                se::HandleObject seObj(arrayBuffer);
                 if (!seObj.isEmpty())
                 {
                     s.rval().setObject(seObj);
@@ -25,10 +25,14 @@
  ****************************************************************************/
 #include "AssetsManagerEx.h"
 #include "base/ccUTF8.h"
-#include "CCAsyncTaskPool.h"
+#include "base/CCScheduler.h"
+#include "platform/CCApplication.h"
 
 #include <stdio.h>
 #include <errno.h>
+#include <string.h>
+#include <ctype.h>
+#include <thread>
 
 #ifdef MINIZIP_FROM_SYSTEM
 #include <minizip/unzip.h>
@@ -40,16 +44,199 @@ NS_CC_EXT_BEGIN
 
 #define VERSION_FILENAME        "version.manifest"
 #define TEMP_MANIFEST_FILENAME  "project.manifest.temp"
+#define TEMP_JOURNAL_FILENAME   "project.manifest.journal"
 #define TEMP_PACKAGE_SUFFIX     "_temp"
 #define MANIFEST_FILENAME       "project.manifest"
 
-#define BUFFER_SIZE    8192
+#define BUFFER_SIZE    65536
 #define MAX_FILENAME   512
+#define DECOMPRESS_TEMP_SUFFIX  ".unzip"
+#define MAX_POST_PROCESS_THREADS 4
 
 #define DEFAULT_CONNECTION_TIMEOUT 45
 
 #define SAVE_POINT_INTERVAL 0.1
 
+namespace {
+
+// RFC 1321 MD5, only used to verify downloaded assets
+class MD5
+{
+public:
+    MD5()
+    : _length(0)
+    {
+        _state[0] = 0x67452301;
+        _state[1] = 0xefcdab89;
+        _state[2] = 0x98badcfe;
+        _state[3] = 0x10325476;
+    }
+
+    void update(const unsigned char* data, size_t length)
+    {
+        size_t used = (size_t)(_length & 63);
+        _length += length;
+
+        if (used > 0)
+        {
+            size_t fill = std::min(length, (size_t)64 - used);
+            memcpy(_buffer + used, data, fill);
+            data += fill;
+            length -= fill;
+            if (used + fill < 64)
+                return;
+            transform(_buffer);
+        }
+
+        for (; length >= 64; data += 64, length -= 64)
+            transform(data);
+
+        if (length > 0)
+            memcpy(_buffer, data, length);
+    }
+
+    std::string hexDigest()
+    {
+        static const unsigned char padding[64] = { 0x80 };
+        unsigned char bits[8];
+        uint64_t bitLength = _length * 8;
+        for (int i = 0; i < 8; ++i)
+            bits[i] = (unsigned char)(bitLength >> (i * 8));
+
+        size_t used = (size_t)(_length & 63);
+        update(padding, used < 56 ? 56 - used : 120 - used);
+        update(bits, 8);
+
+        static const char hexChars[] = "0123456789abcdef";
+        std::string digest(32, '0');
+        for (int i = 0; i < 16; ++i)
+        {
+            unsigned char byte = (unsigned char)(_state[i / 4] >> ((i % 4) * 8));
+            digest[i * 2] = hexChars[byte >> 4];
+            digest[i * 2 + 1] = hexChars[byte & 0x0f];
+        }
+        return digest;
+    }
+
+private:
+    static inline uint32_t rotateLeft(uint32_t x, int n)
+    {
+        return (x << n) | (x >> (32 - n));
+    }
+
+    void transform(const unsigned char* block)
+    {
+        static const uint32_t K[64] = {
+            0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+            0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+            0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+            0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+            0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+            0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+            0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+            0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
+        };
+        static const int R[64] = {
+            7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+            5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20,
+            4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+            6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21
+        };
+
+        uint32_t M[16];
+        for (int i = 0; i < 16; ++i)
+        {
+            M[i] = (uint32_t)block[i * 4] | ((uint32_t)block[i * 4 + 1] << 8) |
+                   ((uint32_t)block[i * 4 + 2] << 16) | ((uint32_t)block[i * 4 + 3] << 24);
+        }
+
+        uint32_t a = _state[0], b = _state[1], c = _state[2], d = _state[3];
+        for (int i = 0; i < 64; ++i)
+        {
+            uint32_t f;
+            int g;
+            if (i < 16)
+            {
+                f = (b & c) | (~b & d);
+                g = i;
+            }
+            else if (i < 32)
+            {
+                f = (d & b) | (~d & c);
+                g = (5 * i + 1) & 15;
+            }
+            else if (i < 48)
+            {
+                f = b ^ c ^ d;
+                g = (3 * i + 5) & 15;
+            }
+            else
+            {
+                f = c ^ (b | ~d);
+                g = (7 * i) & 15;
+            }
+
+            uint32_t temp = d;
+            d = c;
+            c = b;
+            b = b + rotateLeft(a + f + K[i] + M[g], R[i]);
+            a = temp;
+        }
+
+        _state[0] += a;
+        _state[1] += b;
+        _state[2] += c;
+        _state[3] += d;
+    }
+
+    uint32_t _state[4];
+    uint64_t _length;
+    unsigned char _buffer[64];
+};
+
+bool computeFileMD5(const std::string& path, std::string* hexDigest)
+{
+    FILE* fp = fopen(cocos2d::FileUtils::getInstance()->getSuitableFOpen(path).c_str(), "rb");
+    if (fp == nullptr)
+        return false;
+
+    MD5 md5;
+    std::vector<unsigned char> buffer(BUFFER_SIZE);
+    size_t readSize = 0;
+    while ((readSize = fread(buffer.data(), 1, buffer.size(), fp)) > 0)
+    {
+        md5.update(buffer.data(), readSize);
+    }
+    bool ok = ferror(fp) == 0;
+    fclose(fp);
+
+    if (ok)
+        *hexDigest = md5.hexDigest();
+    return ok;
+}
+
+bool md5Equals(const std::string& digest, const std::string& expected)
+{
+    if (digest.size() != expected.size())
+        return false;
+
+    for (size_t i = 0; i < digest.size(); ++i)
+    {
+        if (digest[i] != tolower((unsigned char)expected[i]))
+            return false;
+    }
+    return true;
+}
+
+int getPostProcessThreadCount()
+{
+    // Keep one core for the cocos thread
+    int cores = (int)std::thread::hardware_concurrency();
+    return std::max(1, std::min(MAX_POST_PROCESS_THREADS, cores - 1));
+}
+
+} // end of anonymous namespace
+
 const std::string AssetsManagerEx::VERSION_ID = "@version";
 const std::string AssetsManagerEx::MANIFEST_ID = "@manifest";
 
@@ -79,6 +266,8 @@ AssetsManagerEx::AssetsManagerEx(const std::string& manifestUrl, const std::stri
 , _currConcurrentTask(0)
 , _verifyCallback(nullptr)
 , _inited(false)
+, _md5Verification(false)
+, _postProcessCanceled(std::make_shared<std::atomic<bool>>(false))
 {
     init(manifestUrl, storagePath);
 }
@@ -109,6 +298,8 @@ AssetsManagerEx::AssetsManagerEx(const std::string& manifestUrl, const std::stri
 , _verifyCallback(nullptr)
 , _eventCallback(nullptr)
 , _inited(false)
+, _md5Verification(false)
+, _postProcessCanceled(std::make_shared<std::atomic<bool>>(false))
 {
     init(manifestUrl, storagePath);
 }
@@ -143,6 +334,7 @@ void AssetsManagerEx::init(const std::string& manifestUrl, const std::string& st
     _tempVersionPath = _tempStoragePath + VERSION_FILENAME;
     _cacheManifestPath = _storagePath + MANIFEST_FILENAME;
     _tempManifestPath = _tempStoragePath + TEMP_MANIFEST_FILENAME;
+    _tempJournalPath = _tempStoragePath + TEMP_JOURNAL_FILENAME;
 
     if (manifestUrl.size() > 0)
     {
@@ -152,6 +344,10 @@ void AssetsManagerEx::init(const std::string& manifestUrl, const std::string& st
 
 AssetsManagerEx::~AssetsManagerEx()
 {
+    // Queued post processing tasks return immediately, the pool destructor waits for the running ones
+    *_postProcessCanceled = true;
+    _postProcessPool.reset();
+
     _downloader->onTaskError = (nullptr);
     _downloader->onFileTaskSuccess = (nullptr);
     _downloader->onTaskProgress = (nullptr);
@@ -194,6 +390,11 @@ void AssetsManagerEx::initManifests()
                 CC_SAFE_RELEASE(_tempManifest);
                 _tempManifest = nullptr;
             }
+            // Recover the download states recorded since the manifest was last saved
+            else
+            {
+                _tempManifest->loadJournal(_tempJournalPath);
+            }
         }
     }
     else
@@ -246,6 +447,8 @@ bool AssetsManagerEx::loadLocalManifest(Manifest* localManifest, const std::stri
         _tempVersionPath = _tempStoragePath + VERSION_FILENAME;
         _cacheManifestPath = _storagePath + MANIFEST_FILENAME;
         _tempManifestPath = _tempStoragePath + TEMP_MANIFEST_FILENAME;
+        _tempJournalPath = _tempStoragePath + TEMP_JOURNAL_FILENAME;
+    _tempJournalPath = _tempStoragePath + TEMP_JOURNAL_FILENAME;
     }
     // Release existing local manifest
     if (_localManifest)
@@ -483,6 +686,16 @@ void AssetsManagerEx::adjustPath(std::string &path)
     }
 }
 
+void AssetsManagerEx::removeDecompressTempFile(const std::string &tempPath)
+{
+    // A temp file that can't be removed now is removed before the temp storage is merged
+    if (_fileUtils->removeFile(tempPath))
+    {
+        std::lock_guard<std::mutex> lock(_decompressTempFilesMutex);
+        _decompressTempFiles.erase(tempPath);
+    }
+}
+
 bool AssetsManagerEx::decompress(const std::string &zip)
 {
     // Find root path for zip file
@@ -511,8 +724,9 @@ bool AssetsManagerEx::decompress(const std::string &zip)
         return false;
     }
 
-    // Buffer to hold data read from the zip file
-    char readBuffer[BUFFER_SIZE];
+    // Buffer to hold data read from the zip file, several archives can be decompressed at the same time
+    std::vector<char> readBuffer(BUFFER_SIZE);
+    std::string lastDir;
     // Loop to extract all files.
     uLong i;
     for (i = 0; i < global_info.number_entry; ++i)
@@ -551,9 +765,9 @@ bool AssetsManagerEx::decompress(const std::string &zip)
         }
         else
         {
-            // Create all directories in advance to avoid issue
+            // Create all directories in advance to avoid issue, entries of a directory are usually listed together
             std::string dir = basename(fullPath);
-            if (!_fileUtils->isDirectoryExist(dir)) {
+            if (dir != lastDir && !_fileUtils->isDirectoryExist(dir)) {
                 if (!_fileUtils->createDirectory(dir)) {
                     // Failed to create directory
                     CCLOG("AssetsManagerEx : can not create directory %s\n", fullPath.c_str());
@@ -561,6 +775,7 @@ bool AssetsManagerEx::decompress(const std::string &zip)
                     return false;
                 }
             }
+            lastDir = dir;
             // Entry is a file, so extract it.
             // Open current file.
             if (unzOpenCurrentFile(zipfile) != UNZ_OK)
@@ -570,11 +785,18 @@ bool AssetsManagerEx::decompress(const std::string &zip)
                 return false;
             }
 
-            // Create a file to store current file.
-            FILE *out = fopen(FileUtils::getInstance()->getSuitableFOpen(fullPath).c_str(), "wb");
-            if (!out)
+            // Create a file to store current file, it only takes the destination name once fully written,
+            // so an interrupted update never leaves a truncated file behind.
+            const std::string tempPath = fullPath + DECOMPRESS_TEMP_SUFFIX;
+            FILE *out = fopen(FileUtils::getInstance()->getSuitableFOpen(tempPath).c_str(), "wb");
+            if (out)
             {
-                CCLOG("AssetsManagerEx : can not create decompress destination file %s (errno: %d)\n", fullPath.c_str(), errno);
+                std::lock_guard<std::mutex> lock(_decompressTempFilesMutex);
+                _decompressTempFiles.insert(tempPath);
+            }
+            else
+            {
+                CCLOG("AssetsManagerEx : can not create decompress destination file %s (errno: %d)\n", tempPath.c_str(), errno);
                 unzCloseCurrentFile(zipfile);
                 unzClose(zipfile);
                 return false;
@@ -582,25 +804,53 @@ bool AssetsManagerEx::decompress(const std::string &zip)
 
             // Write current file content to destinate file.
             int error = UNZ_OK;
+            bool written = true;
             do
             {
-                error = unzReadCurrentFile(zipfile, readBuffer, BUFFER_SIZE);
+                error = unzReadCurrentFile(zipfile, readBuffer.data(), (unsigned)readBuffer.size());
                 if (error < 0)
                 {
                     CCLOG("AssetsManagerEx : can not read zip file %s, error code is %d\n", fileName, error);
                     fclose(out);
+                    removeDecompressTempFile(tempPath);
                     unzCloseCurrentFile(zipfile);
                     unzClose(zipfile);
                     return false;
                 }
 
-                if (error > 0)
+                if (error > 0 && fwrite(readBuffer.data(), error, 1, out) != 1)
                 {
-                    fwrite(readBuffer, error, 1, out);
+                    written = false;
+                    break;
                 }
             } while(error > 0);
 
-            fclose(out);
+            if (fclose(out) != 0 || !written)
+            {
+                CCLOG("AssetsManagerEx : can not write decompress destination file %s (errno: %d)\n", tempPath.c_str(), errno);
+                removeDecompressTempFile(tempPath);
+                unzCloseCurrentFile(zipfile);
+                unzClose(zipfile);
+                return false;
+            }
+
+            if (_fileUtils->isFileExist(fullPath))
+            {
+                _fileUtils->removeFile(fullPath);
+            }
+            if (_fileUtils->renameFile(tempPath, fullPath))
+            {
+                std::lock_guard<std::mutex> lock(_decompressTempFilesMutex);
+                _decompressTempFiles.erase(tempPath);
+            }
+            else
+            {
+                CCLOG("AssetsManagerEx : can not move decompressed file to %s\n", fullPath.c_str());
+                removeDecompressTempFile(tempPath);
+                unzCloseCurrentFile(zipfile);
+                unzClose(zipfile);
+                return false;
+            }
         }
 
         unzCloseCurrentFile(zipfile);
@@ -621,43 +871,71 @@ bool AssetsManagerEx::decompress(const std::string &zip)
     return true;
 }
 
-void AssetsManagerEx::decompressDownloadedZip(const std::string &customId, const std::string &storagePath)
+void AssetsManagerEx::postProcessDownloadedAsset(const std::string &customId, const std::string &storagePath, const std::string &md5, bool compressed)
 {
-    struct AsyncData
+    enum class Result
     {
-        std::string customId;
-        std::string zipFile;
-        bool succeed;
+        SUCCEED,
+        VERIFY_FAILED,
+        DECOMPRESS_FAILED
     };
 
-    AsyncData* asyncData = new AsyncData;
-    asyncData->customId = customId;
-    asyncData->zipFile = storagePath;
-    asyncData->succeed = false;
+    if (_postProcessPool == nullptr)
+    {
+        _postProcessPool.reset(experimental::ThreadPool::newFixedThreadPool(getPostProcessThreadCount()));
+    }
+
+    // Release the download slot now so that the next downloads overlap with hashing and decompressing,
+    // it is taken back right before fileSuccess or fileError releases it.
+    _currConcurrentTask = std::max(0, _currConcurrentTask-1);
+    queueDowload();
+
+    auto canceled = _postProcessCanceled;
+    _postProcessPool->pushTask([this, canceled, customId, storagePath, md5, compressed](int /*threadId*/) {
+        if (*canceled)
+            return;
 
-    std::function<void(void*)> decompressFinished = [this](void* param) {
-        auto dataInner = reinterpret_cast<AsyncData*>(param);
-        if (dataInner->succeed)
+        Result result = Result::SUCCEED;
+        if (!md5.empty())
         {
-            fileSuccess(dataInner->customId, dataInner->zipFile);
+            std::string digest;
+            if (!computeFileMD5(storagePath, &digest) || !md5Equals(digest, md5))
+            {
+                result = Result::VERIFY_FAILED;
+            }
         }
-        else
+
+        if (result == Result::SUCCEED && compressed && !decompress(storagePath))
         {
-            std::string errorMsg = "Unable to decompress file " + dataInner->zipFile;
-            // Ensure zip file deletion (if decompress failure cause task thread exit anormally)
-            _fileUtils->removeFile(dataInner->zipFile);
-            dispatchUpdateEvent(EventAssetsManagerEx::EventCode::ERROR_DECOMPRESS, "", errorMsg);
-            fileError(dataInner->customId, errorMsg);
+            result = Result::DECOMPRESS_FAILED;
         }
-        delete dataInner;
-    };
-    AsyncTaskPool::getInstance()->enqueue(AsyncTaskPool::TaskType::TASK_OTHER, decompressFinished, (void*)asyncData, [this, asyncData]() {
-        // Decompress all compressed files
-        if (decompress(asyncData->zipFile))
+
+        // Compressed packages and corrupted files are useless from now on
+        if (compressed || result != Result::SUCCEED)
         {
-            asyncData->succeed = true;
+            _fileUtils->removeFile(storagePath);
         }
-        _fileUtils->removeFile(asyncData->zipFile);
+
+        Application::getInstance()->getScheduler()->performFunctionInCocosThread([this, canceled, customId, storagePath, result]() {
+            if (*canceled)
+                return;
+
+            _currConcurrentTask++;
+            if (result == Result::SUCCEED)
+            {
+                fileSuccess(customId, storagePath);
+            }
+            else if (result == Result::VERIFY_FAILED)
+            {
+                fileError(customId, "Asset file md5 verification failed after downloaded");
+            }
+            else
+            {
+                std::string errorMsg = "Unable to decompress file " + storagePath;
+                dispatchUpdateEvent(EventAssetsManagerEx::EventCode::ERROR_DECOMPRESS, "", errorMsg);
+                fileError(customId, errorMsg);
+            }
+        });
     });
 }
 
@@ -838,7 +1116,9 @@ void AssetsManagerEx::prepareUpdate()
     // Temporary manifest exists, previously updating and equals to the remote version, resuming previous download
     if (_tempManifest && _tempManifest->isLoaded() && _tempManifest->isUpdating() && _tempManifest->versionEquals(_remoteManifest))
     {
+        // Compact the journal replayed in initManifests into the manifest file
         _tempManifest->saveToFile(_tempManifestPath);
+        _tempManifest->openJournal(_tempJournalPath);
         _tempManifest->genResumeAssetsList(&_downloadUnits);
         _totalWaitToDownload = _totalToDownload = (int)_downloadUnits.size();
         _downloadResumed = true;
@@ -894,8 +1174,10 @@ void AssetsManagerEx::prepareUpdate()
             }
             // Start updating the temp manifest
             _tempManifest->setUpdating(true);
-            // Save current download manifest information for resuming
+            // Save current download manifest information for resuming,
+            // the following state changes are appended to the journal instead of rewriting the manifest
             _tempManifest->saveToFile(_tempManifestPath);
+            _tempManifest->openJournal(_tempJournalPath);
 
             _totalWaitToDownload = _totalToDownload = (int)_downloadUnits.size();
         }
@@ -926,13 +1208,22 @@ void AssetsManagerEx::startUpdate()
     }
 }
 
+bool AssetsManagerEx::isDecompressTempFile(const std::string &path)
+{
+    std::lock_guard<std::mutex> lock(_decompressTempFilesMutex);
+    return _decompressTempFiles.find(path) != _decompressTempFiles.end();
+}
+
 void AssetsManagerEx::updateSucceed()
 {
     // Set temp manifest's updating
     _tempManifest->setUpdating(false);
 
     // Every thing is correctly downloaded, do the following
-    // 1. rename temporary manifest to valid manifest
+    // 1. save and rename temporary manifest to valid manifest, the journal is not needed anymore
+    _tempManifest->closeJournal();
+    _fileUtils->removeFile(_tempJournalPath);
+    _tempManifest->saveToFile(_tempManifestPath);
     _fileUtils->renameFile(_tempStoragePath, TEMP_MANIFEST_FILENAME, MANIFEST_FILENAME);
     // 2. merge temporary storage path to storage path so that temporary version turns to cached version
     if (_fileUtils->isDirectoryExist(_tempStoragePath))
@@ -951,6 +1242,11 @@ void AssetsManagerEx::updateSucceed()
             {
                 _fileUtils->createDirectory(dstPath);
             }
+            // Leftover of a failed decompression, assets named like temp files are merged as usual
+            else if (isDecompressTempFile(*it))
+            {
+                _fileUtils->removeFile(*it);
+            }
             // Copy file
             else
             {
@@ -963,6 +1259,8 @@ void AssetsManagerEx::updateSucceed()
         }
         // Remove temp storage path
         _fileUtils->removeDirectory(_tempStoragePath);
+        std::lock_guard<std::mutex> lock(_decompressTempFilesMutex);
+        _decompressTempFiles.clear();
     }
     // 3. swap the localManifest
     CC_SAFE_RELEASE(_localManifest);
@@ -1277,32 +1575,35 @@ void AssetsManagerEx::onSuccess(const std::string &/*srcUrl*/, const std::string
     else
     {
         bool ok = true;
+        bool compressed = false;
+        std::string md5;
         auto &assets = _remoteManifest->getAssets();
         auto assetIt = assets.find(customId);
         if (assetIt != assets.end())
         {
-            Manifest::Asset asset = assetIt->second;
+            const Manifest::Asset& asset = assetIt->second;
+            compressed = asset.compressed;
+            if (_md5Verification)
+            {
+                md5 = asset.md5;
+            }
             if (_verifyCallback != nullptr)
             {
                 ok = _verifyCallback(storagePath, asset);
             }
         }
 
-        if (ok)
+        if (!ok)
         {
-            bool compressed = assetIt != assets.end() ? assetIt->second.compressed : false;
-            if (compressed)
-            {
-                decompressDownloadedZip(customId, storagePath);
-            }
-            else
-            {
-                fileSuccess(customId, storagePath);
-            }
+            fileError(customId, "Asset file verification failed after downloaded");
+        }
+        else if (compressed || !md5.empty())
+        {
+            postProcessDownloadedAsset(customId, storagePath, md5, compressed);
         }
         else
         {
-            fileError(customId, "Asset file verification failed after downloaded");
+            fileSuccess(customId, storagePath);
         }
     }
 }
@@ -1356,7 +1657,8 @@ void AssetsManagerEx::queueDowload()
 
         _tempManifest->setAssetDownloadState(key, Manifest::DownloadState::DOWNLOADING);
     }
-    if (_percentByFile / 100 > _nextSavePoint)
+    // The journal already records every state change, only fall back to saving the whole manifest without it
+    if (!_tempManifest->isJournalOpened() && _percentByFile / 100 > _nextSavePoint)
     {
         // Save current download manifest information for resuming
         _tempManifest->saveToFile(_tempManifestPath);
@@ -1369,7 +1671,7 @@ void AssetsManagerEx::onDownloadUnitsFinished()
     // Finished with error check
     if (_failedUnits.size() > 0)
     {
-        // Save current download manifest information for resuming
+        // Save current download manifest information for resuming, this also compacts the journal
         _tempManifest->saveToFile(_tempManifestPath);
 
         _updateState = State::FAIL_TO_UPDATE;
@@ -27,12 +27,17 @@
 #ifndef __AssetsManagerEx__
 #define __AssetsManagerEx__
 
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "platform/CCFileUtils.h"
 #include "network/CCDownloader.h"
+#include "base/CCThreadPool.h"
 
 #include "CCEventAssetsManagerEx.h"
 
@@ -188,6 +193,16 @@ public:
      */
     void setVerifyCallback(const VerifyCallback& callback) {_verifyCallback = callback;};
     
+    /** @brief Set whether downloaded assets should be checked against the md5 of their manifest entry.
+     * The check runs on the post processing threads together with decompression, after the verify callback if both are used.
+     * @param enabled  Whether to verify md5, false by default
+     */
+    void setMD5Verification(bool enabled) {_md5Verification = enabled;};
+    
+    /** @brief Gets whether downloaded assets are checked against the md5 of their manifest entry.
+     */
+    bool isMD5VerificationEnabled() const {return _md5Verification;};
+    
     /** @brief Set the event callback for receiving update process events
      * @param callback  The event callback function
      */
@@ -226,7 +241,13 @@ protected:
     void startUpdate();
     void updateSucceed();
     bool decompress(const std::string &filename);
-    void decompressDownloadedZip(const std::string &customId, const std::string &storagePath);
+    void removeDecompressTempFile(const std::string &tempPath);
+    bool isDecompressTempFile(const std::string &path);
+    
+    /** @brief Verify the md5 of a downloaded asset and/or decompress it on the post processing threads,
+     * fileSuccess or fileError is then called in cocos thread. The download slot of the asset is released immediately.
+     */
+    void postProcessDownloadedAsset(const std::string &customId, const std::string &storagePath, const std::string &md5, bool compressed);
     
     /** @brief Update a list of assets under the current AssetsManagerEx context
      */
@@ -320,6 +341,9 @@ private:
     //! The local path of cached temporary manifest file
     std::string _tempManifestPath;
     
+    //! The local path of the download state journal of the temporary manifest
+    std::string _tempJournalPath;
+    
     //! The path of local manifest file
     std::string _manifestUrl;
     
@@ -398,6 +422,19 @@ private:
     
     //! Marker for whether the assets manager is inited
     bool _inited;
+    
+    //! Whether downloaded assets are checked against their manifest md5
+    bool _md5Verification;
+    
+    //! Threads verifying and decompressing downloaded assets, created on first use
+    std::unique_ptr<experimental::ThreadPool> _postProcessPool;
+    
+    //! Set when the assets manager is destroyed, post processing results are dropped afterwards
+    std::shared_ptr<std::atomic<bool>> _postProcessCanceled;
+    
+    //! Decompression temp files which couldn't be removed, they are deleted before merging the temp storage
+    std::unordered_set<std::string> _decompressTempFiles;
+    std::mutex _decompressTempFilesMutex;
 };
 
 NS_CC_EXT_END
@@ -46,11 +46,16 @@ void AsyncTaskPool::destroyInstance()
 }
 
 AsyncTaskPool::AsyncTaskPool()
+: _threadPool(experimental::ThreadPool::newFixedThreadPool(experimental::ThreadPool::getDefaultThreadNum()))
 {
+    for (auto& stopCount : _stopCounts)
+        stopCount = 0;
 }
 
 AsyncTaskPool::~AsyncTaskPool()
 {
+    // waits for the running and queued tasks
+    delete _threadPool;
 }
 
 NS_CC_END
@@ -27,17 +27,10 @@ THE SOFTWARE.
 #define __CCSYNC_TASK_POOL_H_
 
 #include "CCPlatformDefine.h"
-#include "platform/CCApplication.h"
-#include "base/CCScheduler.h"
-#include <vector>
-#include <queue>
-#include <memory>
-#include <thread>
-#include <mutex>
-#include <condition_variable>
-#include <future>
+#include "base/CCThreadPool.h"
+#include <atomic>
 #include <functional>
-#include <stdexcept>
+#include <mutex>
 
 /**
 * @addtogroup base
@@ -49,6 +42,8 @@ NS_CC_BEGIN
 /**
  * @class AsyncTaskPool
  * @brief This class allows to perform background operations without having to manipulate threads.
+ * The tasks run on a work-stealing ThreadPool sized by the number of cores, tasks of the same type
+ * run one after another in the order they were enqueued.
  * @js NA
  */
 class CC_DLL AsyncTaskPool
@@ -84,7 +79,8 @@ public:
     /**
      * Enqueue a asynchronous task.
      *
-     * @param type task type is io task, network task or others, each type of task has a thread to deal with it.
+     * @param type task type is io task, network task or others. Io tasks are run before the others,
+     *        tasks of the same type run serially, tasks of different types could run in parallel.
      * @param callback callback when the task is finished. The callback is called in the main thread instead of task thread.
      * @param callbackParam parameter used by the callback.
      * @param f task can be lambda function.
@@ -99,119 +95,62 @@ CC_CONSTRUCTOR_ACCESS:
 
 protected:
 
-    // thread tasks internally used
-    class ThreadTasks {
-        struct AsyncTaskCallBack
-        {
-            TaskCallBack          callback;
-            void*                 callbackParam;
-        };
-    public:
-        ThreadTasks()
-        : _stop(false)
-        {
-            _thread = std::thread(
-                                  [this]
-                                  {
-                                      for(;;)
-                                      {
-                                          std::function<void()> task;
-                                          AsyncTaskCallBack callback;
-                                          {
-                                              std::unique_lock<std::mutex> lock(this->_queueMutex);
-                                              this->_condition.wait(lock,
-                                                                    [this]{ return this->_stop || !this->_tasks.empty(); });
-                                              if(this->_stop && this->_tasks.empty())
-                                                  return;
-                                              task = std::move(this->_tasks.front());
-                                              callback = std::move(this->_taskCallBacks.front());
-                                              this->_tasks.pop();
-                                              this->_taskCallBacks.pop();
-                                          }
-
-                                          task();
-                                          Application::getInstance()->getScheduler()->performFunctionInCocosThread([&, callback]{ callback.callback(callback.callbackParam); });
-                                      }
-                                  }
-                                  );
-        }
-        ~ThreadTasks()
-        {
-            {
-                std::unique_lock<std::mutex> lock(_queueMutex);
-                _stop = true;
-
-                while(_tasks.size())
-                    _tasks.pop();
-                while (_taskCallBacks.size())
-                    _taskCallBacks.pop();
-            }
-            _condition.notify_all();
-            _thread.join();
-        }
-        void clear()
-        {
-            std::unique_lock<std::mutex> lock(_queueMutex);
-            while(_tasks.size())
-                _tasks.pop();
-            while (_taskCallBacks.size())
-                _taskCallBacks.pop();
-        }
-        template<class F>
-        void enqueue(const TaskCallBack& callback, void* callbackParam, F&& f)
-        {
-            auto task = f;//std::bind(std::forward<F>(f), std::forward<Args>(args)...);
-
-            {
-                std::unique_lock<std::mutex> lock(_queueMutex);
-
-                // don't allow enqueueing after stopping the pool
-                if(_stop)
-                {
-                    CC_ASSERT(0 && "already stop");
-                    return;
-                }
-
-                AsyncTaskCallBack taskCallBack;
-                taskCallBack.callback = callback;
-                taskCallBack.callbackParam = callbackParam;
-                _tasks.emplace([task](){ task(); });
-                _taskCallBacks.emplace(taskCallBack);
-            }
-            _condition.notify_one();
-        }
-    private:
-
-        // need to keep track of thread so we can join them
-        std::thread _thread;
-        // the task queue
-        std::queue< std::function<void()> > _tasks;
-        std::queue<AsyncTaskCallBack>            _taskCallBacks;
-
-        // synchronization
-        std::mutex _queueMutex;
-        std::condition_variable _condition;
-        bool _stop;
-    };
+    static experimental::ThreadPool::TaskType toThreadPoolTaskType(TaskType type);
 
-    //tasks
-    ThreadTasks _threadTasks[int(TaskType::TASK_MAX_TYPE)];
+    experimental::ThreadPool* _threadPool;
+
+    // The last task enqueued for each type, the next task of the type waits for it
+    experimental::ThreadPool::TaskHandle _lastTasks[(int)TaskType::TASK_MAX_TYPE];
+    std::mutex _lastTasksMutex;
+    // Increased when the tasks of the type are stopped, tasks enqueued before are skipped
+    std::atomic<unsigned int> _stopCounts[(int)TaskType::TASK_MAX_TYPE];
 
     static AsyncTaskPool* s_asyncTaskPool;
 };
 
+inline experimental::ThreadPool::TaskType AsyncTaskPool::toThreadPoolTaskType(TaskType type)
+{
+    switch (type)
+    {
+        case TaskType::TASK_IO:
+            return experimental::ThreadPool::TaskType::IO;
+        case TaskType::TASK_NETWORK:
+            return experimental::ThreadPool::TaskType::NETWORK;
+        default:
+            return experimental::ThreadPool::TaskType::DEFAULT;
+    }
+}
+
 inline void AsyncTaskPool::stopTasks(TaskType type)
 {
-    auto& threadTask = _threadTasks[(int)type];
-    threadTask.clear();
+    // Tasks waiting for the previous one of the type aren't in the thread pool yet
+    ++_stopCounts[(int)type];
+    {
+        std::lock_guard<std::mutex> lk(_lastTasksMutex);
+        _lastTasks[(int)type] = nullptr;
+    }
+    _threadPool->stopTasksByType(toThreadPoolTaskType(type));
 }
 
 template<class F>
 inline void AsyncTaskPool::enqueue(AsyncTaskPool::TaskType type, const TaskCallBack& callback, void* callbackParam, F&& f)
 {
-    auto& threadTask = _threadTasks[(int)type];
-
-    threadTask.enqueue(callback, callbackParam, f);
+    auto task = f;
+    auto priority = type == TaskType::TASK_IO ? experimental::ThreadPool::TaskPriority::HIGH
+                                              : experimental::ThreadPool::TaskPriority::NORMAL;
+    std::atomic<unsigned int>* stopCount = &_stopCounts[(int)type];
+    unsigned int stopCountWhenEnqueued = *stopCount;
+
+    // Chained on the previous task of the type, so each type is a serial lane
+    std::lock_guard<std::mutex> lk(_lastTasksMutex);
+    auto lastTask = _lastTasks[(int)type];
+    _lastTasks[(int)type] = _threadPool->pushTask([task, stopCount, stopCountWhenEnqueued](int /*threadId*/) {
+        if (*stopCount == stopCountWhenEnqueued)
+            task();
+    }, toThreadPoolTaskType(type), priority, { lastTask }, [callback, callbackParam, stopCount, stopCountWhenEnqueued]() {
+        if (*stopCount == stopCountWhenEnqueued)
+            callback(callbackParam);
+    });
 }
 
 
@@ -28,6 +28,7 @@
 #include "json/prettywriter.h"
 #include "json/stringbuffer.h"
 
+#include <algorithm>
 #include <fstream>
 #include <stdio.h>
 
@@ -50,8 +51,37 @@
 #define KEY_COMPRESSED_FILE     "compressedFile"
 #define KEY_DOWNLOAD_STATE      "downloadState"
 
+// Journal layout, all integers are little endian uint32:
+// magic, format version, asset count, version length, version bytes,
+// then one record per state change: (index of the asset key in the sorted index << 2) | state
+#define JOURNAL_MAGIC           0x4a4d4343 // "CCMJ"
+#define JOURNAL_FORMAT_VERSION  1
+#define JOURNAL_STATE_BITS      2
+#define JOURNAL_STATE_MASK      0x3
+
 NS_CC_EXT_BEGIN
 
+static bool writeUint32(FILE *fp, uint32_t value)
+{
+    unsigned char bytes[4] = {
+        (unsigned char)(value & 0xff),
+        (unsigned char)((value >> 8) & 0xff),
+        (unsigned char)((value >> 16) & 0xff),
+        (unsigned char)((value >> 24) & 0xff)
+    };
+    return fwrite(bytes, sizeof(bytes), 1, fp) == 1;
+}
+
+static bool readUint32(FILE *fp, uint32_t *value)
+{
+    unsigned char bytes[4];
+    if (fread(bytes, sizeof(bytes), 1, fp) != 1)
+        return false;
+
+    *value = (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+    return true;
+}
+
 static int cmpVersion(const std::string& v1, const std::string& v2)
 {
     int i;
@@ -82,6 +112,7 @@ Manifest::Manifest(const std::string& manifestUrl/* = ""*/)
 , _remoteVersionUrl("")
 , _version("")
 , _engineVer("")
+, _journal(nullptr)
 {
     // Init variables
     _fileUtils = FileUtils::getInstance();
@@ -98,6 +129,7 @@ Manifest::Manifest(const std::string& content, const std::string& manifestRoot)
 , _remoteVersionUrl("")
 , _version("")
 , _engineVer("")
+, _journal(nullptr)
 {
     // Init variables
     _fileUtils = FileUtils::getInstance();
@@ -105,6 +137,11 @@ Manifest::Manifest(const std::string& content, const std::string& manifestRoot)
         parseJSONString(content, manifestRoot);
 }
 
+Manifest::~Manifest()
+{
+    closeJournal();
+}
+
 void Manifest::loadJson(const std::string& url)
 {
     clear();
@@ -276,49 +313,51 @@ std::unordered_map<std::string, Manifest::AssetDiff> Manifest::genDiff(const Man
     std::unordered_map<std::string, AssetDiff> diff_map;
     const std::unordered_map<std::string, Asset> &bAssets = b->getAssets();
     
-    std::string key;
-    Asset valueA;
-    Asset valueB;
-    
-    std::unordered_map<std::string, Asset>::const_iterator valueIt, it;
-    for (it = _assets.begin(); it != _assets.end(); ++it)
-    {
-        key = it->first;
-        valueA = it->second;
+    // Walk both sorted indexes together, keys only present on one side are deleted or added
+    size_t i = 0, j = 0;
+    const size_t countA = _assetIndex.size(), countB = b->_assetIndex.size();
+    while (i < countA || j < countB)
+    {
+        int cmp;
+        if (i == countA)
+            cmp = 1;
+        else if (j == countB)
+            cmp = -1;
+        else
+            cmp = _assetIndex[i]->compare(*b->_assetIndex[j]);
         
-        // Deleted
-        valueIt = bAssets.find(key);
-        if (valueIt == bAssets.cend()) {
+        if (cmp < 0)
+        {
+            // Deleted
+            const std::string &key = *_assetIndex[i++];
             AssetDiff diff;
-            diff.asset = valueA;
+            diff.asset = _assets.at(key);
             diff.type = DiffType::DELETED;
             diff_map.emplace(key, diff);
-            continue;
         }
-        
-        // Modified
-        valueB = valueIt->second;
-        if (valueA.md5 != valueB.md5) {
-            AssetDiff diff;
-            diff.asset = valueB;
-            diff.type = DiffType::MODIFIED;
-            diff_map.emplace(key, diff);
-        }
-    }
-    
-    for (it = bAssets.begin(); it != bAssets.end(); ++it)
-    {
-        key = it->first;
-        valueB = it->second;
-        
-        // Added
-        valueIt = _assets.find(key);
-        if (valueIt == _assets.cend()) {
+        else if (cmp > 0)
+        {
+            // Added
+            const std::string &key = *b->_assetIndex[j++];
             AssetDiff diff;
-            diff.asset = valueB;
+            diff.asset = bAssets.at(key);
             diff.type = DiffType::ADDED;
             diff_map.emplace(key, diff);
         }
+        else
+        {
+            // Modified
+            const std::string &key = *_assetIndex[i++];
+            ++j;
+            const Asset &valueB = bAssets.at(key);
+            if (_assets.at(key).md5 != valueB.md5)
+            {
+                AssetDiff diff;
+                diff.asset = valueB;
+                diff.type = DiffType::MODIFIED;
+                diff_map.emplace(key, diff);
+            }
+        }
     }
     
     return diff_map;
@@ -429,36 +468,128 @@ const std::unordered_map<std::string, Manifest::Asset>& Manifest::getAssets() co
 void Manifest::setAssetDownloadState(const std::string &key, const Manifest::DownloadState &state)
 {
     auto valueIt = _assets.find(key);
-    if (valueIt != _assets.end())
+    if (valueIt == _assets.end() || valueIt->second.downloadState == state)
+        return;
+    
+    // The json object is only updated in saveToFile, looking up its members is linear
+    valueIt->second.downloadState = state;
+    
+    if (_journal != nullptr)
     {
-        valueIt->second.downloadState = state;
-        
-        // Update json object
-        if(_json.IsObject())
+        int index = findAssetIndex(key);
+        uint32_t record = ((uint32_t)index << JOURNAL_STATE_BITS) | ((uint32_t)state & JOURNAL_STATE_MASK);
+        if (index < 0 || !writeUint32(_journal, record) || fflush(_journal) != 0)
         {
-            if ( _json.HasMember(KEY_ASSETS) )
-            {
-                rapidjson::Value &assets = _json[KEY_ASSETS];
-                if (assets.IsObject())
-                {
-                    if (assets.HasMember(key.c_str()))
-                    {
-                        rapidjson::Value &entry = assets[key.c_str()];
-                        if (entry.HasMember(KEY_DOWNLOAD_STATE) && entry[KEY_DOWNLOAD_STATE].IsInt())
-                        {
-                            entry[KEY_DOWNLOAD_STATE].SetInt((int) state);
-                        }
-                        else
-                        {
-                            entry.AddMember<int>(KEY_DOWNLOAD_STATE, (int)state, _json.GetAllocator());
-                        }
-                    }
-                }
-            }
+            CCLOG("Manifest : fail to write journal %s\n", _journalPath.c_str());
+            closeJournal();
         }
     }
 }
 
+void Manifest::buildAssetIndex()
+{
+    _assetIndex.clear();
+    _assetIndex.reserve(_assets.size());
+    for (const auto& it : _assets)
+    {
+        _assetIndex.push_back(&it.first);
+    }
+    std::sort(_assetIndex.begin(), _assetIndex.end(), [](const std::string *a, const std::string *b) {
+        return *a < *b;
+    });
+}
+
+int Manifest::findAssetIndex(const std::string &key) const
+{
+    auto it = std::lower_bound(_assetIndex.begin(), _assetIndex.end(), key, [](const std::string *a, const std::string &b) {
+        return *a < b;
+    });
+    if (it == _assetIndex.end() || **it != key)
+        return -1;
+    return (int)(it - _assetIndex.begin());
+}
+
+bool Manifest::writeJournalHeader()
+{
+    bool ok = writeUint32(_journal, JOURNAL_MAGIC)
+        && writeUint32(_journal, JOURNAL_FORMAT_VERSION)
+        && writeUint32(_journal, (uint32_t)_assetIndex.size())
+        && writeUint32(_journal, (uint32_t)_version.size());
+    if (ok && !_version.empty())
+    {
+        ok = fwrite(_version.data(), _version.size(), 1, _journal) == 1;
+    }
+    return ok && fflush(_journal) == 0;
+}
+
+bool Manifest::openJournal(const std::string &journalPath)
+{
+    closeJournal();
+    _journalPath = journalPath;
+    
+    _journal = fopen(_fileUtils->getSuitableFOpen(journalPath).c_str(), "wb");
+    if (_journal == nullptr)
+    {
+        CCLOG("Manifest : fail to create journal %s\n", journalPath.c_str());
+        return false;
+    }
+    if (!writeJournalHeader())
+    {
+        CCLOG("Manifest : fail to write journal %s\n", journalPath.c_str());
+        closeJournal();
+        return false;
+    }
+    return true;
+}
+
+void Manifest::closeJournal()
+{
+    if (_journal != nullptr)
+    {
+        fclose(_journal);
+        _journal = nullptr;
+    }
+}
+
+void Manifest::loadJournal(const std::string &journalPath)
+{
+    if (!_loaded)
+        return;
+    
+    FILE *fp = fopen(_fileUtils->getSuitableFOpen(journalPath).c_str(), "rb");
+    if (fp == nullptr)
+        return;
+    
+    uint32_t magic = 0, format = 0, assetCount = 0, versionLength = 0;
+    bool valid = readUint32(fp, &magic) && magic == JOURNAL_MAGIC
+        && readUint32(fp, &format) && format == JOURNAL_FORMAT_VERSION
+        && readUint32(fp, &assetCount) && assetCount == _assetIndex.size()
+        && readUint32(fp, &versionLength) && versionLength == _version.size();
+    if (valid && versionLength > 0)
+    {
+        std::string version(versionLength, '\0');
+        valid = fread(&version[0], versionLength, 1, fp) == 1 && version == _version;
+    }
+    
+    if (valid)
+    {
+        // A record cut by a crash fails to read and ends the replay
+        uint32_t record = 0;
+        while (readUint32(fp, &record))
+        {
+            uint32_t index = record >> JOURNAL_STATE_BITS;
+            if (index >= _assetIndex.size())
+                break;
+            _assets[*_assetIndex[index]].downloadState = (int)(record & JOURNAL_STATE_MASK);
+        }
+    }
+    else
+    {
+        CCLOG("Manifest : ignore journal %s written for another manifest\n", journalPath.c_str());
+    }
+    fclose(fp);
+}
+
 void Manifest::clear()
 {
     if (_versionLoaded || _loaded)
@@ -476,6 +607,7 @@ void Manifest::clear()
     
     if (_loaded)
     {
+        _assetIndex.clear();
         _assets.clear();
         _searchPaths.clear();
         _loaded = false;
@@ -604,6 +736,8 @@ void Manifest::loadManifest(const rapidjson::Document &json)
         }
     }
     
+    buildAssetIndex();
+    
     // Retrieve all search paths
     if ( json.HasMember(KEY_SEARCH_PATHS) )
     {
@@ -624,14 +758,59 @@ void Manifest::loadManifest(const rapidjson::Document &json)
 
 void Manifest::saveToFile(const std::string &filepath)
 {
+    // Write the download states kept in _assets to the json object in one pass
+    if (_json.IsObject() && _json.HasMember(KEY_ASSETS) && _json[KEY_ASSETS].IsObject())
+    {
+        rapidjson::Value &assets = _json[KEY_ASSETS];
+        for (rapidjson::Value::MemberIterator itr = assets.MemberBegin(); itr != assets.MemberEnd(); ++itr)
+        {
+            auto valueIt = _assets.find(itr->name.GetString());
+            if (valueIt == _assets.end() || valueIt->second.downloadState == DownloadState::UNMARKED || !itr->value.IsObject())
+                continue;
+            
+            rapidjson::Value &entry = itr->value;
+            int state = valueIt->second.downloadState;
+            if (entry.HasMember(KEY_DOWNLOAD_STATE) && entry[KEY_DOWNLOAD_STATE].IsInt())
+            {
+                entry[KEY_DOWNLOAD_STATE].SetInt(state);
+            }
+            else
+            {
+                entry.AddMember<int>(KEY_DOWNLOAD_STATE, state, _json.GetAllocator());
+            }
+        }
+    }
+    
     rapidjson::StringBuffer buffer;
     rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
     _json.Accept(writer);
     
-    std::ofstream output(FileUtils::getInstance()->getSuitableFOpen(filepath), std::ofstream::out);
-
-    if(!output.bad())
-        output << buffer.GetString() << std::endl;
+    // Replace the file only once the new content is completely written
+    std::string tempPath = filepath + ".tmp";
+    bool saved = false;
+    {
+        std::ofstream output(FileUtils::getInstance()->getSuitableFOpen(tempPath), std::ofstream::out);
+        if (!output.bad())
+        {
+            output << buffer.GetString() << std::endl;
+            output.flush();
+            saved = output.good();
+        }
+    }
+    
+    if (!saved || !_fileUtils->renameFile(tempPath, filepath))
+    {
+        CCLOG("Manifest : fail to save manifest to %s\n", filepath.c_str());
+        _fileUtils->removeFile(tempPath);
+        return;
+    }
+    
+    // Every recorded state is in the file now
+    if (_journal != nullptr)
+    {
+        std::string journalPath = _journalPath;
+        openJournal(journalPath);
+    }
 }
 
 NS_CC_EXT_END
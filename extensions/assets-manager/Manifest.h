@@ -130,6 +130,8 @@ public:
      */
     Manifest(const std::string& content, const std::string& manifestRoot);
     
+    virtual ~Manifest();
+    
     /** @brief Parse the manifest file information into this manifest
      * @param manifestUrl Url of the local manifest
      */
@@ -206,12 +208,42 @@ protected:
     
     void loadManifest(const rapidjson::Document &json);
     
+    /** @brief Write the whole manifest with the current download states, the previous file is only replaced once the new one is complete.
+     * An open journal is reset afterwards since every state it recorded is now in the file.
+     */
     void saveToFile(const std::string &filepath);
     
+    /** @brief Apply the download states recorded in a journal, a journal written for another manifest is ignored.
+     * @param journalPath   Path of the journal file
+     */
+    void loadJournal(const std::string &journalPath);
+    
+    /** @brief Start recording download state changes to a journal, the journal file is reset.
+     * @param journalPath   Path of the journal file
+     * @return Whether the journal could be created
+     */
+    bool openJournal(const std::string &journalPath);
+    
+    /** @brief Stop recording download state changes, the journal file is left on disk.
+     */
+    void closeJournal();
+    
+    bool isJournalOpened() const { return _journal != nullptr; };
+    
     Asset parseAsset(const std::string &path, const rapidjson::Value &json);
     
     void clear();
     
+    /** @brief Sort the asset keys, the position of a key is its index in the journal.
+     */
+    void buildAssetIndex();
+    
+    /** @brief Gets the position of an asset key in the sorted index, or -1 if not found.
+     */
+    int findAssetIndex(const std::string &key) const;
+    
+    bool writeJournalHeader();
+    
     /** @brief Gets all groups.
      */
     const std::vector<std::string>& getGroups() const;
@@ -231,7 +263,7 @@ protected:
      */
     const std::unordered_map<std::string, Asset>& getAssets() const;
     
-    /** @brief Set the download state for an asset
+    /** @brief Set the download state for an asset, it is written to the json object by saveToFile and recorded to the journal if opened
      * @param key   Key of the asset to set
      * @param state The current download state of the asset
      */
@@ -280,10 +312,19 @@ private:
     //! Full assets list
     std::unordered_map<std::string, Asset> _assets;
     
+    //! Keys of _assets in ascending order, pointing to the keys stored in _assets
+    std::vector<const std::string*> _assetIndex;
+    
     //! All search paths
     std::vector<std::string> _searchPaths;
     
     rapidjson::Document _json;
+    
+    //! Download state journal, only opened while updating
+    FILE *_journal;
+    
+    //! Path of the journal, kept to reset it after the manifest is saved
+    std::string _journalPath;
 };
 
 NS_CC_EXT_END